@@ -38,6 +38,8 @@
 #include <lists/dir_list.h>
 
 #ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <retro_atomic.h>
 #include "audio_thread_wrapper.h"
 #endif
 
@@ -64,6 +66,56 @@
  /* Converts decibels to voltage gain. returns voltage gain value. */
 #define DB_TO_GAIN(db) (powf(10.0f, (db) / 20.0f))
 
+#ifdef HAVE_THREADS
+/* Packets in the flush thread's ring, must be a power of two. */
+#define AUDIO_FLUSH_RING_PACKETS   8
+/* Core samples per packet; large enough for a whole rewind flush. */
+#define AUDIO_FLUSH_PACKET_SAMPLES (AUDIO_CHUNK_SIZE_NONBLOCKING * 2)
+/* Core samples the ring may hold before the producer has to wait. */
+#define AUDIO_FLUSH_RING_SAMPLES   (AUDIO_CHUNK_SIZE_NONBLOCKING * 2)
+/* Upper bounds for a missed wakeup on either side of the ring. */
+#define AUDIO_FLUSH_IDLE_USEC      5000
+#define AUDIO_FLUSH_WAIT_USEC      2000
+
+typedef struct audio_flush_packet
+{
+   retro_time_t flush_time;
+   size_t samples;
+   float slowmotion_ratio;
+   bool is_slowmotion;
+   bool is_fastforward;
+   int16_t data[AUDIO_FLUSH_PACKET_SAMPLES];
+} audio_flush_packet_t;
+
+/* Single-producer, single-consumer ring between the thread that
+ * runs the core and the flush thread. head and tail count packets
+ * modulo twice the ring size, so that a full ring can be told
+ * apart from an empty one. */
+struct audio_flush_ring
+{
+   audio_flush_packet_t packets[AUDIO_FLUSH_RING_PACKETS];
+   sthread_t *thread;
+   slock_t *lock;      /* Held while a packet is written to the driver */
+   slock_t *wake_lock;
+#ifndef RETRO_ATOMIC_LOCK_FREE
+   slock_t *index_lock;
+#endif
+   scond_t *wake_cond;  /* Signalled when a packet was queued */
+   scond_t *space_cond; /* Signalled when a packet was consumed */
+   retro_atomic_int_t head;
+   retro_atomic_int_t tail;
+   retro_atomic_int_t queued; /* Core samples in the ring */
+   retro_atomic_int_t worker_waiting;
+   retro_atomic_int_t producer_waiting;
+   retro_atomic_int_t quit;
+   bool stopped;       /* Driver is stopped, drop packets */
+};
+
+typedef struct audio_flush_ring audio_flush_ring_t;
+
+static void audio_driver_flush_thread_free(audio_driver_state_t *audio_st);
+#endif
+
 audio_driver_t audio_null = {
    NULL, /* init */
    NULL, /* write */
@@ -336,6 +388,9 @@ static void audio_driver_mixer_deinit(void)
 
 bool audio_driver_deinit(void)
 {
+#ifdef HAVE_THREADS
+   audio_driver_flush_thread_free(&audio_driver_st);
+#endif
 #ifdef HAVE_AUDIOMIXER
    audio_driver_mixer_deinit();
 #endif
@@ -377,6 +432,34 @@ bool audio_driver_find_driver(const char *audio_drv,
    return true;
 }
 
+/**
+ * Gets the space left in the driver's buffer, in bytes, minus
+ * what the samples still queued for the flush thread will take
+ * up once resampled. Must be called with the flush thread lock
+ * held (or from the flush thread itself).
+ *
+ * @param queued Core samples that are still waiting for the flush thread.
+ **/
+static size_t audio_driver_write_avail_queued(
+      audio_driver_state_t *audio_st, size_t queued)
+{
+   size_t avail = audio_st->current_audio->write_avail(
+         audio_st->context_audio_data);
+
+   /* Queued samples will be in the driver's buffer
+    * soon, so count them as already written. */
+   if (queued)
+   {
+      size_t sample_size = (audio_st->flags & AUDIO_FLAG_USE_FLOAT)
+            ? sizeof(float) : sizeof(int16_t);
+      size_t pending     = (size_t)(queued
+            * audio_st->source_ratio_original * sample_size);
+      avail              = (avail > pending) ? avail - pending : 0;
+   }
+
+   return avail;
+}
+
 /**
  * Writes audio samples to audio driver's output.
  * Will first perform DSP processing (if enabled) and resampling.
@@ -388,12 +471,16 @@ bool audio_driver_find_driver(const char *audio_drv,
  * @param samples The size of \c data, in samples.
  * @param is_slowmotion True if the core is currently running in slow motion.
  * @param is_fastmotion True if the core is currently running in fast-forward.
+ * @param flush_time When the core handed over \c data, only used while fast-forwarding.
+ * @param queued Core samples that are still waiting for the flush thread,
+ * and will reach the driver after \c data.
  **/
-static void audio_driver_flush(
+static void audio_driver_flush_process(
       audio_driver_state_t *audio_st,
       float slowmotion_ratio,
       const int16_t *data, size_t samples,
-      bool is_slowmotion, bool is_fastforward)
+      bool is_slowmotion, bool is_fastforward,
+      retro_time_t flush_time, size_t queued)
 {
    struct resampler_data src_data;
    float audio_volume_gain           =
@@ -452,12 +539,16 @@ static void audio_driver_flush(
       if (audio_st->flags & AUDIO_FLAG_CONTROL)
       {
          /* Readjust the audio input rate. */
-         int avail                   = (int)audio_st->current_audio->write_avail(
-               audio_st->context_audio_data);
+         int avail                   = (int)audio_driver_write_avail_queued(
+               audio_st, queued);
          int half_size               = (int)(audio_st->buffer_size / 2);
-         int delta_mid               = avail - half_size;
-         double direction            = (double)delta_mid / half_size;
-         double adjust               = 1.0 + audio_st->rate_control_delta * direction;
+         int delta_mid;
+         double direction;
+         double adjust;
+
+         delta_mid                   = avail - half_size;
+         direction                   = (double)delta_mid / half_size;
+         adjust                      = 1.0 + audio_st->rate_control_delta * direction;
 
          audio_st->free_samples_buf[write_idx]
                                      = avail;
@@ -485,8 +576,6 @@ static void audio_driver_flush(
 
    if (is_fastforward && config_get_ptr()->bools.audio_fastforward_speedup)
    {
-      const retro_time_t flush_time = cpu_features_get_time_usec();
-
       if (audio_st->last_flush_time > 0)
       {
          /* What we should see if the speed was 1.0x, converted to microsecs */
@@ -561,6 +650,307 @@ static void audio_driver_flush(
    }
 }
 
+#ifdef HAVE_THREADS
+static int audio_flush_ring_load(audio_flush_ring_t *ring,
+      retro_atomic_int_t *p)
+{
+#ifdef RETRO_ATOMIC_LOCK_FREE
+   return retro_atomic_load_acquire(p);
+#else
+   int ret;
+   slock_lock(ring->index_lock);
+   ret = *p;
+   slock_unlock(ring->index_lock);
+   return ret;
+#endif
+}
+
+static void audio_flush_ring_store(audio_flush_ring_t *ring,
+      retro_atomic_int_t *p, int val)
+{
+#ifdef RETRO_ATOMIC_LOCK_FREE
+   retro_atomic_store_release(p, val);
+#else
+   slock_lock(ring->index_lock);
+   *p = val;
+   slock_unlock(ring->index_lock);
+#endif
+}
+
+static void audio_flush_ring_add(audio_flush_ring_t *ring,
+      retro_atomic_int_t *p, int val)
+{
+#ifdef RETRO_ATOMIC_LOCK_FREE
+   retro_atomic_fetch_add(p, val);
+#else
+   slock_lock(ring->index_lock);
+   *p += val;
+   slock_unlock(ring->index_lock);
+#endif
+}
+
+/* Wakes up the other side of the ring if it announced
+ * that it is about to sleep on @cond. */
+static void audio_flush_ring_wake(audio_flush_ring_t *ring,
+      retro_atomic_int_t *waiting, scond_t *cond)
+{
+   if (!audio_flush_ring_load(ring, waiting))
+      return;
+   slock_lock(ring->wake_lock);
+   scond_signal(cond);
+   slock_unlock(ring->wake_lock);
+}
+
+static void audio_flush_thread_loop(void *data)
+{
+   audio_driver_state_t *audio_st = (audio_driver_state_t*)data;
+   audio_flush_ring_t *ring       = audio_st->flush_ring;
+
+   while (!audio_flush_ring_load(ring, &ring->quit))
+   {
+      audio_flush_packet_t *pkt;
+      int tail = audio_flush_ring_load(ring, &ring->tail);
+
+      if (tail == audio_flush_ring_load(ring, &ring->head))
+      {
+         slock_lock(ring->wake_lock);
+         audio_flush_ring_store(ring, &ring->worker_waiting, 1);
+         if (     tail == audio_flush_ring_load(ring, &ring->head)
+               && !audio_flush_ring_load(ring, &ring->quit))
+            scond_wait_timeout(ring->wake_cond, ring->wake_lock,
+                  AUDIO_FLUSH_IDLE_USEC);
+         audio_flush_ring_store(ring, &ring->worker_waiting, 0);
+         slock_unlock(ring->wake_lock);
+         continue;
+      }
+
+      pkt = &ring->packets[tail & (AUDIO_FLUSH_RING_PACKETS - 1)];
+
+      slock_lock(ring->lock);
+      if (!ring->stopped)
+         audio_driver_flush_process(audio_st,
+               pkt->slowmotion_ratio, pkt->data, pkt->samples,
+               pkt->is_slowmotion, pkt->is_fastforward, pkt->flush_time,
+               (size_t)audio_flush_ring_load(ring, &ring->queued)
+               - pkt->samples);
+      slock_unlock(ring->lock);
+
+      audio_flush_ring_add(ring, &ring->queued, -(int)pkt->samples);
+      audio_flush_ring_store(ring, &ring->tail,
+            (tail + 1) & (2 * AUDIO_FLUSH_RING_PACKETS - 1));
+      audio_flush_ring_wake(ring, &ring->producer_waiting,
+            ring->space_cond);
+   }
+}
+
+/**
+ * Copies core samples into the flush thread's ring.
+ *
+ * When the ring is full, this waits for the flush thread if audio
+ * is blocking, and drops the samples otherwise, just like a
+ * nonblocking driver would.
+ **/
+static void audio_flush_ring_push(
+      audio_driver_state_t *audio_st,
+      float slowmotion_ratio,
+      const int16_t *data, size_t samples,
+      bool is_slowmotion, bool is_fastforward,
+      retro_time_t flush_time)
+{
+   audio_flush_ring_t *ring = audio_st->flush_ring;
+   bool blocking            = audio_st->chunk_size
+         != audio_st->chunk_nonblock_size;
+
+   while (samples > 0)
+   {
+      audio_flush_packet_t *pkt;
+      size_t len = MIN(samples, AUDIO_FLUSH_PACKET_SAMPLES);
+      int head   = audio_flush_ring_load(ring, &ring->head);
+
+      for (;;)
+      {
+         int tail   = audio_flush_ring_load(ring, &ring->tail);
+         int count  = (head - tail) & (2 * AUDIO_FLUSH_RING_PACKETS - 1);
+         int queued = audio_flush_ring_load(ring, &ring->queued);
+
+         /* Bound the ring by samples as well as by packets,
+          * to keep the latency it adds low. */
+         if (     count == 0
+               || (     count < AUDIO_FLUSH_RING_PACKETS
+                     && queued + len <= AUDIO_FLUSH_RING_SAMPLES))
+            break;
+         if (!blocking)
+            return;
+
+         slock_lock(ring->wake_lock);
+         audio_flush_ring_store(ring, &ring->producer_waiting, 1);
+         if (tail == audio_flush_ring_load(ring, &ring->tail))
+            scond_wait_timeout(ring->space_cond, ring->wake_lock,
+                  AUDIO_FLUSH_WAIT_USEC);
+         audio_flush_ring_store(ring, &ring->producer_waiting, 0);
+         slock_unlock(ring->wake_lock);
+      }
+
+      pkt                   = &ring->packets[head & (AUDIO_FLUSH_RING_PACKETS - 1)];
+      memcpy(pkt->data, data, len * sizeof(int16_t));
+      pkt->samples          = len;
+      pkt->slowmotion_ratio = slowmotion_ratio;
+      pkt->is_slowmotion    = is_slowmotion;
+      pkt->is_fastforward   = is_fastforward;
+      pkt->flush_time       = flush_time;
+
+      audio_flush_ring_add(ring, &ring->queued, (int)len);
+      audio_flush_ring_store(ring, &ring->head,
+            (head + 1) & (2 * AUDIO_FLUSH_RING_PACKETS - 1));
+      audio_flush_ring_wake(ring, &ring->worker_waiting,
+            ring->wake_cond);
+
+      data    += len;
+      samples -= len;
+   }
+}
+
+static void audio_driver_flush_thread_free(audio_driver_state_t *audio_st)
+{
+   audio_flush_ring_t *ring = audio_st->flush_ring;
+
+   if (!ring)
+      return;
+
+   if (ring->thread)
+   {
+      slock_lock(ring->wake_lock);
+      audio_flush_ring_store(ring, &ring->quit, 1);
+      scond_signal(ring->wake_cond);
+      slock_unlock(ring->wake_lock);
+      sthread_join(ring->thread);
+   }
+
+   if (ring->lock)
+      slock_free(ring->lock);
+   if (ring->wake_lock)
+      slock_free(ring->wake_lock);
+#ifndef RETRO_ATOMIC_LOCK_FREE
+   if (ring->index_lock)
+      slock_free(ring->index_lock);
+#endif
+   if (ring->wake_cond)
+      scond_free(ring->wake_cond);
+   if (ring->space_cond)
+      scond_free(ring->space_cond);
+
+   memalign_free(ring);
+   audio_st->flush_ring = NULL;
+}
+
+static bool audio_driver_flush_thread_init(audio_driver_state_t *audio_st)
+{
+   audio_flush_ring_t *ring = (audio_flush_ring_t*)
+      memalign_alloc(64, sizeof(*ring));
+
+   if (!ring)
+      return false;
+
+   memset(ring, 0, sizeof(*ring));
+   audio_st->flush_ring = ring;
+
+   if (     !(ring->lock       = slock_new())
+         || !(ring->wake_lock  = slock_new())
+#ifndef RETRO_ATOMIC_LOCK_FREE
+         || !(ring->index_lock = slock_new())
+#endif
+         || !(ring->wake_cond  = scond_new())
+         || !(ring->space_cond = scond_new())
+         || !(ring->thread     = sthread_create(
+               audio_flush_thread_loop, audio_st)))
+   {
+      audio_driver_flush_thread_free(audio_st);
+      return false;
+   }
+
+   return true;
+}
+
+/* Keeps the flush thread away from the driver, DSP and mixer
+ * while the main thread changes them. */
+static void audio_driver_flush_thread_lock(audio_driver_state_t *audio_st)
+{
+   if (audio_st->flush_ring)
+      slock_lock(audio_st->flush_ring->lock);
+}
+
+static void audio_driver_flush_thread_unlock(audio_driver_state_t *audio_st)
+{
+   if (audio_st->flush_ring)
+      slock_unlock(audio_st->flush_ring->lock);
+}
+#else
+#define audio_driver_flush_thread_lock(audio_st)   ((void)0)
+#define audio_driver_flush_thread_unlock(audio_st) ((void)0)
+#endif
+
+size_t audio_driver_write_avail(void)
+{
+   size_t avail;
+   size_t queued                  = 0;
+   audio_driver_state_t *audio_st = &audio_driver_st;
+
+   if (     !audio_st->current_audio->write_avail
+         || !audio_st->context_audio_data)
+      return 0;
+
+   audio_driver_flush_thread_lock(audio_st);
+#ifdef HAVE_THREADS
+   if (audio_st->flush_ring)
+      queued = (size_t)audio_flush_ring_load(audio_st->flush_ring,
+            &audio_st->flush_ring->queued);
+#endif
+   avail = audio_driver_write_avail_queued(audio_st, queued);
+   audio_driver_flush_thread_unlock(audio_st);
+
+   return avail;
+}
+
+void audio_driver_set_nonblock_state(bool nonblock)
+{
+   audio_driver_state_t *audio_st = &audio_driver_st;
+
+   if (!audio_st->context_audio_data)
+      return;
+
+   audio_driver_flush_thread_lock(audio_st);
+   audio_st->current_audio->set_nonblock_state(
+         audio_st->context_audio_data, nonblock);
+   audio_driver_flush_thread_unlock(audio_st);
+}
+
+/**
+ * Hands audio samples that were just provided by the core over to
+ * the driver, either directly or through the flush thread.
+ * See audio_driver_flush_process for the parameters.
+ **/
+static void audio_driver_flush(
+      audio_driver_state_t *audio_st,
+      float slowmotion_ratio,
+      const int16_t *data, size_t samples,
+      bool is_slowmotion, bool is_fastforward)
+{
+   retro_time_t flush_time = is_fastforward
+         ? cpu_features_get_time_usec() : 0;
+
+#ifdef HAVE_THREADS
+   if (audio_st->flush_ring)
+   {
+      audio_flush_ring_push(audio_st, slowmotion_ratio, data, samples,
+            is_slowmotion, is_fastforward, flush_time);
+      return;
+   }
+#endif
+
+   audio_driver_flush_process(audio_st, slowmotion_ratio, data, samples,
+         is_slowmotion, is_fastforward, flush_time, 0);
+}
+
 #ifdef HAVE_AUDIOMIXER
 audio_mixer_stream_t *audio_driver_mixer_get_stream(unsigned i)
 {
@@ -785,6 +1175,27 @@ bool audio_driver_init_internal(void *settings_data, bool audio_cb_inited)
    audio_mixer_init(settings->uints.audio_output_sample_rate);
 #endif
 
+   /* Queried before the flush thread starts using the driver */
+   if (     audio_driver_st.current_audio->device_list_new
+         && audio_driver_st.context_audio_data)
+      audio_driver_st.devices_list = (struct string_list*)
+         audio_driver_st.current_audio->device_list_new(
+               audio_driver_st.context_audio_data);
+
+#ifdef HAVE_THREADS
+   if (     settings->bools.audio_flush_threaded
+         && !audio_cb_inited
+         && !audio_driver_st.flush_ring
+         && (audio_driver_st.flags & AUDIO_FLAG_ACTIVE)
+         &&  audio_driver_st.context_audio_data)
+   {
+      if (audio_driver_flush_thread_init(&audio_driver_st))
+         RARCH_LOG("[Audio]: Processing audio on a flush thread.\n");
+      else
+         RARCH_WARN("[Audio]: Failed to start the flush thread, processing audio synchronously.\n");
+   }
+#endif
+
    /* Threaded driver is initially stopped. */
    if (     (audio_driver_st.flags & AUDIO_FLAG_ACTIVE)
          &&  audio_cb_inited)
@@ -927,9 +1338,11 @@ size_t audio_driver_sample_batch_rewind(
 void audio_driver_dsp_filter_free(void)
 {
    audio_driver_state_t *audio_st  = &audio_driver_st;
+   audio_driver_flush_thread_lock(audio_st);
    if (audio_st->dsp)
       retro_dsp_filter_free(audio_st->dsp);
    audio_st->dsp = NULL;
+   audio_driver_flush_thread_unlock(audio_st);
 }
 
 bool audio_driver_dsp_filter_init(const char *device)
@@ -950,7 +1363,9 @@ bool audio_driver_dsp_filter_init(const char *device)
    if (!audio_driver_dsp)
       return false;
 
+   audio_driver_flush_thread_lock(&audio_driver_st);
    audio_driver_st.dsp = audio_driver_dsp;
+   audio_driver_flush_thread_unlock(&audio_driver_st);
 
    return true;
 }
@@ -1242,6 +1657,8 @@ bool audio_driver_mixer_add_stream(audio_mixer_stream_params_t *params)
       return false;
    }
 
+   audio_driver_flush_thread_lock(&audio_driver_st);
+
    switch (params->state)
    {
       case AUDIO_STREAM_STATE_PLAYING_SEQUENTIAL:
@@ -1270,6 +1687,8 @@ bool audio_driver_mixer_add_stream(audio_mixer_stream_params_t *params)
    audio_driver_st.mixer_streams[free_slot].volume      = params->volume;
    audio_driver_st.mixer_streams[free_slot].stop_cb     = stop_cb;
 
+   audio_driver_flush_thread_unlock(&audio_driver_st);
+
    return true;
 }
 
@@ -1511,6 +1930,8 @@ void audio_driver_mixer_stop_stream(unsigned i)
    if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
       return;
 
+   audio_driver_flush_thread_lock(&audio_driver_st);
+
    switch (audio_driver_st.mixer_streams[i].state)
    {
       case AUDIO_STREAM_STATE_PLAYING:
@@ -1529,6 +1950,8 @@ void audio_driver_mixer_stop_stream(unsigned i)
       case AUDIO_STREAM_STATE_NONE:
          break;
    }
+
+   audio_driver_flush_thread_unlock(&audio_driver_st);
 }
 
 void audio_driver_mixer_remove_stream(unsigned i)
@@ -1546,6 +1969,7 @@ void audio_driver_mixer_remove_stream(unsigned i)
       case AUDIO_STREAM_STATE_STOPPED:
          {
             audio_mixer_sound_t *handle = audio_driver_st.mixer_streams[i].handle;
+            audio_driver_flush_thread_lock(&audio_driver_st);
             if (handle)
                audio_mixer_destroy(handle);
 
@@ -1558,6 +1982,7 @@ void audio_driver_mixer_remove_stream(unsigned i)
             audio_driver_st.mixer_streams[i].handle  = NULL;
             audio_driver_st.mixer_streams[i].voice   = NULL;
             audio_driver_st.mixer_streams[i].name    = NULL;
+            audio_driver_flush_thread_unlock(&audio_driver_st);
          }
          break;
       case AUDIO_STREAM_STATE_NONE:
@@ -1645,9 +2070,18 @@ bool audio_driver_start(bool is_shutdown)
          || !audio_st->current_audio->start
          || !audio_st->context_audio_data)
       goto error;
+   audio_driver_flush_thread_lock(audio_st);
    if (!audio_st->current_audio->start(
             audio_st->context_audio_data, is_shutdown))
+   {
+      audio_driver_flush_thread_unlock(audio_st);
       goto error;
+   }
+#ifdef HAVE_THREADS
+   if (audio_st->flush_ring)
+      audio_st->flush_ring->stopped = false;
+#endif
+   audio_driver_flush_thread_unlock(audio_st);
 
    RARCH_DBG("[Audio]: Started audio driver \"%s\" (is_shutdown=%s)\n",
          audio_st->current_audio->ident,
@@ -1675,12 +2109,23 @@ bool audio_driver_stop(void)
    bool stopped;
    if (     !audio_driver_st.current_audio
          || !audio_driver_st.current_audio->stop
-         || !audio_driver_st.context_audio_data
-         || !audio_driver_alive()
-      )
+         || !audio_driver_st.context_audio_data)
       return false;
+   audio_driver_flush_thread_lock(&audio_driver_st);
+   if (!audio_driver_alive())
+   {
+      audio_driver_flush_thread_unlock(&audio_driver_st);
+      return false;
+   }
    stopped = audio_driver_st.current_audio->stop(
          audio_driver_st.context_audio_data);
+#ifdef HAVE_THREADS
+   /* Writing to a stopped driver may block, so drop
+    * whatever is still queued until it is restarted. */
+   if (stopped && audio_driver_st.flush_ring)
+      audio_driver_st.flush_ring->stopped = true;
+#endif
+   audio_driver_flush_thread_unlock(&audio_driver_st);
 
    if (stopped)
       RARCH_DBG("[Audio]: Stopped audio driver \"%s\"\n", audio_driver_st.current_audio->ident);
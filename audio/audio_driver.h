@@ -206,6 +206,14 @@ typedef struct
    const audio_driver_t *current_audio;
 
    void *context_audio_data;
+#ifdef HAVE_THREADS
+   /**
+    * Ring that hands core samples over to the flush thread,
+    * which then does all of the processing.
+    * NULL unless audio_flush_threaded is set.
+    */
+   struct audio_flush_ring *flush_ring;
+#endif
 
    /**
     * Scratch buffer for preparing data for the resampler
@@ -320,6 +328,21 @@ bool audio_driver_start(bool is_shutdown);
 
 bool audio_driver_stop(void);
 
+/**
+ * Gets the space left in the driver's buffer, in bytes. Samples
+ * still queued for the flush thread count as already written.
+ * Safe to call while the flush thread is running.
+ *
+ * @return The free space, or 0 if the driver can't report it.
+ */
+size_t audio_driver_write_avail(void);
+
+/**
+ * Switches the driver between blocking and nonblocking writes.
+ * Safe to call while the flush thread is running.
+ */
+void audio_driver_set_nonblock_state(bool nonblock);
+
 /**
  * If you need to query the size of audio samples,
  * use this function instead of checking the flags directly.
@@ -26,6 +26,7 @@
 #include <compat/posix_string.h>
 #include <string/stdstring.h>
 #include <retro_miscellaneous.h>
+#include <retro_inline.h>
 #include <features/features_cpu.h>
 
 #ifdef HAVE_CONFIG_H
@@ -48,6 +49,19 @@
 #include "dynamic.h"
 #include "core.h"
 #include "verbosity.h"
+#include "tasks/tasks_internal.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_CHEAT_SEARCH_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Once no more than 1/N of the memory still matches, searches
+ * walk a list of the matching addresses instead of the map */
+#define CHEAT_SEARCH_SPARSE_DIV 16
+
+/* Bytes of memory compared per search task step */
+#define CHEAT_SEARCH_STEP_SIZE  (4 << 20)
 
 /* TODO/FIXME - public global variables */
 cheat_manager_t cheat_manager_state;
@@ -325,6 +339,9 @@ static void cheat_manager_free(void)
    if (cheat_st->matches)
       free(cheat_st->matches);
 
+   if (cheat_st->candidates)
+      free(cheat_st->candidates);
+
    if (cheat_st->memory_buf_list)
       free(cheat_st->memory_buf_list);
 
@@ -339,10 +356,14 @@ static void cheat_manager_free(void)
    cheat_st->memory_buf_list           = NULL;
    cheat_st->memory_size_list          = NULL;
    cheat_st->matches                   = NULL;
+   cheat_st->candidates                = NULL;
+   cheat_st->num_candidates            = 0;
    cheat_st->num_memory_buffers        = 0;
    cheat_st->total_memory_size         = 0;
    cheat_st->memory_initialized        = false;
    cheat_st->memory_search_initialized = false;
+   /* Drops the result of a search still running */
+   cheat_st->search_generation++;
 }
 
 static void cheat_manager_new(unsigned size)
@@ -772,6 +793,23 @@ void cheat_manager_alloc_if_empty(void)
       cheat_manager_new(0);
 }
 
+/* Whether the candidate list tracks the matches of the
+ * current search size */
+static bool cheat_manager_has_candidates(const cheat_manager_t *cheat_st)
+{
+   return cheat_st->candidates
+      && cheat_st->search_bit_size >= 3
+      && cheat_st->candidates_bit_size == cheat_st->search_bit_size;
+}
+
+static void cheat_manager_free_candidates(cheat_manager_t *cheat_st)
+{
+   if (cheat_st->candidates)
+      free(cheat_st->candidates);
+   cheat_st->candidates     = NULL;
+   cheat_st->num_candidates = 0;
+}
+
 int cheat_manager_initialize_memory(rarch_setting_t *setting, size_t idx, bool wraparound)
 {
    unsigned i;
@@ -877,6 +915,9 @@ int cheat_manager_initialize_memory(rarch_setting_t *setting, size_t idx, bool w
 
    if (is_search_initialization)
    {
+      cheat_st->search_generation++;
+      cheat_manager_free_candidates(cheat_st);
+
       if (cheat_st->prev_memory_buf)
       {
          free(cheat_st->prev_memory_buf);
@@ -1009,142 +1050,635 @@ static void cheat_manager_setup_search_meta(
    }
 }
 
-static int cheat_manager_search(enum cheat_search_type search_type)
+static unsigned cheat_manager_read_value(const uint8_t *p,
+      unsigned bytes_per_item, bool big_endian)
 {
-   size_t _len;
-   char msg[100];
-   cheat_manager_t   *cheat_st = &cheat_manager_state;
-   unsigned char *curr         = cheat_st->curr_memory_buf;
-   unsigned char *prev         = cheat_st->prev_memory_buf;
-   unsigned int idx            = 0;
-   unsigned int curr_val       = 0;
-   unsigned int prev_val       = 0;
-   unsigned int mask           = 0;
-   unsigned int bytes_per_item = 1;
-   unsigned int bits           = 8;
-   unsigned int offset         = 0;
-   unsigned int i              = 0;
-#ifdef HAVE_MENU
-   struct menu_state *menu_st  = menu_state_get_ptr();
-#endif
+   switch (bytes_per_item)
+   {
+      case 2:
+         return big_endian
+            ? ((unsigned)p[0] << 8) | p[1]
+            : p[0] | ((unsigned)p[1] << 8);
+      case 4:
+         return big_endian
+            ? ((unsigned)p[0] << 24) | ((unsigned)p[1] << 16)
+            | ((unsigned)p[2] << 8)  | p[3]
+            : p[0] | ((unsigned)p[1] << 8)
+            | ((unsigned)p[2] << 16) | ((unsigned)p[3] << 24);
+      default:
+         break;
+   }
+   return p[0];
+}
 
-   if (cheat_st->num_memory_buffers == 0 || !prev || !cheat_st->matches)
+static bool cheat_manager_compare(enum cheat_search_type search_type,
+      unsigned curr, unsigned prev, unsigned value)
+{
+   switch (search_type)
    {
-      _len = strlcpy(msg, msg_hash_to_str(MSG_CHEAT_SEARCH_NOT_INITIALIZED), sizeof(msg));
-      runloop_msg_queue_push(msg, _len, 1, 180, true, NULL,
-            MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
-      return 0;
+      case CHEAT_SEARCH_TYPE_EXACT:
+         return curr == value;
+      case CHEAT_SEARCH_TYPE_LT:
+         return curr <  prev;
+      case CHEAT_SEARCH_TYPE_GT:
+         return curr >  prev;
+      case CHEAT_SEARCH_TYPE_LTE:
+         return curr <= prev;
+      case CHEAT_SEARCH_TYPE_GTE:
+         return curr >= prev;
+      case CHEAT_SEARCH_TYPE_EQ:
+         return curr == prev;
+      case CHEAT_SEARCH_TYPE_NEQ:
+         return curr != prev;
+      case CHEAT_SEARCH_TYPE_EQPLUS:
+         return curr == prev + value;
+      case CHEAT_SEARCH_TYPE_EQMINUS:
+         return curr == prev - value;
    }
+   return false;
+}
 
-   cheat_manager_setup_search_meta(cheat_st->search_bit_size, &bytes_per_item, &mask, &bits);
+static unsigned cheat_manager_popcount16(unsigned v)
+{
+   v = v - ((v >> 1) & 0x5555);
+   v = (v & 0x3333) + ((v >> 2) & 0x3333);
+   v = (v + (v >> 4)) & 0x0F0F;
+   return (v + (v >> 8)) & 0x1F;
+}
+
+enum cheat_search_phase
+{
+   CHEAT_SEARCH_PHASE_COMPARE = 0,
+   CHEAT_SEARCH_PHASE_CANDIDATES,
+   CHEAT_SEARCH_PHASE_DONE
+};
+
+/* One search pass. It owns the previous memory snapshot,
+ * the match map and the candidate list while it runs, so
+ * it never touches core memory or the menu's view of the
+ * cheat state from the task thread. */
+struct cheat_search
+{
+   uint8_t *curr;           /* Memory snapshot taken at the start */
+   uint8_t *prev;
+   uint8_t *matches;
+   uint32_t *candidates;    /* NULL when walking the match map */
+   size_t size;
+   size_t pos;              /* Bytes, or candidates, done so far */
+   unsigned num_candidates;
+   unsigned kept;           /* Candidates still matching */
+   unsigned num_matches;
+   unsigned removed;
+   unsigned generation;
+   unsigned bit_size;
+   unsigned bytes_per_item;
+   unsigned bits;
+   unsigned mask;
+   unsigned value;
+   enum cheat_search_type type;
+   enum cheat_search_phase phase;
+   bool big_endian;
+};
+
+static unsigned cheat_search_value(const cheat_manager_t *cheat_st,
+      enum cheat_search_type search_type)
+{
+   switch (search_type)
+   {
+      case CHEAT_SEARCH_TYPE_EXACT:
+         return cheat_st->search_exact_value;
+      case CHEAT_SEARCH_TYPE_EQPLUS:
+         return cheat_st->search_eqplus_value;
+      case CHEAT_SEARCH_TYPE_EQMINUS:
+         return cheat_st->search_eqminus_value;
+      default:
+         break;
+   }
+   return 0;
+}
 
-   /* little endian FF000000 = 256 */
-   for (idx = 0; idx < cheat_st->total_memory_size; idx = idx + bytes_per_item)
+/* Compares the items in [start, end) of the match map one at a
+ * time. Handles sub-byte sizes, and the tail the vector kernels
+ * leave over. */
+static void cheat_search_scalar(cheat_search_t *search,
+      size_t start, size_t end)
+{
+   size_t idx;
+   unsigned bits           = search->bits;
+   unsigned mask           = search->mask;
+   unsigned bytes_per_item = search->bytes_per_item;
+
+   for (idx = start; idx + bytes_per_item <= end; idx += bytes_per_item)
    {
       unsigned byte_part;
+      unsigned curr_val;
+      unsigned prev_val;
 
-      offset = translate_address(idx, &curr);
+      if (!search->matches[idx])
+         continue;
 
-      switch (bytes_per_item)
+      curr_val = cheat_manager_read_value(search->curr + idx,
+            bytes_per_item, search->big_endian);
+      prev_val = cheat_manager_read_value(search->prev + idx,
+            bytes_per_item, search->big_endian);
+
+      if (bits >= 8)
       {
-         case 2:
-            curr_val = cheat_st->big_endian ?
-               (*(curr + idx - offset) * 256) + *(curr + idx + 1 - offset) :
-               *(curr + idx - offset) + (*(curr + idx + 1 - offset) * 256);
-            prev_val = cheat_st->big_endian ?
-               (*(prev + idx) * 256) + *(prev + idx + 1) :
-               *(prev + idx) + (*(prev + idx + 1) * 256);
+         if (!cheat_manager_compare(search->type,
+                  curr_val, prev_val, search->value))
+         {
+            memset(search->matches + idx, 0, bytes_per_item);
+            search->removed++;
+         }
+         continue;
+      }
+
+      for (byte_part = 0; byte_part < 8 / bits; byte_part++)
+      {
+         unsigned part_mask = mask << (byte_part * bits);
+
+         if (!(search->matches[idx] & part_mask))
+            continue;
+
+         if (!cheat_manager_compare(search->type,
+                  (curr_val >> (byte_part * bits)) & mask,
+                  (prev_val >> (byte_part * bits)) & mask,
+                  search->value))
+         {
+            search->matches[idx] &= (~part_mask) & 0xFF;
+            search->removed++;
+         }
+      }
+   }
+}
+
+#if defined(HAVE_CHEAT_SEARCH_SSE2)
+/* The vector kernel compares 16 bytes of items at once. Items
+ * whose first match byte is clear are left alone, the others
+ * are cleared when they stop matching - same as the scalar
+ * path. Searches for a value wider than the item size keep the
+ * scalar path, the wraparound rules differ there. */
+static bool cheat_search_vectorizable(const cheat_search_t *search)
+{
+   if (search->bits < 8)
+      return false;
+
+   switch (search->type)
+   {
+      case CHEAT_SEARCH_TYPE_EXACT:
+      case CHEAT_SEARCH_TYPE_EQPLUS:
+      case CHEAT_SEARCH_TYPE_EQMINUS:
+         return search->value <= search->mask;
+      default:
+         break;
+   }
+   return true;
+}
+
+static INLINE __m128i cheat_search_cmpeq_sse2(__m128i a, __m128i b,
+      unsigned width)
+{
+   switch (width)
+   {
+      case 2:
+         return _mm_cmpeq_epi16(a, b);
+      case 4:
+         return _mm_cmpeq_epi32(a, b);
+   }
+   return _mm_cmpeq_epi8(a, b);
+}
+
+/* Signed compare, fed with sign-flipped values */
+static INLINE __m128i cheat_search_cmpgt_sse2(__m128i a, __m128i b,
+      unsigned width)
+{
+   switch (width)
+   {
+      case 2:
+         return _mm_cmpgt_epi16(a, b);
+      case 4:
+         return _mm_cmpgt_epi32(a, b);
+   }
+   return _mm_cmpgt_epi8(a, b);
+}
+
+static INLINE __m128i cheat_search_sub_sse2(__m128i a, __m128i b,
+      unsigned width)
+{
+   switch (width)
+   {
+      case 2:
+         return _mm_sub_epi16(a, b);
+      case 4:
+         return _mm_sub_epi32(a, b);
+   }
+   return _mm_sub_epi8(a, b);
+}
+
+static INLINE __m128i cheat_search_bswap_sse2(__m128i v, unsigned width)
+{
+   if (width < 2)
+      return v;
+   v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+   if (width == 4)
+      v = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+   return v;
+}
+
+static void cheat_search_sse2(cheat_search_t *search,
+      size_t start, size_t end)
+{
+   size_t i;
+   __m128i sign, first, k, ks;
+   unsigned width    = search->bytes_per_item;
+   __m128i zero      = _mm_setzero_si128();
+   __m128i ones      = _mm_cmpeq_epi8(zero, zero);
+
+   switch (width)
+   {
+      case 2:
+         sign  = _mm_set1_epi16((short)0x8000);
+         first = _mm_set1_epi16(0x00FF);
+         k     = _mm_set1_epi16((short)search->value);
+         break;
+      case 4:
+         sign  = _mm_set1_epi32((int)0x80000000);
+         first = _mm_set1_epi32(0x000000FF);
+         k     = _mm_set1_epi32((int)search->value);
+         break;
+      default:
+         sign  = _mm_set1_epi8((char)0x80);
+         first = ones;
+         k     = _mm_set1_epi8((char)search->value);
+         break;
+   }
+   ks = _mm_xor_si128(k, sign);
+
+   for (i = start; i + 16 <= end; i += 16)
+   {
+      __m128i c, p, cs, ps, cmp, alive, keep, gone;
+      __m128i m = _mm_loadu_si128((const __m128i*)(search->matches + i));
+
+      /* Nothing left to test here */
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(m, zero)) == 0xFFFF)
+         continue;
+
+      c  = _mm_loadu_si128((const __m128i*)(search->curr + i));
+      p  = _mm_loadu_si128((const __m128i*)(search->prev + i));
+
+      if (search->big_endian)
+      {
+         c = cheat_search_bswap_sse2(c, width);
+         p = cheat_search_bswap_sse2(p, width);
+      }
+
+      cs = _mm_xor_si128(c, sign);
+      ps = _mm_xor_si128(p, sign);
+
+      switch (search->type)
+      {
+         case CHEAT_SEARCH_TYPE_EXACT:
+            cmp = cheat_search_cmpeq_sse2(c, k, width);
             break;
-         case 4:
-            curr_val = cheat_st->big_endian ?
-               (*(curr + idx - offset) * 256 * 256 * 256) + (*(curr + idx + 1 - offset) * 256 * 256) + (*(curr + idx + 2 - offset) * 256) + *(curr + idx + 3 - offset) :
-               *(curr + idx - offset) + (*(curr + idx + 1 - offset) * 256) + (*(curr + idx + 2 - offset) * 256 * 256) + (*(curr + idx + 3 - offset) * 256 * 256 * 256);
-            prev_val = cheat_st->big_endian ?
-               (*(prev + idx) * 256 * 256 * 256) + (*(prev + idx + 1) * 256 * 256) + (*(prev + idx + 2) * 256) + *(prev + idx + 3) :
-               *(prev + idx) + (*(prev + idx + 1) * 256) + (*(prev + idx + 2) * 256 * 256) + (*(prev + idx + 3) * 256 * 256 * 256);
+         case CHEAT_SEARCH_TYPE_LT:
+            cmp = cheat_search_cmpgt_sse2(ps, cs, width);
             break;
-         case 1:
+         case CHEAT_SEARCH_TYPE_GT:
+            cmp = cheat_search_cmpgt_sse2(cs, ps, width);
+            break;
+         case CHEAT_SEARCH_TYPE_LTE:
+            cmp = _mm_xor_si128(cheat_search_cmpgt_sse2(cs, ps, width), ones);
+            break;
+         case CHEAT_SEARCH_TYPE_GTE:
+            cmp = _mm_xor_si128(cheat_search_cmpgt_sse2(ps, cs, width), ones);
+            break;
+         case CHEAT_SEARCH_TYPE_EQ:
+            cmp = cheat_search_cmpeq_sse2(c, p, width);
+            break;
+         case CHEAT_SEARCH_TYPE_NEQ:
+            cmp = _mm_xor_si128(cheat_search_cmpeq_sse2(c, p, width), ones);
+            break;
+         case CHEAT_SEARCH_TYPE_EQPLUS:
+            /* curr == prev + value, without wrapping unless
+             * the item is 32 bits wide */
+            cmp = cheat_search_cmpeq_sse2(
+                  cheat_search_sub_sse2(c, p, width), k, width);
+            if (width < 4)
+               cmp = _mm_andnot_si128(
+                     cheat_search_cmpgt_sse2(ks, cs, width), cmp);
+            break;
+         case CHEAT_SEARCH_TYPE_EQMINUS:
          default:
-            curr_val = *(curr - offset + idx);
-            prev_val = *(prev + idx);
+            cmp = cheat_search_cmpeq_sse2(
+                  cheat_search_sub_sse2(p, c, width), k, width);
+            if (width < 4)
+               cmp = _mm_andnot_si128(
+                     cheat_search_cmpgt_sse2(ks, ps, width), cmp);
             break;
       }
 
-      for (byte_part = 0; byte_part < 8 / bits; byte_part++)
+      alive = _mm_xor_si128(cheat_search_cmpeq_sse2(
+               _mm_and_si128(m, first), zero, width), ones);
+      gone  = _mm_andnot_si128(cmp, alive);
+      keep  = _mm_xor_si128(gone, ones);
+
+      _mm_storeu_si128((__m128i*)(search->matches + i),
+            _mm_and_si128(m, keep));
+      search->removed += cheat_manager_popcount16(
+            (unsigned)_mm_movemask_epi8(gone)) / width;
+   }
+}
+#endif
+
+static void cheat_search_map(cheat_search_t *search,
+      size_t start, size_t end)
+{
+#if defined(HAVE_CHEAT_SEARCH_SSE2)
+   if (cheat_search_vectorizable(search))
+   {
+      size_t vec_end = start + ((end - start) & ~(size_t)15);
+      cheat_search_sse2(search, start, vec_end);
+      start = vec_end;
+   }
+#endif
+   cheat_search_scalar(search, start, end);
+}
+
+static void cheat_search_list(cheat_search_t *search,
+      size_t start, size_t end)
+{
+   size_t i;
+   unsigned bytes_per_item = search->bytes_per_item;
+
+   for (i = start; i < end; i++)
+   {
+      uint32_t idx = search->candidates[i];
+
+      if (!search->matches[idx])
+         continue;
+
+      if (cheat_manager_compare(search->type,
+               cheat_manager_read_value(search->curr + idx,
+                  bytes_per_item, search->big_endian),
+               cheat_manager_read_value(search->prev + idx,
+                  bytes_per_item, search->big_endian),
+               search->value))
+         search->candidates[search->kept++] = idx;
+      else
       {
-         unsigned int curr_subval = (curr_val >> (byte_part * bits)) & mask;
-         unsigned int prev_subval = (prev_val >> (byte_part * bits)) & mask;
-         unsigned int prev_match;
+         memset(search->matches + idx, 0, bytes_per_item);
+         search->removed++;
+      }
+   }
+}
 
-         if (bits < 8)
-            prev_match = *(cheat_st->matches + idx) & (mask << (byte_part * bits));
-         else
-            prev_match = *(cheat_st->matches + idx);
+/* Collects the remaining matches into a candidate list, once
+ * there are few enough of them */
+static void cheat_search_build_candidates(cheat_search_t *search)
+{
+   size_t idx;
+   unsigned count          = 0;
+   unsigned num_matches    = search->num_matches > search->removed
+      ? search->num_matches - search->removed : 0;
+   unsigned bytes_per_item = search->bytes_per_item;
+
+   if (     search->bits < 8
+         || search->candidates
+         || num_matches > search->size / CHEAT_SEARCH_SPARSE_DIV)
+      return;
 
-         if (prev_match > 0)
-         {
-            bool match = false;
-            switch (search_type)
-            {
-               case CHEAT_SEARCH_TYPE_EXACT:
-                  match = (curr_subval == cheat_st->search_exact_value);
-                  break;
-               case CHEAT_SEARCH_TYPE_LT:
-                  match = (curr_subval < prev_subval);
-                  break;
-               case CHEAT_SEARCH_TYPE_GT:
-                  match = (curr_subval > prev_subval);
-                  break;
-               case CHEAT_SEARCH_TYPE_LTE:
-                  match = (curr_subval <= prev_subval);
-                  break;
-               case CHEAT_SEARCH_TYPE_GTE:
-                  match = (curr_subval >= prev_subval);
-                  break;
-               case CHEAT_SEARCH_TYPE_EQ:
-                  match = (curr_subval == prev_subval);
-                  break;
-               case CHEAT_SEARCH_TYPE_NEQ:
-                  match = (curr_subval != prev_subval);
-                  break;
-               case CHEAT_SEARCH_TYPE_EQPLUS:
-                  match = (curr_subval == prev_subval + cheat_st->search_eqplus_value);
-                  break;
-               case CHEAT_SEARCH_TYPE_EQMINUS:
-                  match = (curr_subval == prev_subval - cheat_st->search_eqminus_value);
-                  break;
-            }
+   if (!(search->candidates = (uint32_t*)malloc(
+         MAX(num_matches, 1) * sizeof(uint32_t))))
+      return;
 
-            if (!match)
-            {
-               if (bits < 8)
-                  *(cheat_st->matches + idx) = *(cheat_st->matches + idx) &
-                     ((~(mask << (byte_part * bits))) & 0xFF);
-               else
-                  memset(cheat_st->matches + idx, 0, bytes_per_item);
-               if (cheat_st->num_matches > 0)
-                  cheat_st->num_matches--;
-            }
-         }
+   for (idx = 0; idx + bytes_per_item <= search->size;
+         idx += bytes_per_item)
+   {
+      if (!search->matches[idx])
+         continue;
+
+      /* The match map disagrees with the match count */
+      if (count == num_matches)
+      {
+         free(search->candidates);
+         search->candidates = NULL;
+         return;
       }
+
+      search->candidates[count++] = (uint32_t)idx;
    }
 
-   offset = 0;
+   search->num_candidates = count;
+   search->kept           = count;
+}
+
+cheat_search_t *cheat_manager_search_begin(
+      enum cheat_search_type search_type)
+{
+   unsigned i;
+   size_t offset             = 0;
+   cheat_manager_t *cheat_st = &cheat_manager_state;
+   cheat_search_t *search    = NULL;
+
+   if (     cheat_st->search_running
+         || cheat_st->num_memory_buffers == 0
+         || !cheat_st->prev_memory_buf
+         || !cheat_st->matches)
+      return NULL;
+
+   if (!(search = (cheat_search_t*)calloc(1, sizeof(*search))))
+      return NULL;
+
+   if (!(search->curr = (uint8_t*)malloc(
+         MAX(cheat_st->total_memory_size, 1))))
+   {
+      free(search);
+      return NULL;
+   }
 
    for (i = 0; i < cheat_st->num_memory_buffers; i++)
    {
-      memcpy(cheat_st->prev_memory_buf + offset, cheat_st->memory_buf_list[i], cheat_st->memory_size_list[i]);
+      memcpy(search->curr + offset,
+            cheat_st->memory_buf_list[i],
+            cheat_st->memory_size_list[i]);
       offset += cheat_st->memory_size_list[i];
    }
 
-   _len = snprintf(msg, sizeof(msg), msg_hash_to_str(MSG_CHEAT_SEARCH_FOUND_MATCHES), cheat_st->num_matches);
-   runloop_msg_queue_push(msg, _len, 1, 180, true, NULL,
-         MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+   cheat_manager_setup_search_meta(cheat_st->search_bit_size,
+         &search->bytes_per_item, &search->mask, &search->bits);
+
+   if (!cheat_manager_has_candidates(cheat_st))
+      cheat_manager_free_candidates(cheat_st);
+
+   search->prev              = cheat_st->prev_memory_buf;
+   search->matches           = cheat_st->matches;
+   search->candidates        = cheat_st->candidates;
+   search->num_candidates    = cheat_st->num_candidates;
+   search->size              = cheat_st->total_memory_size;
+   search->num_matches       = cheat_st->num_matches;
+   search->generation        = cheat_st->search_generation;
+   search->bit_size          = cheat_st->search_bit_size;
+   search->value             = cheat_search_value(cheat_st, search_type);
+   search->type              = search_type;
+   search->big_endian        = cheat_st->big_endian;
+   search->phase             = CHEAT_SEARCH_PHASE_COMPARE;
+
+   /* The search owns these until it ends */
+   cheat_st->prev_memory_buf = NULL;
+   cheat_st->matches         = NULL;
+   cheat_st->candidates      = NULL;
+   cheat_st->num_candidates  = 0;
+   cheat_st->search_running  = true;
+
+   return search;
+}
+
+bool cheat_manager_search_iterate(cheat_search_t *search)
+{
+   switch (search->phase)
+   {
+      case CHEAT_SEARCH_PHASE_COMPARE:
+         if (search->candidates)
+         {
+            size_t end = MIN(search->pos + CHEAT_SEARCH_STEP_SIZE
+                  / sizeof(uint32_t), search->num_candidates);
+            cheat_search_list(search, search->pos, end);
+            search->pos = end;
+
+            if (end < search->num_candidates)
+               return false;
+
+            search->num_candidates = search->kept;
+         }
+         else
+         {
+            /* Steps stay item aligned */
+            size_t end = MIN(search->pos + CHEAT_SEARCH_STEP_SIZE,
+                  search->size);
+            cheat_search_map(search, search->pos, end);
+            search->pos = end;
+
+            if (end < search->size)
+               return false;
+         }
+         search->phase = CHEAT_SEARCH_PHASE_CANDIDATES;
+         return false;
+      case CHEAT_SEARCH_PHASE_CANDIDATES:
+         cheat_search_build_candidates(search);
+         search->phase = CHEAT_SEARCH_PHASE_DONE;
+         break;
+      case CHEAT_SEARCH_PHASE_DONE:
+         break;
+   }
+
+   return true;
+}
+
+unsigned cheat_manager_search_progress(const cheat_search_t *search)
+{
+   size_t total;
+
+   if (search->phase != CHEAT_SEARCH_PHASE_COMPARE)
+      return 100;
+
+   total = search->candidates ? search->num_candidates : search->size;
+   if (!total)
+      return 100;
+   return (unsigned)((search->pos * 100) / total);
+}
+
+void cheat_manager_search_end(cheat_search_t *search)
+{
+   cheat_manager_t *cheat_st = &cheat_manager_state;
+#ifdef HAVE_MENU
+   struct menu_state *menu_st  = menu_state_get_ptr();
+#endif
+
+   cheat_st->search_running  = false;
+
+   /* Memory was reinitialized or freed in the meantime */
+   if (search->generation != cheat_st->search_generation)
+   {
+      free(search->prev);
+      free(search->matches);
+      free(search->candidates);
+      free(search->curr);
+      free(search);
+      return;
+   }
+
+   /* A search stopped halfway keeps the untested candidates */
+   if (     search->candidates
+         && search->phase == CHEAT_SEARCH_PHASE_COMPARE)
+   {
+      memmove(search->candidates + search->kept,
+            search->candidates + search->pos,
+            (search->num_candidates - search->pos) * sizeof(uint32_t));
+      search->num_candidates = search->kept
+         + (unsigned)(search->num_candidates - search->pos);
+   }
+
+   free(search->prev);
+
+   cheat_st->prev_memory_buf     = search->curr;
+   cheat_st->matches             = search->matches;
+   cheat_st->candidates          = search->candidates;
+   cheat_st->num_candidates      = search->candidates
+      ? search->num_candidates : 0;
+   cheat_st->candidates_bit_size = search->bit_size;
+
+   if (search->candidates)
+      cheat_st->num_matches      = search->num_candidates;
+   else if (cheat_st->num_matches > search->removed)
+      cheat_st->num_matches     -= search->removed;
+   else
+      cheat_st->num_matches      = 0;
+
+   free(search);
+
+   {
+      char msg[100];
+      size_t _len = snprintf(msg, sizeof(msg),
+            msg_hash_to_str(MSG_CHEAT_SEARCH_FOUND_MATCHES),
+            cheat_st->num_matches);
+      runloop_msg_queue_push(msg, _len, 1, 180, true, NULL,
+            MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+   }
 
 #ifdef HAVE_MENU
    menu_st->flags                 |=  MENU_ST_FLAG_ENTRIES_NEED_REFRESH
                                    |  MENU_ST_FLAG_PREVENT_POPULATE;
 #endif
+}
+
+static int cheat_manager_search(enum cheat_search_type search_type)
+{
+   cheat_search_t *search      = NULL;
+   cheat_manager_t   *cheat_st = &cheat_manager_state;
+
+   if (cheat_st->search_running)
+   {
+      const char *_msg = msg_hash_to_str(MSG_CHEAT_SEARCH_IN_PROGRESS);
+      runloop_msg_queue_push(_msg, strlen(_msg), 1, 180, true, NULL,
+            MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+      return 0;
+   }
+
+   if (!(search = cheat_manager_search_begin(search_type)))
+   {
+      const char *_msg = msg_hash_to_str(MSG_CHEAT_SEARCH_NOT_INITIALIZED);
+      runloop_msg_queue_push(_msg, strlen(_msg), 1, 180, true, NULL,
+            MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+      return 0;
+   }
+
+   /* Search right away if no task could be started */
+   if (!task_push_cheat_search(search))
+   {
+      while (!cheat_manager_search_iterate(search));
+      cheat_manager_search_end(search);
+   }
+
    return 0;
 }
 
@@ -1235,6 +1769,22 @@ int cheat_manager_add_matches(const char *path,
    struct menu_state *menu_st  = menu_state_get_ptr();
 #endif
 
+   if (cheat_st->search_running)
+   {
+      _len = strlcpy(msg, msg_hash_to_str(MSG_CHEAT_SEARCH_IN_PROGRESS), sizeof(msg));
+      runloop_msg_queue_push(msg, _len, 1, 180, true, NULL,
+            MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+      return 0;
+   }
+
+   if (!cheat_st->matches)
+   {
+      _len = strlcpy(msg, msg_hash_to_str(MSG_CHEAT_SEARCH_NOT_INITIALIZED), sizeof(msg));
+      runloop_msg_queue_push(msg, _len, 1, 180, true, NULL,
+            MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+      return 0;
+   }
+
    if (cheat_st->num_matches + cheat_st->size > 100)
    {
       _len = strlcpy(msg, msg_hash_to_str(MSG_CHEAT_SEARCH_ADDED_MATCHES_TOO_MANY), sizeof(msg));
@@ -1244,62 +1794,86 @@ int cheat_manager_add_matches(const char *path,
    }
    cheat_manager_setup_search_meta(cheat_st->search_bit_size, &bytes_per_item, &mask, &bits);
 
-   for (idx = 0; idx < cheat_st->total_memory_size; idx = idx + bytes_per_item)
+   if (cheat_manager_has_candidates(cheat_st))
    {
-      offset = translate_address(idx, &curr);
+      unsigned i;
 
-      switch (bytes_per_item)
+      for (i = 0; i < cheat_st->num_candidates; i++)
       {
-         case 2:
-            curr_val = cheat_st->big_endian ?
-               (*(curr + idx - offset) * 256) + *(curr + idx + 1 - offset) :
-               *(curr + idx - offset) + (*(curr + idx + 1 - offset) * 256);
-            break;
-         case 4:
-            curr_val = cheat_st->big_endian ?
-               (*(curr + idx - offset) * 256 * 256 * 256) + (*(curr + idx + 1 - offset) * 256 * 256) + (*(curr + idx + 2 - offset) * 256) + *(curr + idx + 3 - offset) :
-               *(curr + idx - offset) + (*(curr + idx + 1 - offset) * 256) + (*(curr + idx + 2 - offset) * 256 * 256) + (*(curr + idx + 3 - offset) * 256 * 256 * 256);
-            break;
-         case 1:
-         default:
-            curr_val = *(curr - offset + idx);
-            break;
+         idx      = cheat_st->candidates[i];
+         offset   = translate_address(idx, &curr);
+         curr_val = cheat_manager_read_value(curr + idx - offset,
+               bytes_per_item, cheat_st->big_endian);
+
+         if (!cheat_manager_add_new_code(cheat_st->search_bit_size, idx, 0xFF,
+                  cheat_st->big_endian, curr_val))
+         {
+            _len = strlcpy(msg, msg_hash_to_str(MSG_CHEAT_SEARCH_ADDED_MATCHES_FAIL), sizeof(msg));
+            runloop_msg_queue_push(msg, _len, 1, 180, true, NULL,
+                  MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+            return 0;
+         }
       }
-      for (byte_part = 0; byte_part < 8 / bits; byte_part++)
+   }
+   else
+   {
+      for (idx = 0; idx < cheat_st->total_memory_size; idx = idx + bytes_per_item)
       {
-         unsigned int prev_match;
+         offset = translate_address(idx, &curr);
 
-         if (bits < 8)
+         switch (bytes_per_item)
          {
-            prev_match = *(cheat_st->matches + idx) & (mask << (byte_part * bits));
-            if (prev_match)
+            case 2:
+               curr_val = cheat_st->big_endian ?
+                  (*(curr + idx - offset) * 256) + *(curr + idx + 1 - offset) :
+                  *(curr + idx - offset) + (*(curr + idx + 1 - offset) * 256);
+               break;
+            case 4:
+               curr_val = cheat_st->big_endian ?
+                  (*(curr + idx - offset) * 256 * 256 * 256) + (*(curr + idx + 1 - offset) * 256 * 256) + (*(curr + idx + 2 - offset) * 256) + *(curr + idx + 3 - offset) :
+                  *(curr + idx - offset) + (*(curr + idx + 1 - offset) * 256) + (*(curr + idx + 2 - offset) * 256 * 256) + (*(curr + idx + 3 - offset) * 256 * 256 * 256);
+               break;
+            case 1:
+            default:
+               curr_val = *(curr - offset + idx);
+               break;
+         }
+         for (byte_part = 0; byte_part < 8 / bits; byte_part++)
+         {
+            unsigned int prev_match;
+
+            if (bits < 8)
             {
-               if (!cheat_manager_add_new_code(cheat_st->search_bit_size, idx, (mask << (byte_part * bits)),
-                        cheat_st->big_endian, curr_val))
+               prev_match = *(cheat_st->matches + idx) & (mask << (byte_part * bits));
+               if (prev_match)
                {
-                  _len = strlcpy(msg, msg_hash_to_str(MSG_CHEAT_SEARCH_ADDED_MATCHES_FAIL), sizeof(msg));
-                  runloop_msg_queue_push(msg, _len, 1, 180, true, NULL,
-                        MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
-                  return 0;
+                  if (!cheat_manager_add_new_code(cheat_st->search_bit_size, idx, (mask << (byte_part * bits)),
+                           cheat_st->big_endian, curr_val))
+                  {
+                     _len = strlcpy(msg, msg_hash_to_str(MSG_CHEAT_SEARCH_ADDED_MATCHES_FAIL), sizeof(msg));
+                     runloop_msg_queue_push(msg, _len, 1, 180, true, NULL,
+                           MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+                     return 0;
+                  }
                }
             }
-         }
-         else
-         {
-            prev_match = *(cheat_st->matches + idx);
-            if (prev_match)
+            else
             {
-               if (!cheat_manager_add_new_code(cheat_st->search_bit_size, idx, 0xFF,
-                        cheat_st->big_endian, curr_val))
+               prev_match = *(cheat_st->matches + idx);
+               if (prev_match)
                {
-                  _len = strlcpy(msg, msg_hash_to_str(MSG_CHEAT_SEARCH_ADDED_MATCHES_FAIL), sizeof(msg));
-                  runloop_msg_queue_push(msg, _len, 1, 180, true, NULL,
-                        MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
-                  return 0;
+                  if (!cheat_manager_add_new_code(cheat_st->search_bit_size, idx, 0xFF,
+                           cheat_st->big_endian, curr_val))
+                  {
+                     _len = strlcpy(msg, msg_hash_to_str(MSG_CHEAT_SEARCH_ADDED_MATCHES_FAIL), sizeof(msg));
+                     runloop_msg_queue_push(msg, _len, 1, 180, true, NULL,
+                           MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+                     return 0;
+                  }
                }
             }
-         }
 
+         }
       }
    }
 
@@ -1623,6 +2197,58 @@ void cheat_manager_match_action(enum cheat_match_action_type match_action, unsig
 
    cheat_manager_setup_search_meta(cheat_st->search_bit_size, &bytes_per_item, &mask, &bits);
 
+   /* With a candidate list, the match is a direct lookup */
+   if (     match_action != CHEAT_MATCH_ACTION_TYPE_BROWSE
+         && prev
+         && cheat_manager_has_candidates(cheat_st))
+   {
+      const char *_msg = NULL;
+
+      if (target_match_idx >= cheat_st->num_candidates)
+         return;
+
+      idx      = cheat_st->candidates[target_match_idx];
+      offset   = translate_address(idx, &curr);
+      curr_val = cheat_manager_read_value(curr + idx - offset,
+            bytes_per_item, cheat_st->big_endian);
+      prev_val = cheat_manager_read_value(prev + idx,
+            bytes_per_item, cheat_st->big_endian);
+
+      switch (match_action)
+      {
+         case CHEAT_MATCH_ACTION_TYPE_VIEW:
+            *address      = idx;
+            *address_mask = 0xFF;
+            *curr_value   = curr_val;
+            *prev_value   = prev_val;
+            return;
+         case CHEAT_MATCH_ACTION_TYPE_COPY:
+            if (!cheat_manager_add_new_code(cheat_st->search_bit_size, idx, 0xFF,
+                  cheat_st->big_endian, curr_val))
+               _msg = msg_hash_to_str(MSG_CHEAT_SEARCH_ADD_MATCH_FAIL);
+            else
+               _msg = msg_hash_to_str(MSG_CHEAT_SEARCH_ADD_MATCH_SUCCESS);
+            break;
+         case CHEAT_MATCH_ACTION_TYPE_DELETE:
+            memset(cheat_st->matches + idx, 0, bytes_per_item);
+            memmove(cheat_st->candidates + target_match_idx,
+                  cheat_st->candidates + target_match_idx + 1,
+                  (cheat_st->num_candidates - target_match_idx - 1)
+                  * sizeof(uint32_t));
+            cheat_st->num_candidates--;
+            if (cheat_st->num_matches > 0)
+               cheat_st->num_matches--;
+            _msg = msg_hash_to_str(MSG_CHEAT_SEARCH_DELETE_MATCH_SUCCESS);
+            break;
+         default:
+            return;
+      }
+
+      runloop_msg_queue_push(_msg, strlen(_msg), 1, 180, true, NULL,
+            MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+      return;
+   }
+
    if (match_action == CHEAT_MATCH_ACTION_TYPE_BROWSE)
       start_idx = *address;
    else
@@ -162,6 +162,7 @@ struct cheat_manager
    uint8_t *curr_memory_buf;
    uint8_t *prev_memory_buf;
    uint8_t *matches;
+   uint32_t *candidates;            /* Matching addresses, once few are left */
    uint8_t **memory_buf_list;
    unsigned *memory_size_list;
    unsigned int delete_state;
@@ -180,16 +181,22 @@ struct cheat_manager
    unsigned search_eqplus_value;
    unsigned search_eqminus_value;
    unsigned num_matches;
+   unsigned num_candidates;
+   unsigned candidates_bit_size;
+   unsigned search_generation;
    unsigned browse_address;
    char working_desc[CHEAT_DESC_SCRATCH_SIZE];
    char working_code[CHEAT_CODE_SCRATCH_SIZE];
    bool  big_endian;
    bool  memory_initialized;
    bool  memory_search_initialized;
+   bool  search_running;
 };
 
 typedef struct cheat_manager cheat_manager_t;
 
+typedef struct cheat_search cheat_search_t;
+
 extern cheat_manager_t cheat_manager_state;
 
 unsigned cheat_manager_get_size(void);
@@ -265,6 +272,42 @@ int cheat_manager_search_eqplus(rarch_setting_t *setting, size_t idx, bool wrapa
 
 int cheat_manager_search_eqminus(rarch_setting_t *setting, size_t idx, bool wraparound);
 
+/**
+ * cheat_manager_search_begin:
+ * @search_type               : Comparison to run.
+ *
+ * Snapshots the searched memory and takes over the match
+ * state, so that the search can run on another thread. The
+ * match state reads as uninitialized until the search ends.
+ *
+ * Returns: search handle, or NULL if no search can be started.
+ **/
+cheat_search_t *cheat_manager_search_begin(
+      enum cheat_search_type search_type);
+
+/**
+ * cheat_manager_search_iterate:
+ * @search                    : Search handle.
+ *
+ * Runs one bounded step of the search. Safe to call from
+ * any thread, it only touches the search handle.
+ *
+ * Returns: true (1) once the search is complete.
+ **/
+bool cheat_manager_search_iterate(cheat_search_t *search);
+
+unsigned cheat_manager_search_progress(const cheat_search_t *search);
+
+/**
+ * cheat_manager_search_end:
+ * @search                    : Search handle, freed on return.
+ *
+ * Hands the updated match state back and reports the match
+ * count. A search that did not complete keeps the matches it
+ * had not tested yet. Must be called from the main thread.
+ **/
+void cheat_manager_search_end(cheat_search_t *search);
+
 unsigned cheat_manager_get_state_search_size(unsigned search_size);
 
 int cheat_manager_add_matches(const char *path,
@@ -813,6 +813,48 @@ bool command_play_replay_slot(command_t *cmd, const char *arg)
 #endif
 }
 
+bool command_seek_replay(command_t *cmd, const char *arg)
+{
+#ifdef HAVE_BSV_MOVIE
+   char reply[128]                = "";
+   input_driver_state_t *input_st = input_state_get_ptr();
+   uint64_t frame                 = strtoull(arg, NULL, 10);
+   bool ret                       = bsv_movie_seek(input_st, frame);
+
+   /* The seek finishes over the next frames */
+   if (ret)
+      snprintf(reply, sizeof(reply) - 1, "SEEK_REPLAY %llu",
+            (unsigned long long)frame);
+   else
+      snprintf(reply, sizeof(reply) - 1, "SEEK_REPLAY -1");
+
+   cmd->replier(cmd, reply, strlen(reply));
+   return ret;
+#else
+   return false;
+#endif
+}
+
+bool command_seek_rewind(command_t *cmd, const char *arg)
+{
+#ifdef HAVE_REWIND
+   char reply[128]                = "";
+   runloop_state_t *runloop_st    = runloop_state_get_ptr();
+   unsigned frames_back           = (unsigned)strtoul(arg, NULL, 10);
+   bool ret                       = state_manager_seek(
+         &runloop_st->rewind_st, frames_back);
+
+   if (ret)
+      snprintf(reply, sizeof(reply) - 1, "SEEK_REWIND %u", frames_back);
+   else
+      snprintf(reply, sizeof(reply) - 1, "SEEK_REWIND -1");
+
+   cmd->replier(cmd, reply, strlen(reply));
+   return ret;
+#else
+   return false;
+#endif
+}
 
 #if defined(HAVE_CHEEVOS)
 bool command_read_ram(command_t *cmd, const char *arg)
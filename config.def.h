@@ -442,6 +442,16 @@
 #define DEFAULT_VIDEO_THREADED false
 #endif
 
+/* Threaded video: hand the core a frame slot of the video
+ * thread as its software framebuffer, saving one copy per frame.
+ */
+#define DEFAULT_VIDEO_THREADED_ZERO_COPY false
+
+/* Network video driver: send only the tiles that changed,
+ * compressed, from a separate thread, instead of raw frames.
+ */
+#define DEFAULT_VIDEO_NETWORK_STREAM false
+
 #if defined(HAVE_THREADS)
 #if defined(GEKKO) || defined(PSP) || defined(PS2)
 /* For single-core consoles right now it's best to have this be disabled. */
@@ -514,6 +524,10 @@
 
 #define DEFAULT_SHADER_DELAY 0
 
+/* Size limit in megabytes of the on-disk cache of compiled
+ * slang shaders. 0 disables the cache. */
+#define DEFAULT_VIDEO_SHADER_CACHE_SIZE 64
+
 /* Only scale in integer steps.
  * The base size depends on system-reported geometry and aspect ratio.
  * If video_force_aspect is not set, X/Y will be integer scaled independently.
@@ -1193,6 +1207,10 @@
 #define DEFAULT_RATE_CONTROL false
 #endif
 
+/* Runs audio DSP, resampling and mixing on a separate
+ * flush thread, so the core only has to copy its samples. */
+#define DEFAULT_AUDIO_FLUSH_THREADED false
+
 /* Rate control delta. Defines how much rate_control
  * is allowed to adjust input rate. */
 #define DEFAULT_RATE_CONTROL_DELTA  0.005f
@@ -1264,6 +1282,29 @@
  * depending on the save state buffer. */
 #define DEFAULT_REWIND_ENABLE false
 
+/* Computes rewind deltas on a helper thread while the
+ * next frame runs. Costs one extra save state worth
+ * of memory. */
+#ifdef HAVE_THREADS
+#define DEFAULT_REWIND_THREADED true
+#else
+#define DEFAULT_REWIND_THREADED false
+#endif
+
+/* Keeps a full copy of every Nth rewind state, so that
+ * seeking far back doesn't have to undo every delta.
+ * 0 disables them. */
+#define DEFAULT_REWIND_KEYFRAME_INTERVAL 60
+
+/* Memory available to rewind keyframes, in percent of
+ * the rewind buffer size, in addition to the rewind
+ * buffer itself. The oldest keyframes are dropped
+ * once it is used up. */
+#define DEFAULT_REWIND_KEYFRAME_BUDGET 25
+
+/* Compresses keyframes with LZ4. */
+#define DEFAULT_REWIND_KEYFRAME_COMPRESS true
+
 /* When set, any time a cheat is toggled it is immediately applied. */
 #define DEFAULT_APPLY_CHEATS_AFTER_TOGGLE false
 
@@ -1416,6 +1457,11 @@
 #define DEFAULT_SAVESTATE_FILE_COMPRESSION true
 #endif
 
+/* When compressing automatic, undo and RAM save
+ * states, use a fast codec (LZ4) instead of zlib.
+ * Older frontends can't read these files. */
+#define DEFAULT_SAVESTATE_FAST_COMPRESSION true
+
 /* Slowmotion ratio. */
 #define DEFAULT_SLOWMOTION_RATIO 3.0f
 
@@ -1479,6 +1525,15 @@
 /* When creating/updating playlists, compress written data */
 #define DEFAULT_PLAYLIST_COMPRESSION false
 
+/* When updating playlists, append changes to a journal
+ * next to the playlist file instead of rewriting it */
+#define DEFAULT_PLAYLIST_JOURNAL false
+
+/* When loading playlists, keep a binary copy next to
+ * each playlist file that can be mapped directly
+ * instead of parsing the playlist */
+#define DEFAULT_PLAYLIST_CACHE false
+
 #ifdef HAVE_MENU
 /* Specify when to display 'core name' inline on playlist entries */
 #define DEFAULT_PLAYLIST_SHOW_INLINE_CORE_NAME PLAYLIST_INLINE_CORE_DISPLAY_HIST_FAV
@@ -1496,6 +1551,18 @@
 
 #define DEFAULT_SCAN_SERIAL_AND_CRC false
 
+/* Remember the CRC32/serial of scanned and loaded
+ * content, so that unchanged files are not read
+ * again on the next scan or launch */
+#define DEFAULT_CONTENT_FINGERPRINT_CACHE true
+
+/* Memory map uncompressed content for cores that
+ * load it from memory, instead of reading it into
+ * a buffer first. Truncating a mapped file while
+ * the core runs raises SIGBUS (outside Windows,
+ * which doesn't allow it). */
+#define DEFAULT_CONTENT_MEMORY_MAP true
+
 #ifdef __WINRT__
 /* Be paranoid about WinRT file I/O performance, and leave this disabled by
  * default */
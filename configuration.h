@@ -228,6 +228,8 @@ typedef struct settings
       unsigned libretro_log_level;
       unsigned rewind_granularity;
       unsigned rewind_buffer_size_step;
+      unsigned rewind_keyframe_interval;
+      unsigned rewind_keyframe_budget;
       unsigned autosave_interval;
       unsigned replay_checkpoint_interval;
       unsigned replay_max_keep;
@@ -271,6 +273,7 @@ typedef struct settings
       unsigned video_overscan_correction_bottom;
 #endif
       unsigned video_shader_delay;
+      unsigned video_shader_cache_size;
 #ifdef HAVE_SCREENSHOTS
       unsigned notification_show_screenshot_duration;
       unsigned notification_show_screenshot_flash;
@@ -627,6 +630,7 @@ typedef struct settings
       bool video_shader_preset_save_reference_enable;
       bool video_scan_subframes;
       bool video_threaded;
+      bool video_threaded_zero_copy;
       bool video_font_enable;
       bool video_disable_composition;
       bool video_post_filter_record;
@@ -634,6 +638,7 @@ typedef struct settings
       bool video_gpu_screenshot;
       bool video_allow_rotate;
       bool video_shared_context;
+      bool video_network_stream;
       bool video_force_srgb_disable;
       bool video_fps_show;
       bool video_statistics_show;
@@ -661,6 +666,7 @@ typedef struct settings
       bool audio_enable_menu_scroll;
       bool audio_sync;
       bool audio_rate_control;
+      bool audio_flush_threaded;
       bool audio_fastforward_mute;
       bool audio_fastforward_speedup;
       bool audio_rewind_mute;
@@ -989,6 +995,8 @@ typedef struct settings
       bool history_list_enable;
       bool playlist_entry_rename;
       bool rewind_enable;
+      bool rewind_threaded;
+      bool rewind_keyframe_compress;
       bool fastforward_frameskip;
       bool vrr_runloop_enable;
       bool menu_throttle_framerate;
@@ -1008,6 +1016,7 @@ typedef struct settings
       bool savestate_thumbnail_enable;
       bool save_file_compression;
       bool savestate_file_compression;
+      bool savestate_fast_compression;
       bool network_cmd_enable;
       bool stdin_cmd_enable;
       bool keymapper_enable;
@@ -1060,6 +1069,8 @@ typedef struct settings
       bool sustained_performance_mode;
       bool playlist_use_old_format;
       bool playlist_compression;
+      bool playlist_journal;
+      bool playlist_cache;
       bool content_runtime_log;
       bool content_runtime_log_aggregate;
 
@@ -1084,6 +1095,8 @@ typedef struct settings
 
       bool scan_without_core_match;
       bool scan_serial_and_crc;
+      bool content_fingerprint_cache;
+      bool content_memory_map;
 
       bool ai_service_enable;
       bool ai_service_pause;
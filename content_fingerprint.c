@@ -0,0 +1,706 @@
+/* Copyright  (C) 2010-2026 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (content_fingerprint.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <compat/strl.h>
+#include <retro_miscellaneous.h>
+#include <string/stdstring.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <array/rbuf.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "content_fingerprint.h"
+#ifdef HAVE_LIBRETRODB
+#include "tasks/task_database_cue.h"
+#endif
+#include "configuration.h"
+#include "file_path_special.h"
+#include "paths.h"
+#include "verbosity.h"
+
+/* On-disk layout (host byte order, the cache is
+ * never shared between machines):
+ * > content_fingerprint_header_t
+ * > 'count' content_fingerprint_record_t
+ * > string pool holding the NUL-terminated paths */
+#define CONTENT_FINGERPRINT_MAGIC   0x50464152 /* "RAFP" */
+#define CONTENT_FINGERPRINT_VERSION 2
+
+/* Internal record flag: the file changed or disappeared,
+ * the entry is skipped by lookups and not written out */
+#define CONTENT_FINGERPRINT_FLAG_DEAD (1 << 7)
+
+typedef struct content_fingerprint_header
+{
+   uint32_t magic;
+   uint32_t version;
+   uint32_t count;
+   uint32_t pool_size;
+} content_fingerprint_header_t;
+
+typedef struct content_fingerprint_record
+{
+   uint64_t hash;
+   int64_t  size;
+   int64_t  mtime;
+   uint32_t crc;
+   uint32_t path;      /* Offset into the string pool */
+   uint8_t  type;
+   uint8_t  flags;
+   uint8_t  reserved[2];
+   char     serial[CONTENT_FINGERPRINT_SERIAL_SIZE];
+} content_fingerprint_record_t;
+
+typedef struct content_fingerprint_entry
+{
+   content_fingerprint_record_t rec;
+   char *path;
+} content_fingerprint_entry_t;
+
+enum content_fingerprint_state_flags
+{
+   CONTENT_FINGERPRINT_ST_LOADED = (1 << 0),
+   CONTENT_FINGERPRINT_ST_DIRTY  = (1 << 1),
+   CONTENT_FINGERPRINT_ST_QUIT   = (1 << 2)
+};
+
+typedef struct content_fingerprint_state
+{
+   content_fingerprint_entry_t *entries; /* RBUF */
+   /* Open addressing table of entry index + 1,
+    * 0 marks an empty slot */
+   uint32_t *slots;
+   size_t mask;
+#ifdef HAVE_THREADS
+   slock_t *lock;
+   sthread_t *validate_thread;
+#endif
+   char path[PATH_MAX_LENGTH];
+   uint8_t flags;
+} content_fingerprint_state_t;
+
+static content_fingerprint_state_t content_fingerprint_st;
+
+#ifdef HAVE_THREADS
+#define CONTENT_FINGERPRINT_LOCK(st)   slock_lock((st)->lock)
+#define CONTENT_FINGERPRINT_UNLOCK(st) slock_unlock((st)->lock)
+#else
+#define CONTENT_FINGERPRINT_LOCK(st)
+#define CONTENT_FINGERPRINT_UNLOCK(st)
+#endif
+
+static uint64_t content_fingerprint_hash(const char *path,
+      enum content_fingerprint_type type)
+{
+   uint64_t hash = 0xcbf29ce484222325ULL;
+   const unsigned char *s;
+   for (s = (const unsigned char*)path; *s; s++)
+      hash = (hash ^ *s) * 0x100000001b3ULL;
+   hash    = (hash ^ (uint64_t)type) * 0x100000001b3ULL;
+   return hash;
+}
+
+#ifdef HAVE_LIBRETRODB
+/* Folds size and modification time of 'track' into
+ * the stamp of the sheet referencing it */
+static void content_fingerprint_stat_track(const char *track,
+      int64_t *size, int64_t *mtime)
+{
+   struct stat st;
+   if (stat(track, &st) != 0)
+      return;
+   *size  += (int64_t)st.st_size;
+   *mtime  = (int64_t)(((uint64_t)*mtime * 0x100000001b3ULL)
+         ^ (uint64_t)st.st_mtime);
+}
+
+/* Cue and gdi sheets are looked up by their data track,
+ * which can be replaced while the sheet stays the same */
+static void content_fingerprint_stat_tracks(const char *path,
+      int64_t *size, int64_t *mtime)
+{
+   char track[PATH_MAX_LENGTH];
+   const char *ext = path_get_extension(path);
+
+   track[0]        = '\0';
+
+   if (string_is_equal_noncase(ext, "cue"))
+   {
+      char largest[PATH_MAX_LENGTH];
+      uint64_t offset = 0;
+      size_t _len     = 0;
+
+      largest[0]      = '\0';
+
+      /* The serial is read from the first data track,
+       * the CRC from the largest one */
+      if (cue_find_track(path, true, &offset, &_len,
+               track, sizeof(track)) >= 0)
+         content_fingerprint_stat_track(track, size, mtime);
+      if (     cue_find_track(path, false, &offset, &_len,
+               largest, sizeof(largest)) >= 0
+            && !string_is_equal(track, largest))
+         content_fingerprint_stat_track(largest, size, mtime);
+   }
+   else if (string_is_equal_noncase(ext, "gdi"))
+   {
+      if (gdi_find_track(path, true, track, sizeof(track)) >= 0)
+         content_fingerprint_stat_track(track, size, mtime);
+   }
+}
+#endif
+
+/* Gets size and modification time of the file backing
+ * 'path', i.e. of the archive for archive members. Disc
+ * sheets also take the stamp of their data track. */
+static bool content_fingerprint_stat(const char *path,
+      enum content_fingerprint_type type, int64_t *size, int64_t *mtime)
+{
+   struct stat st;
+   const char *delim = path_get_archive_delim(path);
+
+   if (delim)
+   {
+      char archive_path[PATH_MAX_LENGTH];
+      size_t _len = (size_t)(delim - path);
+      if (_len >= sizeof(archive_path))
+         return false;
+      memcpy(archive_path, path, _len);
+      archive_path[_len] = '\0';
+      if (stat(archive_path, &st) != 0)
+         return false;
+   }
+   else if (stat(path, &st) != 0)
+      return false;
+
+   *size  = (int64_t)st.st_size;
+   *mtime = (int64_t)st.st_mtime;
+#ifdef HAVE_LIBRETRODB
+   if (type == CONTENT_FINGERPRINT_DISC && !delim)
+      content_fingerprint_stat_tracks(path, size, mtime);
+#endif
+   return true;
+}
+
+static content_fingerprint_entry_t *content_fingerprint_find(
+      content_fingerprint_state_t *st, const char *path,
+      enum content_fingerprint_type type, uint64_t hash, size_t *slot)
+{
+   size_t i;
+
+   if (!st->slots)
+      return NULL;
+
+   for (i = (size_t)hash & st->mask; st->slots[i];
+         i = (i + 1) & st->mask)
+   {
+      content_fingerprint_entry_t *entry =
+         &st->entries[st->slots[i] - 1];
+      if (     entry->rec.hash == hash
+            && entry->rec.type == (uint8_t)type
+            && string_is_equal(entry->path, path))
+      {
+         if (slot)
+            *slot = i;
+         return entry;
+      }
+   }
+
+   if (slot)
+      *slot = i;
+   return NULL;
+}
+
+static bool content_fingerprint_rehash(content_fingerprint_state_t *st,
+      size_t capacity)
+{
+   size_t i;
+   size_t count    = RBUF_LEN(st->entries);
+   uint32_t *slots = (uint32_t*)calloc(capacity, sizeof(*slots));
+
+   if (!slots)
+      return false;
+
+   free(st->slots);
+   st->slots = slots;
+   st->mask  = capacity - 1;
+
+   for (i = 0; i < count; i++)
+   {
+      size_t j = (size_t)st->entries[i].rec.hash & st->mask;
+      while (slots[j])
+         j = (j + 1) & st->mask;
+      slots[j] = (uint32_t)(i + 1);
+   }
+
+   return true;
+}
+
+static content_fingerprint_entry_t *content_fingerprint_add(
+      content_fingerprint_state_t *st, const char *path,
+      enum content_fingerprint_type type, uint64_t hash)
+{
+   size_t slot  = 0;
+   content_fingerprint_entry_t entry;
+   size_t count = RBUF_LEN(st->entries);
+
+   /* Keep the table at most half full */
+   if ((count + 1) * 2 > (st->slots ? st->mask + 1 : 0))
+   {
+      size_t capacity = st->slots ? (st->mask + 1) * 2 : 1024;
+      if (!content_fingerprint_rehash(st, capacity))
+         return NULL;
+   }
+
+   memset(&entry, 0, sizeof(entry));
+   entry.rec.hash = hash;
+   entry.rec.type = (uint8_t)type;
+   if (!(entry.path = strdup(path)))
+      return NULL;
+
+   if (!RBUF_TRYFIT(st->entries, count + 1))
+   {
+      free(entry.path);
+      return NULL;
+   }
+   RBUF_PUSH(st->entries, entry);
+
+   content_fingerprint_find(st, path, type, hash, &slot);
+   st->slots[slot] = (uint32_t)(count + 1);
+   return &st->entries[count];
+}
+
+static void content_fingerprint_read(content_fingerprint_state_t *st)
+{
+   size_t i;
+   content_fingerprint_header_t *header = NULL;
+   content_fingerprint_record_t *recs   = NULL;
+   const char *pool                     = NULL;
+   void *buf                            = NULL;
+   int64_t _len                         = 0;
+
+   if (!path_is_valid(st->path))
+      return;
+
+   if (   !filestream_read_file(st->path, &buf, &_len)
+       || _len < (int64_t)sizeof(*header))
+      goto error;
+
+   header = (content_fingerprint_header_t*)buf;
+   if (     header->magic   != CONTENT_FINGERPRINT_MAGIC
+         || header->version != CONTENT_FINGERPRINT_VERSION
+         || (uint64_t)_len  != sizeof(*header)
+            + (uint64_t)header->count * sizeof(*recs)
+            + header->pool_size
+         || (header->pool_size && ((const char*)buf)[_len - 1] != '\0'))
+      goto error;
+
+   recs = (content_fingerprint_record_t*)(header + 1);
+   pool = (const char*)(recs + header->count);
+
+   for (i = 0; i < header->count; i++)
+   {
+      content_fingerprint_entry_t *entry;
+      const content_fingerprint_record_t *rec = &recs[i];
+
+      if (     rec->path >= header->pool_size
+            || rec->type >  CONTENT_FINGERPRINT_DISC
+            || rec->serial[CONTENT_FINGERPRINT_SERIAL_SIZE - 1] != '\0'
+            || rec->hash != content_fingerprint_hash(pool + rec->path,
+                  (enum content_fingerprint_type)rec->type))
+         goto error;
+
+      if (!(entry = content_fingerprint_add(st, pool + rec->path,
+            (enum content_fingerprint_type)rec->type, rec->hash)))
+         break;
+      memcpy(&entry->rec, rec, sizeof(*rec));
+   }
+
+   free(buf);
+   return;
+
+error:
+   RARCH_WARN("[Fingerprint]: Discarding invalid cache \"%s\".\n", st->path);
+   for (i = 0; i < RBUF_LEN(st->entries); i++)
+      free(st->entries[i].path);
+   RBUF_FREE(st->entries);
+   free(st->slots);
+   st->slots  = NULL;
+   st->mask   = 0;
+   st->flags |= CONTENT_FINGERPRINT_ST_DIRTY;
+   free(buf);
+}
+
+static bool content_fingerprint_write(content_fingerprint_state_t *st)
+{
+   size_t i, _len;
+   char tmp_path[PATH_MAX_LENGTH];
+   content_fingerprint_header_t header;
+   content_fingerprint_record_t *recs = NULL;
+   char *pool                         = NULL;
+   RFILE *file                        = NULL;
+   bool success                       = false;
+   size_t count                       = RBUF_LEN(st->entries);
+
+   memset(&header, 0, sizeof(header));
+   header.magic   = CONTENT_FINGERPRINT_MAGIC;
+   header.version = CONTENT_FINGERPRINT_VERSION;
+
+   if (count && !(recs = (content_fingerprint_record_t*)
+            malloc(count * sizeof(*recs))))
+      goto end;
+
+   for (i = 0; i < count; i++)
+   {
+      size_t pos;
+      const content_fingerprint_entry_t *entry = &st->entries[i];
+
+      if (entry->rec.flags & CONTENT_FINGERPRINT_FLAG_DEAD)
+         continue;
+
+      pos  = RBUF_LEN(pool);
+      _len = strlen(entry->path) + 1;
+      if (     pos + _len > UINT32_MAX
+            || !RBUF_TRYFIT(pool, pos + _len))
+         goto end;
+      RBUF_RESIZE(pool, pos + _len);
+      memcpy(pool + pos, entry->path, _len);
+
+      recs[header.count]      = entry->rec;
+      recs[header.count].path = (uint32_t)pos;
+      header.count++;
+   }
+   header.pool_size = (uint32_t)RBUF_LEN(pool);
+
+   _len = strlcpy(tmp_path, st->path, sizeof(tmp_path));
+   strlcpy(tmp_path + _len, ".tmp", sizeof(tmp_path) - _len);
+
+   if (!(file = filestream_open(tmp_path,
+         RETRO_VFS_FILE_ACCESS_WRITE,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      goto end;
+
+   success = filestream_write(file, &header, sizeof(header))
+         == sizeof(header);
+   if (success && header.count)
+      success = filestream_write(file, recs, header.count * sizeof(*recs))
+         == (int64_t)(header.count * sizeof(*recs));
+   if (success && header.pool_size)
+      success = filestream_write(file, pool, header.pool_size)
+         == (int64_t)header.pool_size;
+   success = filestream_close(file) == 0 && success;
+
+   if (success)
+   {
+      /* Not every platform replaces on rename */
+      filestream_delete(st->path);
+      success = filestream_rename(tmp_path, st->path) == 0;
+   }
+   else
+      filestream_delete(tmp_path);
+
+end:
+   if (!success)
+      RARCH_WARN("[Fingerprint]: Failed to write cache \"%s\".\n", st->path);
+   free(recs);
+   RBUF_FREE(pool);
+   return success;
+}
+
+#ifdef HAVE_THREADS
+/* Walks the cache once after it was read and marks entries
+ * whose file changed or no longer exists, so that they are
+ * dropped on the next write instead of piling up. */
+static void content_fingerprint_validate_thread(void *data)
+{
+   content_fingerprint_state_t *st = (content_fingerprint_state_t*)data;
+   size_t i                        = 0;
+   size_t removed                  = 0;
+
+   for (;;)
+   {
+      char path[PATH_MAX_LENGTH];
+      content_fingerprint_record_t rec;
+      int64_t size  = 0;
+      int64_t mtime = 0;
+
+      slock_lock(st->lock);
+      if (     (st->flags & CONTENT_FINGERPRINT_ST_QUIT)
+            || i >= RBUF_LEN(st->entries))
+      {
+         slock_unlock(st->lock);
+         break;
+      }
+      rec = st->entries[i].rec;
+      strlcpy(path, st->entries[i].path, sizeof(path));
+      slock_unlock(st->lock);
+
+      if (     !(rec.flags & CONTENT_FINGERPRINT_FLAG_DEAD)
+            && (  !content_fingerprint_stat(path,
+                     (enum content_fingerprint_type)rec.type,
+                     &size, &mtime)
+               || size  != rec.size
+               || mtime != rec.mtime))
+      {
+         content_fingerprint_entry_t *entry;
+         slock_lock(st->lock);
+         entry = &st->entries[i];
+         /* Skip if the entry was refreshed in the meantime */
+         if (     entry->rec.size  == rec.size
+               && entry->rec.mtime == rec.mtime)
+         {
+            entry->rec.flags |= CONTENT_FINGERPRINT_FLAG_DEAD;
+            st->flags        |= CONTENT_FINGERPRINT_ST_DIRTY;
+            removed++;
+         }
+         slock_unlock(st->lock);
+      }
+
+      i++;
+   }
+
+   if (removed)
+      RARCH_LOG("[Fingerprint]: Dropped %u stale entries.\n",
+            (unsigned)removed);
+}
+#endif
+
+/* Reads the cache file on first use. Must be called
+ * with the lock held. Returns false if the cache is
+ * disabled. */
+static bool content_fingerprint_load(content_fingerprint_state_t *st)
+{
+   settings_t *settings;
+   const char *dir_cache;
+
+   if (st->flags & CONTENT_FINGERPRINT_ST_LOADED)
+      return !string_is_empty(st->path);
+
+   st->flags |= CONTENT_FINGERPRINT_ST_LOADED;
+   settings   = config_get_ptr();
+
+   if (!settings || !settings->bools.content_fingerprint_cache)
+      return false;
+
+   dir_cache = settings->paths.directory_cache;
+   if (!string_is_empty(dir_cache))
+   {
+      if (!path_is_directory(dir_cache) && !path_mkdir(dir_cache))
+         return false;
+      fill_pathname_join_special(st->path, dir_cache,
+            FILE_PATH_CONTENT_FINGERPRINT_CACHE, sizeof(st->path));
+   }
+   else
+   {
+      char base[PATH_MAX_LENGTH];
+      const char *path_config = path_get(RARCH_PATH_CONFIG);
+      if (string_is_empty(path_config))
+         return false;
+      fill_pathname_basedir(base, path_config, sizeof(base));
+      fill_pathname_join_special(st->path, base,
+            FILE_PATH_CONTENT_FINGERPRINT_CACHE, sizeof(st->path));
+   }
+
+   content_fingerprint_read(st);
+
+#ifdef HAVE_THREADS
+   if (RBUF_LEN(st->entries))
+      st->validate_thread = sthread_create(
+            content_fingerprint_validate_thread, st);
+#endif
+
+   return true;
+}
+
+void content_fingerprint_init(void)
+{
+   content_fingerprint_state_t *st = &content_fingerprint_st;
+#ifdef HAVE_THREADS
+   if (!st->lock)
+      st->lock = slock_new();
+#endif
+   st->flags &= ~CONTENT_FINGERPRINT_ST_QUIT;
+}
+
+void content_fingerprint_deinit(void)
+{
+   size_t i;
+   content_fingerprint_state_t *st = &content_fingerprint_st;
+
+#ifdef HAVE_THREADS
+   if (!st->lock)
+      return;
+
+   slock_lock(st->lock);
+   st->flags |= CONTENT_FINGERPRINT_ST_QUIT;
+   slock_unlock(st->lock);
+
+   if (st->validate_thread)
+   {
+      sthread_join(st->validate_thread);
+      st->validate_thread = NULL;
+   }
+#endif
+
+   if (     (st->flags & CONTENT_FINGERPRINT_ST_DIRTY)
+         && !string_is_empty(st->path))
+      content_fingerprint_write(st);
+
+   for (i = 0; i < RBUF_LEN(st->entries); i++)
+      free(st->entries[i].path);
+   RBUF_FREE(st->entries);
+   free(st->slots);
+   st->slots   = NULL;
+   st->mask    = 0;
+   st->path[0] = '\0';
+   st->flags   = 0;
+
+#ifdef HAVE_THREADS
+   slock_free(st->lock);
+   st->lock    = NULL;
+#endif
+}
+
+bool content_fingerprint_lookup(const char *path,
+      enum content_fingerprint_type type, content_fingerprint_t *fp)
+{
+   int64_t size, mtime;
+   content_fingerprint_entry_t *entry;
+   content_fingerprint_state_t *st = &content_fingerprint_st;
+   bool found                      = false;
+
+#ifdef HAVE_THREADS
+   if (!st->lock)
+      return false;
+#endif
+   if (     string_is_empty(path)
+         || !content_fingerprint_stat(path, type, &size, &mtime))
+      return false;
+
+   CONTENT_FINGERPRINT_LOCK(st);
+   if (     content_fingerprint_load(st)
+         && (entry = content_fingerprint_find(st, path, type,
+               content_fingerprint_hash(path, type), NULL))
+         && !(entry->rec.flags & CONTENT_FINGERPRINT_FLAG_DEAD)
+         && entry->rec.size  == size
+         && entry->rec.mtime == mtime)
+   {
+      fp->size  = entry->rec.size;
+      fp->crc   = entry->rec.crc;
+      fp->flags = entry->rec.flags;
+      strlcpy(fp->serial, entry->rec.serial, sizeof(fp->serial));
+      found     = true;
+   }
+   CONTENT_FINGERPRINT_UNLOCK(st);
+
+   return found;
+}
+
+void content_fingerprint_store(const char *path,
+      enum content_fingerprint_type type, const content_fingerprint_t *fp)
+{
+   int64_t size, mtime;
+   uint64_t hash;
+   content_fingerprint_entry_t *entry;
+   content_fingerprint_state_t *st = &content_fingerprint_st;
+   uint8_t flags                   = fp->flags;
+
+#ifdef HAVE_THREADS
+   if (!st->lock)
+      return;
+#endif
+   if (     (flags & CONTENT_FINGERPRINT_FLAG_SERIAL)
+         && strlen(fp->serial) >= CONTENT_FINGERPRINT_SERIAL_SIZE)
+      flags &= ~CONTENT_FINGERPRINT_FLAG_SERIAL;
+   if (     !flags
+         || string_is_empty(path)
+         || !content_fingerprint_stat(path, type, &size, &mtime))
+      return;
+
+   hash = content_fingerprint_hash(path, type);
+
+   CONTENT_FINGERPRINT_LOCK(st);
+   if (content_fingerprint_load(st))
+   {
+      if ((entry = content_fingerprint_find(st, path, type, hash, NULL)))
+      {
+         /* Only merge with what is known about the same file */
+         if (     (entry->rec.flags & CONTENT_FINGERPRINT_FLAG_DEAD)
+               || entry->rec.size  != size
+               || entry->rec.mtime != mtime)
+         {
+            entry->rec.flags     = 0;
+            entry->rec.crc       = 0;
+            entry->rec.serial[0] = '\0';
+         }
+      }
+      else
+         entry = content_fingerprint_add(st, path, type, hash);
+
+      if (entry)
+      {
+         entry->rec.size   = size;
+         entry->rec.mtime  = mtime;
+         if (flags & CONTENT_FINGERPRINT_FLAG_CRC)
+            entry->rec.crc = fp->crc;
+         if (flags & CONTENT_FINGERPRINT_FLAG_SERIAL)
+         {
+            strlcpy(entry->rec.serial, fp->serial,
+                  sizeof(entry->rec.serial));
+            entry->rec.flags &= ~CONTENT_FINGERPRINT_FLAG_NO_SERIAL;
+         }
+         else if (flags & CONTENT_FINGERPRINT_FLAG_NO_SERIAL)
+         {
+            entry->rec.serial[0] = '\0';
+            entry->rec.flags    &= ~CONTENT_FINGERPRINT_FLAG_SERIAL;
+         }
+         entry->rec.flags |= flags;
+         st->flags        |= CONTENT_FINGERPRINT_ST_DIRTY;
+      }
+   }
+   CONTENT_FINGERPRINT_UNLOCK(st);
+}
+
+void content_fingerprint_flush(void)
+{
+   content_fingerprint_state_t *st = &content_fingerprint_st;
+
+#ifdef HAVE_THREADS
+   if (!st->lock)
+      return;
+#endif
+
+   CONTENT_FINGERPRINT_LOCK(st);
+   if (     (st->flags & CONTENT_FINGERPRINT_ST_DIRTY)
+         && !string_is_empty(st->path)
+         && content_fingerprint_write(st))
+      st->flags &= ~CONTENT_FINGERPRINT_ST_DIRTY;
+   CONTENT_FINGERPRINT_UNLOCK(st);
+}
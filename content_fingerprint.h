@@ -0,0 +1,127 @@
+/* Copyright  (C) 2010-2026 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (content_fingerprint.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CONTENT_FINGERPRINT_H
+#define __CONTENT_FINGERPRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <retro_common_api.h>
+#include <boolean.h>
+
+RETRO_BEGIN_DECLS
+
+/* Maximum serial length (including the terminator)
+ * that can be cached; longer serials are not stored */
+#define CONTENT_FINGERPRINT_SERIAL_SIZE 28
+
+/* What a fingerprint was computed from.
+ * > FILE: CRC32 of the whole file, or of the archive
+ *   member when the path contains one
+ * > HEAD: CRC32 of the first CRC32_MAX_MB megabytes,
+ *   as used by content loading for larger files
+ * > DISC: serial and/or data track CRC32 of a disc
+ *   image (cue, gdi, chd, iso...). Entries of cue and
+ *   gdi sheets also go stale when the data track changes */
+enum content_fingerprint_type
+{
+   CONTENT_FINGERPRINT_FILE = 0,
+   CONTENT_FINGERPRINT_HEAD,
+   CONTENT_FINGERPRINT_DISC
+};
+
+enum content_fingerprint_flags
+{
+   CONTENT_FINGERPRINT_FLAG_CRC       = (1 << 0),
+   CONTENT_FINGERPRINT_FLAG_SERIAL    = (1 << 1),
+   /* Serial detection was attempted and failed */
+   CONTENT_FINGERPRINT_FLAG_NO_SERIAL = (1 << 2)
+};
+
+typedef struct content_fingerprint
+{
+   /* Size of the file (or of the archive for archive
+    * members, plus the data track for cue and gdi disc
+    * entries), only filled in by lookups */
+   int64_t size;
+   uint32_t crc;
+   uint8_t flags;
+   char serial[CONTENT_FINGERPRINT_SERIAL_SIZE];
+} content_fingerprint_t;
+
+/**
+ * content_fingerprint_init:
+ *
+ * Sets up the fingerprint cache. The cache file itself is
+ * only read on first use.
+ **/
+void content_fingerprint_init(void);
+
+/**
+ * content_fingerprint_deinit:
+ *
+ * Writes any pending changes to disk and frees the cache.
+ **/
+void content_fingerprint_deinit(void);
+
+/**
+ * content_fingerprint_lookup:
+ * @path                : Content path, may contain an archive member.
+ * @type                : What the fingerprint was computed from.
+ * @fp                  : Filled in on success.
+ *
+ * Looks up a cached fingerprint. Entries are only returned
+ * while the size and modification time of the file (or of
+ * the archive for archive members) still match.
+ *
+ * Thread-safe.
+ *
+ * Returns: true if a fingerprint was found.
+ **/
+bool content_fingerprint_lookup(const char *path,
+      enum content_fingerprint_type type, content_fingerprint_t *fp);
+
+/**
+ * content_fingerprint_store:
+ * @path                : Content path, may contain an archive member.
+ * @type                : What the fingerprint was computed from.
+ * @fp                  : Fingerprint to store. Its flags are merged
+ *                        with those of a still valid cached entry.
+ *
+ * Thread-safe.
+ **/
+void content_fingerprint_store(const char *path,
+      enum content_fingerprint_type type, const content_fingerprint_t *fp);
+
+/**
+ * content_fingerprint_flush:
+ *
+ * Writes the cache to disk if it has changed.
+ *
+ * Thread-safe.
+ **/
+void content_fingerprint_flush(void);
+
+RETRO_END_DECLS
+
+#endif
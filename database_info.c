@@ -466,16 +466,13 @@ char *bin_to_hex_alloc(const uint8_t *data, size_t len)
    return ret;
 }
 
-static int database_cursor_iterate(libretrodb_cursor_t *cur,
+static int database_info_parse_item(struct rmsgpack_dom_value *item_ptr,
       database_info_t *db_info)
 {
    unsigned i;
-   struct rmsgpack_dom_value item;
+   struct rmsgpack_dom_value item = *item_ptr;
    const char* str                = NULL;
 
-   if (libretrodb_cursor_read_item(cur, &item) != 0)
-      return -1;
-
    if (item.type != RDT_MAP)
    {
       rmsgpack_dom_value_free(&item);
@@ -714,6 +711,17 @@ static int database_cursor_iterate(libretrodb_cursor_t *cur,
    return 0;
 }
 
+static int database_cursor_iterate(libretrodb_cursor_t *cur,
+      database_info_t *db_info)
+{
+   struct rmsgpack_dom_value item;
+
+   if (libretrodb_cursor_read_item(cur, &item) != 0)
+      return -1;
+
+   return database_info_parse_item(&item, db_info);
+}
+
 static int database_cursor_open(libretrodb_t *db,
       libretrodb_cursor_t *cur, const char *path, const char *query)
 {
@@ -832,6 +840,173 @@ void database_info_free(database_info_handle_t *db)
       string_list_free(db->list);
 }
 
+static void database_info_entry_free(database_info_t *info)
+{
+   if (info->name)
+      free(info->name);
+   if (info->rom_name)
+      free(info->rom_name);
+   if (info->serial)
+      free(info->serial);
+   if (info->genre)
+      free(info->genre);
+   if (info->category)
+      free(info->category);
+   if (info->language)
+      free(info->language);
+   if (info->region)
+      free(info->region);
+   if (info->score)
+      free(info->score);
+   if (info->media)
+      free(info->media);
+   if (info->controls)
+      free(info->controls);
+   if (info->artstyle)
+      free(info->artstyle);
+   if (info->gameplay)
+      free(info->gameplay);
+   if (info->narrative)
+      free(info->narrative);
+   if (info->pacing)
+      free(info->pacing);
+   if (info->perspective)
+      free(info->perspective);
+   if (info->setting)
+      free(info->setting);
+   if (info->visual)
+      free(info->visual);
+   if (info->vehicular)
+      free(info->vehicular);
+   if (info->description)
+      free(info->description);
+   if (info->publisher)
+      free(info->publisher);
+   if (info->developer)
+      string_list_free(info->developer);
+   if (info->origin)
+      free(info->origin);
+   if (info->franchise)
+      free(info->franchise);
+   if (info->edge_magazine_review)
+      free(info->edge_magazine_review);
+
+   if (info->cero_rating)
+      free(info->cero_rating);
+   if (info->pegi_rating)
+      free(info->pegi_rating);
+   if (info->enhancement_hw)
+      free(info->enhancement_hw);
+   if (info->elspa_rating)
+      free(info->elspa_rating);
+   if (info->esrb_rating)
+      free(info->esrb_rating);
+   if (info->bbfc_rating)
+      free(info->bbfc_rating);
+   if (info->sha1)
+      free(info->sha1);
+   if (info->md5)
+      free(info->md5);
+
+   info->name                 = NULL;
+   info->rom_name             = NULL;
+   info->serial               = NULL;
+   info->genre                = NULL;
+   info->description          = NULL;
+   info->publisher            = NULL;
+   info->developer            = NULL;
+   info->origin               = NULL;
+   info->franchise            = NULL;
+   info->edge_magazine_review = NULL;
+   info->cero_rating          = NULL;
+   info->pegi_rating          = NULL;
+   info->enhancement_hw       = NULL;
+   info->elspa_rating         = NULL;
+   info->esrb_rating          = NULL;
+   info->bbfc_rating          = NULL; 
+   info->sha1                 = NULL;
+   info->md5                  = NULL;
+}
+
+/* Reads the entries matching @crc, @archive_crc or @serial
+ * through the libretrodb lookup table instead of running a
+ * query over the whole database. */
+database_info_list_t *database_info_list_new_lookup(const char *rdb_path,
+      uint32_t crc, uint32_t archive_crc, const char *serial)
+{
+   unsigned pass;
+   size_t cap                               = 0;
+   database_info_list_t *database_info_list = NULL;
+   libretrodb_t *db                         = libretrodb_new();
+
+   if (!db)
+      return NULL;
+
+   if (libretrodb_open(rdb_path, db, false) != 0)
+      goto end;
+
+   if (!(database_info_list = (database_info_list_t*)
+         calloc(1, sizeof(*database_info_list))))
+      goto end;
+
+   for (pass = 0; pass < 3; pass++)
+   {
+      size_t nth = 0;
+
+      if (pass == 0 && !crc)
+         continue;
+      if (pass == 1 && (!archive_crc || archive_crc == crc))
+         continue;
+      if (pass == 2 && string_is_empty(serial))
+         continue;
+
+      for (;;)
+      {
+         struct rmsgpack_dom_value item;
+         database_info_t db_info = {0};
+         int ret;
+
+         if (pass == 0)
+            ret = libretrodb_find_by_crc(db, crc, nth, &item);
+         else if (pass == 1)
+            ret = libretrodb_find_by_crc(db, archive_crc, nth, &item);
+         else
+            ret = libretrodb_find_by_serial(db, serial, nth, &item);
+
+         if (ret != 0)
+            break;
+         nth++;
+
+         if (database_info_parse_item(&item, &db_info) != 0)
+            continue;
+
+         if (database_info_list->count == cap)
+         {
+            size_t new_cap           = cap ? cap * 2 : 4;
+            database_info_t *new_ptr = (database_info_t*)
+               realloc(database_info_list->list,
+                     new_cap * sizeof(database_info_t));
+
+            if (!new_ptr)
+            {
+               database_info_entry_free(&db_info);
+               goto end;
+            }
+
+            database_info_list->list = new_ptr;
+            cap                      = new_cap;
+         }
+
+         database_info_list->list[database_info_list->count++] = db_info;
+      }
+   }
+
+end:
+   libretrodb_close(db);
+   libretrodb_free(db);
+   return database_info_list;
+}
+
 database_info_list_t *database_info_list_new(
       const char *rdb_path, const char *query)
 {
@@ -992,94 +1167,7 @@ void database_info_list_free(database_info_list_t *database_info_list)
       return;
 
    for (i = 0; i < database_info_list->count; i++)
-   {
-      database_info_t *info = &database_info_list->list[i];
-
-      if (info->name)
-         free(info->name);
-      if (info->rom_name)
-         free(info->rom_name);
-      if (info->serial)
-         free(info->serial);
-      if (info->genre)
-         free(info->genre);
-      if (info->category)
-         free(info->category);
-      if (info->language)
-         free(info->language);
-      if (info->region)
-         free(info->region);
-      if (info->score)
-         free(info->score);
-      if (info->media)
-         free(info->media);
-      if (info->controls)
-         free(info->controls);
-      if (info->artstyle)
-         free(info->artstyle);
-      if (info->gameplay)
-         free(info->gameplay);
-      if (info->narrative)
-         free(info->narrative);
-      if (info->pacing)
-         free(info->pacing);
-      if (info->perspective)
-         free(info->perspective);
-      if (info->setting)
-         free(info->setting);
-      if (info->visual)
-         free(info->visual);
-      if (info->vehicular)
-         free(info->vehicular);
-      if (info->description)
-         free(info->description);
-      if (info->publisher)
-         free(info->publisher);
-      if (info->developer)
-         string_list_free(info->developer);
-      if (info->origin)
-         free(info->origin);
-      if (info->franchise)
-         free(info->franchise);
-      if (info->edge_magazine_review)
-         free(info->edge_magazine_review);
-
-      if (info->cero_rating)
-         free(info->cero_rating);
-      if (info->pegi_rating)
-         free(info->pegi_rating);
-      if (info->enhancement_hw)
-         free(info->enhancement_hw);
-      if (info->elspa_rating)
-         free(info->elspa_rating);
-      if (info->esrb_rating)
-         free(info->esrb_rating);
-      if (info->bbfc_rating)
-         free(info->bbfc_rating);
-      if (info->sha1)
-         free(info->sha1);
-      if (info->md5)
-         free(info->md5);
-
-      info->name                 = NULL;
-      info->rom_name             = NULL;
-      info->serial               = NULL;
-      info->genre                = NULL;
-      info->description          = NULL;
-      info->publisher            = NULL;
-      info->developer            = NULL;
-      info->origin               = NULL;
-      info->franchise            = NULL;
-      info->edge_magazine_review = NULL;
-      info->cero_rating          = NULL;
-      info->pegi_rating          = NULL;
-      info->enhancement_hw       = NULL;
-      info->elspa_rating         = NULL;
-      info->esrb_rating          = NULL;
-      info->bbfc_rating          = NULL; 
-      info->sha1                 = NULL;
-      info->md5                  = NULL;
-   }
+      database_info_entry_free(&database_info_list->list[i]);
 
    free(database_info_list->list);
 }
@@ -18,7 +18,13 @@
 #include <retro_miscellaneous.h>
 #include <retro_timers.h>
 #include <stdlib.h>
+#include <string.h>
 #include <compat/strl.h>
+#include <streams/trans_stream.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #ifdef HAVE_NETWORKING
 #include <net/net_compat.h>
@@ -43,6 +49,41 @@
 #define xstr(s) str(s)
 #define str(s) #s
 
+/* Streaming mode (video_network_stream).
+ *
+ * The default mode sends every frame as a raw block of
+ * screen_width * screen_height 32-bit pixels. Streaming mode
+ * instead splits the frame into tiles, and only sends the tiles
+ * that changed, each compressed as an LZ4 block. All integers
+ * are big-endian, pixels are 32-bit words in host order, same as
+ * in raw mode.
+ *
+ * Once, after connecting:
+ *    "RANV" | u32 version (1)
+ *
+ * Per frame:
+ *    u32 size of the rest of the frame | u16 width | u16 height
+ *    u16 tile size | u16 reserved | u32 tile count
+ *
+ * Per tile:
+ *    u16 tile column | u16 tile row | u8 codec (0 raw, 1 LZ4)
+ *    u8 reserved[3] | u32 data size | data
+ *
+ * Tiles on the right and bottom edges are clipped to the frame.
+ * Whenever the frame size changes every tile is sent, so a frame
+ * with a new size is always complete.
+ *
+ * Sending happens on a separate thread. If the link can't keep
+ * up, a frame that has not started sending yet is replaced by the
+ * next one, and its tiles are merged into that frame, so the
+ * receiver never misses a change. */
+#define NETWORK_STREAM_VERSION      1
+#define NETWORK_STREAM_TILE_SIZE    32
+#define NETWORK_STREAM_FRAME_HEADER 16
+#define NETWORK_STREAM_TILE_HEADER  12
+#define NETWORK_STREAM_CODEC_RAW    0
+#define NETWORK_STREAM_CODEC_LZ4    1
+
 enum
 {
    NETWORK_VIDEO_PIXELFORMAT_RGBA8888 = 0,
@@ -50,13 +91,56 @@ enum
    NETWORK_VIDEO_PIXELFORMAT_RGB565
 } network_video_pixelformat;
 
+typedef struct network_stream_packet
+{
+   uint8_t *data;
+   uint8_t *dirty;          /* Tiles carried by this packet */
+   size_t size;
+   size_t capacity;
+   unsigned tiles;
+} network_stream_packet_t;
+
+typedef struct network_stream
+{
+   /* Producer side: build is owned by the video thread,
+    * sending by the sender thread, pending is handed over
+    * between them under lock. */
+   network_stream_packet_t packets[3];
+   uint32_t *prev;          /* Last encoded frame */
+   uint8_t *dirty;          /* Tiles waiting to be sent */
+   uint32_t *tile;          /* One tile, packed */
+   void *lz4;
+   unsigned width;
+   unsigned height;
+   unsigned tiles_x;
+   unsigned tiles_y;
+   unsigned build;
+   unsigned pending;
+   unsigned sending;
+   bool has_pending;
+   bool failed;
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   bool quit;
+#endif
+} network_stream_t;
+
 typedef struct network
 {
+   network_stream_t *stream;
+   unsigned *scale_x;       /* Source column of each screen column */
+   unsigned *scale_y;       /* Source row of each screen row */
    int fd;
    unsigned video_width;
    unsigned video_height;
    unsigned screen_width;
    unsigned screen_height;
+   unsigned scale_width;
+   unsigned scale_height;
+   unsigned scale_screen_width;
+   unsigned scale_screen_height;
    uint16_t port;
    char address[256];
 } network_video_t;
@@ -90,6 +174,482 @@ static void gfx_ctx_network_input_driver(
    *input_data = NULL;
 }
 
+static INLINE uint8_t *network_stream_put16(uint8_t *p, unsigned v)
+{
+   p[0] = (uint8_t)(v >> 8);
+   p[1] = (uint8_t)(v);
+   return p + 2;
+}
+
+static INLINE uint8_t *network_stream_put32(uint8_t *p, uint32_t v)
+{
+   p[0] = (uint8_t)(v >> 24);
+   p[1] = (uint8_t)(v >> 16);
+   p[2] = (uint8_t)(v >> 8);
+   p[3] = (uint8_t)(v);
+   return p + 4;
+}
+
+#ifdef HAVE_THREADS
+/* The socket is non-blocking while the sender thread runs,
+ * so that it can notice a quit request on a stalled link. */
+static bool network_stream_send(network_stream_t *stream, int fd,
+      const uint8_t *data, size_t len)
+{
+   while (len)
+   {
+      bool quit;
+      bool ready = true;
+      ssize_t ret = socket_send_all_nonblocking(fd, data, len, true);
+
+      if (ret < 0)
+         return false;
+
+      data += ret;
+      len  -= ret;
+
+      if (!len)
+         break;
+
+      slock_lock(stream->lock);
+      quit = stream->quit;
+      slock_unlock(stream->lock);
+
+      if (quit)
+         return false;
+
+      socket_wait(fd, NULL, &ready, 100);
+   }
+
+   return true;
+}
+
+typedef struct network_stream_thread_data
+{
+   network_stream_t *stream;
+   int fd;
+} network_stream_thread_data_t;
+
+static void network_stream_thread(void *data)
+{
+   network_stream_thread_data_t *td = (network_stream_thread_data_t*)data;
+   network_stream_t *stream         = td->stream;
+   int fd                           = td->fd;
+
+   free(td);
+
+   for (;;)
+   {
+      network_stream_packet_t *packet;
+      unsigned tmp;
+
+      slock_lock(stream->lock);
+      while (!stream->has_pending && !stream->quit)
+         scond_wait(stream->cond, stream->lock);
+
+      if (stream->quit)
+      {
+         slock_unlock(stream->lock);
+         break;
+      }
+
+      tmp                 = stream->sending;
+      stream->sending     = stream->pending;
+      stream->pending     = tmp;
+      stream->has_pending = false;
+      packet              = &stream->packets[stream->sending];
+      slock_unlock(stream->lock);
+
+      if (!network_stream_send(stream, fd, packet->data, packet->size))
+      {
+         slock_lock(stream->lock);
+         if (!stream->quit)
+            RARCH_ERR("[Network]: Stream send failed, stopping stream.\n");
+         stream->failed = true;
+         slock_unlock(stream->lock);
+         break;
+      }
+   }
+}
+#endif
+
+static void network_stream_free(network_stream_t *stream)
+{
+   unsigned i;
+
+   if (!stream)
+      return;
+
+#ifdef HAVE_THREADS
+   if (stream->thread)
+   {
+      slock_lock(stream->lock);
+      stream->quit = true;
+      scond_signal(stream->cond);
+      slock_unlock(stream->lock);
+      sthread_join(stream->thread);
+   }
+   if (stream->cond)
+      scond_free(stream->cond);
+   if (stream->lock)
+      slock_free(stream->lock);
+#endif
+
+   for (i = 0; i < ARRAY_SIZE(stream->packets); i++)
+   {
+      free(stream->packets[i].data);
+      free(stream->packets[i].dirty);
+   }
+
+   if (stream->lz4)
+      trans_stream_get_lz4_compress_backend()->stream_free(stream->lz4);
+
+   free(stream->prev);
+   free(stream->dirty);
+   free(stream->tile);
+   free(stream);
+}
+
+static network_stream_t *network_stream_new(int fd)
+{
+   uint8_t header[8];
+#ifdef HAVE_THREADS
+   network_stream_thread_data_t *td = NULL;
+#endif
+   network_stream_t *stream         = (network_stream_t*)
+      calloc(1, sizeof(*stream));
+
+   if (!stream)
+      return NULL;
+
+   stream->build   = 0;
+   stream->pending = 1;
+   stream->sending = 2;
+   stream->tile    = (uint32_t*)malloc(NETWORK_STREAM_TILE_SIZE
+         * NETWORK_STREAM_TILE_SIZE * sizeof(uint32_t));
+   stream->lz4     = trans_stream_get_lz4_compress_backend()->stream_new();
+
+   if (!stream->tile || !stream->lz4)
+      goto error;
+
+#ifdef HAVE_THREADS
+   if (     !(stream->lock = slock_new())
+         || !(stream->cond = scond_new())
+         || !(td = (network_stream_thread_data_t*)malloc(sizeof(*td))))
+      goto error;
+
+   td->stream = stream;
+   td->fd     = fd;
+#endif
+
+   memcpy(header, "RANV", 4);
+   network_stream_put32(header + 4, NETWORK_STREAM_VERSION);
+   if (!socket_send_all_blocking(fd, header, sizeof(header), true))
+   {
+#ifdef HAVE_THREADS
+      free(td);
+#endif
+      goto error;
+   }
+
+#ifdef HAVE_THREADS
+   if (!socket_set_block(fd, false))
+   {
+      free(td);
+      goto error;
+   }
+
+   if (!(stream->thread = sthread_create(network_stream_thread, td)))
+   {
+      free(td);
+      socket_set_block(fd, true);
+      goto error;
+   }
+#endif
+
+   return stream;
+
+error:
+   network_stream_free(stream);
+   return NULL;
+}
+
+/* Starts over with a new frame size. The caller owns
+ * no pending packet afterwards, and every tile is dirty. */
+static bool network_stream_resize(network_stream_t *stream,
+      unsigned width, unsigned height)
+{
+   unsigned tiles;
+   unsigned tiles_x = (width  + NETWORK_STREAM_TILE_SIZE - 1)
+      / NETWORK_STREAM_TILE_SIZE;
+   unsigned tiles_y = (height + NETWORK_STREAM_TILE_SIZE - 1)
+      / NETWORK_STREAM_TILE_SIZE;
+
+   free(stream->prev);
+   free(stream->dirty);
+
+   tiles           = tiles_x * tiles_y;
+   stream->prev    = (uint32_t*)malloc(width * height * sizeof(uint32_t));
+   stream->dirty   = (uint8_t*)malloc(tiles);
+   stream->width   = 0;
+   stream->height  = 0;
+
+   if (!stream->prev || !stream->dirty)
+      return false;
+
+   memset(stream->dirty, 1, tiles);
+
+   stream->width   = width;
+   stream->height  = height;
+   stream->tiles_x = tiles_x;
+   stream->tiles_y = tiles_y;
+   return true;
+}
+
+/* Compares each tile of 'frame' against the previous frame,
+ * and marks the tiles that changed. */
+static void network_stream_diff(network_stream_t *stream,
+      const uint32_t *frame)
+{
+   unsigned tx, ty;
+   unsigned width = stream->width;
+
+   for (ty = 0; ty < stream->tiles_y; ty++)
+   {
+      unsigned y0 = ty * NETWORK_STREAM_TILE_SIZE;
+      unsigned y1 = MIN(y0 + NETWORK_STREAM_TILE_SIZE, stream->height);
+
+      for (tx = 0; tx < stream->tiles_x; tx++)
+      {
+         unsigned y;
+         unsigned x0   = tx * NETWORK_STREAM_TILE_SIZE;
+         size_t   len  = MIN(NETWORK_STREAM_TILE_SIZE, width - x0)
+            * sizeof(uint32_t);
+         uint8_t *mark = &stream->dirty[ty * stream->tiles_x + tx];
+
+         for (y = y0; y < y1; y++)
+         {
+            size_t offset = (size_t)y * width + x0;
+
+            if (*mark)
+               memcpy(stream->prev + offset, frame + offset, len);
+            else if (memcmp(stream->prev + offset, frame + offset, len))
+            {
+               *mark = 1;
+               memcpy(stream->prev + offset, frame + offset, len);
+            }
+         }
+      }
+   }
+}
+
+/* Encodes the dirty tiles of 'frame' into the build packet */
+static bool network_stream_encode(network_stream_t *stream,
+      const uint32_t *frame, unsigned count)
+{
+   unsigned tx, ty;
+   uint8_t *out;
+   const struct trans_stream_backend *be =
+      trans_stream_get_lz4_compress_backend();
+   network_stream_packet_t *packet       = &stream->packets[stream->build];
+   unsigned tiles                        = stream->tiles_x * stream->tiles_y;
+   size_t capacity                       = NETWORK_STREAM_FRAME_HEADER
+      + (size_t)count * (NETWORK_STREAM_TILE_HEADER
+            + NETWORK_STREAM_TILE_SIZE * NETWORK_STREAM_TILE_SIZE
+            * sizeof(uint32_t));
+
+   if (packet->capacity < capacity)
+   {
+      uint8_t *data = (uint8_t*)realloc(packet->data, capacity);
+      if (!data)
+         return false;
+      packet->data     = data;
+      packet->capacity = capacity;
+   }
+
+   if (packet->tiles != tiles)
+   {
+      uint8_t *dirty = (uint8_t*)realloc(packet->dirty, tiles);
+      if (!dirty)
+         return false;
+      packet->dirty = dirty;
+      packet->tiles = tiles;
+   }
+
+   memcpy(packet->dirty, stream->dirty, tiles);
+
+   out = packet->data + 4;
+   out = network_stream_put16(out, stream->width);
+   out = network_stream_put16(out, stream->height);
+   out = network_stream_put16(out, NETWORK_STREAM_TILE_SIZE);
+   out = network_stream_put16(out, 0);
+   out = network_stream_put32(out, count);
+
+   for (ty = 0; ty < stream->tiles_y; ty++)
+   {
+      unsigned y0 = ty * NETWORK_STREAM_TILE_SIZE;
+      unsigned th = MIN(NETWORK_STREAM_TILE_SIZE, stream->height - y0);
+
+      for (tx = 0; tx < stream->tiles_x; tx++)
+      {
+         unsigned y;
+         uint32_t rd, wn;
+         unsigned x0   = tx * NETWORK_STREAM_TILE_SIZE;
+         unsigned tw   = MIN(NETWORK_STREAM_TILE_SIZE, stream->width - x0);
+         uint32_t size = tw * th * sizeof(uint32_t);
+         uint8_t *data = out + NETWORK_STREAM_TILE_HEADER;
+
+         if (!stream->dirty[ty * stream->tiles_x + tx])
+            continue;
+
+         for (y = 0; y < th; y++)
+            memcpy(stream->tile + y * tw,
+                  frame + (size_t)(y0 + y) * stream->width + x0,
+                  tw * sizeof(uint32_t));
+
+         /* Capping the output at the raw size makes the
+          * codec bail out early on tiles that don't shrink */
+         be->set_in(stream->lz4, (const uint8_t*)stream->tile, size);
+         be->set_out(stream->lz4, data, size);
+
+         out    = network_stream_put16(out, tx);
+         out    = network_stream_put16(out, ty);
+         if (be->trans(stream->lz4, true, &rd, &wn, NULL))
+            *out++ = NETWORK_STREAM_CODEC_LZ4;
+         else
+         {
+            memcpy(data, stream->tile, size);
+            wn     = size;
+            *out++ = NETWORK_STREAM_CODEC_RAW;
+         }
+         *out++ = 0;
+         *out++ = 0;
+         *out++ = 0;
+         out    = network_stream_put32(out, wn);
+         out   += wn;
+      }
+   }
+
+   packet->size = (size_t)(out - packet->data);
+   network_stream_put32(packet->data, (uint32_t)(packet->size - 4));
+   memset(stream->dirty, 0, tiles);
+   return true;
+}
+
+static void network_stream_frame(network_stream_t *stream, int fd,
+      const uint32_t *frame, unsigned width, unsigned height)
+{
+   unsigned i;
+   unsigned tiles;
+   unsigned count = 0;
+   bool resized   = false;
+
+#ifdef HAVE_THREADS
+   slock_lock(stream->lock);
+   /* Take back a packet the sender hasn't picked up yet,
+    * its tiles go out with this frame instead */
+   if (stream->has_pending)
+   {
+      network_stream_packet_t *packet = &stream->packets[stream->pending];
+      stream->has_pending = false;
+      if (     stream->dirty
+            && packet->tiles == stream->tiles_x * stream->tiles_y)
+         for (i = 0; i < packet->tiles; i++)
+            stream->dirty[i] |= packet->dirty[i];
+   }
+   if (stream->failed)
+   {
+      slock_unlock(stream->lock);
+      return;
+   }
+   slock_unlock(stream->lock);
+#else
+   if (stream->failed)
+      return;
+#endif
+
+   if (width != stream->width || height != stream->height)
+   {
+      if (!network_stream_resize(stream, width, height))
+         return;
+      resized = true;
+   }
+
+   if (resized)
+      memcpy(stream->prev, frame, width * height * sizeof(uint32_t));
+   else
+      network_stream_diff(stream, frame);
+
+   tiles = stream->tiles_x * stream->tiles_y;
+   for (i = 0; i < tiles; i++)
+      count += stream->dirty[i];
+
+   if (!count || !network_stream_encode(stream, frame, count))
+      return;
+
+#ifdef HAVE_THREADS
+   slock_lock(stream->lock);
+   i                   = stream->pending;
+   stream->pending     = stream->build;
+   stream->build       = i;
+   stream->has_pending = true;
+   scond_signal(stream->cond);
+   slock_unlock(stream->lock);
+#else
+   if (!socket_send_all_blocking(fd,
+            stream->packets[stream->build].data,
+            stream->packets[stream->build].size, true))
+   {
+      RARCH_ERR("[Network]: Stream send failed, stopping stream.\n");
+      stream->failed = true;
+   }
+#endif
+}
+
+/* Precomputes the source row and column of each screen
+ * pixel, so scaling needs no divides per pixel */
+static bool network_gfx_update_scale(network_video_t *network,
+      unsigned width, unsigned height)
+{
+   unsigned i;
+
+   if (     network->scale_x
+         && network->scale_y
+         && (network->scale_width         == width)
+         && (network->scale_height        == height)
+         && (network->scale_screen_width  == network->screen_width)
+         && (network->scale_screen_height == network->screen_height))
+      return true;
+
+   free(network->scale_x);
+   free(network->scale_y);
+
+   network->scale_x = (unsigned*)malloc(
+         MAX(network->screen_width,  1) * sizeof(unsigned));
+   network->scale_y = (unsigned*)malloc(
+         MAX(network->screen_height, 1) * sizeof(unsigned));
+
+   if (!network->scale_x || !network->scale_y)
+   {
+      free(network->scale_x);
+      free(network->scale_y);
+      network->scale_x = NULL;
+      network->scale_y = NULL;
+      return false;
+   }
+
+   for (i = 0; i < network->screen_width; i++)
+      network->scale_x[i] = (width  * i) / network->screen_width;
+   for (i = 0; i < network->screen_height; i++)
+      network->scale_y[i] = (height * i) / network->screen_height;
+
+   network->scale_width         = width;
+   network->scale_height        = height;
+   network->scale_screen_width  = network->screen_width;
+   network->scale_screen_height = network->screen_height;
+   return true;
+}
+
 static void *network_gfx_init(const video_info_t *video,
       input_driver_t **input, void **input_data)
 {
@@ -98,6 +658,7 @@ static void *network_gfx_init(const video_info_t *video,
    settings_t *settings                 = config_get_ptr();
    network_video_t *network             = (network_video_t*)calloc(1, sizeof(*network));
    bool video_font_enable               = settings->bools.video_font_enable;
+   bool video_network_stream            = settings->bools.video_network_stream;
    const char *joypad_driver            = settings->arrays.input_joypad_driver;
 
    *input                               = NULL;
@@ -154,6 +715,14 @@ try_connect:
       goto try_connect;
    }
 
+   if (video_network_stream)
+   {
+      if ((network->stream = network_stream_new(network->fd)))
+         RARCH_LOG("[Network]: Streaming changed tiles.\n");
+      else
+         RARCH_WARN("[Network]: Could not start stream, sending raw frames.\n");
+   }
+
    RARCH_LOG("[Network]: Init complete.\n");
 
    return network;
@@ -223,7 +792,9 @@ static bool network_gfx_frame(void *data, const void *frame,
    }
 
    if (     (network->video_width  != width)
-         || (network->video_height != height))
+         || (network->video_height != height)
+         || (network->scale_screen_width  != network->screen_width)
+         || (network->scale_screen_height != network->screen_height))
    {
       network->video_width  = width;
       network->video_height = height;
@@ -238,6 +809,9 @@ static bool network_gfx_frame(void *data, const void *frame,
                * sizeof(unsigned));
    }
 
+   if (!network_gfx_update_scale(network, width, height))
+      return true;
+
    if (bits == 16)
    {
       if (network_video_temp_buf)
@@ -249,12 +823,16 @@ static bool network_gfx_frame(void *data, const void *frame,
 
             for (y = 0; y < network->screen_height; y++)
             {
+               /* scale incoming frame to fit the screen */
+               const unsigned short *src = (const unsigned short*)
+                  ((const uint8_t*)frame_to_copy
+                   + pitch * network->scale_y[y]);
+               unsigned *dst             = network_video_temp_buf
+                  + network->screen_width * y;
+
                for (x = 0; x < network->screen_width; x++)
                {
-                  /* scale incoming frame to fit the screen */
-                  unsigned    scaled_x = (width * x) / network->screen_width;
-                  unsigned    scaled_y = (height * y) / network->screen_height;
-                  unsigned short pixel = ((unsigned short*)frame_to_copy)[width * scaled_y + scaled_x];
+                  unsigned short pixel = src[network->scale_x[x]];
 
                   /* convert RGBX4444 to RGBX8888 */
                   unsigned r           = ((pixel & 0xF000) << 8)
@@ -264,8 +842,7 @@ static bool network_gfx_frame(void *data, const void *frame,
                   unsigned b           = ((pixel & 0x00F0) << 0)
                      | ((pixel & 0x00F0) >> 4);
 
-                  network_video_temp_buf[network->screen_width * y + x]
-                     = 0xFF000000 | b | g | r;
+                  dst[x]               = 0xFF000000 | b | g | r;
                }
             }
 
@@ -279,19 +856,23 @@ static bool network_gfx_frame(void *data, const void *frame,
 
             for (y = 0; y < network->screen_height; y++)
             {
+               /* scale incoming frame to fit the screen */
+               const unsigned short *src = (const unsigned short*)
+                  ((const uint8_t*)frame_to_copy
+                   + pitch * network->scale_y[y]);
+               unsigned *dst             = network_video_temp_buf
+                  + network->screen_width * y;
+
                for (x = 0; x < network->screen_width; x++)
                {
-                  /* scale incoming frame to fit the screen */
-                  unsigned    scaled_x = (width * x) / network->screen_width;
-                  unsigned    scaled_y = (height * y) / network->screen_height;
-                  unsigned short pixel = ((unsigned short*)frame_to_copy)[(pitch / (bits / 8)) * scaled_y + scaled_x];
+                  unsigned short pixel = src[network->scale_x[x]];
 
                   /* convert RGB565 to RGBX8888 */
                   unsigned r = ((pixel & 0x001F) << 3) | ((pixel & 0x001C) >> 2);
                   unsigned g = ((pixel & 0x07E0) << 5) | ((pixel & 0x0600) >> 1);
                   unsigned b = ((pixel & 0xF800) << 8) | ((pixel & 0xE000) << 3);
 
-                  network_video_temp_buf[network->screen_width * y + x] = 0xFF000000 | b | g | r;
+                  dst[x]     = 0xFF000000 | b | g | r;
                }
             }
 
@@ -304,22 +885,21 @@ static bool network_gfx_frame(void *data, const void *frame,
          /* no temp buffer available yet */
       }
    }
-   else
+   else if (network_video_temp_buf)
    {
       /* Scale 32-bit RGBX8888 image to output geometry. */
       unsigned x, y;
 
       for (y = 0; y < network->screen_height; y++)
       {
-         for (x = 0; x < network->screen_width; x++)
-         {
-            /* scale incoming frame to fit the screen */
-            unsigned scaled_x = (width * x) / network->screen_width;
-            unsigned scaled_y = (height * y) / network->screen_height;
-            unsigned    pixel = ((unsigned*)frame_to_copy)[(pitch / (bits / 8)) * scaled_y + scaled_x];
+         /* scale incoming frame to fit the screen */
+         const unsigned *src = (const unsigned*)
+            ((const uint8_t*)frame_to_copy + pitch * network->scale_y[y]);
+         unsigned *dst       = network_video_temp_buf
+            + network->screen_width * y;
 
-            network_video_temp_buf[network->screen_width * y + x] = pixel;
-         }
+         for (x = 0; x < network->screen_width; x++)
+            dst[x] = src[network->scale_x[x]];
       }
 
       pixfmt        = NETWORK_VIDEO_PIXELFORMAT_BGRA8888;
@@ -328,7 +908,14 @@ static bool network_gfx_frame(void *data, const void *frame,
 
    if (draw && network->screen_width > 0 && network->screen_height > 0)
    {
-      if (network->fd > 0)
+      if (network->stream)
+      {
+         if (frame_to_copy == network_video_temp_buf)
+            network_stream_frame(network->stream, network->fd,
+                  (const uint32_t*)network_video_temp_buf,
+                  network->screen_width, network->screen_height);
+      }
+      else if (network->fd > 0)
          socket_send_all_blocking(network->fd, frame_to_copy, network->screen_width * network->screen_height * 4, true);
    }
 
@@ -375,6 +962,10 @@ static void network_gfx_free(void *data)
 
    font_driver_free_osd();
 
+   network_stream_free(network->stream);
+   free(network->scale_x);
+   free(network->scale_y);
+
    if (network->fd >= 0)
       socket_close(network->fd);
 
@@ -29,6 +29,7 @@
 #include <iostream>
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
 #include <mutex>
 
 #include "../../verbosity.h"
@@ -456,3 +457,11 @@ bool glslang::compile_spirv(const std::string &source, Stage stage,
    GlslangToSpv(*program.getIntermediate(language), *spirv);
    return true;
 }
+
+std::string glslang::compiler_version()
+{
+   char ver[128];
+   snprintf(ver, sizeof(ver), "%d.%d %s", GetKhronosToolId(),
+         GLSLANG_MINOR_VERSION, GetGlslVersionString());
+   return ver;
+}
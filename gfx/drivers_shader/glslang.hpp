@@ -18,6 +18,7 @@ namespace glslang
     };
 
     bool compile_spirv(const std::string &source, Stage stage, std::vector<uint32_t> *spirv);
+    std::string compiler_version();
 }
 
 #endif
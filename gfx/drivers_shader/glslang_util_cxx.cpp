@@ -16,11 +16,18 @@
 #include <stdio.h>
 #include <string.h>
 #include <string>
+#include <vector>
+#include <map>
+#include <mutex>
 #include <algorithm>
 
 #include <retro_miscellaneous.h>
+#include <lrc_hash.h>
+#include <compat/posix_string.h>
+#include <compat/strl.h>
 #include <file/file_path.h>
 #include <file/config_file.h>
+#include <lists/dir_list.h>
 #include <streams/file_stream.h>
 #include <string/stdstring.h>
 
@@ -33,8 +40,380 @@
 #if defined(HAVE_GLSLANG)
 #include "glslang.hpp"
 #endif
+#include "../../configuration.h"
+#include "../../paths.h"
 #include "../../verbosity.h"
 
+#if defined(HAVE_GLSLANG)
+/* Compiled shaders are cached on disk, keyed by a hash of the
+ * preprocessed source and the glslang version. An entry holds
+ * the SPIR-V of both stages and the parsed metadata. The index
+ * file lists entries from least to most recently used; the
+ * oldest ones are dropped when the cache outgrows
+ * video_shader_cache_size. */
+#define GLSLANG_CACHE_MAGIC   0x43505352 /* "RSPC" */
+#define GLSLANG_CACHE_VERSION 1
+#define GLSLANG_CACHE_EXT     "spvc"
+#define GLSLANG_CACHE_INDEX   "index"
+
+struct glslang_cache_entry
+{
+   std::string key;
+   uint64_t size;
+};
+
+struct glslang_cache_reader
+{
+   const uint8_t *data;
+   size_t size;
+   size_t pos;
+   bool ok;
+};
+
+static std::mutex glslang_cache_lock;
+static std::string glslang_cache_loaded_dir;
+static std::vector<glslang_cache_entry> glslang_cache_lru;
+static uint64_t glslang_cache_total;
+
+static bool glslang_cache_dir(char *s, size_t len)
+{
+   settings_t *settings  = config_get_ptr();
+   const char *dir_cache = settings->paths.directory_cache;
+
+   if (!settings->uints.video_shader_cache_size)
+      return false;
+
+   if (!string_is_empty(dir_cache))
+      fill_pathname_join_special(s, dir_cache, "slang", len);
+   else
+   {
+      char base[PATH_MAX_LENGTH];
+      const char *path_config = path_get(RARCH_PATH_CONFIG);
+      if (string_is_empty(path_config))
+         return false;
+      fill_pathname_basedir(base, path_config, sizeof(base));
+      fill_pathname_join_special(s, base, "shader_cache", len);
+   }
+
+   return path_is_directory(s) || path_mkdir(s);
+}
+
+static void glslang_cache_key(const struct string_list *lines, char *key)
+{
+   size_t i;
+   char header[32];
+   std::string data;
+
+   snprintf(header, sizeof(header), "slang %d ", GLSLANG_CACHE_VERSION);
+   data.append(header);
+   data.append(glslang::compiler_version());
+   data.append("\n");
+
+   for (i = 0; i < lines->size; i++)
+   {
+      data.append(lines->elems[i].data);
+      data.append("\n");
+   }
+
+   sha256_hash(key, (const uint8_t*)data.data(), data.size());
+}
+
+static void glslang_cache_entry_path(char *s, const char *dir,
+      const std::string &key, size_t len)
+{
+   char name[80];
+   snprintf(name, sizeof(name), "%s." GLSLANG_CACHE_EXT, key.c_str());
+   fill_pathname_join_special(s, dir, name, len);
+}
+
+/* Picks up the LRU order from the index file. Entries missing
+ * from it are treated as the oldest, and listed files which
+ * are gone are forgotten. */
+static void glslang_cache_load_index(const char *dir)
+{
+   size_t i;
+   char path[PATH_MAX_LENGTH];
+   std::map<std::string, uint64_t> files;
+   void *buf                 = NULL;
+   int64_t len               = 0;
+   struct string_list *list  = dir_list_new(dir, GLSLANG_CACHE_EXT,
+         false, false, false, false);
+
+   glslang_cache_loaded_dir  = dir;
+   glslang_cache_lru.clear();
+   glslang_cache_total       = 0;
+
+   if (list)
+   {
+      for (i = 0; i < list->size; i++)
+      {
+         char key[80];
+         const char *name = path_basename(list->elems[i].data);
+         int32_t size     = path_get_size(list->elems[i].data);
+         strlcpy(key, name, sizeof(key));
+         path_remove_extension(key);
+         if (size > 0)
+            files[key] = (uint64_t)size;
+      }
+      string_list_free(list);
+   }
+
+   fill_pathname_join_special(path, dir, GLSLANG_CACHE_INDEX, sizeof(path));
+   if (filestream_read_file(path, &buf, &len))
+   {
+      std::vector<glslang_cache_entry> listed;
+      char *save = NULL;
+      char *line = strtok_r((char*)buf, "\n", &save);
+
+      while (line)
+      {
+         char *sep = strchr(line, ' ');
+         if (sep)
+         {
+            std::map<std::string, uint64_t>::iterator it;
+            *sep = '\0';
+            if ((it = files.find(line)) != files.end())
+            {
+               listed.push_back({ it->first, it->second });
+               files.erase(it);
+            }
+         }
+         line = strtok_r(NULL, "\n", &save);
+      }
+      free(buf);
+
+      for (std::map<std::string, uint64_t>::iterator it = files.begin();
+            it != files.end(); ++it)
+         glslang_cache_lru.push_back({ it->first, it->second });
+      glslang_cache_lru.insert(glslang_cache_lru.end(),
+            listed.begin(), listed.end());
+   }
+   else
+   {
+      for (std::map<std::string, uint64_t>::iterator it = files.begin();
+            it != files.end(); ++it)
+         glslang_cache_lru.push_back({ it->first, it->second });
+   }
+
+   for (i = 0; i < glslang_cache_lru.size(); i++)
+      glslang_cache_total += glslang_cache_lru[i].size;
+}
+
+/* Marks an entry as the most recently used one (adding it if
+ * needed), evicts the oldest entries past the size limit, and
+ * writes the index back. */
+static void glslang_cache_touch(const char *dir,
+      const std::string &key, uint64_t size)
+{
+   size_t i;
+   char path[PATH_MAX_LENGTH];
+   std::string index;
+   uint64_t limit = (uint64_t)
+      config_get_ptr()->uints.video_shader_cache_size << 20;
+
+   std::lock_guard<std::mutex> guard(glslang_cache_lock);
+
+   if (glslang_cache_loaded_dir != dir)
+      glslang_cache_load_index(dir);
+
+   for (i = 0; i < glslang_cache_lru.size(); i++)
+   {
+      if (glslang_cache_lru[i].key == key)
+      {
+         glslang_cache_total -= glslang_cache_lru[i].size;
+         glslang_cache_lru.erase(glslang_cache_lru.begin() + i);
+         break;
+      }
+   }
+   glslang_cache_lru.push_back({ key, size });
+   glslang_cache_total += size;
+
+   while (glslang_cache_total > limit && glslang_cache_lru.size() > 1)
+   {
+      glslang_cache_entry_path(path, dir, glslang_cache_lru.front().key,
+            sizeof(path));
+      filestream_delete(path);
+      glslang_cache_total -= glslang_cache_lru.front().size;
+      glslang_cache_lru.erase(glslang_cache_lru.begin());
+   }
+
+   for (i = 0; i < glslang_cache_lru.size(); i++)
+   {
+      char line[96];
+      snprintf(line, sizeof(line), "%s %llu\n",
+            glslang_cache_lru[i].key.c_str(),
+            (unsigned long long)glslang_cache_lru[i].size);
+      index.append(line);
+   }
+
+   fill_pathname_join_special(path, dir, GLSLANG_CACHE_INDEX, sizeof(path));
+   filestream_write_file(path, index.data(), index.size());
+}
+
+static void glslang_cache_put_u32(std::vector<uint8_t> &buf, uint32_t val)
+{
+   const uint8_t *p = (const uint8_t*)&val;
+   buf.insert(buf.end(), p, p + sizeof(val));
+}
+
+static void glslang_cache_put_float(std::vector<uint8_t> &buf, float val)
+{
+   uint32_t bits;
+   memcpy(&bits, &val, sizeof(bits));
+   glslang_cache_put_u32(buf, bits);
+}
+
+static void glslang_cache_put_string(std::vector<uint8_t> &buf,
+      const std::string &str)
+{
+   glslang_cache_put_u32(buf, (uint32_t)str.size());
+   buf.insert(buf.end(), str.begin(), str.end());
+}
+
+static void glslang_cache_put_spirv(std::vector<uint8_t> &buf,
+      const std::vector<uint32_t> &spirv)
+{
+   const uint8_t *p = (const uint8_t*)spirv.data();
+   glslang_cache_put_u32(buf, (uint32_t)spirv.size());
+   buf.insert(buf.end(), p, p + spirv.size() * sizeof(uint32_t));
+}
+
+static uint32_t glslang_cache_get_u32(glslang_cache_reader *r)
+{
+   uint32_t val = 0;
+   if (r->size - r->pos < sizeof(val))
+   {
+      r->ok = false;
+      return 0;
+   }
+   memcpy(&val, r->data + r->pos, sizeof(val));
+   r->pos += sizeof(val);
+   return val;
+}
+
+static float glslang_cache_get_float(glslang_cache_reader *r)
+{
+   float val;
+   uint32_t bits = glslang_cache_get_u32(r);
+   memcpy(&val, &bits, sizeof(val));
+   return val;
+}
+
+static void glslang_cache_get_string(glslang_cache_reader *r,
+      std::string *str)
+{
+   uint32_t len = glslang_cache_get_u32(r);
+   if (!r->ok || r->size - r->pos < len)
+   {
+      r->ok = false;
+      return;
+   }
+   str->assign((const char*)r->data + r->pos, len);
+   r->pos += len;
+}
+
+static void glslang_cache_get_spirv(glslang_cache_reader *r,
+      std::vector<uint32_t> *spirv)
+{
+   uint32_t count = glslang_cache_get_u32(r);
+   if (!r->ok || (r->size - r->pos) / sizeof(uint32_t) < count)
+   {
+      r->ok = false;
+      return;
+   }
+   spirv->resize(count);
+   memcpy(spirv->data(), r->data + r->pos, count * sizeof(uint32_t));
+   r->pos += count * sizeof(uint32_t);
+}
+
+static bool glslang_cache_read(const char *dir, const std::string &key,
+      glslang_output *output)
+{
+   uint32_t i, count;
+   char path[PATH_MAX_LENGTH];
+   glslang_cache_reader r;
+   void *buf   = NULL;
+   int64_t len = 0;
+
+   glslang_cache_entry_path(path, dir, key, sizeof(path));
+   if (!path_is_valid(path) || !filestream_read_file(path, &buf, &len))
+      return false;
+
+   r.data = (const uint8_t*)buf;
+   r.size = (size_t)len;
+   r.pos  = 0;
+   r.ok   = true;
+
+   if (     glslang_cache_get_u32(&r) != GLSLANG_CACHE_MAGIC
+         || glslang_cache_get_u32(&r) != GLSLANG_CACHE_VERSION)
+      r.ok = false;
+
+   glslang_cache_get_spirv(&r, &output->vertex);
+   glslang_cache_get_spirv(&r, &output->fragment);
+   output->meta = glslang_meta{};
+   glslang_cache_get_string(&r, &output->meta.name);
+   output->meta.rt_format = (glslang_format)glslang_cache_get_u32(&r);
+   count                  = glslang_cache_get_u32(&r);
+
+   for (i = 0; r.ok && i < count; i++)
+   {
+      glslang_parameter param;
+      glslang_cache_get_string(&r, &param.id);
+      glslang_cache_get_string(&r, &param.desc);
+      param.initial = glslang_cache_get_float(&r);
+      param.minimum = glslang_cache_get_float(&r);
+      param.maximum = glslang_cache_get_float(&r);
+      param.step    = glslang_cache_get_float(&r);
+      output->meta.parameters.push_back(param);
+   }
+
+   free(buf);
+
+   if (     !r.ok
+         || r.pos != r.size
+         || output->meta.rt_format >= SLANG_FORMAT_MAX)
+   {
+      RARCH_WARN("[slang]: Discarding invalid cached shader \"%s\".\n", path);
+      filestream_delete(path);
+      return false;
+   }
+
+   glslang_cache_touch(dir, key, (uint64_t)len);
+   return true;
+}
+
+static void glslang_cache_write(const char *dir, const std::string &key,
+      const glslang_output *output)
+{
+   size_t i;
+   char path[PATH_MAX_LENGTH];
+   std::vector<uint8_t> buf;
+
+   glslang_cache_put_u32(buf, GLSLANG_CACHE_MAGIC);
+   glslang_cache_put_u32(buf, GLSLANG_CACHE_VERSION);
+   glslang_cache_put_spirv(buf, output->vertex);
+   glslang_cache_put_spirv(buf, output->fragment);
+   glslang_cache_put_string(buf, output->meta.name);
+   glslang_cache_put_u32(buf, (uint32_t)output->meta.rt_format);
+   glslang_cache_put_u32(buf, (uint32_t)output->meta.parameters.size());
+
+   for (i = 0; i < output->meta.parameters.size(); i++)
+   {
+      const glslang_parameter *param = &output->meta.parameters[i];
+      glslang_cache_put_string(buf, param->id);
+      glslang_cache_put_string(buf, param->desc);
+      glslang_cache_put_float(buf, param->initial);
+      glslang_cache_put_float(buf, param->minimum);
+      glslang_cache_put_float(buf, param->maximum);
+      glslang_cache_put_float(buf, param->step);
+   }
+
+   glslang_cache_entry_path(path, dir, key, sizeof(path));
+   if (filestream_write_file(path, buf.data(), buf.size()))
+      glslang_cache_touch(dir, key, buf.size());
+}
+#endif
+
 static std::string build_stage_source(
       const struct string_list *lines, const char *stage)
 {
@@ -213,15 +592,32 @@ bool glslang_parse_meta(const struct string_list *lines, glslang_meta *meta)
 bool glslang_compile_shader(const char *shader_path, glslang_output *output)
 {
 #if defined(HAVE_GLSLANG)
+   char cache_dir[PATH_MAX_LENGTH];
+   char cache_key[65];
    struct string_list lines;
+   bool use_cache = false;
 
    if (!string_list_initialize(&lines))
       return false;
 
-   RARCH_LOG("[slang]: Compiling shader: \"%s\".\n", shader_path);
-
    if (!glslang_read_shader_file(shader_path, &lines, true, false))
       goto error;
+
+   /* The includes are resolved at this point, so the hash
+    * covers everything the compiled output depends on */
+   if ((use_cache = glslang_cache_dir(cache_dir, sizeof(cache_dir))))
+   {
+      glslang_cache_key(&lines, cache_key);
+      if (glslang_cache_read(cache_dir, cache_key, output))
+      {
+         RARCH_LOG("[slang]: Using cached shader: \"%s\".\n", shader_path);
+         string_list_deinitialize(&lines);
+         return true;
+      }
+   }
+
+   RARCH_LOG("[slang]: Compiling shader: \"%s\".\n", shader_path);
+
    output->meta = glslang_meta{};
    if (!glslang_parse_meta(&lines, &output->meta))
       goto error;
@@ -240,6 +636,9 @@ bool glslang_compile_shader(const char *shader_path, glslang_output *output)
       goto error;
    }
 
+   if (use_cache)
+      glslang_cache_write(cache_dir, cache_key, output);
+
    string_list_deinitialize(&lines);
 
    return true;
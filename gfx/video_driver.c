@@ -3523,6 +3523,7 @@ bool video_driver_init_internal(bool *video_is_threaded, bool verbosity_enabled)
 
 #ifdef HAVE_THREADS
    video.is_threaded                 = VIDEO_DRIVER_IS_THREADED_INTERNAL(video_st);
+   video.threaded_zero_copy          = settings->bools.video_threaded_zero_copy;
    *video_is_threaded                = video.is_threaded;
 
    if (video.is_threaded)
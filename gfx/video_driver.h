@@ -362,6 +362,10 @@ typedef struct video_info
 
    bool is_threaded;
 
+   /* Threaded video: let the core render straight into the
+    * frame slots through GET_CURRENT_SOFTWARE_FRAMEBUFFER. */
+   bool threaded_zero_copy;
+
    /* Use 32bit RGBA rather than native RGB565/XBGR1555.
     *
     * XRGB1555 format is 16-bit and has byte ordering: 0RRRRRGGGGGBBBBB,
@@ -43,6 +43,34 @@ static void *video_thread_init_never_call(const video_info_t *video,
 }
 
 /* thread -> user */
+static int video_thread_mailbox_peek(thread_video_t *thr)
+{
+#ifdef RETRO_ATOMIC_LOCK_FREE
+   return retro_atomic_load_acquire(&thr->frame.mailbox);
+#else
+   int ret;
+   slock_lock(thr->frame.mailbox_lock);
+   ret = thr->frame.mailbox;
+   slock_unlock(thr->frame.mailbox_lock);
+   return ret;
+#endif
+}
+
+/* Puts @val in the mailbox, and returns what it held before */
+static int video_thread_mailbox_swap(thread_video_t *thr, int val)
+{
+#ifdef RETRO_ATOMIC_LOCK_FREE
+   return retro_atomic_xchg(&thr->frame.mailbox, val);
+#else
+   int ret;
+   slock_lock(thr->frame.mailbox_lock);
+   ret               = thr->frame.mailbox;
+   thr->frame.mailbox = val;
+   slock_unlock(thr->frame.mailbox_lock);
+   return ret;
+#endif
+}
+
 static void video_thread_reply(thread_video_t *thr, const thread_packet_t *pkt)
 {
    slock_lock(thr->lock);
@@ -418,11 +446,10 @@ static void video_thread_loop(void *data)
    for (;;)
    {
       slock_lock(thr->lock);
-      while (thr->send_cmd == CMD_VIDEO_NONE && !thr->frame.updated)
+      while (thr->send_cmd == CMD_VIDEO_NONE
+            && !(video_thread_mailbox_peek(thr) & THREAD_VIDEO_FRAME_FRESH))
          scond_wait(thr->cond_thread, thr->lock);
 
-      updated = thr->frame.updated;
-
       /* To avoid race condition where send_cmd is updated
        * right after the switch is checked. */
       pkt     = thr->cmd_data;
@@ -432,12 +459,24 @@ static void video_thread_loop(void *data)
       if (video_thread_handle_packet(thr, &pkt))
          return;
 
+      /* Take the latest frame, and hand our
+       * previous slot back to the mailbox */
+      updated = false;
+      if (video_thread_mailbox_peek(thr) & THREAD_VIDEO_FRAME_FRESH)
+      {
+         thr->frame.front = video_thread_mailbox_swap(thr, thr->frame.front)
+            & THREAD_VIDEO_FRAME_SLOT_MASK;
+         updated          = true;
+      }
+
       if (updated)
       {
          struct video_viewport vp;
          bool               alive = false;
          bool               focus = false;
          bool        has_windowed = false;
+         thread_video_slot_t *slot = &thr->frame.slots[thr->frame.front];
+         retro_time_t      latency = cpu_features_get_time_usec() - slot->time;
 
          vp.x                     = 0;
          vp.y                     = 0;
@@ -446,6 +485,11 @@ static void video_thread_loop(void *data)
          vp.full_width            = 0;
          vp.full_height           = 0;
 
+         thr->frame.rendered++;
+         thr->frame.latency_total += latency;
+         if (latency > thr->frame.latency_max)
+            thr->frame.latency_max = latency;
+
          slock_lock(thr->frame.lock);
 
          thread_update_driver_state(thr);
@@ -462,9 +506,10 @@ static void video_thread_loop(void *data)
                video_driver_build_info(&video_info);
 
                ret = thr->driver->frame(thr->driver_data,
-                  thr->frame.buffer, thr->frame.width, thr->frame.height,
-                  thr->frame.count, thr->frame.pitch,
-                  *thr->frame.msg ? thr->frame.msg : NULL,
+                  slot->dupe ? NULL : slot->buffer,
+                  slot->width, slot->height,
+                  slot->count, slot->pitch,
+                  *slot->msg ? slot->msg : NULL,
                   &video_info);
 
                slock_unlock(thr->frame.lock);
@@ -493,7 +538,6 @@ static void video_thread_loop(void *data)
          thr->focus         = focus;
          thr->has_windowed  = has_windowed;
          thr->vp            = vp;
-         thr->frame.updated = false;
          scond_signal(thr->cond_cmd);
          slock_unlock(thr->lock);
       }
@@ -577,7 +621,9 @@ static bool video_thread_frame(void *data, const void *frame_,
       unsigned width, unsigned height, uint64_t frame_count,
       unsigned pitch, const char *msg, video_frame_info_t *video_info)
 {
-   thread_video_t *thr = (thread_video_t*)data;
+   int prev;
+   thread_video_slot_t *slot = NULL;
+   thread_video_t *thr       = (thread_video_t*)data;
 
    if (!thr)
       return false;
@@ -595,19 +641,19 @@ static bool video_thread_frame(void *data, const void *frame_,
       return false;
    }
 
-   slock_lock(thr->lock);
-
+   /* With vsync on, let the video thread pace us:
+    * wait for it to take the pending frame, but no longer than
+    * a refresh interval since the last one, after which the
+    * pending frame is replaced. */
    if (!thr->nonblock)
    {
-      retro_time_t target_frame_time =
-         (retro_time_t)roundf(1000000 / video_info->refresh_rate);
-      retro_time_t target            = thr->last_time + target_frame_time;
+      retro_time_t target = thr->last_time
+         + (retro_time_t)roundf(1000000 / video_info->refresh_rate);
 
-      /* Ideally, use absolute time, but that is only a good idea on POSIX. */
-      while (thr->frame.updated)
+      slock_lock(thr->lock);
+      while (video_thread_mailbox_peek(thr) & THREAD_VIDEO_FRAME_FRESH)
       {
-         retro_time_t current = cpu_features_get_time_usec();
-         retro_time_t delta   = target - current;
+         retro_time_t delta = target - cpu_features_get_time_usec();
 
          if (delta <= 0)
             break;
@@ -615,50 +661,70 @@ static bool video_thread_frame(void *data, const void *frame_,
          if (!scond_wait_timeout(thr->cond_cmd, thr->lock, delta))
             break;
       }
+      slock_unlock(thr->lock);
    }
 
-   /* Drop frame if updated flag is still set, as thread is
-    * still working on last frame. */
-   if (!thr->frame.updated)
+   /* A duped frame while the previous one is still waiting
+    * to be rendered changes nothing, keep the pending one. */
+   if (     !frame_
+         && (video_thread_mailbox_peek(thr) & THREAD_VIDEO_FRAME_FRESH))
+      return true;
+
+   slot = &thr->frame.slots[thr->frame.back];
+
+   if (frame_ == slot->buffer)
+      /* Core rendered straight into our slot through
+       * GET_CURRENT_SOFTWARE_FRAMEBUFFER, nothing to copy */
+      slot->pitch = pitch;
+   else if (frame_)
    {
       const uint8_t *src   = (const uint8_t*)frame_;
-      uint8_t       *dst   = thr->frame.buffer;
+      uint8_t       *dst   = slot->buffer;
       unsigned copy_stride = width *
          (thr->info.rgb32 ? sizeof(uint32_t) : sizeof(uint16_t));
+      unsigned i;
 
-      if (src)
-      {
-         int i; /* TODO/FIXME - increment counter never meaningfully used */
-         for (i = 0; i < (int)height; i++, src += pitch, dst += copy_stride)
+      if (copy_stride == pitch)
+         memcpy(dst, src, (size_t)pitch * height);
+      else
+         for (i = 0; i < height; i++, src += pitch, dst += copy_stride)
             memcpy(dst, src, copy_stride);
-      }
 
-      thr->frame.updated = true;
-      thr->frame.width   = width;
-      thr->frame.height  = height;
-      thr->frame.count   = frame_count;
-      thr->frame.pitch   = copy_stride;
+      slot->pitch = copy_stride;
+   }
 
-      if (msg)
-         strlcpy(thr->frame.msg, msg, sizeof(thr->frame.msg));
-      else
-         *thr->frame.msg = '\0';
+   slot->dupe   = !frame_;
+   slot->width  = width;
+   slot->height = height;
+   slot->count  = frame_count;
+   slot->time   = cpu_features_get_time_usec();
 
-      scond_signal(thr->cond_thread);
+   if (msg)
+      strlcpy(slot->msg, msg, sizeof(slot->msg));
+   else
+      *slot->msg = '\0';
+
+   /* Publish, and take whichever slot was in the mailbox.
+    * If that one was never rendered, it is simply replaced. */
+   prev            = video_thread_mailbox_swap(thr,
+         (int)thr->frame.back | THREAD_VIDEO_FRAME_FRESH);
+   thr->frame.back = prev & THREAD_VIDEO_FRAME_SLOT_MASK;
+   thr->hit_count++;
+   if (prev & THREAD_VIDEO_FRAME_FRESH)
+      thr->miss_count++;
+
+   slock_lock(thr->lock);
+   scond_signal(thr->cond_thread);
 
 #ifdef HAVE_MENU
-      if (thr->texture.enable)
-      {
-         do
-         {
-            scond_wait(thr->cond_cmd, thr->lock);
-         } while (thr->frame.updated);
-      }
-#endif
-      thr->hit_count++;
+   /* The menu is driven by the video thread rendering,
+    * so keep it in lockstep while it is shown */
+   if (thr->texture.enable)
+   {
+      while (video_thread_mailbox_peek(thr) & THREAD_VIDEO_FRAME_FRESH)
+         scond_wait(thr->cond_cmd, thr->lock);
    }
-   else
-      thr->miss_count++;
+#endif
 
    slock_unlock(thr->lock);
 
@@ -689,28 +755,45 @@ static bool video_thread_init(thread_video_t *thr,
       return false;
    if (!(thr->frame.lock  = slock_new()))
       return false;
+#ifndef RETRO_ATOMIC_LOCK_FREE
+   if (!(thr->frame.mailbox_lock = slock_new()))
+      return false;
+#endif
    if (!(thr->cond_cmd    = scond_new()))
       return false;
    if (!(thr->cond_thread = scond_new()))
       return false;
 
    {
+      unsigned i;
       size_t max_size        = info.input_scale * RARCH_SCALE_BASE;
       max_size              *= max_size;
       max_size              *= info.rgb32 ?
          sizeof(uint32_t) : sizeof(uint16_t);
 
+      for (i = 0; i < THREAD_VIDEO_FRAME_SLOTS; i++)
+      {
 #ifdef _3DS
-      thr->frame.buffer      = linearMemAlign(max_size, 0x80);
+         thr->frame.slots[i].buffer = linearMemAlign(max_size, 0x80);
 #else
-      thr->frame.buffer      = (uint8_t*)malloc(max_size);
+         thr->frame.slots[i].buffer = (uint8_t*)malloc(max_size);
 #endif
-      if (!thr->frame.buffer)
-         return false;
+         if (!thr->frame.slots[i].buffer)
+            return false;
+
+         memset(thr->frame.slots[i].buffer, 0x80, max_size);
+      }
 
-      memset(thr->frame.buffer, 0x80, max_size);
+      /* Slot 0 is written by the emulation thread first,
+       * slot 1 sits in the mailbox (nothing to render yet),
+       * slot 2 is held by the video thread */
+      thr->frame.buffer_size = max_size;
+      thr->frame.back        = 0;
+      thr->frame.mailbox     = 1;
+      thr->frame.front       = 2;
    }
 
+   thr->frame.zero_copy      = info.threaded_zero_copy;
    thr->input                = input;
    thr->input_data           = input_data;
    thr->info                 = info;
@@ -818,6 +901,7 @@ static bool video_thread_read_viewport(void *data,
 
 static void video_thread_free(void *data)
 {
+   unsigned i;
    thread_video_t *thr = (thread_video_t*)data;
 
    if (thr)
@@ -840,22 +924,33 @@ static void video_thread_free(void *data)
       }
 
       free(thr->texture.frame);
+      for (i = 0; i < THREAD_VIDEO_FRAME_SLOTS; i++)
+      {
 #ifdef _3DS
-      linearFree(thr->frame.buffer);
+         linearFree(thr->frame.slots[i].buffer);
 #else
-      free(thr->frame.buffer);
+         free(thr->frame.slots[i].buffer);
 #endif
+      }
       free(thr->alpha_mod);
 
       slock_free(thr->frame.lock);
+#ifndef RETRO_ATOMIC_LOCK_FREE
+      slock_free(thr->frame.mailbox_lock);
+#endif
       slock_free(thr->alpha_lock);
       slock_free(thr->lock);
       scond_free(thr->cond_cmd);
       scond_free(thr->cond_thread);
 
       RARCH_LOG(
-         "Threaded video stats: Frames pushed: %u, Frames dropped: %u.\n",
-         thr->hit_count, thr->miss_count);
+         "Threaded video stats: Frames pushed: %u, Frames replaced: %u, "
+         "Frames rendered: %u, Latency avg/max: %u/%u usec.\n",
+         thr->hit_count, thr->miss_count, thr->frame.rendered,
+         thr->frame.rendered
+         ? (unsigned)(thr->frame.latency_total / thr->frame.rendered)
+         : 0,
+         (unsigned)thr->frame.latency_max);
 
       free(thr);
    }
@@ -1248,6 +1343,45 @@ static struct video_shader *thread_get_current_shader(void *data)
    return NULL;
 }
 
+/* Hands the core the slot it will publish next, so that
+ * it renders in place and video_thread_frame() skips the
+ * copy. Only possible when no conversion or filter sits
+ * between the core and the video driver. */
+static bool thread_get_current_software_framebuffer(void *data,
+      struct retro_framebuffer *framebuffer)
+{
+   size_t pitch;
+   enum retro_pixel_format fmt;
+   thread_video_t *thr            = (thread_video_t*)data;
+   video_driver_state_t *video_st = video_state_get_ptr();
+
+   if (!thr || !thr->frame.zero_copy || !framebuffer)
+      return false;
+
+   fmt = thr->info.rgb32
+      ? RETRO_PIXEL_FORMAT_XRGB8888
+      : RETRO_PIXEL_FORMAT_RGB565;
+
+   if (video_st->pix_fmt != fmt)
+      return false;
+#ifdef HAVE_VIDEO_FILTER
+   if (video_st->state_filter)
+      return false;
+#endif
+
+   pitch = framebuffer->width * (thr->info.rgb32
+         ? sizeof(uint32_t) : sizeof(uint16_t));
+
+   if (pitch * framebuffer->height > thr->frame.buffer_size)
+      return false;
+
+   framebuffer->data         = thr->frame.slots[thr->frame.back].buffer;
+   framebuffer->pitch        = pitch;
+   framebuffer->format       = fmt;
+   framebuffer->memory_flags = RETRO_MEMORY_TYPE_CACHED;
+   return true;
+}
+
 static uint32_t thread_get_flags(void *data)
 {
    thread_video_t *thr = (thread_video_t*)data;
@@ -1278,7 +1412,7 @@ static const video_poke_interface_t thread_poke = {
    thread_show_mouse,
    thread_grab_mouse_toggle,
    thread_get_current_shader,
-   NULL, /* get_current_software_framebuffer */
+   thread_get_current_software_framebuffer,
    NULL, /* get_hw_render_interface */
    thread_set_hdr_max_nits,
    thread_set_hdr_paper_white_nits,
@@ -21,6 +21,7 @@
 
 #include <boolean.h>
 #include <retro_common_api.h>
+#include <retro_atomic.h>
 #include <rthreads/rthreads.h>
 #include <retro_miscellaneous.h>
 
@@ -66,6 +67,29 @@ enum thread_cmd
    CMD_DUMMY = INT_MAX
 };
 
+/* Frames are handed from the emulation thread to the video
+ * thread through a triple-buffered mailbox: one slot is owned
+ * by each thread, and the third holds the latest published
+ * frame. Publishing swaps the producer's slot with the mailbox,
+ * so the emulation thread never waits for the video thread and
+ * the newest frame is never dropped. */
+#define THREAD_VIDEO_FRAME_SLOTS      3
+#define THREAD_VIDEO_FRAME_SLOT_MASK  0x3
+/* Set in the mailbox when it holds a frame not yet rendered */
+#define THREAD_VIDEO_FRAME_FRESH      0x4
+
+typedef struct thread_video_slot
+{
+   retro_time_t time;      /* When the frame was published */
+   uint64_t count;
+   uint8_t *buffer;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   char msg[NAME_MAX_LENGTH];
+   bool dupe;              /* Core asked to redraw the previous frame */
+} thread_video_slot_t;
+
 typedef int (*custom_command_method_t)(void*);
 
 typedef bool (*custom_font_command_method_t)(const void **font_driver,
@@ -203,8 +227,8 @@ typedef struct thread_video
       bool full_screen;
    } texture;
 
-   unsigned hit_count;
-   unsigned miss_count;
+   unsigned hit_count;   /* Frames published */
+   unsigned miss_count;  /* Frames replaced before they were rendered */
    unsigned alpha_mods;
 
    struct video_viewport vp;
@@ -220,15 +244,21 @@ typedef struct thread_video
 
    struct
    {
-      uint64_t count;
+      thread_video_slot_t slots[THREAD_VIDEO_FRAME_SLOTS];
+      /* Publish-to-render latency, in microseconds */
+      retro_time_t latency_total;
+      retro_time_t latency_max;
       slock_t *lock;
-      uint8_t *buffer;
-      unsigned width;
-      unsigned height;
-      unsigned pitch;
-      char msg[NAME_MAX_LENGTH];
-      bool updated;
+#ifndef RETRO_ATOMIC_LOCK_FREE
+      slock_t *mailbox_lock;
+#endif
+      size_t buffer_size;
+      unsigned rendered;
+      unsigned back;                /* Owned by the emulation thread */
+      unsigned front;               /* Owned by the video thread */
+      retro_atomic_int_t mailbox;   /* Latest slot | FRAME_FRESH */
       bool within_thread;
+      bool zero_copy;
    } frame;
 
    bool apply_state_changes;
@@ -139,6 +139,7 @@ COMPRESSION
 ============================================================ */
 #include "../libretro-common/streams/stdin_stream.c"
 #include "../libretro-common/streams/trans_stream.c"
+#include "../libretro-common/streams/trans_stream_lz4.c"
 #include "../libretro-common/streams/trans_stream_pipe.c"
 
 #ifdef HAVE_ZLIB
@@ -239,6 +240,7 @@ CHEATS
 ============================================================ */
 #ifdef HAVE_CHEATS
 #include "../cheat_manager.c"
+#include "../tasks/task_cheat_search.c"
 #endif
 #include "../libretro-common/hash/lrc_hash.c"
 
@@ -1102,6 +1104,9 @@ FILE
 #endif
 #if defined(HAVE_MMAP_WIN32)
 #include "../libretro-common/file/nbio/nbio_windowsmmap.c"
+#if !defined(__WINRT__)
+#include "../libretro-common/memmap/memmap.c"
+#endif
 #endif
 #include "../libretro-common/file/nbio/nbio_intf.c"
 
@@ -1641,6 +1646,11 @@ MANUAL CONTENT SCAN
 ============================================================ */
 #include "../manual_content_scan.c"
 
+/*============================================================
+CONTENT FINGERPRINT CACHE
+============================================================ */
+#include "../content_fingerprint.c"
+
 /*============================================================
 DISK CONTROL INTERFACE
 ============================================================ */
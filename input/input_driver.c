@@ -45,6 +45,7 @@
 #endif
 
 #include "../accessibility.h"
+#include "../audio/audio_driver.h"
 #include "../command.h"
 #include "../config.def.keybinds.h"
 #include "../configuration.h"
@@ -65,6 +66,10 @@
 
 #define HOLD_BTN_DELAY_SEC 2
 
+/* Time spent running replay frames towards a seek target,
+ * per runloop iteration */
+#define BSV_MOVIE_SEEK_STEP_USEC 12000
+
 /* Depends on ASCII character values */
 #define ISPRINT(c) (((int)(c) >= ' ' && (int)(c) <= '~') ? 1 : 0)
 
@@ -5929,6 +5934,13 @@ void bsv_movie_frame_rewind(void)
 
    handle->did_rewind = true;
 
+   if (recording)
+   {
+      bsv_movie_sync(handle);
+      /* The previous checkpoint may get truncated away */
+      handle->checkpoint_pos = -1;
+   }
+
    if (     ( (handle->frame_counter & handle->frame_mask) <= 1)
          && (handle->frame_pos[0] == handle->min_file_pos))
    {
@@ -6055,6 +6067,12 @@ void bsv_movie_finish_rewind(input_driver_state_t *input_st)
 void bsv_movie_read_next_events(bsv_movie_t *handle)
 {
    input_driver_state_t *input_st = input_state_get_ptr();
+   /* Don't read the footer index as frames */
+   if (handle->end_pos && intfstream_tell(handle->file) >= handle->end_pos)
+   {
+      input_st->bsv_movie_state.flags |= BSV_FLAG_MOVIE_END;
+      return;
+   }
    if (intfstream_read(handle->file, &(handle->key_event_count), 1) == 1)
    {
       int i;
@@ -6114,6 +6132,15 @@ void bsv_movie_read_next_events(bsv_movie_t *handle)
          input_st->bsv_movie_state.flags |= BSV_FLAG_MOVIE_END;
          return;
       }
+      else if (next_frame_type == REPLAY_TOKEN_CHECKPOINT2_FRAME)
+      {
+         if (!bsv_movie_read_checkpoint(handle, true))
+         {
+            RARCH_ERR("[Replay] Replay checkpoint truncated\n");
+            input_st->bsv_movie_state.flags |= BSV_FLAG_MOVIE_END;
+            return;
+         }
+      }
       else if (next_frame_type == REPLAY_TOKEN_CHECKPOINT_FRAME)
       {
          uint64_t size;
@@ -6129,7 +6156,18 @@ void bsv_movie_read_next_events(bsv_movie_t *handle)
          }
 
          size = swap_if_big64(size);
-         st   = (uint8_t*)malloc(size);
+         /* Don't trust the file with the allocation size */
+         if (size > core_serialize_size())
+         {
+            RARCH_ERR("[Replay] Invalid checkpoint size.\n");
+            input_st->bsv_movie_state.flags |= BSV_FLAG_MOVIE_END;
+            return;
+         }
+         if (!(st = (uint8_t*)malloc(size)))
+         {
+            input_st->bsv_movie_state.flags |= BSV_FLAG_MOVIE_END;
+            return;
+         }
          if (intfstream_read(handle->file, st, size) != (int64_t)size)
          {
             RARCH_ERR("[Replay] Replay checkpoint truncated\n");
@@ -6171,20 +6209,18 @@ void bsv_movie_next_frame(input_driver_state_t *input_st)
 
    if (input_st->bsv_movie_state.flags & BSV_FLAG_MOVIE_RECORDING)
    {
-      int i;
+      bool checkpoint    = false;
       uint16_t evt_count = swap_if_big16(handle->input_event_count);
       /* write key events, frame is over */
-      intfstream_write(handle->file, &(handle->key_event_count), 1);
-      for (i = 0; i < handle->key_event_count; i++)
-         intfstream_write(handle->file, &(handle->key_events[i]),
-               sizeof(bsv_key_data_t));
+      bsv_movie_write(handle, &(handle->key_event_count), 1);
+      bsv_movie_write(handle, handle->key_events,
+            handle->key_event_count * sizeof(bsv_key_data_t));
       /* Zero out key events when playing back or recording */
       handle->key_event_count = 0;
       /* write input events, frame is over */
-      intfstream_write(handle->file, &evt_count, 2);
-      for (i = 0; i < handle->input_event_count; i++)
-         intfstream_write(handle->file, &(handle->input_events[i]),
-               sizeof(bsv_input_data_t));
+      bsv_movie_write(handle, &evt_count, 2);
+      bsv_movie_write(handle, handle->input_events,
+            handle->input_event_count * sizeof(bsv_input_data_t));
       /* Zero out input events when playing back or recording */
       handle->input_event_count = 0;
 
@@ -6192,27 +6228,23 @@ void bsv_movie_next_frame(input_driver_state_t *input_st)
       if (     (checkpoint_interval != 0)
             && (handle->frame_counter > 0)
             && (handle->frame_counter % (checkpoint_interval*60) == 0))
-      {
-         retro_ctx_serialize_info_t serial_info;
-         uint8_t frame_tok = REPLAY_TOKEN_CHECKPOINT_FRAME;
-         size_t _len       = core_serialize_size();
-         uint64_t size     = swap_if_big64(_len);
-         uint8_t *st       = (uint8_t*)malloc(_len);
-         serial_info.data  = st;
-         serial_info.size  = _len;
-         core_serialize(&serial_info);
-         /* "next frame is a checkpoint" */
-         intfstream_write(handle->file, (uint8_t *)(&frame_tok), sizeof(uint8_t));
-         intfstream_write(handle->file, &size, sizeof(uint64_t));
-         intfstream_write(handle->file, st, _len);
-         free(st);
-      }
-      else
+         checkpoint = bsv_movie_write_checkpoint(handle);
+
+      if (!checkpoint)
       {
          uint8_t frame_tok = REPLAY_TOKEN_REGULAR_FRAME;
          /* write "next frame is not a checkpoint" */
-         intfstream_write(handle->file, (uint8_t *)(&frame_tok), sizeof(uint8_t));
+         bsv_movie_write(handle, &frame_tok, sizeof(uint8_t));
       }
+
+      /* Hand the file writes off in batches, about once a second */
+      if (     checkpoint
+            || ++handle->frames_since_flush >= 60
+            || handle->record_len >= (64 << 10))
+         bsv_movie_kick(handle);
+
+      handle->frame_pos[handle->frame_counter & handle->frame_mask] = bsv_movie_tell(handle);
+      return;
    }
 
    if (input_st->bsv_movie_state.flags & BSV_FLAG_MOVIE_PLAYBACK)
@@ -6220,11 +6252,188 @@ void bsv_movie_next_frame(input_driver_state_t *input_st)
    handle->frame_pos[handle->frame_counter & handle->frame_mask] = intfstream_tell(handle->file);
 }
 
+/**
+ * bsv_movie_seek:
+ * @input_st : Input driver state, with a replay being played back.
+ * @frame    : Frame to seek to.
+ *
+ * Jumps to the nearest checkpoint at or before @frame (from the
+ * footer index, or a scan of the file if it has none). The frames
+ * from there on are run by bsv_movie_seek_step(), so that a long
+ * seek doesn't stall the frontend.
+ *
+ * Returns: true if the seek was started.
+ **/
+bool bsv_movie_seek(input_driver_state_t *input_st, uint64_t frame)
+{
+   size_t i;
+   uint64_t best_frame            = 0;
+   uint32_t video_flags;
+   uint8_t audio_flags;
+   video_driver_state_t *video_st = video_state_get_ptr();
+   audio_driver_state_t *audio_st = audio_state_get_ptr();
+   bsv_movie_t *handle            = input_st->bsv_movie_state_handle;
+   const bsv_movie_index_entry_t *best = NULL;
+
+   if (     !handle
+         || !(input_st->bsv_movie_state.flags & BSV_FLAG_MOVIE_PLAYBACK))
+      return false;
+
+   if (!handle->index_valid && !bsv_movie_build_index(handle))
+      return false;
+
+   /* Index entries are in frame order. Records past the first are
+    * read a frame early, except in version 0 replays. */
+   for (i = 0; i < handle->index_count; i++)
+   {
+      uint64_t at = handle->index[i].frame + (handle->version > 0 ? 0 : 1);
+      if (at > frame)
+         break;
+      best       = &handle->index[i];
+      best_frame = at;
+   }
+
+   video_flags = video_st->flags;
+   audio_flags = audio_st->flags;
+   audio_st->flags |= AUDIO_FLAG_SUSPENDED;
+   video_st->flags &= ~VIDEO_FLAG_ACTIVE;
+
+   /* Only jump if it isn't quicker to just keep running */
+   if (     best
+         && (   frame < handle->frame_counter
+             || best_frame > handle->frame_counter + 1))
+   {
+      size_t first = best - handle->index;
+
+      /* Delta checkpoints need the chain since the last full one */
+      while (first > 0 && !handle->index[first].full)
+         first--;
+
+      handle->checkpoint_pos = -1;
+      for (i = first; i < (size_t)(best - handle->index); i++)
+      {
+         intfstream_seek(handle->file,
+               handle->index[i].checkpoint_pos + 1, SEEK_SET);
+         if (!bsv_movie_read_checkpoint(handle, false))
+            break;
+      }
+
+      /* Replays the frame reading the checkpoint record, so the
+       * counter and inputs match regular playback from there */
+      intfstream_seek(handle->file, best->record_pos, SEEK_SET);
+      input_st->bsv_movie_state.flags &= ~BSV_FLAG_MOVIE_END;
+      handle->frame_counter = best_frame ? best_frame - 1 : 0;
+      bsv_movie_read_next_events(handle);
+      handle->frame_pos[handle->frame_counter & handle->frame_mask] =
+            intfstream_tell(handle->file);
+      if (best_frame)
+      {
+         core_run();
+         bsv_movie_finish_rewind(input_st);
+      }
+   }
+   else if (frame < handle->frame_counter)
+   {
+      /* No checkpoint before it, start over */
+      retro_ctx_serialize_info_t serial_info;
+
+      intfstream_seek(handle->file, handle->min_file_pos, SEEK_SET);
+      input_st->bsv_movie_state.flags &= ~BSV_FLAG_MOVIE_END;
+      handle->checkpoint_pos = -1;
+      if (handle->state_size)
+      {
+         serial_info.data_const = handle->state;
+         serial_info.size       = handle->state_size;
+         core_unserialize(&serial_info);
+      }
+      handle->frame_counter = 0;
+      handle->frame_pos[0]  = handle->min_file_pos;
+      if (handle->version > 0)
+         bsv_movie_read_next_events(handle);
+   }
+
+   video_st->flags    = video_flags;
+   audio_st->flags    = audio_flags;
+
+   handle->seek_frame = frame;
+   handle->seek_start = handle->frame_counter;
+   handle->seeking    = handle->frame_counter < frame;
+
+   return true;
+}
+
+/**
+ * bsv_movie_seek_step:
+ * @input_st : Input driver state.
+ *
+ * Runs the core towards the target of a pending bsv_movie_seek()
+ * with video and audio suppressed, for at most
+ * BSV_MOVIE_SEEK_STEP_USEC per call, and shows how far it got.
+ **/
+void bsv_movie_seek_step(input_driver_state_t *input_st)
+{
+   retro_time_t deadline;
+   uint32_t video_flags;
+   uint8_t audio_flags;
+   video_driver_state_t *video_st = video_state_get_ptr();
+   audio_driver_state_t *audio_st = audio_state_get_ptr();
+   bsv_movie_t *handle            = input_st->bsv_movie_state_handle;
+
+   if (!handle || !handle->seeking)
+      return;
+
+   deadline         = cpu_features_get_time_usec() + BSV_MOVIE_SEEK_STEP_USEC;
+   video_flags      = video_st->flags;
+   audio_flags      = audio_st->flags;
+   audio_st->flags |= AUDIO_FLAG_SUSPENDED;
+   video_st->flags &= ~VIDEO_FLAG_ACTIVE;
+
+   while (     handle->frame_counter < handle->seek_frame
+         && !(input_st->bsv_movie_state.flags & BSV_FLAG_MOVIE_END)
+         && cpu_features_get_time_usec() < deadline)
+   {
+      bsv_movie_next_frame(input_st);
+      core_run();
+      bsv_movie_finish_rewind(input_st);
+   }
+
+   video_st->flags = video_flags;
+   audio_st->flags = audio_flags;
+
+   if (input_st->bsv_movie_state.flags & BSV_FLAG_MOVIE_END)
+   {
+      RARCH_WARN("[Replay] Replay ended at frame %llu, before seek target %llu.\n",
+            (unsigned long long)handle->frame_counter,
+            (unsigned long long)handle->seek_frame);
+      handle->seeking = false;
+   }
+   else if (handle->frame_counter < handle->seek_frame)
+   {
+      char msg[128];
+      size_t _len = strlcpy(msg, msg_hash_to_str(MSG_REPLAY_SEEKING),
+            sizeof(msg));
+      snprintf(msg + _len, sizeof(msg) - _len, ": %u%%",
+            (unsigned)(100 * (handle->frame_counter - handle->seek_start)
+               / (handle->seek_frame - handle->seek_start)));
+      runloop_msg_queue_push(msg, strlen(msg), 1, 1, true, NULL,
+            MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+   }
+   else
+   {
+      RARCH_LOG("[Replay] Seeked to frame %llu.\n",
+            (unsigned long long)handle->frame_counter);
+      handle->seeking = false;
+   }
+}
+
 size_t replay_get_serialize_size(void)
 {
    input_driver_state_t *input_st = &input_driver_st;
    if (input_st->bsv_movie_state.flags & (BSV_FLAG_MOVIE_RECORDING | BSV_FLAG_MOVIE_PLAYBACK))
+   {
+      bsv_movie_sync(input_st->bsv_movie_state_handle);
       return sizeof(int32_t)+intfstream_tell(input_st->bsv_movie_state_handle->file);
+   }
    return 0;
 }
 
@@ -6235,11 +6444,15 @@ bool replay_get_serialized_data(void* buffer)
 
    if (input_st->bsv_movie_state.flags & (BSV_FLAG_MOVIE_RECORDING | BSV_FLAG_MOVIE_PLAYBACK))
    {
-      int64_t file_end        = intfstream_tell(handle->file);
-      int64_t read_amt        = 0;
-      long file_end_lil       = swap_if_big32(file_end);
-      uint8_t *file_end_bytes = (uint8_t *)(&file_end_lil);
-      uint8_t *buf            = buffer;
+      int64_t file_end, read_amt;
+      long file_end_lil;
+      uint8_t *file_end_bytes, *buf;
+      bsv_movie_sync(handle);
+      file_end                = intfstream_tell(handle->file);
+      read_amt                = 0;
+      file_end_lil            = swap_if_big32(file_end);
+      file_end_bytes          = (uint8_t *)(&file_end_lil);
+      buf                     = buffer;
       buf[0]                  = file_end_bytes[0];
       buf[1]                  = file_end_bytes[1];
       buf[2]                  = file_end_bytes[2];
@@ -6298,8 +6511,13 @@ bool replay_set_serialized_data(void* buf)
 
       if (ident == input_st->bsv_movie_state_handle->identifier) /* is compatible? */
       {
-         int32_t loaded_len    = swap_if_big32(((int32_t *)buffer)[0]);
-         int64_t handle_idx    = intfstream_tell(
+         int32_t loaded_len;
+         int64_t handle_idx;
+         bsv_movie_sync(input_st->bsv_movie_state_handle);
+         /* Checkpoint deltas must not cross the jump */
+         input_st->bsv_movie_state_handle->checkpoint_pos = -1;
+         loaded_len            = swap_if_big32(((int32_t *)buffer)[0]);
+         handle_idx            = intfstream_tell(
                input_st->bsv_movie_state_handle->file);
          /* If the state is part of this replay, go back to that state
             and rewind/fast forward the replay.
@@ -28,6 +28,9 @@
 #include <libretro.h>
 #include <retro_miscellaneous.h>
 #include <streams/interface_stream.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 #ifdef HAVE_CONFIG_H
 #include "../config.h"
 #endif /* HAVE_CONFIG_H */
@@ -103,6 +106,11 @@
 #define REPLAY_TOKEN_INVALID          '\0'
 #define REPLAY_TOKEN_REGULAR_FRAME    'f'
 #define REPLAY_TOKEN_CHECKPOINT_FRAME 'c'
+/* Compressed checkpoint, possibly a delta against the previous one */
+#define REPLAY_TOKEN_CHECKPOINT2_FRAME 'C'
+
+#define REPLAY_CHECKPOINT2_FULL  0
+#define REPLAY_CHECKPOINT2_DELTA 1
 
 /**
  * Takes as input analog key identifiers and converts them to corresponding
@@ -199,6 +207,18 @@ struct bsv_input_data
 };
 typedef struct bsv_input_data bsv_input_data_t;
 
+/* Where to find a checkpoint, for seeking */
+typedef struct bsv_movie_index_entry
+{
+   /* Number of the frame record holding the checkpoint,
+    * counted from the first one after the initial state */
+   uint64_t frame;
+   uint64_t record_pos;
+   uint64_t checkpoint_pos;
+   /* Whether it decodes without the previous checkpoint */
+   bool full;
+} bsv_movie_index_entry_t;
+
 struct bsv_movie
 {
    intfstream_t *file;
@@ -220,6 +240,53 @@ struct bsv_movie
    bsv_key_data_t key_events[128];
    bsv_input_data_t input_events[512];
 
+   /* Recording goes through a memory buffer, drained into
+    * 'file' by a writer thread so the main thread never waits
+    * on disk I/O. While the writer is busy it owns 'file'. */
+   uint8_t *record_buf;
+   uint8_t *flush_buf;
+   size_t record_len;
+   size_t record_cap;
+   size_t flush_len;
+   size_t flush_cap;
+   /* File position once everything recorded is written,
+    * -1 if it has to be asked from the file */
+   int64_t write_pos;
+   unsigned frames_since_flush;
+#ifdef HAVE_THREADS
+   sthread_t *writer;
+   slock_t *writer_lock;
+   scond_t *writer_cond;
+   bool writer_busy;
+   bool writer_quit;
+#endif
+
+   /* Last checkpoint, which the next delta is against,
+    * and the offset of its record (-1 if there is none) */
+   uint8_t *checkpoint;
+   uint8_t *checkpoint_scratch;
+   uint8_t *checkpoint_packed;
+   void *checkpoint_stream;
+   int64_t checkpoint_pos;
+   size_t checkpoint_size;
+   size_t checkpoint_packed_cap;
+   unsigned checkpoint_count;
+
+   /* Checkpoint index, from the file footer or a scan */
+   bsv_movie_index_entry_t *index;
+   size_t index_count;
+   size_t index_cap;
+   /* Where frame records end and the footer begins,
+    * 0 if there is no footer */
+   int64_t end_pos;
+   bool index_valid;
+
+   /* Pending seek, run a batch of frames at a time
+    * by bsv_movie_seek_step() */
+   uint64_t seek_frame;
+   uint64_t seek_start;
+   bool seeking;
+
    /* Rewind state */
    bool playback;
    bool first_rewind;
@@ -1038,6 +1105,16 @@ void bsv_movie_deinit(input_driver_state_t *input_st);
 void bsv_movie_deinit_full(input_driver_state_t *input_st);
 void bsv_movie_enqueue(input_driver_state_t *input_st, bsv_movie_t *state, enum bsv_flags flags);
 
+void bsv_movie_write(bsv_movie_t *handle, const void *data, size_t len);
+void bsv_movie_kick(bsv_movie_t *handle);
+void bsv_movie_sync(bsv_movie_t *handle);
+int64_t bsv_movie_tell(bsv_movie_t *handle);
+bool bsv_movie_write_checkpoint(bsv_movie_t *handle);
+bool bsv_movie_read_checkpoint(bsv_movie_t *handle, bool load);
+bool bsv_movie_build_index(bsv_movie_t *handle);
+bool bsv_movie_seek(input_driver_state_t *input_st, uint64_t frame);
+void bsv_movie_seek_step(input_driver_state_t *input_st);
+
 bool movie_start_playback(input_driver_state_t *input_st, char *path);
 bool movie_start_record(input_driver_state_t *input_st, char *path);
 bool movie_stop_playback(input_driver_state_t *input_st);
@@ -15210,6 +15210,10 @@ MSG_HASH(
    MSG_REPLAY_SLOT,
    "Replay slot"
    )
+MSG_HASH(
+   MSG_REPLAY_SEEKING,
+   "Seeking replay"
+   )
 MSG_HASH(
    MSG_TAKING_SCREENSHOT,
    "Taking screenshot."
@@ -15546,6 +15550,14 @@ MSG_HASH(
    MSG_CHEAT_SEARCH_FOUND_MATCHES,
    "New match count = %u"
    )
+MSG_HASH(
+   MSG_CHEAT_SEARCH_RUNNING,
+   "Searching memory"
+   )
+MSG_HASH(
+   MSG_CHEAT_SEARCH_IN_PROGRESS,
+   "A search is already running."
+   )
 MSG_HASH(
    MSG_CHEAT_SEARCH_ADDED_MATCHES_SUCCESS,
    "Added %u matches."
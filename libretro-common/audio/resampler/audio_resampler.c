@@ -101,6 +101,32 @@ static const retro_resampler_t *find_resampler_driver(const char *ident)
    return resampler_drivers[0];
 }
 
+/**
+ * resampler_get_simd_mask:
+ *
+ * Returns: SIMD instruction sets usable by resamplers, which is
+ * cpu_features_get() plus the RESAMPLER_SIMD_FMA and
+ * RESAMPLER_SIMD_AVX512 bits where they apply.
+ **/
+static resampler_simd_mask_t resampler_get_simd_mask(void)
+{
+   resampler_simd_mask_t mask = (resampler_simd_mask_t)cpu_features_get();
+#if (defined(__x86_64__) || defined(__i386__)) \
+      && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+   /* __builtin_cpu_supports also checks that the OS
+    * saves the wider register state. */
+   if (mask & RESAMPLER_SIMD_AVX2)
+   {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("fma"))
+         mask |= RESAMPLER_SIMD_FMA;
+      if (__builtin_cpu_supports("avx512f"))
+         mask |= RESAMPLER_SIMD_AVX512;
+   }
+#endif
+   return mask;
+}
+
 /**
  * resampler_append_plugs:
  * @re                         : Resampler handle
@@ -116,7 +142,7 @@ static bool resampler_append_plugs(void **re,
       enum resampler_quality quality,
       double bw_ratio)
 {
-   resampler_simd_mask_t mask = (resampler_simd_mask_t)cpu_features_get();
+   resampler_simd_mask_t mask = resampler_get_simd_mask();
 
    if (*backend)
       *re = (*backend)->init(&resampler_config, bw_ratio, quality, mask);
@@ -187,3 +213,13 @@ bool retro_resampler_realloc(void **re, const retro_resampler_t **backend,
 
    return true;
 }
+
+void retro_resampler_cache_init(void)
+{
+   sinc_resampler_cache_init();
+}
+
+void retro_resampler_cache_deinit(void)
+{
+   sinc_resampler_cache_deinit();
+}
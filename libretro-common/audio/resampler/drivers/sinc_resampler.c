@@ -43,6 +43,25 @@
 #include <immintrin.h>
 #endif
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+/* The FMA and AVX-512 paths are picked at runtime, so they
+ * must build without building the whole file for them. */
+#if (defined(__x86_64__) || defined(__i386__)) \
+      && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define HAVE_SINC_FMA
+#define HAVE_SINC_AVX512
+#include <immintrin.h>
+#define SINC_FMA_TARGET    __attribute__((target("avx2,fma")))
+#define SINC_AVX512_TARGET __attribute__((target("avx512f,avx2,fma")))
+#endif
+
+/* Phase tables no resampler uses are kept around for reuse,
+ * up to this many. */
+#define SINC_TABLE_CACHE_UNUSED_MAX 4
+
 /* Rough SNR values for upsampling:
  * LOWEST: 40 dB
  * LOWER: 55 dB
@@ -66,12 +85,38 @@ enum sinc_window
  * of sinc taps, the AVX code is clearly faster than SSE1.
  */
 
+/* Phase tables only depend on the quality settings and the
+ * (bucketed) ratio, so they are shared between resamplers
+ * and cached across core and driver reinits. */
+struct sinc_table
+{
+   struct sinc_table *next;
+   float *phase_table;
+   double cutoff;
+   float kaiser_beta;
+   unsigned phase_bits;
+   unsigned taps;
+   unsigned refs;
+   enum sinc_window window_type;
+};
+
+/* The cache lives from sinc_resampler_cache_init to
+ * sinc_resampler_cache_deinit, so tables survive driver
+ * reinits and core switches. Until it is set up, every
+ * resampler builds a table of its own. */
+static struct sinc_table *sinc_table_cache = NULL;
+static bool sinc_table_cache_inited        = false;
+#ifdef HAVE_THREADS
+static slock_t *sinc_table_cache_lock      = NULL;
+#endif
+
 typedef struct rarch_sinc_resampler
 {
-   /* A buffer for phase_table, buffer_l and buffer_r
+   /* A buffer for buffer_l and buffer_r
     * are created in a single calloc().
     * Ensure that we get as good cache locality as we can hope for. */
    float *main_buffer;
+   struct sinc_table *table;
    float *phase_table;
    float *buffer_l;
    float *buffer_r;
@@ -83,6 +128,9 @@ typedef struct rarch_sinc_resampler
    uint32_t time;
    float subphase_mod;
    float kaiser_beta;
+   /* Picked per resampler, as the kernel depends on
+    * the number of taps the phase table was built for */
+   void (*process)(void *re_, struct resampler_data *data);
 } rarch_sinc_resampler_t;
 
 #if (defined(__ARM_NEON__) || defined(HAVE_NEON))
@@ -407,6 +455,307 @@ static void resampler_sinc_process_avx(void *re_, struct resampler_data *data)
 }
 #endif
 
+#ifdef HAVE_SINC_FMA
+/* Sums up both channels at once.
+ * Returns { L, R, L, R }. */
+static SINC_FMA_TARGET INLINE __m128 resampler_sinc_hsum_avx(
+      __m256 sum_l, __m256 sum_r)
+{
+   /* sum = { r23, r01, l23, l01 | r67, r45, l67, l45 } */
+   __m256 sum = _mm256_hadd_ps(sum_l, sum_r);
+   /* sum = { R0-3, L0-3, R0-3, L0-3 | R4-7, L4-7, R4-7, L4-7 } */
+   sum        = _mm256_hadd_ps(sum, sum);
+   return _mm_add_ps(_mm256_castps256_ps128(sum),
+         _mm256_extractf128_ps(sum, 1));
+}
+
+static SINC_FMA_TARGET void resampler_sinc_process_fma_kaiser(
+      void *re_, struct resampler_data *data)
+{
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
+   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+
+   uint32_t ratio                 = phases / data->ratio;
+   const float *input             = data->data_in;
+   float *output                  = data->data_out;
+   size_t frames                  = data->input_frames;
+   size_t out_frames              = 0;
+   unsigned taps                  = resamp->taps;
+
+   while (frames)
+   {
+      while (frames && resamp->time >= phases)
+      {
+         /* Push in reverse to make filter more obvious. */
+         if (!resamp->ptr)
+            resamp->ptr = taps;
+         resamp->ptr--;
+
+         resamp->buffer_l[resamp->ptr + taps] =
+            resamp->buffer_l[resamp->ptr]     = *input++;
+
+         resamp->buffer_r[resamp->ptr + taps] =
+            resamp->buffer_r[resamp->ptr]     = *input++;
+
+         resamp->time                        -= phases;
+         frames--;
+      }
+
+      {
+         const float *buffer_l    = resamp->buffer_l + resamp->ptr;
+         const float *buffer_r    = resamp->buffer_r + resamp->ptr;
+         while (resamp->time < phases)
+         {
+            int i;
+            unsigned phase           = resamp->time >> resamp->subphase_bits;
+            const float *phase_table = resamp->phase_table + phase * taps * 2;
+            const float *delta_table = phase_table + taps;
+            __m256 delta             = _mm256_set1_ps((float)
+                  (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
+            __m256 sum_l             = _mm256_setzero_ps();
+            __m256 sum_r             = _mm256_setzero_ps();
+
+            /* Each coefficient is interpolated once
+             * and then applied to both channels. */
+            for (i = 0; i < (int)taps; i += 8)
+            {
+               __m256 sinc = _mm256_fmadd_ps(_mm256_load_ps(delta_table + i),
+                     delta, _mm256_load_ps(phase_table + i));
+               sum_l       = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_l + i),
+                     sinc, sum_l);
+               sum_r       = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_r + i),
+                     sinc, sum_r);
+            }
+
+            _mm_storel_pi((__m64*)output,
+                  resampler_sinc_hsum_avx(sum_l, sum_r));
+
+            output += 2;
+            out_frames++;
+            resamp->time += ratio;
+         }
+      }
+   }
+
+   data->output_frames = out_frames;
+}
+
+static SINC_FMA_TARGET void resampler_sinc_process_fma(
+      void *re_, struct resampler_data *data)
+{
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
+   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+
+   uint32_t ratio                 = phases / data->ratio;
+   const float *input             = data->data_in;
+   float *output                  = data->data_out;
+   size_t frames                  = data->input_frames;
+   size_t out_frames              = 0;
+   unsigned taps                  = resamp->taps;
+
+   while (frames)
+   {
+      while (frames && resamp->time >= phases)
+      {
+         /* Push in reverse to make filter more obvious. */
+         if (!resamp->ptr)
+            resamp->ptr = taps;
+         resamp->ptr--;
+
+         resamp->buffer_l[resamp->ptr + taps] =
+            resamp->buffer_l[resamp->ptr]     = *input++;
+
+         resamp->buffer_r[resamp->ptr + taps] =
+            resamp->buffer_r[resamp->ptr]     = *input++;
+
+         resamp->time                        -= phases;
+         frames--;
+      }
+
+      {
+         const float *buffer_l    = resamp->buffer_l + resamp->ptr;
+         const float *buffer_r    = resamp->buffer_r + resamp->ptr;
+         while (resamp->time < phases)
+         {
+            int i;
+            unsigned phase           = resamp->time >> resamp->subphase_bits;
+            const float *phase_table = resamp->phase_table + phase * taps;
+            __m256 sum_l             = _mm256_setzero_ps();
+            __m256 sum_r             = _mm256_setzero_ps();
+
+            for (i = 0; i < (int)taps; i += 8)
+            {
+               __m256 sinc = _mm256_load_ps(phase_table + i);
+               sum_l       = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_l + i),
+                     sinc, sum_l);
+               sum_r       = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_r + i),
+                     sinc, sum_r);
+            }
+
+            _mm_storel_pi((__m64*)output,
+                  resampler_sinc_hsum_avx(sum_l, sum_r));
+
+            output += 2;
+            out_frames++;
+            resamp->time += ratio;
+         }
+      }
+   }
+
+   data->output_frames = out_frames;
+}
+#endif
+
+#ifdef HAVE_SINC_AVX512
+/* Folds the upper half of both sums onto the lower half,
+ * then sums up like the AVX2 path. */
+static SINC_AVX512_TARGET INLINE __m128 resampler_sinc_hsum_avx512(
+      __m512 sum_l, __m512 sum_r)
+{
+   __m256 l = _mm256_add_ps(_mm512_castps512_ps256(sum_l),
+         _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(sum_l), 1)));
+   __m256 r = _mm256_add_ps(_mm512_castps512_ps256(sum_r),
+         _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(sum_r), 1)));
+   return resampler_sinc_hsum_avx(l, r);
+}
+
+/* Assumes that taps is a multiple of 16. */
+static SINC_AVX512_TARGET void resampler_sinc_process_avx512_kaiser(
+      void *re_, struct resampler_data *data)
+{
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
+   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+
+   uint32_t ratio                 = phases / data->ratio;
+   const float *input             = data->data_in;
+   float *output                  = data->data_out;
+   size_t frames                  = data->input_frames;
+   size_t out_frames              = 0;
+   unsigned taps                  = resamp->taps;
+
+   while (frames)
+   {
+      while (frames && resamp->time >= phases)
+      {
+         /* Push in reverse to make filter more obvious. */
+         if (!resamp->ptr)
+            resamp->ptr = taps;
+         resamp->ptr--;
+
+         resamp->buffer_l[resamp->ptr + taps] =
+            resamp->buffer_l[resamp->ptr]     = *input++;
+
+         resamp->buffer_r[resamp->ptr + taps] =
+            resamp->buffer_r[resamp->ptr]     = *input++;
+
+         resamp->time                        -= phases;
+         frames--;
+      }
+
+      {
+         const float *buffer_l    = resamp->buffer_l + resamp->ptr;
+         const float *buffer_r    = resamp->buffer_r + resamp->ptr;
+         while (resamp->time < phases)
+         {
+            int i;
+            unsigned phase           = resamp->time >> resamp->subphase_bits;
+            const float *phase_table = resamp->phase_table + phase * taps * 2;
+            const float *delta_table = phase_table + taps;
+            __m512 delta             = _mm512_set1_ps((float)
+                  (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
+            __m512 sum_l             = _mm512_setzero_ps();
+            __m512 sum_r             = _mm512_setzero_ps();
+
+            for (i = 0; i < (int)taps; i += 16)
+            {
+               __m512 sinc = _mm512_fmadd_ps(_mm512_load_ps(delta_table + i),
+                     delta, _mm512_load_ps(phase_table + i));
+               sum_l       = _mm512_fmadd_ps(_mm512_loadu_ps(buffer_l + i),
+                     sinc, sum_l);
+               sum_r       = _mm512_fmadd_ps(_mm512_loadu_ps(buffer_r + i),
+                     sinc, sum_r);
+            }
+
+            _mm_storel_pi((__m64*)output,
+                  resampler_sinc_hsum_avx512(sum_l, sum_r));
+
+            output += 2;
+            out_frames++;
+            resamp->time += ratio;
+         }
+      }
+   }
+
+   data->output_frames = out_frames;
+}
+
+/* Assumes that taps is a multiple of 16. */
+static SINC_AVX512_TARGET void resampler_sinc_process_avx512(
+      void *re_, struct resampler_data *data)
+{
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
+   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+
+   uint32_t ratio                 = phases / data->ratio;
+   const float *input             = data->data_in;
+   float *output                  = data->data_out;
+   size_t frames                  = data->input_frames;
+   size_t out_frames              = 0;
+   unsigned taps                  = resamp->taps;
+
+   while (frames)
+   {
+      while (frames && resamp->time >= phases)
+      {
+         /* Push in reverse to make filter more obvious. */
+         if (!resamp->ptr)
+            resamp->ptr = taps;
+         resamp->ptr--;
+
+         resamp->buffer_l[resamp->ptr + taps] =
+            resamp->buffer_l[resamp->ptr]     = *input++;
+
+         resamp->buffer_r[resamp->ptr + taps] =
+            resamp->buffer_r[resamp->ptr]     = *input++;
+
+         resamp->time                        -= phases;
+         frames--;
+      }
+
+      {
+         const float *buffer_l    = resamp->buffer_l + resamp->ptr;
+         const float *buffer_r    = resamp->buffer_r + resamp->ptr;
+         while (resamp->time < phases)
+         {
+            int i;
+            unsigned phase           = resamp->time >> resamp->subphase_bits;
+            const float *phase_table = resamp->phase_table + phase * taps;
+            __m512 sum_l             = _mm512_setzero_ps();
+            __m512 sum_r             = _mm512_setzero_ps();
+
+            for (i = 0; i < (int)taps; i += 16)
+            {
+               __m512 sinc = _mm512_load_ps(phase_table + i);
+               sum_l       = _mm512_fmadd_ps(_mm512_loadu_ps(buffer_l + i),
+                     sinc, sum_l);
+               sum_r       = _mm512_fmadd_ps(_mm512_loadu_ps(buffer_r + i),
+                     sinc, sum_r);
+            }
+
+            _mm_storel_pi((__m64*)output,
+                  resampler_sinc_hsum_avx512(sum_l, sum_r));
+
+            output += 2;
+            out_frames++;
+            resamp->time += ratio;
+         }
+      }
+   }
+
+   data->output_frames = out_frames;
+}
+#endif
+
 #if defined(__SSE__)
 static void resampler_sinc_process_sse_kaiser(void *re_, struct resampler_data *data)
 {
@@ -729,14 +1078,6 @@ static void resampler_sinc_process_c(void *re_, struct resampler_data *data)
    data->output_frames = out_frames;
 }
 
-static void resampler_sinc_free(void *data)
-{
-   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)data;
-   if (resamp)
-      memalign_free(resamp->main_buffer);
-   free(resamp);
-}
-
 static void sinc_init_table_kaiser(rarch_sinc_resampler_t *resamp,
       double cutoff,
       float *phase_table, int phases, int taps, bool calculate_delta)
@@ -858,15 +1199,204 @@ static void sinc_init_table_lanczos(
    }
 }
 
+static void sinc_table_free(struct sinc_table *table)
+{
+   memalign_free(table->phase_table);
+   free(table);
+}
+
+/* Drops the least recently used tables that no resampler
+ * is using anymore, keeping at most SINC_TABLE_CACHE_UNUSED_MAX.
+ * The list is kept in most recently used order. */
+static void sinc_table_cache_trim(void)
+{
+   unsigned unused            = 0;
+   struct sinc_table **link   = &sinc_table_cache;
+
+   while (*link)
+   {
+      struct sinc_table *table = *link;
+      if (!table->refs && ++unused > SINC_TABLE_CACHE_UNUSED_MAX)
+      {
+         *link = table->next;
+         sinc_table_free(table);
+         continue;
+      }
+      link = &table->next;
+   }
+}
+
+/**
+ * sinc_table_acquire:
+ *
+ * Looks up the phase table that @re needs in the cache,
+ * and generates it on a miss. The table is shared, so it
+ * must be handed back with sinc_table_release. Without
+ * a cache, the table is private to @re.
+ *
+ * Returns: the table, or NULL on allocation failure.
+ **/
+static struct sinc_table *sinc_table_acquire(
+      rarch_sinc_resampler_t *re, enum sinc_window window_type,
+      double cutoff)
+{
+   struct sinc_table **link;
+   struct sinc_table *table = NULL;
+   size_t phase_elems       = (1 << re->phase_bits) * re->taps;
+
+   if (window_type == SINC_WINDOW_KAISER)
+      phase_elems           = phase_elems * 2;
+
+#ifdef HAVE_THREADS
+   if (sinc_table_cache_inited)
+      slock_lock(sinc_table_cache_lock);
+#endif
+
+   for (link = &sinc_table_cache; *link; link = &(*link)->next)
+   {
+      struct sinc_table *cur = *link;
+      if (     cur->window_type == window_type
+            && cur->cutoff      == cutoff
+            && cur->kaiser_beta == re->kaiser_beta
+            && cur->phase_bits  == re->phase_bits
+            && cur->taps        == re->taps)
+      {
+         /* Move to the front. */
+         *link     = cur->next;
+         table     = cur;
+         break;
+      }
+   }
+
+   if (!table)
+   {
+      if ((table = (struct sinc_table*)calloc(1, sizeof(*table))))
+      {
+         table->window_type = window_type;
+         table->cutoff      = cutoff;
+         table->kaiser_beta = re->kaiser_beta;
+         table->phase_bits  = re->phase_bits;
+         table->taps        = re->taps;
+         table->phase_table = (float*)memalign_alloc(128,
+               sizeof(float) * phase_elems);
+      }
+
+      if (!table || !table->phase_table)
+      {
+         free(table);
+         table = NULL;
+      }
+      else
+      {
+         memset(table->phase_table, 0, sizeof(float) * phase_elems);
+
+         switch (window_type)
+         {
+            case SINC_WINDOW_LANCZOS:
+               sinc_init_table_lanczos(re, cutoff, table->phase_table,
+                     1 << re->phase_bits, re->taps, false);
+               break;
+            case SINC_WINDOW_KAISER:
+               sinc_init_table_kaiser(re, cutoff, table->phase_table,
+                     1 << re->phase_bits, re->taps, true);
+               break;
+            case SINC_WINDOW_NONE:
+               break;
+         }
+      }
+   }
+
+   if (table)
+   {
+      table->refs++;
+      if (sinc_table_cache_inited)
+      {
+         table->next      = sinc_table_cache;
+         sinc_table_cache = table;
+      }
+   }
+
+#ifdef HAVE_THREADS
+   if (sinc_table_cache_inited)
+      slock_unlock(sinc_table_cache_lock);
+#endif
+
+   return table;
+}
+
+static void sinc_table_release(struct sinc_table *table)
+{
+   if (!sinc_table_cache_inited)
+   {
+      sinc_table_free(table);
+      return;
+   }
+#ifdef HAVE_THREADS
+   slock_lock(sinc_table_cache_lock);
+#endif
+   table->refs--;
+   sinc_table_cache_trim();
+#ifdef HAVE_THREADS
+   slock_unlock(sinc_table_cache_lock);
+#endif
+}
+
+void sinc_resampler_cache_init(void)
+{
+   if (sinc_table_cache_inited)
+      return;
+#ifdef HAVE_THREADS
+   if (!(sinc_table_cache_lock = slock_new()))
+      return;
+#endif
+   sinc_table_cache_inited = true;
+}
+
+void sinc_resampler_cache_deinit(void)
+{
+   if (!sinc_table_cache_inited)
+      return;
+   while (sinc_table_cache)
+   {
+      struct sinc_table *table = sinc_table_cache;
+      sinc_table_cache         = table->next;
+      sinc_table_free(table);
+   }
+#ifdef HAVE_THREADS
+   slock_free(sinc_table_cache_lock);
+   sinc_table_cache_lock   = NULL;
+#endif
+   sinc_table_cache_inited = false;
+}
+
+static void resampler_sinc_free(void *data)
+{
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)data;
+   if (resamp)
+   {
+      if (resamp->table)
+         sinc_table_release(resamp->table);
+      memalign_free(resamp->main_buffer);
+   }
+   free(resamp);
+}
+
+static void resampler_sinc_process(void *re_, struct resampler_data *data)
+{
+   rarch_sinc_resampler_t *re = (rarch_sinc_resampler_t*)re_;
+   re->process(re_, data);
+}
+
 static void *resampler_sinc_new(const struct resampler_config *config,
       double bandwidth_mod, enum resampler_quality quality,
       resampler_simd_mask_t mask)
 {
    double cutoff                  = 0.0;
-   size_t phase_elems             = 0;
    size_t elems                   = 0;
    unsigned enable_avx            = 0;
    unsigned sidelobes             = 0;
+   bool use_fma                   = false;
+   bool use_avx512                = false;
    enum sinc_window window_type   = SINC_WINDOW_NONE;
    rarch_sinc_resampler_t *re     = (rarch_sinc_resampler_t*)
       calloc(1, sizeof(*re));
@@ -924,14 +1454,37 @@ static void *resampler_sinc_new(const struct resampler_config *config,
    re->taps          = sidelobes * 2;
 
    /* Downsampling, must lower cutoff, and extend number of
-    * taps accordingly to keep same stopband attenuation. */
+    * taps accordingly to keep same stopband attenuation.
+    * The ratio is rounded down to 1/256 steps, so that close
+    * ratios can share a phase table. */
    if (bandwidth_mod < 1.0)
    {
+      double bucket = floor(bandwidth_mod * 256.0) / 256.0;
+      if (bucket > 0.0)
+         bandwidth_mod = bucket;
       cutoff  *= bandwidth_mod;
       re->taps = (unsigned)ceil(re->taps / bandwidth_mod);
    }
 
+   /* Like with AVX, the wider paths only pay off once there
+    * are enough taps to make up for the horizontal sums;
+    * see samples/audio/resampler for a benchmark. */
+#ifdef HAVE_SINC_FMA
+   use_fma         = re->taps >= 32
+      && (mask & (RESAMPLER_SIMD_AVX2 | RESAMPLER_SIMD_FMA))
+      == (RESAMPLER_SIMD_AVX2 | RESAMPLER_SIMD_FMA);
+#endif
+#ifdef HAVE_SINC_AVX512
+   use_avx512      = use_fma && re->taps >= 128
+      && (mask & RESAMPLER_SIMD_AVX512);
+#endif
+
    /* Be SIMD-friendly. */
+   if (use_avx512)
+      re->taps     = (re->taps + 15) & ~15;
+   else if (use_fma)
+      re->taps     = (re->taps + 7) & ~7;
+   else
 #if defined(__AVX__)
    if (enable_avx)
       re->taps  = (re->taps + 7) & ~7;
@@ -945,10 +1498,10 @@ static void *resampler_sinc_new(const struct resampler_config *config,
 #endif
    }
 
-   phase_elems     = ((1 << re->phase_bits) * re->taps);
-   if (window_type == SINC_WINDOW_KAISER)
-      phase_elems  = phase_elems * 2;
-   elems           = phase_elems + 4 * re->taps;
+   if (window_type == SINC_WINDOW_NONE)
+      goto error;
+
+   elems           = 4 * re->taps;
 
    re->main_buffer = (float*)memalign_alloc(128, sizeof(float) * elems);
    if (!re->main_buffer)
@@ -956,42 +1509,48 @@ static void *resampler_sinc_new(const struct resampler_config *config,
 
    memset(re->main_buffer, 0, sizeof(float) * elems);
 
-   re->phase_table = re->main_buffer;
-   re->buffer_l    = re->main_buffer + phase_elems;
+   re->buffer_l    = re->main_buffer;
    re->buffer_r    = re->buffer_l + 2 * re->taps;
 
-   switch (window_type)
-   {
-      case SINC_WINDOW_LANCZOS:
-         sinc_init_table_lanczos(re, cutoff, re->phase_table,
-               1 << re->phase_bits, re->taps, false);
-         break;
-      case SINC_WINDOW_KAISER:
-         sinc_init_table_kaiser(re, cutoff, re->phase_table,
-               1 << re->phase_bits, re->taps, true);
-         break;
-      case SINC_WINDOW_NONE:
-         goto error;
-   }
+   if (!(re->table = sinc_table_acquire(re, window_type, cutoff)))
+      goto error;
+
+   re->phase_table = re->table->phase_table;
 
-   sinc_resampler.process = resampler_sinc_process_c;
+   re->process    = resampler_sinc_process_c;
    if (window_type == SINC_WINDOW_KAISER)
-      sinc_resampler.process    = resampler_sinc_process_c_kaiser;
+      re->process = resampler_sinc_process_c_kaiser;
 
-   if (mask & RESAMPLER_SIMD_AVX && enable_avx)
+   if (use_avx512)
+   {
+#ifdef HAVE_SINC_AVX512
+      re->process    = resampler_sinc_process_avx512;
+      if (window_type == SINC_WINDOW_KAISER)
+         re->process = resampler_sinc_process_avx512_kaiser;
+#endif
+   }
+   else if (use_fma)
+   {
+#ifdef HAVE_SINC_FMA
+      re->process    = resampler_sinc_process_fma;
+      if (window_type == SINC_WINDOW_KAISER)
+         re->process = resampler_sinc_process_fma_kaiser;
+#endif
+   }
+   else if (mask & RESAMPLER_SIMD_AVX && enable_avx)
    {
 #if defined(__AVX__)
-      sinc_resampler.process    = resampler_sinc_process_avx;
+      re->process    = resampler_sinc_process_avx;
       if (window_type == SINC_WINDOW_KAISER)
-         sinc_resampler.process = resampler_sinc_process_avx_kaiser;
+         re->process = resampler_sinc_process_avx_kaiser;
 #endif
    }
    else if (mask & RESAMPLER_SIMD_SSE)
    {
 #if defined(__SSE__)
-      sinc_resampler.process = resampler_sinc_process_sse;
+      re->process = resampler_sinc_process_sse;
       if (window_type == SINC_WINDOW_KAISER)
-         sinc_resampler.process = resampler_sinc_process_sse_kaiser;
+         re->process = resampler_sinc_process_sse_kaiser;
 #endif
    }
    else if (mask & RESAMPLER_SIMD_NEON)
@@ -999,11 +1558,11 @@ static void *resampler_sinc_new(const struct resampler_config *config,
 #if (defined(__ARM_NEON__) || defined(HAVE_NEON))
 #ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
       if (window_type != SINC_WINDOW_KAISER)
-         sinc_resampler.process = resampler_sinc_process_neon;
+         re->process = resampler_sinc_process_neon;
 #else
-      sinc_resampler.process = resampler_sinc_process_neon;
+      re->process = resampler_sinc_process_neon;
       if (window_type == SINC_WINDOW_KAISER)
-         sinc_resampler.process = resampler_sinc_process_neon_kaiser;
+         re->process = resampler_sinc_process_neon_kaiser;
 #endif
 #endif
    }
@@ -1017,7 +1576,7 @@ error:
 
 retro_resampler_t sinc_resampler = {
    resampler_sinc_new,
-   resampler_sinc_process_c,
+   resampler_sinc_process,
    resampler_sinc_free,
    RESAMPLER_API_VERSION,
    "sinc",
@@ -34,6 +34,7 @@
 #include <libretro.h>
 #include <features/features_cpu.h>
 #include <retro_timers.h>
+#include <retro_atomic.h>
 
 #if defined(_WIN32) && !defined(_XBOX)
 #include <windows.h>
@@ -585,6 +586,53 @@ unsigned cpu_features_get_core_amount(void)
 #endif
 }
 
+#ifdef RETRO_ATOMIC_LOCK_FREE
+/* Upper bound for the helper thread budget */
+#define CPU_FEATURES_THREADS_MAX 8
+
+/* Helper threads currently running across the process */
+static retro_atomic_int_t cpu_features_threads_used = 0;
+
+unsigned cpu_features_reserve_threads(unsigned wanted)
+{
+   int limit = (int)cpu_features_get_core_amount() - 1;
+   int used;
+   int granted;
+
+   if (limit > CPU_FEATURES_THREADS_MAX)
+      limit = CPU_FEATURES_THREADS_MAX;
+
+   used    = retro_atomic_fetch_add(&cpu_features_threads_used, (int)wanted);
+   granted = limit - used;
+   if (granted < 0)
+      granted = 0;
+   if (granted > (int)wanted)
+      granted = (int)wanted;
+   /* Give back what was taken but not granted */
+   if (granted < (int)wanted)
+      retro_atomic_fetch_add(&cpu_features_threads_used,
+            granted - (int)wanted);
+
+   return (unsigned)granted;
+}
+
+void cpu_features_release_threads(unsigned count)
+{
+   if (count)
+      retro_atomic_fetch_add(&cpu_features_threads_used, -(int)count);
+}
+#else
+/* No budget can be shared without atomics, callers stay serial */
+unsigned cpu_features_reserve_threads(unsigned wanted)
+{
+   return 0;
+}
+
+void cpu_features_release_threads(unsigned count)
+{
+}
+#endif
+
 /* According to http://en.wikipedia.org/wiki/CPUID */
 #define VENDOR_INTEL_b  0x756e6547
 #define VENDOR_INTEL_c  0x6c65746e
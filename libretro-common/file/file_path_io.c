@@ -98,6 +98,22 @@ int32_t path_get_size(const char *path)
    return -1;
 }
 
+/**
+ * path_get_mtime:
+ * @path               : path
+ *
+ * Gets the modification time of a file. Cores that
+ * supply their own VFS cannot report one.
+ *
+ * @return Modification time in seconds, or 0 if unknown.
+ */
+int64_t path_get_mtime(const char *path)
+{
+   if (path_stat_cb != retro_vfs_stat_impl)
+      return 0;
+   return retro_vfs_mtime_impl(path);
+}
+
 /**
  * path_mkdir:
  * @dir                : directory
@@ -46,6 +46,10 @@ RETRO_BEGIN_DECLS
 #define RESAMPLER_SIMD_AVX2     (1 << 12)
 #define RESAMPLER_SIMD_VFPU     (1 << 13)
 #define RESAMPLER_SIMD_PS       (1 << 14)
+/* Not reported by cpu_features_get(),
+ * retro_resampler_realloc probes for them itself. */
+#define RESAMPLER_SIMD_FMA      (1 << 29)
+#define RESAMPLER_SIMD_AVX512   (1 << 30)
 
 enum resampler_quality
 {
@@ -185,6 +189,10 @@ extern retro_resampler_t CC_resampler;
 #endif
 extern retro_resampler_t nearest_resampler;
 
+/* See retro_resampler_cache_init */
+void sinc_resampler_cache_init(void);
+void sinc_resampler_cache_deinit(void);
+
 /**
  * audio_resampler_driver_find_handle:
  * @index              : index of driver to get handle to.
@@ -218,6 +226,25 @@ const char *audio_resampler_driver_find_ident(int index);
 bool retro_resampler_realloc(void **re, const retro_resampler_t **backend,
       const char *ident, enum resampler_quality quality, double bw_ratio);
 
+/**
+ * retro_resampler_cache_init:
+ *
+ * Sets up the cache of filter tables, which lets resamplers
+ * with the same settings share them and keeps them across
+ * resampler reallocations. Must be called once before any
+ * resampler is created, without it every resampler builds
+ * tables of its own.
+ **/
+void retro_resampler_cache_init(void);
+
+/**
+ * retro_resampler_cache_deinit:
+ *
+ * Frees the cache of filter tables. Must only be called
+ * once all resamplers have been freed.
+ **/
+void retro_resampler_cache_deinit(void);
+
 RETRO_END_DECLS
 
 #endif
@@ -40,6 +40,19 @@ RETRO_BEGIN_DECLS
  */
 uint32_t encoding_crc32(uint32_t crc, const uint8_t *buf, size_t len);
 
+/**
+ * Combines the CRC32 checksums of two consecutive buffers,
+ * so that large buffers can be checksummed in independent chunks.
+ *
+ * @param crc1 The CRC32 checksum of the first buffer.
+ * @param crc2 The CRC32 checksum of the second buffer,
+ * calculated with an initial value of 0.
+ * @param len2 The length of the second buffer.
+ * @return The CRC32 checksum of both buffers, as if \c encoding_crc32
+ * had been called on the first buffer followed by the second one.
+ */
+uint32_t encoding_crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
 RETRO_END_DECLS
 
 #endif
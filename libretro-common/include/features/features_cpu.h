@@ -80,6 +80,32 @@ uint64_t cpu_features_get(void);
  */
 unsigned cpu_features_get_core_amount(void);
 
+/**
+ * Takes helper threads out of a budget shared by the whole
+ * process, so that code starting its own short-lived workers
+ * (CHD read-ahead, database hashing, rzip (de)compression)
+ * doesn't oversubscribe the CPU when several of them run at
+ * once, e.g. from task queue workers.
+ *
+ * The budget is one thread less than the number of cores
+ * (at most 8), the calling thread being the remaining one.
+ * Without atomic operations no thread is ever granted.
+ *
+ * @param wanted The number of threads the caller would like to start.
+ * @return The number of threads the caller may start,
+ * between 0 and \c wanted. Must be handed back with
+ * \c cpu_features_release_threads once they have exited.
+ */
+unsigned cpu_features_reserve_threads(unsigned wanted);
+
+/**
+ * Hands threads taken with \c cpu_features_reserve_threads
+ * back to the budget.
+ *
+ * @param count The number of threads that have exited.
+ */
+void cpu_features_release_threads(unsigned count);
+
 /**
  * Returns the name of the CPU model.
  *
@@ -38,6 +38,38 @@
 #endif
 
 #if !defined(HAVE_MMAN) || defined(_WIN32)
+#ifndef PROT_READ
+#define PROT_READ         0x1  /* Page can be read */
+#endif
+
+#ifndef PROT_WRITE
+#define PROT_WRITE        0x2  /* Page can be written. */
+#endif
+
+#ifndef PROT_READWRITE
+#define PROT_READWRITE    0x3  /* Page can be written to and read from. */
+#endif
+
+#ifndef PROT_EXEC
+#define PROT_EXEC         0x4  /* Page can be executed. */
+#endif
+
+#ifndef PROT_NONE
+#define PROT_NONE         0x0  /* Page can not be accessed. */
+#endif
+
+#ifndef MAP_SHARED
+#define MAP_SHARED        0x01 /* Writes go to the file. */
+#endif
+
+#ifndef MAP_PRIVATE
+#define MAP_PRIVATE       0x02 /* Writes are copy-on-write. */
+#endif
+
+#ifndef MAP_FAILED
+#define MAP_FAILED        ((void *) -1)
+#endif
+
 void* mmap(void *addr, size_t len, int mmap_prot, int mmap_flags, int fildes, size_t off);
 
 int munmap(void *addr, size_t len);
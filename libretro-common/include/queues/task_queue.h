@@ -46,6 +46,24 @@ enum task_type
    TASK_TYPE_BLOCKING
 };
 
+/**
+ * Scheduling class of a task.
+ * In threaded mode, idle workers always pick the runnable task
+ * with the highest priority first, so latency-sensitive work
+ * is not held up behind long-running bulk tasks.
+ */
+enum task_priority
+{
+   /** Long-running background work (database scans, core updates). */
+   TASK_PRIORITY_LOW = 0,
+   /** The default for tasks that do not set a priority. */
+   TASK_PRIORITY_NORMAL,
+   /** Latency-sensitive work (save states, thumbnails). */
+   TASK_PRIORITY_HIGH,
+
+   TASK_PRIORITY_LAST
+};
+
 enum task_style
 {
    TASK_STYLE_NONE,
@@ -120,7 +138,16 @@ enum retro_task_flags
     * If set, the task queue will not call \c progress_cb
     * and will not display any messages from this task.
     */
-   RETRO_TASK_FLG_MUTE             = (1 << 3)
+   RETRO_TASK_FLG_MUTE             = (1 << 3),
+   /**
+    * If set, the task may run on any worker alongside other tasks.
+    * Tasks without this flag never run at the same time as each
+    * other, as if there was a single worker thread, since most
+    * handlers touch shared state without locking it.
+    * Only set it for handlers that work on their own state.
+    * Set by the caller before the task is pushed.
+    */
+   RETRO_TASK_FLG_CONCURRENT       = (1 << 4)
 };
 
 /**
@@ -275,7 +302,32 @@ struct retro_task
    enum task_type type;
    enum task_style style;
 
+   /**
+    * The scheduling class of this task.
+    * Set by the caller; defaults to \c TASK_PRIORITY_NORMAL.
+    */
+   enum task_priority priority;
+
+   /**
+    * The time (in microseconds) when this task was pushed to the queue.
+    * Set by the task system.
+    * Can be used to compute how long the task has been queued.
+    */
+   retro_time_t time_pushed;
+
+   /**
+    * The total time (in microseconds) spent inside \c handler so far.
+    * Set by the task system.
+    */
+   retro_time_t time_running;
+
    uint8_t flags;
+
+   /**
+    * @private Set while a worker thread is running \c handler.
+    * Do not touch this; it is managed by the task system.
+    */
+   bool busy;
 };
 
 /**
@@ -363,6 +415,14 @@ typedef struct task_retriever_data
     * Must not be zero.
     */
    size_t element_size;
+
+   /**
+    * The number of tasks in the queue (of any handler),
+    * and how many of them are currently being run by a worker.
+    * Set by \c task_queue_retrieve.
+    */
+   size_t queue_depth;
+   size_t queue_busy;
 } task_retriever_data_t;
 
 /**
@@ -541,6 +601,15 @@ void task_queue_set_threaded(void);
  */
 void task_queue_unset_threaded(void);
 
+/**
+ * Sets the number of worker threads used in threaded mode.
+ * Takes effect the next time the task queue is (re)initialized.
+ *
+ * @param count The number of workers,
+ * or 0 to use one worker per CPU core.
+ */
+void task_queue_set_worker_count(unsigned count);
+
 /**
  * Returns whether the task queue is running in threaded mode.
  *
@@ -655,9 +724,11 @@ void task_queue_deinit(void);
  * Must be called before any other task_queue_* function,
  * and must only be called from the main thread.
  *
- * @param threaded \c true if tasks should run on a separate thread,
+ * @param threaded \c true if tasks should run on a pool of worker threads
+ * (one per CPU core by default, see \c task_queue_set_worker_count),
  * \c false if they should remain on the calling thread.
- * All tasks run in sequence on a single thread.
+ * A single task never runs on more than one worker at a time,
+ * but different tasks may run concurrently.
  * If you want to scale a task to multiple threads,
  * you must do so within the task itself.
  * @param msg_push The task system will call this function to output messages.
@@ -0,0 +1,123 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (retro_atomic.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_ATOMIC_H
+#define __LIBRETRO_SDK_ATOMIC_H
+
+#include <retro_inline.h>
+
+/* Minimal set of atomic operations on an int-sized value,
+ * for lock-free handoff between threads.
+ *
+ * RETRO_ATOMIC_LOCK_FREE is only defined when the compiler
+ * provides real atomic builtins. Code using these helpers
+ * must provide a mutex-based fallback otherwise. */
+
+#if defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#define RETRO_ATOMIC_LOCK_FREE 1
+
+typedef int retro_atomic_int_t;
+
+static INLINE int retro_atomic_load_acquire(retro_atomic_int_t *p)
+{
+   return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static INLINE void retro_atomic_store_release(retro_atomic_int_t *p, int v)
+{
+   __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static INLINE int retro_atomic_xchg(retro_atomic_int_t *p, int v)
+{
+   return __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL);
+}
+
+static INLINE int retro_atomic_fetch_add(retro_atomic_int_t *p, int v)
+{
+   return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL);
+}
+#elif defined(__GNUC__) && (__GNUC__ == 4 && __GNUC_MINOR__ >= 1)
+#define RETRO_ATOMIC_LOCK_FREE 1
+
+typedef volatile int retro_atomic_int_t;
+
+/* The legacy __sync builtins are all full barriers */
+static INLINE int retro_atomic_load_acquire(retro_atomic_int_t *p)
+{
+   return __sync_fetch_and_add(p, 0);
+}
+
+static INLINE void retro_atomic_store_release(retro_atomic_int_t *p, int v)
+{
+   __sync_synchronize();
+   *p = v;
+   __sync_synchronize();
+}
+
+static INLINE int retro_atomic_xchg(retro_atomic_int_t *p, int v)
+{
+   int old;
+   do
+   {
+      old = *p;
+   } while (!__sync_bool_compare_and_swap(p, old, v));
+   return old;
+}
+
+static INLINE int retro_atomic_fetch_add(retro_atomic_int_t *p, int v)
+{
+   return __sync_fetch_and_add(p, v);
+}
+#elif defined(_MSC_VER) && _MSC_VER >= 1400 && !defined(_XBOX)
+#include <intrin.h>
+#define RETRO_ATOMIC_LOCK_FREE 1
+
+typedef volatile long retro_atomic_int_t;
+
+/* The Interlocked intrinsics are all full barriers */
+static INLINE int retro_atomic_load_acquire(retro_atomic_int_t *p)
+{
+   return (int)_InterlockedCompareExchange(p, 0, 0);
+}
+
+static INLINE void retro_atomic_store_release(retro_atomic_int_t *p, int v)
+{
+   _InterlockedExchange(p, (long)v);
+}
+
+static INLINE int retro_atomic_xchg(retro_atomic_int_t *p, int v)
+{
+   return (int)_InterlockedExchange(p, (long)v);
+}
+
+static INLINE int retro_atomic_fetch_add(retro_atomic_int_t *p, int v)
+{
+   return (int)_InterlockedExchangeAdd(p, (long)v);
+}
+#else
+/* No lock-free atomics; the type is still provided so that
+ * structures can be declared unconditionally. */
+typedef volatile int retro_atomic_int_t;
+#endif
+
+#endif
@@ -26,6 +26,7 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include <boolean.h>
 #include <retro_common_api.h>
 
 RETRO_BEGIN_DECLS
@@ -39,6 +40,23 @@ typedef struct chdstream chdstream_t;
 /* Primary (largest) data track, used for CRC identification purposes */
 #define CHDSTREAM_TRACK_PRIMARY (-3)
 
+/* Hunk cache counters. Every time reading moves on to
+ * another hunk, exactly one of hits, waits or misses
+ * is incremented. */
+typedef struct chdstream_cache_stats
+{
+   /* Hunk was already decompressed */
+   uint64_t hits;
+   /* ...of which by a read-ahead thread */
+   uint64_t prefetch_hits;
+   /* Hunk was still being decompressed by a read-ahead thread */
+   uint64_t waits;
+   /* Hunk had to be decompressed by the reading thread */
+   uint64_t misses;
+   /* Hunks decompressed by read-ahead threads */
+   uint64_t prefetched;
+} chdstream_cache_stats_t;
+
 chdstream_t *chdstream_open(const char *path, int32_t track);
 
 void chdstream_close(chdstream_t *stream);
@@ -63,6 +81,37 @@ uint32_t chdstream_get_frame_size(chdstream_t* stream);
 
 uint32_t chdstream_get_first_track_sector(chdstream_t* stream);
 
+/**
+ * chdstream_set_cache_size:
+ * @stream             : CHD stream handle.
+ * @hunks              : Number of decompressed hunks to keep
+ *                       around (16 by default, at least 2).
+ * @readahead          : Number of hunks decompressed ahead of
+ *                       sequential reads on other threads
+ *                       (8 by default). 0 disables read-ahead.
+ *
+ * Resizes the hunk cache of @stream, dropping what it held.
+ * The cache is grown to fit the read-ahead if needed.
+ * Read-ahead is only available with HAVE_THREADS on multi-core
+ * systems, only starts once the stream is read sequentially,
+ * and its threads come from a budget shared by all streams.
+ *
+ * Returns: false if the cache could not be allocated, in which
+ * case the previous one is kept.
+ **/
+bool chdstream_set_cache_size(chdstream_t *stream,
+      unsigned hunks, unsigned readahead);
+
+/**
+ * chdstream_get_cache_stats:
+ * @stream             : CHD stream handle.
+ * @stats              : Receives the hunk cache counters.
+ *
+ * Counters are kept per stream since it was opened.
+ **/
+void chdstream_get_cache_stats(chdstream_t *stream,
+      chdstream_cache_stats_t *stats);
+
 RETRO_END_DECLS
 
 #endif
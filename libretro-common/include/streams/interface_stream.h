@@ -130,6 +130,10 @@ intfstream_t *intfstream_open_chd_track(const char *path,
 intfstream_t *intfstream_open_rzip_file(const char *path,
       unsigned mode);
 
+/* 'codec' is an enum rzip_codec, used when writing */
+intfstream_t *intfstream_open_rzip_file_codec(const char *path,
+      unsigned mode, unsigned codec);
+
 RETRO_END_DECLS
 
 #endif
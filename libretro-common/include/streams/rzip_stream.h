@@ -51,6 +51,13 @@ RETRO_BEGIN_DECLS
  * is handled automatically. File type (compressed/
  * uncompressed) is detected via the RZIP header.
  * 
+ * When built with HAVE_THREADS, reads and writes
+ * spanning several whole chunks (e.g. via
+ * rzipstream_read_file()/rzipstream_write_file())
+ * (de)compress those chunks in parallel. Since each
+ * chunk is an independent zlib stream, the resulting
+ * files are byte-identical to serial output.
+ * 
  * ## RZIP file format:
  * 
  * <file id header>:                8 bytes
@@ -59,10 +66,14 @@ RETRO_BEGIN_DECLS
  *                                  - nominal (maximum) size of each uncompressed
  *                                    chunk, in bytes
  * <total uncompressed data size>:  8 bytes, little endian order
+ * <codec>:                         4 bytes, file format version 2 only
+ *                                  - [enum rzip_codec][0][0][0]
+ *                                  - version 1 files are always zlib
  * <size of next compressed chunk>: 4 bytes, little endian order
  *                                  - size on-disk of next compressed data
  *                                    chunk, in bytes
- * <next compressed chunk>:         n bytes of zlib compressed data
+ * <next compressed chunk>:         n bytes of compressed data
+ *                                  (a zlib stream or an LZ4 block)
  * ...
  * <size of next compressed chunk> : repeated until end of file
  * <next compressed chunk>         :
@@ -72,6 +83,20 @@ RETRO_BEGIN_DECLS
 /* Prevent direct access to rzipstream_t members */
 typedef struct rzipstream rzipstream_t;
 
+/* Chunk compression method
+ * > ZLIB: best ratio, for files kept around
+ *   (manual save states, SRAM)
+ * > LZ4: several times faster in both directions
+ *   at the cost of larger files, for frequently
+ *   written data (auto/undo save states) */
+enum rzip_codec
+{
+   RZIP_CODEC_ZLIB = 0,
+   RZIP_CODEC_LZ4,
+
+   RZIP_CODEC_LAST
+};
+
 /* File Open */
 
 /* Opens a new or existing RZIP file
@@ -84,6 +109,12 @@ typedef struct rzipstream rzipstream_t;
  * is invalid or an IO error occurs */
 rzipstream_t* rzipstream_open(const char *path, unsigned mode);
 
+/* Same as rzipstream_open(), but new files are
+ * compressed with 'codec' instead of zlib.
+ * 'codec' is ignored when reading */
+rzipstream_t* rzipstream_open_codec(const char *path, unsigned mode,
+      enum rzip_codec codec);
+
 /* File Read */
 
 /* Reads (a maximum of) 'len' bytes from an RZIP file.
@@ -144,6 +175,11 @@ int rzipstream_printf(rzipstream_t *stream, const char* format, ...);
  * Returns false in the event of an error */
 bool rzipstream_write_file(const char *path, const void *data, int64_t len);
 
+/* Same as rzipstream_write_file(), but compresses
+ * with 'codec' instead of zlib */
+bool rzipstream_write_file_codec(const char *path, const void *data,
+      int64_t len, enum rzip_codec codec);
+
 /* File Control */
 
 /* Sets file position to the beginning of the
@@ -95,10 +95,14 @@ bool trans_stream_trans_full(
 
 const struct trans_stream_backend* trans_stream_get_zlib_deflate_backend(void);
 const struct trans_stream_backend* trans_stream_get_zlib_inflate_backend(void);
+const struct trans_stream_backend* trans_stream_get_lz4_compress_backend(void);
+const struct trans_stream_backend* trans_stream_get_lz4_decompress_backend(void);
 const struct trans_stream_backend* trans_stream_get_pipe_backend(void);
 
 extern const struct trans_stream_backend zlib_deflate_backend;
 extern const struct trans_stream_backend zlib_inflate_backend;
+extern const struct trans_stream_backend lz4_compress_backend;
+extern const struct trans_stream_backend lz4_decompress_backend;
 extern const struct trans_stream_backend pipe_backend;
 
 RETRO_END_DECLS
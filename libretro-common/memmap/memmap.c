@@ -24,30 +24,6 @@
 #include <stdlib.h>
 #include <memmap.h>
 
-#ifndef PROT_READ
-#define PROT_READ         0x1  /* Page can be read */
-#endif
-
-#ifndef PROT_WRITE
-#define PROT_WRITE        0x2  /* Page can be written. */
-#endif
-
-#ifndef PROT_READWRITE
-#define PROT_READWRITE    0x3  /* Page can be written to and read from. */
-#endif
-
-#ifndef PROT_EXEC
-#define PROT_EXEC         0x4  /* Page can be executed. */
-#endif
-
-#ifndef PROT_NONE
-#define PROT_NONE         0x0  /* Page can not be accessed. */
-#endif
-
-#ifndef MAP_FAILED
-#define MAP_FAILED        ((void *) -1)
-#endif
-
 #ifdef _WIN32
 void* mmap(void *addr, size_t len, int prot, int flags,
       int fildes, size_t offset)
@@ -55,36 +31,52 @@ void* mmap(void *addr, size_t len, int prot, int flags,
    void     *map = (void*)NULL;
    HANDLE handle = INVALID_HANDLE_VALUE;
 
-   switch (prot)
+   /* Writes to a private mapping only
+    * ever reach its own copy of the pages */
+   if ((flags & MAP_PRIVATE) && (prot & PROT_WRITE))
    {
-      case PROT_READ:
-      default:
-         handle = CreateFileMapping((HANDLE)
-               _get_osfhandle(fildes), 0, PAGE_READONLY, 0,
-               len, 0);
-         if (!handle)
-            break;
-         map = (void*)MapViewOfFile(handle, FILE_MAP_READ, 0, 0, len);
+      handle = CreateFileMapping((HANDLE)
+            _get_osfhandle(fildes), 0, PAGE_WRITECOPY, 0,
+            0, 0);
+      if (handle)
+      {
+         map = (void*)MapViewOfFile(handle, FILE_MAP_COPY, 0, 0, len);
          CloseHandle(handle);
-         break;
-      case PROT_WRITE:
-         handle = CreateFileMapping((HANDLE)
-               _get_osfhandle(fildes),0,PAGE_READWRITE,0,
-               len, 0);
-         if (!handle)
+      }
+   }
+   else
+   {
+      switch (prot)
+      {
+         case PROT_READ:
+         default:
+            handle = CreateFileMapping((HANDLE)
+                  _get_osfhandle(fildes), 0, PAGE_READONLY, 0,
+                  len, 0);
+            if (!handle)
+               break;
+            map = (void*)MapViewOfFile(handle, FILE_MAP_READ, 0, 0, len);
+            CloseHandle(handle);
             break;
-         map = (void*)MapViewOfFile(handle, FILE_MAP_WRITE, 0, 0, len);
-         CloseHandle(handle);
-         break;
-      case PROT_READWRITE:
-         handle = CreateFileMapping((HANDLE)
-               _get_osfhandle(fildes),0,PAGE_READWRITE,0,
-               len, 0);
-         if (!handle)
+         case PROT_WRITE:
+            handle = CreateFileMapping((HANDLE)
+                  _get_osfhandle(fildes),0,PAGE_READWRITE,0,
+                  len, 0);
+            if (!handle)
+               break;
+            map = (void*)MapViewOfFile(handle, FILE_MAP_WRITE, 0, 0, len);
+            CloseHandle(handle);
             break;
-         map = (void*)MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, len);
-         CloseHandle(handle);
-         break;
+         case PROT_READWRITE:
+            handle = CreateFileMapping((HANDLE)
+                  _get_osfhandle(fildes),0,PAGE_READWRITE,0,
+                  len, 0);
+            if (!handle)
+               break;
+            map = (void*)MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, len);
+            CloseHandle(handle);
+            break;
+      }
    }
 
    if (map == (void*)NULL)
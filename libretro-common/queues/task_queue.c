@@ -77,13 +77,22 @@ static slock_t *finished_lock               = NULL;
 static slock_t *property_lock               = NULL;
 static slock_t *queue_lock                  = NULL;
 static scond_t *worker_cond                 = NULL;
-static sthread_t *worker_thread             = NULL;
+static sthread_t **worker_threads           = NULL;
+static unsigned worker_count                = 0;
+static unsigned worker_count_wanted         = 0;
 static bool worker_continue                 = true;
 /* use running_lock when touching it */
+/* Set while a task without RETRO_TASK_FLG_CONCURRENT is running,
+ * use running_lock when touching it */
+static bool worker_serial_busy              = false;
 #endif
 
+/* Upper bound for the default (one per core) worker count */
+#define TASK_WORKERS_MAX 8
+
 #ifdef HAVE_GCD
 static unsigned gcd_queue_count             = 0;
+static dispatch_queue_t gcd_serial_queue    = NULL;
 #endif
 
 static void task_queue_msg_push(retro_task_t *task,
@@ -240,7 +249,9 @@ static void retro_task_regular_gather(void)
 
       if (!task->when || task->when < cpu_features_get_time_usec())
       {
+         retro_time_t start  = cpu_features_get_time_usec();
          task->handler(task);
+         task->time_running += cpu_features_get_time_usec() - start;
 
          task_queue_push_progress(task);
       }
@@ -289,10 +300,18 @@ static void retro_task_regular_retrieve(task_retriever_data_t *data)
    retro_task_t *task          = NULL;
    task_retriever_info_t *tail = NULL;
 
+   data->queue_depth           = 0;
+   data->queue_busy            = 0;
+
    /* Parse all running tasks and handle matching handlers */
    for (task = tasks_running.front; task != NULL; task = task->next)
    {
       task_retriever_info_t *info = NULL;
+
+      data->queue_depth++;
+      if (task->busy)
+         data->queue_busy++;
+
       if (task->handler != data->handler)
          continue;
 
@@ -488,10 +507,60 @@ static void retro_task_threaded_retrieve(task_retriever_data_t *data)
    slock_unlock(running_lock);
 }
 
+/* Picks the next task a worker should run: the first due,
+ * idle task of the highest priority. Since unfinished tasks
+ * are moved to the back of the queue after each step, tasks
+ * of the same priority are still run round-robin.
+ * Only one task without RETRO_TASK_FLG_CONCURRENT runs at a time.
+ * If nothing is due yet, @delay receives the time until the
+ * earliest scheduled task, or 0 if there is none.
+ *
+ * 'running_lock' must be held for the duration of this function */
+static retro_task_t *task_queue_next_runnable(retro_time_t *delay)
+{
+   retro_task_t *task = NULL;
+   retro_task_t *best = NULL;
+   retro_time_t now   = cpu_features_get_time_usec();
+
+   *delay             = 0;
+
+   for (task = tasks_running.front; task; task = task->next)
+   {
+      if (task->busy)
+         continue;
+
+      if (worker_serial_busy && !(task->flags & RETRO_TASK_FLG_CONCURRENT))
+         continue;
+
+      if (task->when)
+      {
+         /* allow half a millisecond for context switching */
+         retro_time_t wait = task->when - now - 500;
+         if (wait > 0)
+         {
+            if (!*delay || wait < *delay)
+               *delay = wait;
+            continue;
+         }
+      }
+
+      if (!best || task->priority > best->priority)
+      {
+         best = task;
+         if (best->priority == TASK_PRIORITY_LAST - 1)
+            break;
+      }
+   }
+
+   return best;
+}
+
 static void threaded_worker(void *userdata)
 {
    for (;;)
    {
+      retro_time_t start;
+      retro_time_t delay  = 0;
       retro_task_t *task  = NULL;
       bool       finished = false;
 
@@ -503,27 +572,24 @@ static void threaded_worker(void *userdata)
          break; /* should we keep running until all tasks finished? */
       }
 
-      /* Get first task to run */
-      if (!(task = tasks_running.front))
+      /* Get the next task to run */
+      if (!(task = task_queue_next_runnable(&delay)))
       {
-         scond_wait(worker_cond, running_lock);
-         slock_unlock(running_lock);
-         continue;
-      }
-
-      if (task->when)
-      {
-         retro_time_t now   = cpu_features_get_time_usec();
-         retro_time_t delay = task->when - now - 500; /* allow half a millisecond for context switching */
          if (delay > 0)
-         {
             scond_wait_timeout(worker_cond, running_lock, delay);
-            slock_unlock(running_lock);
-            continue;
-         }
+         else
+            scond_wait(worker_cond, running_lock);
+         slock_unlock(running_lock);
+         continue;
       }
 
+      /* Claim it, so no other worker runs it concurrently */
+      task->busy = true;
+      if (!(task->flags & RETRO_TASK_FLG_CONCURRENT))
+         worker_serial_busy = true;
       slock_unlock(running_lock);
+
+      start = cpu_features_get_time_usec();
       task->handler(task);
 #ifdef EMSCRIPTEN
       /* Workaround emscripten pthread bug where not parking the
@@ -538,29 +604,35 @@ static void threaded_worker(void *userdata)
       slock_unlock(property_lock);
 
       /* Update queue */
-      if (!finished)
+      slock_lock(running_lock);
+      slock_lock(queue_lock);
+      task->busy          = false;
+      task->time_running += cpu_features_get_time_usec() - start;
+
+      if (!(task->flags & RETRO_TASK_FLG_CONCURRENT))
       {
-         /* Move the task to the back of the queue */
-         /* mimics retro_task_threaded_push_running,
-          * but also includes a task_queue_remove */
-         slock_lock(running_lock);
-         slock_lock(queue_lock);
+         /* The next serial task can run now */
+         worker_serial_busy = false;
+         scond_signal(worker_cond);
+      }
 
-         /* do nothing if only item in queue */
+      if (!finished)
+      {
+         /* Move the task to the back of the queue,
+          * do nothing if only item in queue */
          if (task->next)
          {
             task_queue_remove(&tasks_running, task);
             task_queue_put(&tasks_running, task);
-            scond_signal(worker_cond);
          }
+         /* The task is available again, wake up an idle worker */
+         scond_signal(worker_cond);
          slock_unlock(queue_lock);
          slock_unlock(running_lock);
       }
       else
       {
          /* Remove task from running queue */
-         slock_lock(running_lock);
-         slock_lock(queue_lock);
          task_queue_remove(&tasks_running, task);
          slock_unlock(queue_lock);
          slock_unlock(running_lock);
@@ -575,6 +647,22 @@ static void threaded_worker(void *userdata)
 
 static void retro_task_threaded_init(void)
 {
+   unsigned i;
+   unsigned count  = worker_count_wanted;
+
+   if (!count)
+   {
+      count        = cpu_features_get_core_amount();
+      if (count > TASK_WORKERS_MAX)
+         count     = TASK_WORKERS_MAX;
+   }
+#ifdef EMSCRIPTEN
+   /* Each worker consumes a thread from the fixed-size pthread pool */
+   count           = 1;
+#endif
+   if (count < 1)
+      count        = 1;
+
    running_lock    = slock_new();
    finished_lock   = slock_new();
    property_lock   = slock_new();
@@ -582,20 +670,35 @@ static void retro_task_threaded_init(void)
    worker_cond     = scond_new();
 
    slock_lock(running_lock);
-   worker_continue = true;
+   worker_continue    = true;
+   worker_serial_busy = false;
    slock_unlock(running_lock);
 
-   worker_thread   = sthread_create(threaded_worker, NULL);
+   worker_count    = 0;
+   if ((worker_threads = (sthread_t**)calloc(count, sizeof(*worker_threads))))
+   {
+      for (i = 0; i < count; i++)
+      {
+         if (!(worker_threads[worker_count] =
+                  sthread_create(threaded_worker, NULL)))
+            break;
+         worker_count++;
+      }
+   }
 }
 
 static void retro_task_threaded_deinit(void)
 {
+   unsigned i;
+
    slock_lock(running_lock);
    worker_continue = false;
-   scond_signal(worker_cond);
+   scond_broadcast(worker_cond);
    slock_unlock(running_lock);
 
-   sthread_join(worker_thread);
+   for (i = 0; i < worker_count; i++)
+      sthread_join(worker_threads[i]);
+   free(worker_threads);
 
    scond_free(worker_cond);
    slock_free(running_lock);
@@ -603,7 +706,8 @@ static void retro_task_threaded_deinit(void)
    slock_free(property_lock);
    slock_free(queue_lock);
 
-   worker_thread   = NULL;
+   worker_threads  = NULL;
+   worker_count    = 0;
    worker_cond     = NULL;
    running_lock    = NULL;
    finished_lock   = NULL;
@@ -627,10 +731,20 @@ static struct retro_task_impl impl_threaded = {
 
 #ifdef HAVE_GCD
 
+/* Serial tasks are all run on one serial queue */
+static dispatch_queue_t gcd_task_queue(bool serial)
+{
+   if (serial)
+      return gcd_serial_queue;
+   return dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+}
+
 static void gcd_worker(retro_task_t *task)
 {
    bool       finished = false;
+   bool       serial   = false;
    slock_lock(running_lock);
+   serial              = (task->flags & RETRO_TASK_FLG_CONCURRENT) ? false : true;
 
    if (!worker_continue)
    {
@@ -648,7 +762,7 @@ static void gcd_worker(retro_task_t *task)
       if (delay > 0)
       {
          dispatch_time_t after = dispatch_time(DISPATCH_TIME_NOW, delay);
-         dispatch_after(after, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0),
+         dispatch_after(after, gcd_task_queue(serial),
                         ^{ gcd_worker(task); });
          slock_unlock(running_lock);
          return;
@@ -664,7 +778,7 @@ static void gcd_worker(retro_task_t *task)
    slock_unlock(property_lock);
 
    if (!finished)
-      dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0),
+      dispatch_async(gcd_task_queue(serial),
                      ^{ gcd_worker(task); });
    else
    {
@@ -691,7 +805,7 @@ static void retro_task_gcd_push_running(retro_task_t *task)
    slock_lock(queue_lock);
    task_queue_put(&tasks_running, task);
    gcd_queue_count++;
-   dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0),
+   dispatch_async(gcd_task_queue(!(task->flags & RETRO_TASK_FLG_CONCURRENT)),
                   ^{ gcd_worker(task); });
    slock_unlock(queue_lock);
    slock_unlock(running_lock);
@@ -733,12 +847,16 @@ static void retro_task_gcd_init(void)
    queue_lock      = slock_new();
    worker_cond     = scond_new();
 
+   if (!gcd_serial_queue)
+      gcd_serial_queue = dispatch_queue_create("retro_task_serial",
+            DISPATCH_QUEUE_SERIAL);
+
    slock_lock(running_lock);
    worker_continue = true;
    for (task = tasks_running.front; task; task = task->next)
    {
       gcd_queue_count++;
-      dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0),
+      dispatch_async(gcd_task_queue(!(task->flags & RETRO_TASK_FLG_CONCURRENT)),
                      ^{ gcd_worker(task); });
    };
    slock_unlock(running_lock);
@@ -822,6 +940,13 @@ void task_queue_unset_threaded(void)
    task_threaded_enable = false;
 }
 
+void task_queue_set_worker_count(unsigned count)
+{
+#ifdef HAVE_THREADS
+   worker_count_wanted  = count;
+#endif
+}
+
 bool task_queue_is_threaded(void)
 {
    return task_threaded_enable;
@@ -884,6 +1009,10 @@ bool task_queue_push(retro_task_t *task)
          return false;
    }
 
+   task->time_pushed  = cpu_features_get_time_usec();
+   task->time_running = 0;
+   task->busy         = false;
+
    /* The lack of NULL checks in the following functions
     * is proposital to ensure correct control flow by the users. */
    impl_current->push_running(task);
@@ -1109,6 +1238,10 @@ retro_task_t *task_init(void)
    task->title             = NULL;
    task->type              = TASK_TYPE_NONE;
    task->style             = TASK_STYLE_NONE;
+   task->priority          = TASK_PRIORITY_NORMAL;
+   task->time_pushed       = 0;
+   task->time_running      = 0;
+   task->busy              = false;
    task->ident             = task_count++;
    task->frontend_userdata = NULL;
    task->next              = NULL;
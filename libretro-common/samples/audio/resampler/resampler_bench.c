@@ -0,0 +1,220 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (resampler_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Runs every sinc resampler path this CPU has over the same
+ * input, and prints how fast each one is and how far its
+ * output is from the plain C path. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <features/features_cpu.h>
+#include <audio/audio_resampler.h>
+
+#define BENCH_IN_RATE  44100
+#define BENCH_OUT_RATE 48000
+#define BENCH_CHUNK    1024
+#define BENCH_SECONDS  10
+
+struct bench_path
+{
+   const char *name;
+   resampler_simd_mask_t mask;
+};
+
+/* Each path gets the mask of a CPU that has just that
+ * much, the driver picks the best path it has for it. */
+static const struct bench_path bench_paths[] = {
+   { "C",       0 },
+#if defined(__SSE__)
+   { "SSE",     RESAMPLER_SIMD_SSE },
+#endif
+#if defined(__AVX__)
+   { "AVX",     RESAMPLER_SIMD_SSE | RESAMPLER_SIMD_AVX },
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+   { "AVX2/FMA", RESAMPLER_SIMD_SSE | RESAMPLER_SIMD_AVX
+      | RESAMPLER_SIMD_AVX2 | RESAMPLER_SIMD_FMA },
+   { "AVX-512", RESAMPLER_SIMD_SSE | RESAMPLER_SIMD_AVX
+      | RESAMPLER_SIMD_AVX2 | RESAMPLER_SIMD_FMA | RESAMPLER_SIMD_AVX512 },
+#endif
+#if defined(__ARM_NEON__) || defined(HAVE_NEON)
+   { "NEON",    RESAMPLER_SIMD_NEON },
+#endif
+};
+
+static const struct
+{
+   const char *name;
+   enum resampler_quality quality;
+} bench_qualities[] = {
+   { "lowest",  RESAMPLER_QUALITY_LOWEST },
+   { "lower",   RESAMPLER_QUALITY_LOWER },
+   { "normal",  RESAMPLER_QUALITY_NORMAL },
+   { "higher",  RESAMPLER_QUALITY_HIGHER },
+   { "highest", RESAMPLER_QUALITY_HIGHEST },
+};
+
+static resampler_simd_mask_t bench_simd_mask(void)
+{
+   resampler_simd_mask_t mask = (resampler_simd_mask_t)cpu_features_get();
+#if (defined(__x86_64__) || defined(__i386__)) \
+      && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("fma"))
+      mask |= RESAMPLER_SIMD_FMA;
+   if (__builtin_cpu_supports("avx512f"))
+      mask |= RESAMPLER_SIMD_AVX512;
+#endif
+   return mask;
+}
+
+/* Returns the number of output samples. */
+static size_t bench_run(enum resampler_quality quality,
+      resampler_simd_mask_t mask, double ratio,
+      const float *in, size_t in_frames, float *out,
+      retro_time_t *elapsed)
+{
+   size_t i;
+   retro_time_t start;
+   size_t out_samples           = 0;
+   resampler_process_t process;
+   void *re                     = sinc_resampler.init(NULL, ratio,
+         quality, mask);
+
+   if (!re)
+      return 0;
+
+   process = sinc_resampler.process;
+   start   = cpu_features_get_time_usec();
+
+   for (i = 0; i < in_frames; i += BENCH_CHUNK)
+   {
+      struct resampler_data data;
+
+      data.data_in       = in + i * 2;
+      data.data_out      = out + out_samples;
+      data.input_frames  = BENCH_CHUNK;
+      data.output_frames = 0;
+      data.ratio         = ratio;
+
+      process(re, &data);
+      out_samples       += data.output_frames * 2;
+   }
+
+   *elapsed = cpu_features_get_time_usec() - start;
+   sinc_resampler.free(re);
+   return out_samples;
+}
+
+int main(void)
+{
+   unsigned q, p;
+   size_t i;
+   double ratio                 = (double)BENCH_OUT_RATE / BENCH_IN_RATE;
+   size_t in_frames             = BENCH_IN_RATE * BENCH_SECONDS;
+   size_t out_max               = (size_t)(in_frames * ratio * 2) + 4096;
+   resampler_simd_mask_t avail  = bench_simd_mask();
+   float *in                    = (float*)malloc(in_frames * 2 * sizeof(float));
+   float *ref                   = (float*)malloc(out_max * sizeof(float));
+   float *out                   = (float*)malloc(out_max * sizeof(float));
+
+   if (!in || !ref || !out)
+      return 1;
+
+   in_frames -= in_frames % BENCH_CHUNK;
+
+   /* A chord on the left, noise on the right. */
+   srand(1);
+   for (i = 0; i < in_frames; i++)
+   {
+      double t      = (double)i / BENCH_IN_RATE;
+      in[i * 2 + 0] = 0.3f * (float)(sin(2.0 * M_PI * 440.0 * t)
+            + sin(2.0 * M_PI * 554.37 * t) + sin(2.0 * M_PI * 659.25 * t));
+      in[i * 2 + 1] = (float)rand() / RAND_MAX - 0.5f;
+   }
+
+   /* The first init generates the phase table, the second one
+    * should find it in the cache, which lives as long as
+    * some resampler does. */
+   {
+      void *re[2];
+      for (q = 0; q < 2; q++)
+      {
+         retro_time_t start = cpu_features_get_time_usec();
+         re[q]              = sinc_resampler.init(NULL, ratio,
+               RESAMPLER_QUALITY_HIGHEST, avail);
+         printf("highest quality init #%u: %.2f ms\n", q + 1,
+               (cpu_features_get_time_usec() - start) / 1000.0);
+      }
+      for (q = 0; q < 2; q++)
+         if (re[q])
+            sinc_resampler.free(re[q]);
+   }
+   printf("\n");
+
+   printf("%u seconds of %u Hz stereo to %u Hz, %u frames per call\n\n",
+         BENCH_SECONDS, BENCH_IN_RATE, BENCH_OUT_RATE, BENCH_CHUNK);
+   printf("%-8s %-9s %10s %10s %12s\n",
+         "quality", "path", "time (ms)", "realtime", "max diff");
+
+   for (q = 0; q < sizeof(bench_qualities) / sizeof(bench_qualities[0]); q++)
+   {
+      retro_time_t elapsed;
+      size_t ref_samples = bench_run(bench_qualities[q].quality, 0,
+            ratio, in, in_frames, ref, &elapsed);
+
+      for (p = 0; p < sizeof(bench_paths) / sizeof(bench_paths[0]); p++)
+      {
+         size_t out_samples;
+         float max_diff = 0.0f;
+
+         if ((avail & bench_paths[p].mask) != bench_paths[p].mask)
+            continue;
+
+         out_samples = bench_run(bench_qualities[q].quality,
+               bench_paths[p].mask, ratio, in, in_frames, out, &elapsed);
+
+         /* Wider paths may round the tap count up,
+          * so only the C path is compared sample by sample. */
+         for (i = 0; i < out_samples && i < ref_samples; i++)
+         {
+            float diff = fabsf(out[i] - ref[i]);
+            if (diff > max_diff)
+               max_diff = diff;
+         }
+
+         printf("%-8s %-9s %10.2f %9.0fx %12g\n",
+               bench_qualities[q].name, bench_paths[p].name,
+               elapsed / 1000.0,
+               BENCH_SECONDS * 1000000.0 / (elapsed ? elapsed : 1),
+               max_diff);
+      }
+   }
+
+   free(in);
+   free(ref);
+   free(out);
+   return 0;
+}
@@ -31,15 +31,93 @@
 #include <libchdr/chd.h>
 #include <string/stdstring.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <features/features_cpu.h>
+#include <retro_atomic.h>
+#endif
+
 #define SECTOR_SIZE 2352
 #define SUBCODE_SIZE 96
 #define TRACK_PAD 4
 
+/* Defaults for chdstream_set_cache_size() */
+#define CHDSTREAM_CACHE_HUNKS 16
+#define CHDSTREAM_READAHEAD_HUNKS 8
+
+/* Maximum number of read-ahead threads per stream. Every
+ * thread holds its own chd_file, and they are taken out of
+ * the process-wide budget (cpu_features_reserve_threads()),
+ * so streams opened at the same time (e.g. by a database
+ * scan) don't each start their own. */
+#define CHDSTREAM_MAX_THREADS 4
+
+/* Number of consecutive hunks that must be read in order
+ * before read-ahead starts. Serial detection and file system
+ * lookups only touch a few scattered hunks and never get
+ * that far, so they don't pay for the extra threads. */
+#define CHDSTREAM_READAHEAD_TRIGGER 2
+
+enum chdstream_hunk_state
+{
+   CHDSTREAM_HUNK_EMPTY = 0,
+   /* Waiting for a read-ahead thread */
+   CHDSTREAM_HUNK_QUEUED,
+   /* Being decompressed */
+   CHDSTREAM_HUNK_BUSY,
+   CHDSTREAM_HUNK_READY
+};
+
+/* A cache slot holding one decompressed hunk */
+typedef struct chdstream_hunk
+{
+   uint8_t *data;
+   int32_t hunknum;
+   /* Last use, for LRU eviction. While queued,
+    * the order in which read-ahead was requested */
+   uint32_t tick;
+   enum chdstream_hunk_state state;
+   /* Decompressed by a read-ahead thread and not read yet */
+   bool prefetched;
+} chdstream_hunk_t;
+
+#ifdef HAVE_THREADS
+typedef struct chdstream_worker
+{
+   chdstream_t *stream;
+   sthread_t *thread;
+   /* Every thread has its own handle, since
+    * a chd_file can only decompress one hunk at a time */
+   chd_file *chd;
+} chdstream_worker_t;
+#endif
+
 struct chdstream
 {
    chd_file *chd;
-   /* Loaded hunk */
+   /* Loaded hunk, points into the cache */
    uint8_t *hunkmem;
+   char *path;
+   chdstream_hunk_t *cache;
+#ifdef HAVE_THREADS
+   /* Only created once read-ahead starts, guards
+    * the cache slots and the stats */
+   slock_t *lock;
+   scond_t *cond;
+   chdstream_worker_t workers[CHDSTREAM_MAX_THREADS];
+   unsigned num_workers;
+   bool quit;
+#endif
+   chdstream_cache_stats_t stats;
+   /* Number of cache slots */
+   unsigned cache_size;
+   /* Number of hunks to decompress ahead, 0 when disabled */
+   unsigned readahead;
+   /* Number of consecutive hunks read in order */
+   unsigned sequential;
+   uint32_t tick;
+   /* Last hunk holding data of the track */
+   uint32_t last_hunk;
    /* Byte offset where track data starts (after pregap) */
    size_t track_start;
    /* Byte offset where track data ends */
@@ -203,11 +281,69 @@ chdstream_find_track(chd_file *fd, int32_t track, metadata_t *meta)
    return chdstream_find_track_number(fd, track, meta);
 }
 
+static void chdstream_cache_free(chdstream_t *stream)
+{
+   unsigned i;
+
+   if (!stream->cache)
+      return;
+
+   for (i = 0; i < stream->cache_size; i++)
+      if (stream->cache[i].data)
+         free(stream->cache[i].data);
+   free(stream->cache);
+   stream->cache      = NULL;
+   stream->cache_size = 0;
+}
+
+/* (Re)allocates the cache slots, dropping whatever they held.
+ * No read-ahead thread may be running. */
+static bool chdstream_cache_alloc(chdstream_t *stream,
+      unsigned hunks, unsigned readahead)
+{
+   unsigned i;
+   chdstream_hunk_t *cache;
+   uint32_t totalhunks = chd_get_header(stream->chd)->totalhunks;
+
+#if defined(HAVE_THREADS) && defined(RETRO_ATOMIC_LOCK_FREE)
+   if (cpu_features_get_core_amount() <= 1)
+      readahead = 0;
+#else
+   readahead = 0;
+#endif
+
+   /* The loaded hunk is never evicted, so there must be room
+    * for one more. Read-ahead needs room for the current hunk,
+    * the hunks in flight and at least one to evict. */
+   if (hunks < 2)
+      hunks     = 2;
+   if (readahead && hunks < readahead + 2)
+      hunks     = readahead + 2;
+   if (hunks > totalhunks)
+      hunks     = totalhunks ? totalhunks : 1;
+   if (readahead + 2 > hunks)
+      readahead = 0;
+
+   /* Slot buffers are allocated on first use */
+   if (!(cache = (chdstream_hunk_t*)calloc(hunks, sizeof(*cache))))
+      return false;
+   for (i = 0; i < hunks; i++)
+      cache[i].hunknum = -1;
+
+   chdstream_cache_free(stream);
+   stream->cache      = cache;
+   stream->cache_size = hunks;
+   stream->readahead  = readahead;
+   stream->hunkmem    = NULL;
+   stream->hunknum    = -1;
+   stream->sequential = 0;
+   return true;
+}
+
 chdstream_t *chdstream_open(const char *path, int32_t track)
 {
    metadata_t meta;
    uint32_t pregap         = 0;
-   uint8_t *hunkmem        = NULL;
    const chd_header *hd    = NULL;
    chdstream_t *stream     = NULL;
    chd_file *chd           = NULL;
@@ -234,13 +370,32 @@ chdstream_t *chdstream_open(const char *path, int32_t track)
    stream->offset          = 0;
    stream->hunkmem         = NULL;
    stream->hunknum         = -1;
+   stream->path            = NULL;
+   stream->cache           = NULL;
+   stream->sequential      = 0;
+   stream->tick            = 0;
+   stream->last_hunk       = 0;
+#ifdef HAVE_THREADS
+   stream->lock            = NULL;
+   stream->cond            = NULL;
+   stream->num_workers     = 0;
+   stream->quit            = false;
+   /* Read-ahead threads open their own handles */
+   if (!(stream->path      = strdup(path)))
+      goto error;
+#endif
+   stream->cache_size      = 0;
+   memset(&stream->stats, 0, sizeof(stream->stats));
 
    hd                      = chd_get_header(chd);
-   hunkmem                 = (uint8_t*)malloc(hd->hunkbytes);
-   if (!hunkmem)
-      goto error;
+   stream->chd             = chd;
 
-   stream->hunkmem         = hunkmem;
+   if (!chdstream_cache_alloc(stream,
+            CHDSTREAM_CACHE_HUNKS, CHDSTREAM_READAHEAD_HUNKS))
+   {
+      stream->chd          = NULL;
+      goto error;
+   }
 
    if (string_is_equal(meta.type, "MODE1_RAW"))
       stream->frame_size   = SECTOR_SIZE;
@@ -258,12 +413,16 @@ chdstream_t *chdstream_open(const char *path, int32_t track)
    if (meta.pgtype[0] != 'V')
       pregap               = meta.pregap;
 
-   stream->chd             = chd;
    stream->frames_per_hunk = hd->hunkbytes / hd->unitbytes;
    stream->track_frame     = meta.frame_offset;
    stream->track_start     = (size_t)pregap * stream->frame_size;
    stream->track_end       = stream->track_start + 
                              (size_t)meta.frames * stream->frame_size;
+   if (meta.frames > 0)
+      stream->last_hunk    = (stream->track_frame + meta.frames - 1)
+                           / stream->frames_per_hunk;
+   if (stream->last_hunk >= hd->totalhunks)
+      stream->last_hunk    = hd->totalhunks ? hd->totalhunks - 1 : 0;
 
    return stream;
 
@@ -277,40 +436,402 @@ error:
    return NULL;
 }
 
+#ifdef HAVE_THREADS
+static void chdstream_stop_workers(chdstream_t *stream)
+{
+   unsigned i;
+
+   if (stream->lock)
+   {
+      slock_lock(stream->lock);
+      stream->quit = true;
+      scond_broadcast(stream->cond);
+      slock_unlock(stream->lock);
+   }
+
+   for (i = 0; i < stream->num_workers; i++)
+   {
+      sthread_join(stream->workers[i].thread);
+      chd_close(stream->workers[i].chd);
+   }
+   cpu_features_release_threads(stream->num_workers);
+   stream->num_workers = 0;
+
+   if (stream->cond)
+      scond_free(stream->cond);
+   if (stream->lock)
+      slock_free(stream->lock);
+   stream->cond = NULL;
+   stream->lock = NULL;
+}
+#endif
+
+bool chdstream_set_cache_size(chdstream_t *stream,
+      unsigned hunks, unsigned readahead)
+{
+#ifdef HAVE_THREADS
+   /* Restarted by the next sequential reads */
+   chdstream_stop_workers(stream);
+#endif
+   return chdstream_cache_alloc(stream, hunks, readahead);
+}
+
+void chdstream_get_cache_stats(chdstream_t *stream,
+      chdstream_cache_stats_t *stats)
+{
+#ifdef HAVE_THREADS
+   if (stream->lock)
+      slock_lock(stream->lock);
+#endif
+   *stats = stream->stats;
+#ifdef HAVE_THREADS
+   if (stream->lock)
+      slock_unlock(stream->lock);
+#endif
+}
+
 void chdstream_close(chdstream_t *stream)
 {
    if (!stream)
       return;
 
-   if (stream->hunkmem)
-      free(stream->hunkmem);
+#ifdef HAVE_THREADS
+   chdstream_stop_workers(stream);
+#endif
+
+   chdstream_cache_free(stream);
+   if (stream->path)
+      free(stream->path);
    if (stream->chd)
       chd_close(stream->chd);
    free(stream);
 }
 
+static chd_error chdstream_decompress(chdstream_t *stream,
+      chd_file *chd, uint32_t hunknum, uint8_t *data)
+{
+   chd_error err = chd_read(chd, hunknum, data);
+
+   if (err == CHDERR_NONE && stream->swab)
+   {
+      uint32_t i;
+      uint32_t count  = chd_get_header(chd)->hunkbytes / 2;
+      uint16_t *array = (uint16_t*)data;
+      for (i = 0; i < count; ++i)
+         array[i] = SWAP16(array[i]);
+   }
+
+   return err;
+}
+
+static chdstream_hunk_t *chdstream_cache_find(chdstream_t *stream,
+      uint32_t hunknum)
+{
+   unsigned i;
+   for (i = 0; i < stream->cache_size; i++)
+      if (     stream->cache[i].hunknum == (int32_t)hunknum
+            && stream->cache[i].state   != CHDSTREAM_HUNK_EMPTY)
+         return &stream->cache[i];
+   return NULL;
+}
+
+/* Picks the least recently used slot that isn't being
+ * decompressed, never the one holding the loaded hunk.
+ * Slots still queued for read-ahead are only given up
+ * when @take_queued is set and nothing else is left. */
+static chdstream_hunk_t *chdstream_cache_evict(chdstream_t *stream,
+      bool take_queued)
+{
+   unsigned i;
+   chdstream_hunk_t *victim = NULL;
+
+   for (i = 0; i < stream->cache_size; i++)
+   {
+      chdstream_hunk_t *slot = &stream->cache[i];
+
+      if (slot->state == CHDSTREAM_HUNK_EMPTY)
+      {
+         victim = slot;
+         break;
+      }
+      if (     slot->state != CHDSTREAM_HUNK_READY
+            || slot->hunknum == stream->hunknum)
+         continue;
+      if (!victim || (int32_t)(slot->tick - victim->tick) < 0)
+         victim = slot;
+   }
+
+   if (!victim && take_queued)
+   {
+      for (i = 0; i < stream->cache_size; i++)
+      {
+         chdstream_hunk_t *slot = &stream->cache[i];
+         if (     slot->state == CHDSTREAM_HUNK_QUEUED
+               && (!victim || (int32_t)(slot->tick - victim->tick) > 0))
+            victim = slot;
+      }
+   }
+
+   if (victim && !victim->data)
+   {
+      if (!(victim->data = (uint8_t*)malloc(
+                  chd_get_header(stream->chd)->hunkbytes)))
+         return NULL;
+   }
+
+   return victim;
+}
+
+#ifdef HAVE_THREADS
+static void chdstream_worker(void *data)
+{
+   chdstream_worker_t *worker = (chdstream_worker_t*)data;
+   chdstream_t *stream        = worker->stream;
+
+   slock_lock(stream->lock);
+
+   for (;;)
+   {
+      unsigned i;
+      uint32_t hunknum;
+      chd_error err;
+      chdstream_hunk_t *slot = NULL;
+
+      if (stream->quit)
+         break;
+
+      /* Oldest request first, it's the closest to the reader */
+      for (i = 0; i < stream->cache_size; i++)
+      {
+         chdstream_hunk_t *cur = &stream->cache[i];
+         if (     cur->state == CHDSTREAM_HUNK_QUEUED
+               && (!slot || (int32_t)(cur->tick - slot->tick) < 0))
+            slot = cur;
+      }
+
+      if (!slot)
+      {
+         scond_wait(stream->cond, stream->lock);
+         continue;
+      }
+
+      slot->state = CHDSTREAM_HUNK_BUSY;
+      hunknum     = (uint32_t)slot->hunknum;
+      slock_unlock(stream->lock);
+
+      err         = chdstream_decompress(stream, worker->chd,
+            hunknum, slot->data);
+
+      slock_lock(stream->lock);
+      if (err == CHDERR_NONE)
+      {
+         slot->state = CHDSTREAM_HUNK_READY;
+         stream->stats.prefetched++;
+      }
+      else
+      {
+         /* The reader will try again itself */
+         slot->state   = CHDSTREAM_HUNK_EMPTY;
+         slot->hunknum = -1;
+      }
+      scond_broadcast(stream->cond);
+   }
+
+   slock_unlock(stream->lock);
+}
+
+static bool chdstream_start_workers(chdstream_t *stream)
+{
+   unsigned i;
+   unsigned num_threads = stream->readahead;
+
+   if (num_threads > CHDSTREAM_MAX_THREADS)
+      num_threads = CHDSTREAM_MAX_THREADS;
+   /* Other streams may already use up the budget,
+    * this one then decompresses everything itself */
+   if (!(num_threads = cpu_features_reserve_threads(num_threads)))
+      return false;
+
+   if (     !(stream->lock = slock_new())
+         || !(stream->cond = scond_new()))
+   {
+      cpu_features_release_threads(num_threads);
+      return false;
+   }
+
+   for (i = 0; i < num_threads; i++)
+   {
+      chdstream_worker_t *worker = &stream->workers[stream->num_workers];
+
+      worker->stream = stream;
+      worker->chd    = NULL;
+      if (chd_open(stream->path, CHD_OPEN_READ, NULL,
+               &worker->chd) != CHDERR_NONE)
+         break;
+      if (!(worker->thread = sthread_create(chdstream_worker, worker)))
+      {
+         chd_close(worker->chd);
+         break;
+      }
+      stream->num_workers++;
+   }
+
+   /* Give back what couldn't be started */
+   cpu_features_release_threads(num_threads - stream->num_workers);
+
+   return stream->num_workers > 0;
+}
+
+/* Queues the hunks following the loaded one for
+ * the read-ahead threads, up to the end of the track */
+static void chdstream_queue_readahead(chdstream_t *stream)
+{
+   unsigned i;
+   bool queued = false;
+
+   for (i = 1; i <= stream->readahead; i++)
+   {
+      chdstream_hunk_t *slot;
+      uint32_t hunknum = (uint32_t)stream->hunknum + i;
+
+      if (hunknum > stream->last_hunk)
+         break;
+      if (chdstream_cache_find(stream, hunknum))
+         continue;
+      if (!(slot = chdstream_cache_evict(stream, false)))
+         break;
+
+      slot->hunknum    = (int32_t)hunknum;
+      slot->tick       = ++stream->tick;
+      slot->state      = CHDSTREAM_HUNK_QUEUED;
+      slot->prefetched = true;
+      queued           = true;
+   }
+
+   if (queued)
+      scond_broadcast(stream->cond);
+}
+#endif
+
 static bool
 chdstream_load_hunk(chdstream_t *stream, uint32_t hunknum)
 {
-   uint16_t *array;
+   chdstream_hunk_t *slot;
+   bool sequential;
+   chd_error err = CHDERR_NONE;
 
    if ((int)hunknum == stream->hunknum)
       return true;
 
-   if (chd_read(stream->chd, hunknum, stream->hunkmem) != CHDERR_NONE)
-      return false;
+   sequential = (   stream->hunknum >= 0
+                 && hunknum == (uint32_t)stream->hunknum + 1);
+   if (sequential)
+      stream->sequential++;
+   else
+      stream->sequential = 0;
 
-   if (stream->swab)
+#ifdef HAVE_THREADS
+   if (     stream->readahead
+         && !stream->lock
+         && stream->sequential >= CHDSTREAM_READAHEAD_TRIGGER)
    {
-      uint32_t i;
-      uint32_t count = chd_get_header(stream->chd)->hunkbytes / 2;
-      array          = (uint16_t*)stream->hunkmem;
-      for (i = 0; i < count; ++i)
-         array[i] = SWAP16(array[i]);
+      if (!chdstream_start_workers(stream))
+      {
+         chdstream_stop_workers(stream);
+         stream->readahead = 0;
+      }
    }
 
-   stream->hunknum = hunknum;
-   return true;
+   if (stream->lock)
+   {
+      slock_lock(stream->lock);
+
+      /* Reading moved elsewhere, drop the
+       * read-ahead that hasn't started yet */
+      if (!sequential)
+      {
+         unsigned i;
+         for (i = 0; i < stream->cache_size; i++)
+         {
+            if (stream->cache[i].state == CHDSTREAM_HUNK_QUEUED)
+            {
+               stream->cache[i].state   = CHDSTREAM_HUNK_EMPTY;
+               stream->cache[i].hunknum = -1;
+            }
+         }
+      }
+
+      /* Wait for a read-ahead thread that is already on it */
+      if (     (slot = chdstream_cache_find(stream, hunknum))
+            && slot->state == CHDSTREAM_HUNK_BUSY)
+      {
+         stream->stats.waits++;
+         do
+         {
+            scond_wait(stream->cond, stream->lock);
+         } while ((slot = chdstream_cache_find(stream, hunknum))
+               && slot->state == CHDSTREAM_HUNK_BUSY);
+      }
+   }
+   else
+#endif
+      slot = chdstream_cache_find(stream, hunknum);
+
+   if (slot && slot->state == CHDSTREAM_HUNK_READY)
+   {
+      stream->stats.hits++;
+      if (slot->prefetched)
+         stream->stats.prefetch_hits++;
+   }
+   else
+   {
+      /* Not cached, or still queued for read-ahead,
+       * in which case it's quicker to do it right here */
+      if (!slot && !(slot = chdstream_cache_evict(stream, true)))
+         err = CHDERR_OUT_OF_MEMORY;
+      else
+      {
+         slot->hunknum = (int32_t)hunknum;
+         slot->state   = CHDSTREAM_HUNK_BUSY;
+#ifdef HAVE_THREADS
+         if (stream->lock)
+            slock_unlock(stream->lock);
+#endif
+         err           = chdstream_decompress(stream, stream->chd,
+               hunknum, slot->data);
+#ifdef HAVE_THREADS
+         if (stream->lock)
+            slock_lock(stream->lock);
+#endif
+         stream->stats.misses++;
+         if (err == CHDERR_NONE)
+            slot->state   = CHDSTREAM_HUNK_READY;
+         else
+         {
+            slot->state   = CHDSTREAM_HUNK_EMPTY;
+            slot->hunknum = -1;
+         }
+      }
+   }
+
+   if (err == CHDERR_NONE)
+   {
+      slot->tick       = ++stream->tick;
+      slot->prefetched = false;
+      stream->hunkmem  = slot->data;
+      stream->hunknum  = hunknum;
+#ifdef HAVE_THREADS
+      if (stream->lock && sequential)
+         chdstream_queue_readahead(stream);
+#endif
+   }
+
+#ifdef HAVE_THREADS
+   if (stream->lock)
+      slock_unlock(stream->lock);
+#endif
+
+   return err == CHDERR_NONE;
 }
 
 ssize_t chdstream_read(chdstream_t *stream, void *data, size_t bytes)
@@ -61,6 +61,7 @@ struct intfstream_internal
    struct
    {
       rzipstream_t *fp;
+      enum rzip_codec codec;
    } rzip;
 #endif
    enum intfstream_type type;
@@ -151,7 +152,7 @@ bool intfstream_open(intfstream_internal_t *intf, const char *path,
 #endif
       case INTFSTREAM_RZIP:
 #if defined(HAVE_ZLIB)
-         intf->rzip.fp = rzipstream_open(path, mode);
+         intf->rzip.fp = rzipstream_open_codec(path, mode, intf->rzip.codec);
          if (!intf->rzip.fp)
             return false;
          break;
@@ -237,6 +238,7 @@ void *intfstream_init(intfstream_info_t *info)
 #endif
 #ifdef HAVE_ZLIB
    intf->rzip.fp         = NULL;
+   intf->rzip.codec      = RZIP_CODEC_ZLIB;
 #endif
 
    switch (intf->type)
@@ -801,6 +803,13 @@ error:
 
 intfstream_t* intfstream_open_rzip_file(const char *path,
       unsigned mode)
+{
+   return intfstream_open_rzip_file_codec(path, mode,
+         0 /* RZIP_CODEC_ZLIB */);
+}
+
+intfstream_t* intfstream_open_rzip_file_codec(const char *path,
+      unsigned mode, unsigned codec)
 {
    intfstream_info_t info;
    intfstream_t *fd = NULL;
@@ -811,6 +820,10 @@ intfstream_t* intfstream_open_rzip_file(const char *path,
    if (!fd)
       return NULL;
 
+#if defined(HAVE_ZLIB)
+   fd->rzip.codec   = (enum rzip_codec)codec;
+#endif
+
    if (!intfstream_open(fd, path, mode, RETRO_VFS_FILE_ACCESS_HINT_NONE))
       goto error;
 
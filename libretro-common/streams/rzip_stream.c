@@ -28,8 +28,18 @@
 
 #include <streams/rzip_stream.h>
 
-/* Current RZIP file format version */
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <features/features_cpu.h>
+#endif
+
+/* RZIP file format versions
+ * > Version 1: zlib only, 20 byte header
+ * > Version 2: adds a codec field to the header.
+ *   Only used for non-zlib codecs, so that zlib
+ *   files remain readable by older frontends */
 #define RZIP_VERSION 1
+#define RZIP_VERSION_CODEC 2
 
 /* Compression level
  * > zlib default of 6 provides the best
@@ -42,8 +52,13 @@
 
 /* Header sizes (in bytes) */
 #define RZIP_HEADER_SIZE 20
+#define RZIP_HEADER_SIZE_CODEC 24
 #define RZIP_CHUNK_HEADER_SIZE 4
 
+/* Maximum number of worker threads used to
+ * (de)compress chunks in parallel */
+#define RZIP_MAX_THREADS 8
+
 /* Holds all metadata for an RZIP file stream */
 struct rzipstream
 {
@@ -64,6 +79,8 @@ struct rzipstream
    uint32_t out_buf_ptr;
    uint32_t out_buf_occupancy;
    uint32_t chunk_size;
+   uint32_t header_size;
+   enum rzip_codec codec;
    bool is_compressed;
    bool is_writing;
 };
@@ -79,12 +96,12 @@ static bool rzipstream_read_file_header(rzipstream_t *stream)
 {
    unsigned i;
    int64_t length;
-   uint8_t header_bytes[RZIP_HEADER_SIZE];
+   uint8_t header_bytes[RZIP_HEADER_SIZE_CODEC];
 
    if (!stream)
       return false;
 
-   for (i = 0; i < RZIP_HEADER_SIZE; i++)
+   for (i = 0; i < RZIP_HEADER_SIZE_CODEC; i++)
       header_bytes[i] = 0;
 
    /* Attempt to read header bytes */
@@ -104,8 +121,11 @@ static bool rzipstream_read_file_header(rzipstream_t *stream)
        || (header_bytes[3] !=           73)  /* I */
        || (header_bytes[4] !=           80)  /* P */
        || (header_bytes[5] !=          118)  /* v */
-       || (header_bytes[6] != RZIP_VERSION)  /* file format version number */
-       || (header_bytes[7] !=           35)) /* # */
+       || (   (header_bytes[6] != RZIP_VERSION)
+           && (header_bytes[6] != RZIP_VERSION_CODEC)) /* file format version number */
+       || (header_bytes[7] !=           35)  /* # */
+       || (   (header_bytes[6] == RZIP_VERSION_CODEC)
+           && (length < RZIP_HEADER_SIZE_CODEC)))
    {
       /* Reset file to start */
       filestream_seek(stream->file, 0, SEEK_SET);
@@ -133,6 +153,24 @@ static bool rzipstream_read_file_header(rzipstream_t *stream)
                    (uint64_t)header_bytes[12]) == 0)
       return false;
 
+   /* Get codec - version 2 only */
+   if (header_bytes[6] == RZIP_VERSION_CODEC)
+   {
+      if (header_bytes[20] >= RZIP_CODEC_LAST)
+         return false;
+      stream->codec       = (enum rzip_codec)header_bytes[20];
+      stream->header_size = RZIP_HEADER_SIZE_CODEC;
+   }
+   else
+   {
+      stream->codec       = RZIP_CODEC_ZLIB;
+      stream->header_size = RZIP_HEADER_SIZE;
+   }
+
+   /* Move to the first chunk */
+   if (filestream_seek(stream->file, stream->header_size, SEEK_SET) != 0)
+      return false;
+
    stream->is_compressed = true;
    return true;
 }
@@ -143,13 +181,13 @@ static bool rzipstream_read_file_header(rzipstream_t *stream)
 static bool rzipstream_write_file_header(rzipstream_t *stream)
 {
    unsigned i;
-   uint8_t header_bytes[RZIP_HEADER_SIZE];
+   uint8_t header_bytes[RZIP_HEADER_SIZE_CODEC];
 
    if (!stream)
       return false;
 
    /* Populate header array */
-   for (i = 0; i < RZIP_HEADER_SIZE; i++)
+   for (i = 0; i < RZIP_HEADER_SIZE_CODEC; i++)
       header_bytes[i] = 0;
 
    /* > 'Magic numbers' - first 8 bytes */
@@ -159,7 +197,8 @@ static bool rzipstream_write_file_header(rzipstream_t *stream)
    header_bytes[3]    =        73;    /* I */
    header_bytes[4]    =        80;    /* P */
    header_bytes[5]    =       118;    /* v */
-   header_bytes[6]    = RZIP_VERSION; /* file format version number */
+   header_bytes[6]    = (stream->codec == RZIP_CODEC_ZLIB)
+      ? RZIP_VERSION : RZIP_VERSION_CODEC; /* file format version number */
    header_bytes[7]    =        35;    /* # */
 
    /* > Uncompressed chunk size - next 4 bytes */
@@ -178,20 +217,47 @@ static bool rzipstream_write_file_header(rzipstream_t *stream)
    header_bytes[13]   = (stream->size >>  8) & 0xFF;
    header_bytes[12]   =  stream->size        & 0xFF;
 
+   /* > Codec (version 2 only) - next byte,
+    *   followed by 3 reserved bytes */
+   header_bytes[20]   = (uint8_t)stream->codec;
+
    /* Reset file to start */
    filestream_seek(stream->file, 0, SEEK_SET);
 
    /* Write header bytes */
    return (filestream_write(stream->file,
-         header_bytes, sizeof(header_bytes)) == RZIP_HEADER_SIZE);
+         header_bytes, stream->header_size) == stream->header_size);
 }
 
 /* Stream Initialisation/De-initialisation */
 
+/* Returns the transform stream backend
+ * implementing 'codec' */
+static const struct trans_stream_backend *rzipstream_get_backend(
+      enum rzip_codec codec, bool compress)
+{
+   switch (codec)
+   {
+      case RZIP_CODEC_ZLIB:
+         return compress
+            ? trans_stream_get_zlib_deflate_backend()
+            : trans_stream_get_zlib_inflate_backend();
+      case RZIP_CODEC_LZ4:
+         return compress
+            ? trans_stream_get_lz4_compress_backend()
+            : trans_stream_get_lz4_decompress_backend();
+      default:
+         break;
+   }
+
+   return NULL;
+}
+
 /* Initialises all members of an rzipstream_t struct,
  * reading config from existing file header if available */
 static bool rzipstream_init_stream(
-      rzipstream_t *stream, const char *path, bool is_writing)
+      rzipstream_t *stream, const char *path, bool is_writing,
+      enum rzip_codec codec)
 {
    unsigned file_mode;
 
@@ -220,6 +286,9 @@ static bool rzipstream_init_stream(
    {
       /* Written files are always compressed */
       stream->is_compressed = true;
+      stream->codec         = codec;
+      stream->header_size   = (codec == RZIP_CODEC_ZLIB)
+         ? RZIP_HEADER_SIZE : RZIP_HEADER_SIZE_CODEC;
       file_mode             = RETRO_VFS_FILE_ACCESS_WRITE;
    }
    /* For read files, must get compression status
@@ -253,15 +322,17 @@ static bool rzipstream_init_stream(
    if (stream->is_writing)
    {
       /* Compression */
-      if (!(stream->deflate_backend = trans_stream_get_zlib_deflate_backend()))
+      if (!(stream->deflate_backend = rzipstream_get_backend(
+            stream->codec, true)))
          return false;
 
       if (!(stream->deflate_stream = stream->deflate_backend->stream_new()))
          return false;
 
       /* Set compression level */
-      if (!stream->deflate_backend->define(
-            stream->deflate_stream, "level", RZIP_COMPRESSION_LEVEL))
+      if (     (stream->codec == RZIP_CODEC_ZLIB)
+            && !stream->deflate_backend->define(
+               stream->deflate_stream, "level", RZIP_COMPRESSION_LEVEL))
          return false;
 
       /* Buffers
@@ -286,7 +357,8 @@ static bool rzipstream_init_stream(
    else if (stream->is_compressed)
    {
       /* Decompression */
-      if (!(stream->inflate_backend = trans_stream_get_zlib_inflate_backend()))
+      if (!(stream->inflate_backend = rzipstream_get_backend(
+            stream->codec, false)))
          return false;
 
       if (!(stream->inflate_stream = stream->inflate_backend->stream_new()))
@@ -376,9 +448,12 @@ static int rzipstream_free_stream(rzipstream_t *stream)
  *   - RETRO_VFS_FILE_ACCESS_WRITE
  * > When reading, 'path' may reference compressed
  *   or uncompressed data
+ * > When writing, data is compressed with 'codec';
+ *   when reading, the codec is taken from the file
  * Returns NULL if arguments are invalid, file
  * is invalid or an IO error occurs */
-rzipstream_t* rzipstream_open(const char *path, unsigned mode)
+rzipstream_t* rzipstream_open_codec(const char *path, unsigned mode,
+      enum rzip_codec codec)
 {
    rzipstream_t *stream = NULL;
 
@@ -403,6 +478,8 @@ rzipstream_t* rzipstream_open(const char *path, unsigned mode)
    stream->is_writing      = false;
    stream->size            = 0;
    stream->chunk_size      = 0;
+   stream->header_size     = RZIP_HEADER_SIZE;
+   stream->codec           = RZIP_CODEC_ZLIB;
    stream->virtual_ptr     = 0;
    stream->file            = NULL;
    stream->deflate_backend = NULL;
@@ -420,7 +497,7 @@ rzipstream_t* rzipstream_open(const char *path, unsigned mode)
    /* Initialise stream */
    if (!rzipstream_init_stream(
          stream, path,
-         (mode == RETRO_VFS_FILE_ACCESS_WRITE)))
+         (mode == RETRO_VFS_FILE_ACCESS_WRITE), codec))
    {
       rzipstream_free_stream(stream);
       return NULL;
@@ -429,20 +506,63 @@ rzipstream_t* rzipstream_open(const char *path, unsigned mode)
    return stream;
 }
 
-/* File Read */
+/* Opens a new or existing RZIP file
+ * > Supported 'mode' values are:
+ *   - RETRO_VFS_FILE_ACCESS_READ
+ *   - RETRO_VFS_FILE_ACCESS_WRITE
+ * > When reading, 'path' may reference compressed
+ *   or uncompressed data
+ * Returns NULL if arguments are invalid, file
+ * is invalid or an IO error occurs */
+rzipstream_t* rzipstream_open(const char *path, unsigned mode)
+{
+   return rzipstream_open_codec(path, mode, RZIP_CODEC_ZLIB);
+}
 
-/* Reads and decompresses the next chunk of data
- * in the RZIP file */
-static bool rzipstream_read_chunk(rzipstream_t *stream)
+/* Chunk Functions */
+
+/* Runs a single chunk of data through a transform
+ * stream in one pass, writing the result to 'out'.
+ * Each chunk is a self-contained zlib stream, so
+ * chunks may be processed in any order */
+static bool rzipstream_trans_chunk(
+      const struct trans_stream_backend *backend, void *trans,
+      const uint8_t *in, uint32_t in_size,
+      uint8_t *out, uint32_t out_size, uint32_t *written)
+{
+   uint32_t trans_read;
+   uint32_t trans_written;
+
+   backend->set_in(trans, in, in_size);
+   backend->set_out(trans, out, out_size);
+
+   /* Note: We have to set 'flush == true' here, otherwise we
+    * can't guarantee that the entire chunk will be written
+    * to the output buffer - this is inefficient, but not
+    * much we can do... */
+   if (!backend->trans(trans, true, &trans_read, &trans_written, NULL))
+      return false;
+
+   /* Error checking */
+   if (trans_read != in_size)
+      return false;
+
+   if (   (trans_written == 0)
+       || (trans_written > out_size))
+      return false;
+
+   *written = trans_written;
+   return true;
+}
+
+/* Reads the next compressed chunk from file into
+ * 'buf', growing it if required */
+static bool rzipstream_read_chunk_data(rzipstream_t *stream,
+      uint8_t **buf, uint32_t *buf_size, uint32_t *chunk_size)
 {
    unsigned i;
    uint8_t chunk_header_bytes[RZIP_CHUNK_HEADER_SIZE];
    uint32_t compressed_chunk_size;
-   uint32_t inflate_read;
-   uint32_t inflate_written;
-
-   if (!stream || !stream->inflate_backend || !stream->inflate_stream)
-      return false;
 
    for (i = 0; i < RZIP_CHUNK_HEADER_SIZE; i++)
       chunk_header_bytes[i] = 0;
@@ -462,52 +582,395 @@ static bool rzipstream_read_chunk(rzipstream_t *stream)
       return false;
 
    /* Resize input buffer, if required */
-   if (compressed_chunk_size > stream->in_buf_size)
+   if (compressed_chunk_size > *buf_size)
    {
-      free(stream->in_buf);
-      stream->in_buf      = NULL;
+      free(*buf);
+      *buf      = NULL;
 
-      stream->in_buf_size = compressed_chunk_size;
-      stream->in_buf      = (uint8_t *)calloc(stream->in_buf_size, 1);
-      if (!stream->in_buf)
+      *buf_size = compressed_chunk_size;
+      if (!(*buf = (uint8_t *)calloc(*buf_size, 1)))
+      {
+         *buf_size = 0;
          return false;
-
-      /* Note: Uncompressed data size is fixed, and read
-       * from the file header - we therefore don't attempt
-       * to resize the output buffer (if it's too small, then
-       * that's an error condition) */
+      }
    }
 
    /* Read compressed chunk from file */
    if (filestream_read(
-         stream->file, stream->in_buf, compressed_chunk_size) !=
+         stream->file, *buf, compressed_chunk_size) !=
          compressed_chunk_size)
       return false;
 
-   /* Decompress chunk data */
-   stream->inflate_backend->set_in(
-         stream->inflate_stream,
-         stream->in_buf, compressed_chunk_size);
+   *chunk_size = compressed_chunk_size;
+   return true;
+}
 
-   stream->inflate_backend->set_out(
-         stream->inflate_stream,
-         stream->out_buf, stream->out_buf_size);
+/* Writes a compressed chunk and its header to file */
+static bool rzipstream_write_chunk_data(rzipstream_t *stream,
+      const uint8_t *buf, uint32_t chunk_size)
+{
+   uint8_t chunk_header_bytes[RZIP_CHUNK_HEADER_SIZE];
 
-   /* Note: We have to set 'flush == true' here, otherwise we
-    * can't guarantee that the entire chunk will be written
-    * to the output buffer - this is inefficient, but not
-    * much we can do... */
-   if (!stream->inflate_backend->trans(
-         stream->inflate_stream, true,
-         &inflate_read, &inflate_written, NULL))
+   /* Write compressed chunk size to file */
+   chunk_header_bytes[3] = (chunk_size >> 24) & 0xFF;
+   chunk_header_bytes[2] = (chunk_size >> 16) & 0xFF;
+   chunk_header_bytes[1] = (chunk_size >>  8) & 0xFF;
+   chunk_header_bytes[0] =  chunk_size        & 0xFF;
+
+   if (filestream_write(
+         stream->file, chunk_header_bytes, sizeof(chunk_header_bytes)) !=
+         RZIP_CHUNK_HEADER_SIZE)
       return false;
 
-   /* Error checking */
-   if (inflate_read != compressed_chunk_size)
+   /* Write compressed data to file */
+   return (filestream_write(stream->file, buf, chunk_size) == chunk_size);
+}
+
+#ifdef HAVE_THREADS
+/* Parallel Chunk Processing
+ *
+ * The calling thread performs all file access,
+ * strictly in chunk order, while a set of workers
+ * (de)compresses chunks held in a small ring of
+ * slots. On-disk layout is therefore identical to
+ * that produced by the serial code path. */
+
+enum rzip_slot_state
+{
+   RZIP_SLOT_FREE = 0,
+   RZIP_SLOT_READY,
+   RZIP_SLOT_BUSY,
+   RZIP_SLOT_DONE
+};
+
+typedef struct
+{
+   const uint8_t *in;
+   uint8_t *out;
+   uint8_t *buf;        /* Compressed data, owned by the slot */
+   uint32_t buf_size;
+   uint32_t in_size;
+   uint32_t out_size;
+   uint32_t written;
+   enum rzip_slot_state state;
+   bool ok;
+} rzip_slot_t;
+
+typedef struct
+{
+   const struct trans_stream_backend *backend;
+   slock_t *lock;
+   scond_t *cond;
+   rzip_slot_t *slots;
+   size_t num_slots;
+   size_t num_chunks;
+   size_t next;         /* Next chunk to be claimed by a worker */
+   enum rzip_codec codec;
+   bool compress;
+   bool quit;
+} rzip_pool_t;
+
+static void rzipstream_worker(void *data)
+{
+   rzip_pool_t *pool = (rzip_pool_t*)data;
+   void *trans       = pool->backend->stream_new();
+
+   if (trans && pool->compress && (pool->codec == RZIP_CODEC_ZLIB))
+      pool->backend->define(trans, "level", RZIP_COMPRESSION_LEVEL);
+
+   for (;;)
+   {
+      rzip_slot_t *slot = NULL;
+      bool ok           = false;
+
+      slock_lock(pool->lock);
+      while (!pool->quit
+            && !(   (pool->next < pool->num_chunks)
+                 && (pool->slots[pool->next % pool->num_slots].state
+                  == RZIP_SLOT_READY)))
+         scond_wait(pool->cond, pool->lock);
+
+      if (pool->quit)
+      {
+         slock_unlock(pool->lock);
+         break;
+      }
+
+      slot        = &pool->slots[pool->next++ % pool->num_slots];
+      slot->state = RZIP_SLOT_BUSY;
+      slock_unlock(pool->lock);
+
+      if (trans)
+         ok = rzipstream_trans_chunk(pool->backend, trans,
+               slot->in, slot->in_size,
+               slot->out, slot->out_size, &slot->written);
+
+      slock_lock(pool->lock);
+      slot->ok    = ok;
+      slot->state = RZIP_SLOT_DONE;
+      scond_broadcast(pool->cond);
+      slock_unlock(pool->lock);
+   }
+
+   if (trans)
+      pool->backend->stream_free(trans);
+}
+
+/* Takes the workers for 'num_chunks' chunks out of
+ * the process-wide thread budget, returns how many
+ * were reserved (0 means serial) */
+static unsigned rzipstream_reserve_threads(size_t num_chunks)
+{
+   unsigned num_threads = RZIP_MAX_THREADS;
+
+   if (num_threads > num_chunks)
+      num_threads = (unsigned)num_chunks;
+
+   num_threads = cpu_features_reserve_threads(num_threads);
+
+   /* Not worth it, stay serial */
+   if (num_threads < 2)
+   {
+      cpu_features_release_threads(num_threads);
+      return 0;
+   }
+
+   return num_threads;
+}
+
+/* Prepares slot for chunk 'idx' and hands it
+ * over to the workers */
+static bool rzipstream_parallel_fill(rzipstream_t *stream,
+      rzip_pool_t *pool, rzip_slot_t *slot,
+      const uint8_t *src, uint8_t *dst, size_t idx)
+{
+   if (pool->compress)
+   {
+      slot->in       = src + idx * stream->chunk_size;
+      slot->in_size  = stream->chunk_size;
+      slot->out      = slot->buf;
+      slot->out_size = slot->buf_size;
+   }
+   else
+   {
+      if (!rzipstream_read_chunk_data(stream,
+            &slot->buf, &slot->buf_size, &slot->in_size))
+         return false;
+      slot->in       = slot->buf;
+      slot->out      = dst + idx * stream->chunk_size;
+      slot->out_size = stream->chunk_size;
+   }
+
+   slock_lock(pool->lock);
+   slot->state = RZIP_SLOT_READY;
+   scond_broadcast(pool->cond);
+   slock_unlock(pool->lock);
+   return true;
+}
+
+/* Same as rzipstream_parallel(), on the calling
+ * thread with the stream's own buffers and
+ * (de)compression stream */
+static bool rzipstream_serial(rzipstream_t *stream,
+      const uint8_t *src, uint8_t *dst, size_t num_chunks)
+{
+   size_t i;
+
+   for (i = 0; i < num_chunks; i++)
+   {
+      uint32_t written;
+
+      if (stream->is_writing)
+      {
+         if (!rzipstream_trans_chunk(
+               stream->deflate_backend, stream->deflate_stream,
+               src + i * stream->chunk_size, stream->chunk_size,
+               stream->out_buf, stream->out_buf_size, &written))
+            return false;
+
+         if (!rzipstream_write_chunk_data(stream, stream->out_buf, written))
+            return false;
+      }
+      else
+      {
+         uint32_t compressed_chunk_size;
+
+         if (!rzipstream_read_chunk_data(stream,
+               &stream->in_buf, &stream->in_buf_size,
+               &compressed_chunk_size))
+            return false;
+
+         if (!rzipstream_trans_chunk(
+               stream->inflate_backend, stream->inflate_stream,
+               stream->in_buf, compressed_chunk_size,
+               dst + i * stream->chunk_size, stream->chunk_size, &written))
+            return false;
+
+         if (written != stream->chunk_size)
+            return false;
+      }
+   }
+
+   return true;
+}
+
+/* Compresses 'num_chunks' full chunks from 'src' and
+ * writes them to file, or reads and decompresses
+ * 'num_chunks' full chunks from file into 'dst'.
+ * 'num_threads' comes from rzipstream_reserve_threads()
+ * and is handed back to the budget before returning.
+ * If no worker can be started, the chunks are
+ * processed on the calling thread instead */
+static bool rzipstream_parallel(rzipstream_t *stream,
+      const uint8_t *src, uint8_t *dst,
+      size_t num_chunks, unsigned num_threads)
+{
+   size_t i;
+   unsigned num_workers = 0;
+   bool success         = false;
+   sthread_t **workers  = NULL;
+   rzip_pool_t pool;
+
+   pool.backend    = stream->is_writing
+      ? stream->deflate_backend
+      : stream->inflate_backend;
+   pool.lock       = slock_new();
+   pool.cond       = scond_new();
+   pool.num_slots  = num_threads * 2;
+   pool.num_chunks = num_chunks;
+   pool.next       = 0;
+   pool.codec      = stream->codec;
+   pool.compress   = stream->is_writing;
+   pool.quit       = false;
+
+   if (pool.num_slots > num_chunks)
+      pool.num_slots = num_chunks;
+
+   pool.slots      = (rzip_slot_t*)calloc(pool.num_slots, sizeof(*pool.slots));
+   workers         = (sthread_t**)calloc(num_threads, sizeof(*workers));
+
+   if (!pool.backend || !pool.lock || !pool.cond || !pool.slots || !workers)
+      goto serial;
+
+   /* Compressed output is bounded in the same way
+    * as the serial output buffer; compressed input
+    * buffers grow on demand */
+   for (i = 0; i < pool.num_slots; i++)
+   {
+      pool.slots[i].buf_size = stream->is_writing
+         ? stream->out_buf_size
+         : stream->in_buf_size;
+      if (!(pool.slots[i].buf = (uint8_t*)malloc(pool.slots[i].buf_size)))
+         goto serial;
+   }
+
+   for (num_workers = 0; num_workers < num_threads; num_workers++)
+      if (!(workers[num_workers] = sthread_create(rzipstream_worker, &pool)))
+         break;
+
+   if (num_workers == 0)
+      goto serial;
+
+   for (i = 0; i < pool.num_slots; i++)
+      if (!rzipstream_parallel_fill(stream, &pool, &pool.slots[i],
+               src, dst, i))
+         goto end;
+
+   /* Retire chunks in order, refilling each
+    * slot with the next pending chunk */
+   for (i = 0; i < num_chunks; i++)
+   {
+      rzip_slot_t *slot = &pool.slots[i % pool.num_slots];
+
+      slock_lock(pool.lock);
+      while (slot->state != RZIP_SLOT_DONE)
+         scond_wait(pool.cond, pool.lock);
+      slot->state = RZIP_SLOT_FREE;
+      slock_unlock(pool.lock);
+
+      if (!slot->ok)
+         goto end;
+
+      if (stream->is_writing)
+      {
+         if (!rzipstream_write_chunk_data(stream, slot->buf, slot->written))
+            goto end;
+      }
+      /* Every chunk other than the last one of
+       * the file must inflate to exactly chunk_size */
+      else if (slot->written != stream->chunk_size)
+         goto end;
+
+      if (i + pool.num_slots < num_chunks)
+         if (!rzipstream_parallel_fill(stream, &pool, slot,
+                  src, dst, i + pool.num_slots))
+            goto end;
+   }
+
+   success = true;
+   goto end;
+
+serial:
+   /* Nothing has been read or written yet */
+   success = rzipstream_serial(stream, src, dst, num_chunks);
+
+end:
+   if (num_workers > 0)
+   {
+      unsigned j;
+
+      slock_lock(pool.lock);
+      pool.quit = true;
+      scond_broadcast(pool.cond);
+      slock_unlock(pool.lock);
+
+      for (j = 0; j < num_workers; j++)
+         sthread_join(workers[j]);
+   }
+
+   if (pool.slots)
+   {
+      for (i = 0; i < pool.num_slots; i++)
+         free(pool.slots[i].buf);
+      free(pool.slots);
+   }
+   free(workers);
+   if (pool.cond)
+      scond_free(pool.cond);
+   if (pool.lock)
+      slock_free(pool.lock);
+
+   cpu_features_release_threads(num_threads);
+
+   return success;
+}
+#endif
+
+/* File Read */
+
+/* Reads and decompresses the next chunk of data
+ * in the RZIP file */
+static bool rzipstream_read_chunk(rzipstream_t *stream)
+{
+   uint32_t compressed_chunk_size;
+   uint32_t inflate_written;
+
+   if (!stream || !stream->inflate_backend || !stream->inflate_stream)
+      return false;
+
+   /* Note: Uncompressed data size is fixed, and read
+    * from the file header - we therefore don't attempt
+    * to resize the output buffer (if it's too small, then
+    * that's an error condition) */
+   if (!rzipstream_read_chunk_data(stream,
+         &stream->in_buf, &stream->in_buf_size, &compressed_chunk_size))
       return false;
 
-   if (   (inflate_written == 0)
-       || (inflate_written > stream->out_buf_size))
+   /* Decompress chunk data */
+   if (!rzipstream_trans_chunk(
+         stream->inflate_backend, stream->inflate_stream,
+         stream->in_buf, compressed_chunk_size,
+         stream->out_buf, stream->out_buf_size, &inflate_written))
       return false;
 
    /* Record current output buffer occupancy
@@ -545,6 +1008,35 @@ int64_t rzipstream_read(rzipstream_t *stream, void *data, int64_t len)
       if (stream->virtual_ptr >= stream->size)
          return data_read;
 
+#ifdef HAVE_THREADS
+      /* Large reads spanning several whole chunks
+       * are decompressed in parallel, straight into
+       * the caller's buffer */
+      if (     (stream->out_buf_ptr >= stream->out_buf_occupancy)
+            && (data_len >= 2 * (int64_t)stream->chunk_size))
+      {
+         uint64_t remaining   = stream->size - stream->virtual_ptr;
+         size_t num_chunks    = (size_t)(((uint64_t)data_len < remaining
+                  ? (uint64_t)data_len : remaining) / stream->chunk_size);
+         unsigned num_threads = rzipstream_reserve_threads(num_chunks);
+
+         if (num_threads)
+         {
+            int64_t read_size = (int64_t)num_chunks * stream->chunk_size;
+
+            if (!rzipstream_parallel(stream, NULL, data_ptr,
+                     num_chunks, num_threads))
+               return -1;
+
+            data_ptr            += read_size;
+            data_len            -= read_size;
+            stream->virtual_ptr += read_size;
+            data_read           += read_size;
+            continue;
+         }
+      }
+#endif
+
       /* If everything in the output buffer has already
        * been read, grab and extract the next chunk
        * from disk */
@@ -720,57 +1212,19 @@ error:
  * as the next RZIP file chunk */
 static bool rzipstream_write_chunk(rzipstream_t *stream)
 {
-   unsigned i;
-   uint8_t chunk_header_bytes[RZIP_CHUNK_HEADER_SIZE];
-   uint32_t deflate_read;
    uint32_t deflate_written;
 
    if (!stream || !stream->deflate_backend || !stream->deflate_stream)
       return false;
 
-   for (i = 0; i < RZIP_CHUNK_HEADER_SIZE; i++)
-      chunk_header_bytes[i] = 0;
-
    /* Compress data currently held in input buffer */
-   stream->deflate_backend->set_in(
-         stream->deflate_stream,
-         stream->in_buf, stream->in_buf_ptr);
-
-   stream->deflate_backend->set_out(
-         stream->deflate_stream,
-         stream->out_buf, stream->out_buf_size);
-
-   /* Note: We have to set 'flush == true' here, otherwise we
-    * can't guarantee that the entire chunk will be written
-    * to the output buffer - this is inefficient, but not
-    * much we can do... */
-   if (!stream->deflate_backend->trans(
-         stream->deflate_stream, true,
-         &deflate_read, &deflate_written, NULL))
-      return false;
-
-   /* Error checking */
-   if (deflate_read != stream->in_buf_ptr)
+   if (!rzipstream_trans_chunk(
+         stream->deflate_backend, stream->deflate_stream,
+         stream->in_buf, stream->in_buf_ptr,
+         stream->out_buf, stream->out_buf_size, &deflate_written))
       return false;
 
-   if (   (deflate_written == 0)
-       || (deflate_written > stream->out_buf_size))
-      return false;
-
-   /* Write compressed chunk size to file */
-   chunk_header_bytes[3] = (deflate_written >> 24) & 0xFF;
-   chunk_header_bytes[2] = (deflate_written >> 16) & 0xFF;
-   chunk_header_bytes[1] = (deflate_written >>  8) & 0xFF;
-   chunk_header_bytes[0] =  deflate_written        & 0xFF;
-
-   if (filestream_write(
-         stream->file, chunk_header_bytes, sizeof(chunk_header_bytes)) !=
-         RZIP_CHUNK_HEADER_SIZE)
-      return false;
-
-   /* Write compressed data to file */
-   if (filestream_write(
-         stream->file, stream->out_buf, deflate_written) != deflate_written)
+   if (!rzipstream_write_chunk_data(stream, stream->out_buf, deflate_written))
       return false;
 
    /* Reset input buffer pointer */
@@ -800,6 +1254,33 @@ int64_t rzipstream_write(rzipstream_t *stream, const void *data, int64_t len)
          if (!rzipstream_write_chunk(stream))
             return -1;
 
+#ifdef HAVE_THREADS
+      /* Large writes spanning several whole chunks
+       * are compressed in parallel, directly from
+       * the caller's buffer */
+      if (     (stream->in_buf_ptr == 0)
+            && (data_len >= 2 * (int64_t)stream->chunk_size))
+      {
+         size_t num_chunks    = (size_t)(data_len / stream->chunk_size);
+         unsigned num_threads = rzipstream_reserve_threads(num_chunks);
+
+         if (num_threads)
+         {
+            int64_t write_size = (int64_t)num_chunks * stream->chunk_size;
+
+            if (!rzipstream_parallel(stream, data_ptr, NULL,
+                     num_chunks, num_threads))
+               return -1;
+
+            data_ptr            += write_size;
+            data_len            -= write_size;
+            stream->size        += write_size;
+            stream->virtual_ptr += write_size;
+            continue;
+         }
+      }
+#endif
+
       /* Get amount of data to cache during this loop
        * > i.e. minimum of space remaining in input buffer
        *   and remaining 'write data' size */
@@ -879,9 +1360,10 @@ int rzipstream_printf(rzipstream_t *stream, const char* format, ...)
 }
 
 /* Writes contents of 'data' buffer to file
- * specified by 'path'.
+ * specified by 'path', compressed with 'codec'.
  * Returns false in the event of an error */
-bool rzipstream_write_file(const char *path, const void *data, int64_t len)
+bool rzipstream_write_file_codec(const char *path, const void *data,
+      int64_t len, enum rzip_codec codec)
 {
    int64_t bytes_written = 0;
    rzipstream_t *stream  = NULL;
@@ -890,7 +1372,8 @@ bool rzipstream_write_file(const char *path, const void *data, int64_t len)
       return false;
 
    /* Attempt to open file */
-   if (!(stream = rzipstream_open(path, RETRO_VFS_FILE_ACCESS_WRITE)))
+   if (!(stream = rzipstream_open_codec(
+         path, RETRO_VFS_FILE_ACCESS_WRITE, codec)))
       return false;
 
    /* Write contents of data buffer to file */
@@ -905,6 +1388,14 @@ bool rzipstream_write_file(const char *path, const void *data, int64_t len)
    return (bytes_written == len);
 }
 
+/* Writes contents of 'data' buffer to file
+ * specified by 'path'.
+ * Returns false in the event of an error */
+bool rzipstream_write_file(const char *path, const void *data, int64_t len)
+{
+   return rzipstream_write_file_codec(path, data, len, RZIP_CODEC_ZLIB);
+}
+
 /* File Control */
 
 /* Sets file position to the beginning of the
@@ -941,7 +1432,7 @@ void rzipstream_rewind(rzipstream_t *stream)
    if (stream->is_writing)
    {
       /* Reset file position to first chunk location */
-      filestream_seek(stream->file, RZIP_HEADER_SIZE, SEEK_SET);
+      filestream_seek(stream->file, stream->header_size, SEEK_SET);
       if (filestream_error(stream->file))
          return;
 
@@ -970,7 +1461,7 @@ void rzipstream_rewind(rzipstream_t *stream)
           * from disk... */
 
          /* Reset file position to first chunk location */
-         filestream_seek(stream->file, RZIP_HEADER_SIZE, SEEK_SET);
+         filestream_seek(stream->file, stream->header_size, SEEK_SET);
          if (filestream_error(stream->file))
             return;
 
@@ -0,0 +1,424 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (trans_stream_lz4.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Minimal LZ4 block format codec.
+ *
+ * Trades compression ratio for speed: compression is a
+ * single-probe hash search, decompression is little
+ * more than a memcpy. Output is a plain LZ4 block (no
+ * frame, no checksum), interoperable with the reference
+ * LZ4_compress_default()/LZ4_decompress_safe().
+ *
+ * This is a block codec: each call to trans() consumes
+ * all pending input as one independent block, so the
+ * output buffer must be large enough to hold the whole
+ * result - at worst, n + (n / 255) + 16 bytes. */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_inline.h>
+#include <streams/trans_stream.h>
+
+#define LZ4_MIN_MATCH     4
+/* The last match must start at least 12 bytes before
+ * the end of the block, and the last 5 bytes are
+ * always literals */
+#define LZ4_MF_LIMIT      12
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MAX_DISTANCE  65535
+#define LZ4_HASH_LOG      12
+#define LZ4_HASH_SIZE     (1 << LZ4_HASH_LOG)
+
+struct lz4_trans_stream
+{
+   const uint8_t *in;
+   uint8_t *out;
+   uint32_t in_size;
+   uint32_t out_size;
+   uint32_t table[LZ4_HASH_SIZE];
+};
+
+static INLINE uint32_t lz4_read32(const uint8_t *p)
+{
+   uint32_t v;
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+static INLINE uint32_t lz4_hash(uint32_t v)
+{
+   return (v * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+/* Writes a sequence length continuation (255 runs) */
+static INLINE uint8_t *lz4_write_length(uint8_t *op, uint32_t len)
+{
+   for (; len >= 255; len -= 255)
+      *op++ = 255;
+   *op++ = (uint8_t)len;
+   return op;
+}
+
+static void *lz4_stream_new(void)
+{
+   struct lz4_trans_stream *ret = (struct lz4_trans_stream*)
+      calloc(1, sizeof(*ret));
+   return ret;
+}
+
+static void lz4_stream_free(void *data)
+{
+   free(data);
+}
+
+static bool lz4_define(void *data, const char *prop, uint32_t val)
+{
+   /* No tunables */
+   return false;
+}
+
+static void lz4_set_in(void *data, const uint8_t *in, uint32_t in_size)
+{
+   struct lz4_trans_stream *z = (struct lz4_trans_stream*)data;
+
+   if (!z)
+      return;
+
+   z->in      = in;
+   z->in_size = in_size;
+}
+
+static void lz4_set_out(void *data, uint8_t *out, uint32_t out_size)
+{
+   struct lz4_trans_stream *z = (struct lz4_trans_stream*)data;
+
+   if (!z)
+      return;
+
+   z->out      = out;
+   z->out_size = out_size;
+}
+
+/* Returns compressed size, or 0 if 'out' is too small */
+static uint32_t lz4_compress_block(uint32_t *table,
+      const uint8_t *in, uint32_t in_size,
+      uint8_t *out, uint32_t out_size)
+{
+   const uint8_t *ip     = in;
+   const uint8_t *anchor = in;
+   const uint8_t *iend   = in + in_size;
+   uint8_t *op           = out;
+   uint8_t *oend         = out + out_size;
+
+   if (in_size > LZ4_MF_LIMIT)
+   {
+      const uint8_t *mflimit    = iend - LZ4_MF_LIMIT;
+      const uint8_t *matchlimit = iend - LZ4_LAST_LITERALS;
+
+      memset(table, 0, LZ4_HASH_SIZE * sizeof(*table));
+      ip++;
+
+      while (ip < mflimit)
+      {
+         uint32_t h              = lz4_hash(lz4_read32(ip));
+         const uint8_t *match    = in + table[h];
+         uint32_t lit_len, match_len;
+         uint8_t *token;
+
+         table[h]                = (uint32_t)(ip - in);
+
+         if (     (match >= ip)
+               || ((uint32_t)(ip - match) > LZ4_MAX_DISTANCE)
+               || (lz4_read32(match) != lz4_read32(ip)))
+         {
+            /* Skip ahead faster through incompressible data */
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+         }
+
+         /* Extend match backwards over pending literals */
+         while ((ip > anchor) && (match > in) && (ip[-1] == match[-1]))
+         {
+            ip--;
+            match--;
+         }
+
+         /* Extend match forwards */
+         {
+            const uint8_t *p = ip    + LZ4_MIN_MATCH;
+            const uint8_t *m = match + LZ4_MIN_MATCH;
+            while ((p < matchlimit) && (*p == *m))
+            {
+               p++;
+               m++;
+            }
+            match_len = (uint32_t)(p - ip) - LZ4_MIN_MATCH;
+         }
+
+         lit_len = (uint32_t)(ip - anchor);
+
+         /* token + literal length + literals + offset + match length */
+         if ((size_t)(oend - op) < 1 + (lit_len / 255) + 1
+               + lit_len + 2 + (match_len / 255) + 1)
+            return 0;
+
+         token = op++;
+         if (lit_len >= 15)
+         {
+            *token = 15 << 4;
+            op     = lz4_write_length(op, lit_len - 15);
+         }
+         else
+            *token = (uint8_t)(lit_len << 4);
+
+         memcpy(op, anchor, lit_len);
+         op     += lit_len;
+
+         *op++   = (uint8_t)((ip - match) & 0xFF);
+         *op++   = (uint8_t)((ip - match) >> 8);
+
+         if (match_len >= 15)
+         {
+            *token |= 15;
+            op      = lz4_write_length(op, match_len - 15);
+         }
+         else
+            *token |= (uint8_t)match_len;
+
+         ip     += match_len + LZ4_MIN_MATCH;
+         anchor  = ip;
+
+         /* Index the position right before the next
+          * search, improves ratio on repetitive data */
+         if (ip < mflimit)
+            table[lz4_hash(lz4_read32(ip - 2))] = (uint32_t)(ip - 2 - in);
+      }
+   }
+
+   /* Final literal run */
+   {
+      uint32_t lit_len = (uint32_t)(iend - anchor);
+
+      if ((size_t)(oend - op) < 1 + (lit_len / 255) + 1 + lit_len)
+         return 0;
+
+      if (lit_len >= 15)
+      {
+         *op++ = 15 << 4;
+         op    = lz4_write_length(op, lit_len - 15);
+      }
+      else
+         *op++ = (uint8_t)(lit_len << 4);
+
+      memcpy(op, anchor, lit_len);
+      op += lit_len;
+   }
+
+   return (uint32_t)(op - out);
+}
+
+/* Returns decompressed size, or -1 on malformed input
+ * or if 'out' is too small */
+static int64_t lz4_decompress_block(
+      const uint8_t *in, uint32_t in_size,
+      uint8_t *out, uint32_t out_size)
+{
+   const uint8_t *ip   = in;
+   const uint8_t *iend = in + in_size;
+   uint8_t *op         = out;
+   uint8_t *oend       = out + out_size;
+
+   while (ip < iend)
+   {
+      size_t len;
+      size_t offset;
+      const uint8_t *match;
+      uint8_t token = *ip++;
+
+      /* Literals */
+      len = token >> 4;
+      if (len == 15)
+      {
+         uint8_t b;
+         do
+         {
+            if (ip >= iend)
+               return -1;
+            b    = *ip++;
+            len += b;
+         } while (b == 255);
+      }
+
+      if (     ((size_t)(iend - ip) < len)
+            || ((size_t)(oend - op) < len))
+         return -1;
+
+      memcpy(op, ip, len);
+      ip += len;
+      op += len;
+
+      /* The last sequence has no match part */
+      if (ip >= iend)
+         break;
+
+      /* Match */
+      if ((size_t)(iend - ip) < 2)
+         return -1;
+
+      offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+      ip    += 2;
+
+      if ((offset == 0) || (offset > (size_t)(op - out)))
+         return -1;
+
+      len    = token & 15;
+      if (len == 15)
+      {
+         uint8_t b;
+         do
+         {
+            if (ip >= iend)
+               return -1;
+            b    = *ip++;
+            len += b;
+         } while (b == 255);
+      }
+      len   += LZ4_MIN_MATCH;
+
+      if ((size_t)(oend - op) < len)
+         return -1;
+
+      match  = op - offset;
+
+      /* Overlapping copies repeat the pattern,
+       * so they must be done byte by byte */
+      if (offset >= len)
+      {
+         memcpy(op, match, len);
+         op += len;
+      }
+      else
+         while (len--)
+            *op++ = *match++;
+   }
+
+   return (int64_t)(op - out);
+}
+
+static bool lz4_compress_trans(
+   void *data, bool flush,
+   uint32_t *rd, uint32_t *wn,
+   enum trans_stream_error *error)
+{
+   uint32_t written;
+   struct lz4_trans_stream *z = (struct lz4_trans_stream*)data;
+
+   *rd = 0;
+   *wn = 0;
+
+   if (!z || (!z->in && z->in_size))
+   {
+      if (error)
+         *error = TRANS_STREAM_ERROR_INVALID;
+      return false;
+   }
+
+   if (!(written = lz4_compress_block(z->table,
+         z->in, z->in_size, z->out, z->out_size)))
+   {
+      if (error)
+         *error = TRANS_STREAM_ERROR_BUFFER_FULL;
+      return false;
+   }
+
+   *rd          = z->in_size;
+   *wn          = written;
+   z->in       += z->in_size;
+   z->in_size   = 0;
+   z->out      += written;
+   z->out_size -= written;
+
+   if (error)
+      *error = TRANS_STREAM_ERROR_NONE;
+   return true;
+}
+
+static bool lz4_decompress_trans(
+   void *data, bool flush,
+   uint32_t *rd, uint32_t *wn,
+   enum trans_stream_error *error)
+{
+   int64_t written;
+   struct lz4_trans_stream *z = (struct lz4_trans_stream*)data;
+
+   *rd = 0;
+   *wn = 0;
+
+   if (!z || !z->in || !z->out)
+   {
+      if (error)
+         *error = TRANS_STREAM_ERROR_INVALID;
+      return false;
+   }
+
+   if ((written = lz4_decompress_block(
+         z->in, z->in_size, z->out, z->out_size)) < 0)
+   {
+      if (error)
+         *error = TRANS_STREAM_ERROR_OTHER;
+      return false;
+   }
+
+   *rd          = z->in_size;
+   *wn          = (uint32_t)written;
+   z->in       += z->in_size;
+   z->in_size   = 0;
+   z->out      += written;
+   z->out_size -= (uint32_t)written;
+
+   if (error)
+      *error = TRANS_STREAM_ERROR_NONE;
+   return true;
+}
+
+const struct trans_stream_backend lz4_compress_backend = {
+   "lz4_compress",
+   &lz4_decompress_backend,
+   lz4_stream_new,
+   lz4_stream_free,
+   lz4_define,
+   lz4_set_in,
+   lz4_set_out,
+   lz4_compress_trans
+};
+
+const struct trans_stream_backend lz4_decompress_backend = {
+   "lz4_decompress",
+   &lz4_compress_backend,
+   lz4_stream_new,
+   lz4_stream_free,
+   lz4_define,
+   lz4_set_in,
+   lz4_set_out,
+   lz4_decompress_trans
+};
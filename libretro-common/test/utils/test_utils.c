@@ -71,6 +71,81 @@ START_TEST (test_crc32)
 }
 END_TEST
 
+/* Bit at a time reference implementation */
+static uint32_t crc32_reference(uint32_t crc, const uint8_t *buf, size_t len)
+{
+   crc = ~crc;
+   while (len--)
+   {
+      int i;
+      crc ^= *buf++;
+      for (i = 0; i < 8; i++)
+         crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+   }
+   return ~crc;
+}
+
+START_TEST (test_crc32_lengths)
+{
+   size_t i, offset, len;
+   uint8_t *buf = (uint8_t*)malloc(4096 + 16);
+   ck_assert(buf != NULL);
+   for (i = 0; i < 4096 + 16; i++)
+      buf[i] = (uint8_t)((i * 2654435761u) >> 13);
+
+   ck_assert_uint_eq(encoding_crc32(0, (const uint8_t*)"123456789", 9),
+         0xcbf43926);
+   ck_assert_uint_eq(encoding_crc32(0, buf, 0), 0);
+   ck_assert_uint_eq(encoding_crc32(0x12345678, buf, 0), 0x12345678);
+
+   /* Every length around the slice and fold boundaries,
+    * at every alignment */
+   for (offset = 0; offset < 16; offset++)
+      for (len = 0; len <= 300; len++)
+         ck_assert_uint_eq(encoding_crc32(0, buf + offset, len),
+               crc32_reference(0, buf + offset, len));
+
+   ck_assert_uint_eq(encoding_crc32(0, buf + 3, 4096 + 13),
+         crc32_reference(0, buf + 3, 4096 + 13));
+   /* Continuing from a previous CRC */
+   ck_assert_uint_eq(encoding_crc32(encoding_crc32(0, buf, 1000),
+            buf + 1000, 3000),
+         crc32_reference(0, buf, 4000));
+   free(buf);
+}
+END_TEST
+
+START_TEST (test_crc32_combine)
+{
+   size_t i, split;
+   uint32_t full;
+   uint8_t *buf = (uint8_t*)malloc(4096);
+   ck_assert(buf != NULL);
+   for (i = 0; i < 4096; i++)
+      buf[i] = (uint8_t)(i ^ (i >> 7));
+   full = encoding_crc32(0, buf, 4096);
+
+   for (split = 0; split <= 4096; split += 97)
+   {
+      uint32_t crc1 = encoding_crc32(0, buf, split);
+      uint32_t crc2 = encoding_crc32(0, buf + split, 4096 - split);
+      ck_assert_uint_eq(encoding_crc32_combine(crc1, crc2, 4096 - split),
+            full);
+   }
+
+   /* Empty second half */
+   ck_assert_uint_eq(encoding_crc32_combine(full, 0, 0), full);
+   /* Chunks hashed independently */
+   ck_assert_uint_eq(encoding_crc32_combine(
+            encoding_crc32_combine(
+               encoding_crc32(0, buf, 1024),
+               encoding_crc32(0, buf + 1024, 1024), 1024),
+            encoding_crc32(0, buf + 2048, 2048), 2048),
+         full);
+   free(buf);
+}
+END_TEST
+
 #define CRC32_BUFFER_SIZE 1048576
 #define CRC32_MAX_MB 64
 
@@ -141,6 +216,8 @@ Suite *create_suite(void)
    TCase *tc_core = tcase_create("Core");
    tcase_add_test(tc_core, test_md5);
    tcase_add_test(tc_core, test_crc32);
+   tcase_add_test(tc_core, test_crc32_lengths);
+   tcase_add_test(tc_core, test_crc32_combine);
    tcase_add_test(tc_core, test_crc32_file);
    suite_add_tcase(s, tc_core);
 
@@ -967,6 +967,60 @@ int retro_vfs_stat_impl(const char *path, int32_t *size)
    return ret;
 }
 
+/* The libretro VFS interface has no way of reporting
+ * modification times, so this is only available to
+ * frontend code. Returns 0 if the time is unknown. */
+int64_t retro_vfs_mtime_impl(const char *path)
+{
+   if (!path || !*path)
+      return 0;
+   {
+#if defined(VITA)
+      /* SceIoStat only has a broken down SceDateTime */
+      return 0;
+#elif defined(__PSL1GHT__) || defined(__PS3__)
+      sysFSStat stat_buf;
+
+      if (sysFsStat(path, &stat_buf) < 0)
+         return 0;
+
+      return (int64_t)stat_buf.st_mtime;
+#elif defined(_WIN32)
+      struct _stat stat_buf;
+#if defined(LEGACY_WIN32)
+      int ret                   = -1;
+      char *path_local          = utf8_to_local_string_alloc(path);
+
+      if (!string_is_empty(path_local))
+         ret                    = _stat(path_local, &stat_buf);
+
+      if (path_local)
+         free(path_local);
+#else
+      int ret                   = -1;
+      wchar_t *path_wide        = utf8_to_utf16_string_alloc(path);
+
+      if (path_wide)
+      {
+         ret                    = _wstat(path_wide, &stat_buf);
+         free(path_wide);
+      }
+#endif
+      if (ret != 0)
+         return 0;
+
+      return (int64_t)stat_buf.st_mtime;
+#else
+      struct stat stat_buf;
+
+      if (stat(path, &stat_buf) < 0)
+         return 0;
+
+      return (int64_t)stat_buf.st_mtime;
+#endif
+   }
+}
+
 #if defined(VITA)
 #define path_mkdir_error(ret) (((ret) == SCE_ERROR_ERRNO_EEXIST))
 #elif defined(PSP) || defined(PS2) || defined(_3DS) || defined(WIIU) || defined(SWITCH)
@@ -30,8 +30,12 @@
 #include <sys/stat.h>
 #include <stdlib.h>
 
+#include <file/file_path.h>
 #include <streams/file_stream.h>
+#include <vfs/vfs_implementation.h>
 #include <retro_endianness.h>
+#include <retro_miscellaneous.h>
+#include <memmap.h>
 #include <string/stdstring.h>
 #include <compat/strl.h>
 
@@ -44,20 +48,69 @@
 
 #define MAGIC_NUMBER "RARCHDB"
 
+/* Sidecar lookup table, stored next to the database as
+ * '<name>.rdb.idx'. It is rebuilt whenever the stamp no
+ * longer matches the database it was generated from. */
+#define LOOKUP_MAGIC_NUMBER "RDBLUT1"
+#define LOOKUP_FILE_EXT     ".idx"
+#define LOOKUP_BYTE_ORDER   0x01020304
+#define LOOKUP_VERSION      2
+
+/* Mapping the table is only a fast path, any platform
+ * can fall back to reading it into memory */
+#if defined(HAVE_MMAN) && !defined(_WIN32)
+#define HAVE_LOOKUP_MMAP
+#endif
+
 struct node_iter_ctx
 {
    libretrodb_t *db;
    libretrodb_index_t *idx;
 };
 
+typedef struct libretrodb_lookup_header
+{
+   char magic_number[sizeof(LOOKUP_MAGIC_NUMBER)];
+   uint32_t byte_order;
+   uint32_t version;
+   /* Validity stamp of the source database */
+   uint64_t rdb_size;
+   uint64_t rdb_mtime;
+   uint64_t rdb_count;
+   uint64_t rdb_metadata_offset;
+   /* Entry counts of the two sorted tables that follow */
+   uint64_t crc_count;
+   uint64_t serial_count;
+} libretrodb_lookup_header_t;
+
+typedef struct libretrodb_lookup_entry
+{
+   uint32_t key;
+   uint32_t pad;
+   uint64_t offset;
+} libretrodb_lookup_entry_t;
+
+typedef struct libretrodb_lookup
+{
+   void *data;
+   const libretrodb_lookup_entry_t *crc;
+   const libretrodb_lookup_entry_t *serial;
+   size_t size;
+   uint64_t crc_count;
+   uint64_t serial_count;
+   bool mapped;
+} libretrodb_lookup_t;
+
 struct libretrodb
 {
    RFILE *fd;
    char *path;
+   libretrodb_lookup_t *lookup;
    bool can_write;
    uint64_t root;
    uint64_t count;
    uint64_t first_index_offset;
+   uint64_t metadata_offset;
 };
 
 struct libretrodb_index
@@ -171,8 +224,26 @@ clean:
    return rv;
 }
 
+static void libretrodb_lookup_free(libretrodb_lookup_t *lookup)
+{
+   if (!lookup)
+      return;
+   if (lookup->data)
+   {
+#ifdef HAVE_LOOKUP_MMAP
+      if (lookup->mapped)
+         munmap(lookup->data, lookup->size);
+      else
+#endif
+         free(lookup->data);
+   }
+   free(lookup);
+}
+
 void libretrodb_close(libretrodb_t *db)
 {
+   libretrodb_lookup_free(db->lookup);
+   db->lookup = NULL;
    if (db->fd)
       filestream_close(db->fd);
    if (!string_is_empty(db->path))
@@ -194,8 +265,10 @@ int libretrodb_open(const char *path, libretrodb_t *db, bool write)
 
    if (!string_is_empty(db->path))
       free(db->path);
+   libretrodb_lookup_free(db->lookup);
 
-   db->path  = strdup(path);
+   db->lookup = NULL;
+   db->path   = strdup(path);
    db->root  = filestream_tell(fd);
 
    if ((int)filestream_read(fd, &header, sizeof(header)) == -1)
@@ -212,6 +285,7 @@ int libretrodb_open(const char *path, libretrodb_t *db, bool write)
       goto error;
 
    db->count              = md.count;
+   db->metadata_offset    = header.metadata_offset;
    db->first_index_offset = filestream_tell(fd);
    db->fd                 = fd;
    return 0;
@@ -319,6 +393,425 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
    return -1;
 }
 
+static uint32_t libretrodb_lookup_hash(const char *s, size_t len)
+{
+   size_t i;
+   uint32_t hash = 5381;
+   for (i = 0; i < len; i++)
+      hash = ((hash << 5) + hash) + (uint8_t)s[i];
+   return hash;
+}
+
+static int libretrodb_lookup_entry_compare(const void *a, const void *b)
+{
+   const libretrodb_lookup_entry_t *l = (const libretrodb_lookup_entry_t*)a;
+   const libretrodb_lookup_entry_t *r = (const libretrodb_lookup_entry_t*)b;
+   if (l->key != r->key)
+      return (l->key < r->key) ? -1 : 1;
+   /* Keep database order for duplicate keys, so the
+    * first match is the same one a cursor would find */
+   if (l->offset != r->offset)
+      return (l->offset < r->offset) ? -1 : 1;
+   return 0;
+}
+
+/* A rebuilt database can keep its size and entry count,
+ * so the stamp also carries its modification time */
+static uint64_t libretrodb_lookup_mtime(libretrodb_t *db)
+{
+   return (uint64_t)path_get_mtime(db->path);
+}
+
+static bool libretrodb_lookup_set(libretrodb_t *db,
+      libretrodb_lookup_t *lookup, void *data, size_t size)
+{
+   const libretrodb_lookup_header_t *header =
+      (const libretrodb_lookup_header_t*)data;
+   const uint8_t *entries = (const uint8_t*)data + sizeof(*header);
+
+   if (size < sizeof(*header))
+      return false;
+   if (memcmp(header->magic_number, LOOKUP_MAGIC_NUMBER,
+            sizeof(LOOKUP_MAGIC_NUMBER)) != 0)
+      return false;
+   if (     header->byte_order          != LOOKUP_BYTE_ORDER
+         || header->version             != LOOKUP_VERSION
+         || header->rdb_size            != (uint64_t)filestream_get_size(db->fd)
+         || header->rdb_mtime           != libretrodb_lookup_mtime(db)
+         || header->rdb_count           != db->count
+         || header->rdb_metadata_offset != db->metadata_offset)
+      return false;
+   if (size != sizeof(*header) + (header->crc_count + header->serial_count)
+         * sizeof(libretrodb_lookup_entry_t))
+      return false;
+
+   lookup->data         = data;
+   lookup->size         = size;
+   lookup->crc_count    = header->crc_count;
+   lookup->serial_count = header->serial_count;
+   lookup->crc          = (const libretrodb_lookup_entry_t*)entries;
+   lookup->serial       = lookup->crc + header->crc_count;
+   return true;
+}
+
+#ifdef HAVE_LOOKUP_MMAP
+static void *libretrodb_lookup_map(const char *path, int64_t *len)
+{
+   void *data                               = NULL;
+   libretro_vfs_implementation_file *handle = NULL;
+   RFILE *file                              = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_READ,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return NULL;
+
+   *len   = filestream_get_size(file);
+   handle = filestream_get_vfs_handle(file);
+
+   /* Only plain files have a descriptor to map */
+   if (     *len >= (int64_t)sizeof(libretrodb_lookup_header_t)
+         && (uint64_t)*len <= (uint64_t)((size_t)-1)
+         && handle
+         && handle->scheme == VFS_SCHEME_NONE
+         && handle->fp)
+   {
+      data = mmap(NULL, (size_t)*len, PROT_READ, MAP_PRIVATE,
+            fileno(handle->fp), 0);
+      if (data == MAP_FAILED)
+         data = NULL;
+   }
+
+   /* The mapping keeps its own reference to the file */
+   filestream_close(file);
+   return data;
+}
+#endif
+
+static bool libretrodb_lookup_load(libretrodb_t *db,
+      libretrodb_lookup_t *lookup, const char *path)
+{
+   void *data     = NULL;
+   int64_t len    = 0;
+
+   lookup->mapped = false;
+
+#ifdef HAVE_LOOKUP_MMAP
+   if ((data = libretrodb_lookup_map(path, &len)))
+      lookup->mapped = true;
+#endif
+
+   if (!data && !filestream_read_file(path, &data, &len))
+      return false;
+
+   if (libretrodb_lookup_set(db, lookup, data, (size_t)len))
+      return true;
+
+#ifdef HAVE_LOOKUP_MMAP
+   if (lookup->mapped)
+      munmap(data, (size_t)len);
+   else
+#endif
+      free(data);
+   lookup->mapped = false;
+   return false;
+}
+
+static bool libretrodb_lookup_append(libretrodb_lookup_entry_t **entries,
+      uint64_t *count, uint64_t *cap, uint32_t key, uint64_t offset)
+{
+   if (*count == *cap)
+   {
+      uint64_t new_cap                   = *cap ? *cap * 2 : 1024;
+      libretrodb_lookup_entry_t *new_ptr = (libretrodb_lookup_entry_t*)
+         realloc(*entries, (size_t)new_cap * sizeof(**entries));
+      if (!new_ptr)
+         return false;
+      *entries = new_ptr;
+      *cap     = new_cap;
+   }
+   (*entries)[*count].key    = key;
+   (*entries)[*count].pad    = 0;
+   (*entries)[*count].offset = offset;
+   (*count)++;
+   return true;
+}
+
+/* Walks the whole database once and writes the sorted
+ * crc/serial tables. If the sidecar cannot be written
+ * (read-only media), the table is kept in memory only. */
+static bool libretrodb_lookup_build(libretrodb_t *db,
+      libretrodb_lookup_t *lookup, const char *path)
+{
+   char tmp_path[PATH_MAX_LENGTH];
+   struct rmsgpack_dom_value item;
+   struct rmsgpack_dom_value crc_key;
+   struct rmsgpack_dom_value serial_key;
+   libretrodb_lookup_header_t header;
+   libretrodb_cursor_t cur               = {0};
+   libretrodb_lookup_entry_t *crcs       = NULL;
+   libretrodb_lookup_entry_t *serials    = NULL;
+   uint64_t crc_count                    = 0;
+   uint64_t crc_cap                      = 0;
+   uint64_t serial_count                 = 0;
+   uint64_t serial_cap                   = 0;
+   uint8_t *data                         = NULL;
+   size_t size                           = 0;
+   uint64_t item_loc                     = 0;
+   bool ret                              = false;
+
+   if (libretrodb_cursor_open(db, &cur, NULL) != 0)
+      return false;
+
+   crc_key.type                = RDT_STRING;
+   crc_key.val.string.len      = STRLEN_CONST("crc");
+   crc_key.val.string.buff     = (char*)"crc";
+   serial_key.type             = RDT_STRING;
+   serial_key.val.string.len   = STRLEN_CONST("serial");
+   serial_key.val.string.buff  = (char*)"serial";
+   item.type                   = RDT_NULL;
+   item_loc                    = filestream_tell(cur.fd);
+
+   while (libretrodb_cursor_read_item(&cur, &item) == 0)
+   {
+      struct rmsgpack_dom_value *field = NULL;
+
+      if (item.type == RDT_MAP)
+      {
+         if (     (field = rmsgpack_dom_value_map_value(&item, &crc_key))
+               && field->type == RDT_BINARY
+               && field->val.binary.len == sizeof(uint32_t))
+         {
+            uint32_t crc;
+            memcpy(&crc, field->val.binary.buff, sizeof(crc));
+            if (!libretrodb_lookup_append(&crcs, &crc_count, &crc_cap,
+                     swap_if_little32(crc), item_loc))
+               goto end;
+         }
+
+         if (     (field = rmsgpack_dom_value_map_value(&item, &serial_key))
+               && (field->type == RDT_BINARY || field->type == RDT_STRING)
+               && field->val.binary.len > 0)
+         {
+            if (!libretrodb_lookup_append(&serials, &serial_count,
+                     &serial_cap, libretrodb_lookup_hash(
+                        field->val.binary.buff, field->val.binary.len),
+                     item_loc))
+               goto end;
+         }
+      }
+
+      rmsgpack_dom_value_free(&item);
+      item.type = RDT_NULL;
+      item_loc  = filestream_tell(cur.fd);
+   }
+
+   if (crcs)
+      qsort(crcs, (size_t)crc_count, sizeof(*crcs),
+            libretrodb_lookup_entry_compare);
+   if (serials)
+      qsort(serials, (size_t)serial_count, sizeof(*serials),
+            libretrodb_lookup_entry_compare);
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic_number, LOOKUP_MAGIC_NUMBER,
+         sizeof(LOOKUP_MAGIC_NUMBER));
+   header.byte_order          = LOOKUP_BYTE_ORDER;
+   header.version             = LOOKUP_VERSION;
+   header.rdb_size            = (uint64_t)filestream_get_size(db->fd);
+   header.rdb_mtime           = libretrodb_lookup_mtime(db);
+   header.rdb_count           = db->count;
+   header.rdb_metadata_offset = db->metadata_offset;
+   header.crc_count           = crc_count;
+   header.serial_count        = serial_count;
+
+   size = sizeof(header)
+      + (size_t)(crc_count + serial_count) * sizeof(libretrodb_lookup_entry_t);
+
+   if (!(data = (uint8_t*)malloc(size)))
+      goto end;
+
+   memcpy(data, &header, sizeof(header));
+   if (crc_count)
+      memcpy(data + sizeof(header), crcs,
+            (size_t)crc_count * sizeof(*crcs));
+   if (serial_count)
+      memcpy(data + sizeof(header) + crc_count * sizeof(*crcs), serials,
+            (size_t)serial_count * sizeof(*serials));
+
+   /* Write to a temporary file first so that concurrent
+    * readers never observe a partially written table */
+   strlcpy(tmp_path, path, sizeof(tmp_path));
+   strlcat(tmp_path, ".tmp", sizeof(tmp_path));
+   if (filestream_write_file(tmp_path, data, (int64_t)size))
+   {
+      filestream_delete(path);
+      if (filestream_rename(tmp_path, path) != 0)
+         filestream_delete(tmp_path);
+   }
+
+   lookup->mapped = false;
+   if ((ret = libretrodb_lookup_set(db, lookup, data, size)))
+      data = NULL;
+
+end:
+   rmsgpack_dom_value_free(&item);
+   libretrodb_cursor_close(&cur);
+   free(crcs);
+   free(serials);
+   free(data);
+   return ret;
+}
+
+static libretrodb_lookup_t *libretrodb_lookup_get(libretrodb_t *db)
+{
+   char path[PATH_MAX_LENGTH];
+   libretrodb_lookup_t *lookup = NULL;
+
+   if (db->lookup)
+      return db->lookup;
+   if (!db->fd || string_is_empty(db->path))
+      return NULL;
+   if (!(lookup = (libretrodb_lookup_t*)calloc(1, sizeof(*lookup))))
+      return NULL;
+
+   strlcpy(path, db->path, sizeof(path));
+   strlcat(path, LOOKUP_FILE_EXT, sizeof(path));
+
+   if (     !libretrodb_lookup_load(db, lookup, path)
+         && !libretrodb_lookup_build(db, lookup, path))
+   {
+      free(lookup);
+      return NULL;
+   }
+
+   db->lookup = lookup;
+   return lookup;
+}
+
+/* Returns the position of the first entry with @key,
+ * or @count if there is none */
+static uint64_t libretrodb_lookup_lower_bound(
+      const libretrodb_lookup_entry_t *entries, uint64_t count, uint32_t key)
+{
+   uint64_t lo = 0;
+   uint64_t hi = count;
+
+   while (lo < hi)
+   {
+      uint64_t mid = lo + ((hi - lo) >> 1);
+      if (entries[mid].key < key)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   if (lo < count && entries[lo].key == key)
+      return lo;
+   return count;
+}
+
+static int libretrodb_read_at(libretrodb_t *db, uint64_t offset,
+      struct rmsgpack_dom_value *out)
+{
+   if (filestream_seek(db->fd, (int64_t)offset,
+            RETRO_VFS_SEEK_POSITION_START) < 0)
+      return -1;
+   if (rmsgpack_dom_read(db->fd, out) < 0)
+      return -1;
+   if (out->type != RDT_MAP)
+   {
+      rmsgpack_dom_value_free(out);
+      return -1;
+   }
+   return 0;
+}
+
+/**
+ * libretrodb_find_by_crc:
+ * @db                  : Handle to database.
+ * @crc                 : CRC32 of the content.
+ * @nth                 : Which match to return if several
+ *                        entries share @crc, starting at 0.
+ * @out                 : Matching entry, owned by the caller.
+ *
+ * Looks up an entry through the sidecar lookup table,
+ * building it first if it is missing or stale.
+ *
+ * Returns: 0 if found, otherwise negative.
+ **/
+int libretrodb_find_by_crc(libretrodb_t *db, uint32_t crc, size_t nth,
+      struct rmsgpack_dom_value *out)
+{
+   uint64_t pos;
+   libretrodb_lookup_t *lookup = libretrodb_lookup_get(db);
+
+   if (!lookup)
+      return -1;
+
+   pos = libretrodb_lookup_lower_bound(lookup->crc, lookup->crc_count, crc);
+   if (pos + nth >= lookup->crc_count || lookup->crc[pos + nth].key != crc)
+      return -1;
+
+   return libretrodb_read_at(db, lookup->crc[pos + nth].offset, out);
+}
+
+/**
+ * libretrodb_find_by_serial:
+ * @db                  : Handle to database.
+ * @serial              : Serial of the content.
+ * @nth                 : Which match to return if several
+ *                        entries share @serial, starting at 0.
+ * @out                 : Matching entry, owned by the caller.
+ *
+ * Same as libretrodb_find_by_crc(), keyed on serial.
+ *
+ * Returns: 0 if found, otherwise negative.
+ **/
+int libretrodb_find_by_serial(libretrodb_t *db, const char *serial,
+      size_t nth, struct rmsgpack_dom_value *out)
+{
+   uint32_t hash;
+   uint64_t pos;
+   struct rmsgpack_dom_value key;
+   size_t len                  = 0;
+   libretrodb_lookup_t *lookup = NULL;
+
+   if (string_is_empty(serial) || !(lookup = libretrodb_lookup_get(db)))
+      return -1;
+
+   len                    = strlen(serial);
+   hash                   = libretrodb_lookup_hash(serial, len);
+   key.type               = RDT_STRING;
+   key.val.string.len     = STRLEN_CONST("serial");
+   key.val.string.buff    = (char*)"serial";
+
+   /* Hashes may collide, so compare the actual serial */
+   for (pos = libretrodb_lookup_lower_bound(lookup->serial,
+            lookup->serial_count, hash);
+         pos < lookup->serial_count && lookup->serial[pos].key == hash;
+         pos++)
+   {
+      struct rmsgpack_dom_value *field = NULL;
+
+      if (libretrodb_read_at(db, lookup->serial[pos].offset, out) != 0)
+         continue;
+
+      if (     (field = rmsgpack_dom_value_map_value(out, &key))
+            && (field->type == RDT_BINARY || field->type == RDT_STRING)
+            && field->val.binary.len == len
+            && memcmp(field->val.binary.buff, serial, len) == 0)
+      {
+         if (nth-- == 0)
+            return 0;
+      }
+
+      rmsgpack_dom_value_free(out);
+   }
+
+   return -1;
+}
+
 /**
  * libretrodb_cursor_reset:
  * @cursor              : Handle to database cursor.
@@ -588,7 +1081,9 @@ libretrodb_t *libretrodb_new(void)
    db->root               = 0;
    db->count              = 0;
    db->first_index_offset = 0;
+   db->metadata_offset    = 0;
    db->path               = NULL;
+   db->lookup             = NULL;
 
    return db;
 }
@@ -57,6 +57,38 @@ int libretrodb_create_index(libretrodb_t *db, const char *name,
 int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
         const void *key, struct rmsgpack_dom_value *out);
 
+/**
+ * libretrodb_find_by_crc:
+ * @db                  : Handle to database.
+ * @crc                 : CRC32 of the content.
+ * @nth                 : Which match to return if several
+ *                        entries share @crc, starting at 0.
+ * @out                 : Matching entry, owned by the caller.
+ *
+ * Looks up an entry in O(log n) through a sorted lookup
+ * table kept next to the database ('<path>.idx'). The
+ * table is built on first use and whenever it is stale.
+ *
+ * Returns: 0 if found, otherwise negative.
+ **/
+int libretrodb_find_by_crc(libretrodb_t *db, uint32_t crc, size_t nth,
+      struct rmsgpack_dom_value *out);
+
+/**
+ * libretrodb_find_by_serial:
+ * @db                  : Handle to database.
+ * @serial              : Serial of the content.
+ * @nth                 : Which match to return if several
+ *                        entries share @serial, starting at 0.
+ * @out                 : Matching entry, owned by the caller.
+ *
+ * Same as libretrodb_find_by_crc(), keyed on serial.
+ *
+ * Returns: 0 if found, otherwise negative.
+ **/
+int libretrodb_find_by_serial(libretrodb_t *db, const char *serial,
+      size_t nth, struct rmsgpack_dom_value *out);
+
 libretrodb_t *libretrodb_new(void);
 
 void libretrodb_free(libretrodb_t *db);
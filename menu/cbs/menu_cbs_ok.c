@@ -2715,6 +2715,8 @@ static int action_ok_playlist_entry_collection(const char *path,
    playlist_config.capacity               = COLLECTION_SIZE;
    playlist_config.old_format             = settings->bools.playlist_use_old_format;
    playlist_config.compress               = settings->bools.playlist_compression;
+   playlist_config.journal                = settings->bools.playlist_journal;
+   playlist_config.cache                  = settings->bools.playlist_cache;
    playlist_config.fuzzy_archive_match    = settings->bools.playlist_fuzzy_archive_match;
    playlist_config_set_base_content_directory(&playlist_config, settings->bools.playlist_portable_paths ? settings->paths.directory_menu_content : NULL);
 
@@ -8252,6 +8254,8 @@ static int action_ok_manual_content_scan_start(const char *path,
    playlist_config.capacity            = COLLECTION_SIZE;
    playlist_config.old_format          = settings->bools.playlist_use_old_format;
    playlist_config.compress            = settings->bools.playlist_compression;
+   playlist_config.journal             = settings->bools.playlist_journal;
+   playlist_config.cache               = settings->bools.playlist_cache;
    playlist_config.fuzzy_archive_match = settings->bools.playlist_fuzzy_archive_match;
    playlist_config_set_base_content_directory(&playlist_config,
          settings->bools.playlist_portable_paths ?
@@ -8655,6 +8659,8 @@ static int action_ok_pl_content_thumbnails(const char *path,
          playlist_config.capacity            = COLLECTION_SIZE;
          playlist_config.old_format          = settings->bools.playlist_use_old_format;
          playlist_config.compress            = settings->bools.playlist_compression;
+         playlist_config.journal             = settings->bools.playlist_journal;
+         playlist_config.cache               = settings->bools.playlist_cache;
          playlist_config.fuzzy_archive_match = settings->bools.playlist_fuzzy_archive_match;
 
          fill_pathname_join_special(
@@ -8821,6 +8827,8 @@ static int action_ok_playlist_refresh(const char *path,
       playlist_config->capacity            = COLLECTION_SIZE;
       playlist_config->old_format          = settings->bools.playlist_use_old_format;
       playlist_config->compress            = settings->bools.playlist_compression;
+      playlist_config->journal             = settings->bools.playlist_journal;
+      playlist_config->cache               = settings->bools.playlist_cache;
       playlist_config->fuzzy_archive_match = settings->bools.playlist_fuzzy_archive_match;
       playlist_config_set_base_content_directory(playlist_config,
             settings->bools.playlist_portable_paths ?
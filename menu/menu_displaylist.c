@@ -2690,6 +2690,8 @@ static int menu_displaylist_parse_database_entry(menu_handle_t *menu,
    playlist_config.capacity            = COLLECTION_SIZE;
    playlist_config.old_format          = playlist_use_old_format;
    playlist_config.compress            = playlist_compression;
+   playlist_config.journal             = false;
+   playlist_config.cache               = false;
    playlist_config.fuzzy_archive_match = playlist_fuzzy_archive_match;
 
    playlist_config_set_base_content_directory(&playlist_config,
@@ -3473,6 +3475,8 @@ static void menu_displaylist_set_new_playlist(
    playlist_config.capacity            = COLLECTION_SIZE;
    playlist_config.old_format          = settings->bools.playlist_use_old_format;
    playlist_config.compress            = settings->bools.playlist_compression;
+   playlist_config.journal             = settings->bools.playlist_journal;
+   playlist_config.cache               = settings->bools.playlist_cache;
    playlist_config.fuzzy_archive_match = settings->bools.playlist_fuzzy_archive_match;
    playlist_config_set_base_content_directory(&playlist_config,
            settings->bools.playlist_portable_paths
@@ -602,7 +602,7 @@ typedef struct
 
 #if defined(HAVE_LIBRETRODB)
 explore_state_t *menu_explore_build_list(const char *directory_playlist,
-      const char *directory_database);
+      const char *directory_database, bool playlist_cache);
 uintptr_t menu_explore_get_entry_icon(unsigned type);
 ssize_t menu_explore_get_entry_playlist_index(unsigned type,
       playlist_t **playlist, const struct playlist_entry **entry,
@@ -448,7 +448,7 @@ static void explore_load_icons(explore_state_t *state)
 }
 
 explore_state_t *menu_explore_build_list(const char *directory_playlist,
-      const char *directory_database)
+      const char *directory_database, bool playlist_cache)
 {
    unsigned i;
    char tmp[PATH_MAX_LENGTH];
@@ -494,6 +494,8 @@ explore_state_t *menu_explore_build_list(const char *directory_playlist,
       playlist_config.capacity                  = 0;
       playlist_config.old_format                = false;
       playlist_config.compress                  = false;
+      playlist_config.journal                   = false;
+      playlist_config.cache                     = playlist_cache;
       playlist_config.fuzzy_archive_match       = false;
       playlist_config.autofix_paths             = false;
 
@@ -1330,7 +1332,8 @@ unsigned menu_displaylist_explore(file_list_t *list, settings_t *settings)
       if (!menu_explore_init_in_progress(NULL))
          task_push_menu_explore_init(
                settings->paths.directory_playlist,
-               settings->paths.path_content_database);
+               settings->paths.path_content_database,
+               settings->bools.playlist_cache);
 
       menu_entries_append(list,
             msg_hash_to_str(MENU_ENUM_LABEL_VALUE_EXPLORE_INITIALISING_LIST),
@@ -480,6 +480,7 @@ enum msg_hash_enums
    MSG_FAILED_TO_START_MOVIE_RECORD,
    MSG_STATE_SLOT,
    MSG_REPLAY_SLOT,
+   MSG_REPLAY_SEEKING,
    MSG_STARTING_MOVIE_RECORD_TO,
    MSG_FAILED_TO_APPLY_SHADER,
    MSG_FAILED_TO_APPLY_SHADER_PRESET,
@@ -4097,6 +4098,8 @@ enum msg_hash_enums
    MSG_CHEAT_INIT_FAIL,
    MSG_CHEAT_SEARCH_NOT_INITIALIZED,
    MSG_CHEAT_SEARCH_FOUND_MATCHES,
+   MSG_CHEAT_SEARCH_RUNNING,
+   MSG_CHEAT_SEARCH_IN_PROGRESS,
    MSG_CHEAT_SEARCH_ADDED_MATCHES_SUCCESS,
    MSG_CHEAT_SEARCH_ADDED_MATCHES_FAIL,
    MSG_CHEAT_SEARCH_ADDED_MATCHES_TOO_MANY,
@@ -39,6 +39,10 @@
 #include <encodings/base64.h>
 #include <features/features_cpu.h>
 #include <lrc_hash.h>
+#include <retro_endianness.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #ifdef HAVE_IFINFO
 #include <net/net_ifinfo.h>
@@ -82,6 +86,9 @@
 
 #include "netplay_private.h"
 
+#define XXH_INLINE_ALL
+#include "../../deps/xxHash/xxhash.h"
+
 #ifdef TCP_NODELAY
 #define SET_TCP_NODELAY(fd) \
    { \
@@ -128,11 +135,6 @@
    if ((connection)->netplay_protocol >= (vmin) && \
          (connection)->netplay_protocol <= (vmax))
 
-#define NETPLAY_MAGIC 0x52414E50 /* RANP */
-#define FULL_MAGIC    0x46554C4C /* FULL */
-#define POKE_MAGIC    0x504F4B45 /* POKE */
-#define BANNED_MAGIC  0x44454E59 /* DENY */
-
 /* Discovery magics */
 #define DISCOVERY_QUERY_MAGIC    0x52414E51 /* RANQ */
 #define DISCOVERY_RESPONSE_MAGIC 0x52414E53 /* RANS */
@@ -772,7 +774,7 @@ static bool netplay_handshake_init_send(netplay_t *netplay,
 
    header[0] = htonl(NETPLAY_MAGIC);
    header[1] = htonl(netplay_platform_magic());
-   header[2] = htonl(NETPLAY_COMPRESSION_SUPPORTED);
+   header[2] = htonl(NETPLAY_COMPRESSION_SUPPORTED | NETPLAY_HASH_SUPPORTED);
 
    if (netplay->is_server)
    {
@@ -1118,6 +1120,11 @@ bool netplay_handshake_init(netplay_t *netplay,
       return false;
    connection->compression_supported = (uint32_t)compression;
 
+   /* Check which frame hash to use */
+   connection->frame_hash = (ntohl(header[2]) & NETPLAY_HASH_SUPPORTED
+         & NETPLAY_HASH_XXH3)
+      ? NETPLAY_FRAME_HASH_XXH3 : NETPLAY_FRAME_HASH_CRC32;
+
    if (!netplay->is_server)
    {
       /* If a password is demanded, ask for it */
@@ -2153,6 +2160,518 @@ static uint32_t netplay_delta_frame_crc(netplay_t *netplay,
    return encoding_crc32(0L, input, netplay->coremem_size);
 }
 
+/**
+ * netplay_delta_hash_blocks
+ *
+ * Get the CRC of every block of core memory.
+ */
+static void netplay_delta_hash_blocks(const uint8_t *data, size_t len,
+      uint32_t *hashes)
+{
+   size_t i;
+
+   for (i = 0; i < len; i += NETPLAY_DELTA_BLOCK_SIZE)
+   {
+      size_t block_len = len - i;
+      if (block_len > NETPLAY_DELTA_BLOCK_SIZE)
+         block_len     = NETPLAY_DELTA_BLOCK_SIZE;
+      *hashes++        = encoding_crc32(0L, data + i, block_len);
+   }
+}
+
+/**
+ * netplay_delta_base_store
+ *
+ * Keep the core memory of a frame whose CRC or XXH3 digest both sides
+ * agree on, so that later savestates can be sent against it. Its block
+ * hashes are left for netplay_delta_base_hash, as most bases are
+ * replaced before any peer asks for a delta.
+ */
+static void netplay_delta_base_store(netplay_t *netplay, uint32_t frame,
+      const uint8_t *coremem, uint32_t crc, uint32_t hash)
+{
+   struct netplay_delta_base *base =
+      &netplay->delta_bases[netplay->delta_base_ptr];
+
+   if (!netplay->coremem_size)
+      return;
+
+   if (base->size != netplay->coremem_size)
+   {
+      free(base->coremem);
+      free(base->hashes);
+      base->coremem = (uint8_t*)malloc(netplay->coremem_size);
+      base->hashes  = NULL;
+      base->size    = netplay->coremem_size;
+      base->valid   = false;
+
+      if (!base->coremem)
+      {
+         base->size = 0;
+         return;
+      }
+   }
+
+   memcpy(base->coremem, coremem, netplay->coremem_size);
+
+   base->frame             = frame;
+   base->crc               = crc;
+   base->hash              = hash;
+   base->hashed            = false;
+   base->valid             = true;
+   netplay->delta_base_ptr = (netplay->delta_base_ptr + 1)
+      % NETPLAY_DELTA_BASES;
+}
+
+/**
+ * netplay_delta_base_adopt
+ *
+ * Same as netplay_delta_base_store, but takes over a buffer of core
+ * memory instead of copying it, and hands back the buffer of the base
+ * it replaces (or NULL) in its place.
+ */
+static void netplay_delta_base_adopt(netplay_t *netplay, uint32_t frame,
+      uint8_t **coremem, uint32_t crc, uint32_t hash)
+{
+   uint8_t *old;
+   struct netplay_delta_base *base =
+      &netplay->delta_bases[netplay->delta_base_ptr];
+
+   if (!netplay->coremem_size || !*coremem)
+      return;
+
+   if (base->size != netplay->coremem_size)
+   {
+      free(base->coremem);
+      free(base->hashes);
+      base->coremem = NULL;
+      base->hashes  = NULL;
+   }
+
+   old                     = base->coremem;
+   base->coremem           = *coremem;
+   *coremem                = old;
+   base->size              = netplay->coremem_size;
+   base->frame             = frame;
+   base->crc               = crc;
+   base->hash              = hash;
+   base->hashed            = false;
+   base->valid             = true;
+   netplay->delta_base_ptr = (netplay->delta_base_ptr + 1)
+      % NETPLAY_DELTA_BASES;
+}
+
+/**
+ * netplay_delta_base_hash
+ *
+ * Get the block hashes of a base state, the first time a peer
+ * asks for a delta against it.
+ *
+ * Returns true if the hashes are available, false otherwise.
+ */
+static bool netplay_delta_base_hash(struct netplay_delta_base *base)
+{
+   if (base->hashed)
+      return true;
+
+   if (!base->hashes)
+   {
+      size_t blocks = (base->size + NETPLAY_DELTA_BLOCK_SIZE - 1)
+         / NETPLAY_DELTA_BLOCK_SIZE;
+      if (!(base->hashes = (uint32_t*)malloc(blocks * sizeof(uint32_t))))
+         return false;
+   }
+
+   netplay_delta_hash_blocks(base->coremem, base->size, base->hashes);
+   base->hashed = true;
+   return true;
+}
+
+/**
+ * netplay_delta_base_find
+ *
+ * Get the base state for the given frame and CRC or XXH3 digest,
+ * if we still have it.
+ */
+static struct netplay_delta_base *netplay_delta_base_find(
+      netplay_t *netplay, uint32_t frame, uint32_t crc)
+{
+   size_t i;
+
+   for (i = 0; i < NETPLAY_DELTA_BASES; i++)
+   {
+      struct netplay_delta_base *base = &netplay->delta_bases[i];
+      if (     base->valid
+            && base->frame == frame
+            && crc
+            && (base->crc == crc || base->hash == crc)
+            && base->size  == netplay->coremem_size)
+         return base;
+   }
+
+   return NULL;
+}
+
+/**
+ * netplay_delta_bases_free
+ *
+ * Forget all base states, e.g. because the state size changed.
+ */
+static void netplay_delta_bases_free(netplay_t *netplay)
+{
+   size_t i;
+
+   for (i = 0; i < NETPLAY_DELTA_BASES; i++)
+   {
+      struct netplay_delta_base *base = &netplay->delta_bases[i];
+      free(base->coremem);
+      free(base->hashes);
+      memset(base, 0, sizeof(*base));
+   }
+
+   netplay->delta_base_ptr = 0;
+}
+
+/**
+ * netplay_delta_buffer_reserve
+ *
+ * Make sure the delta buffer can hold at least the given size.
+ */
+static bool netplay_delta_buffer_reserve(netplay_t *netplay, size_t len)
+{
+   uint8_t *buf;
+
+   if (netplay->delta_buffer_size >= len)
+      return true;
+
+   if (!(buf = (uint8_t*)realloc(netplay->delta_buffer, len)))
+      return false;
+
+   netplay->delta_buffer      = buf;
+   netplay->delta_buffer_size = len;
+   return true;
+}
+
+enum netplay_frame_hasher_state
+{
+   NETPLAY_FRAME_HASHER_IDLE = 0,
+   NETPLAY_FRAME_HASHER_BUSY,
+   NETPLAY_FRAME_HASHER_DONE
+};
+
+/* How many of the server's check frames a client keeps
+ * chunk hashes for, while it catches up to them */
+#define NETPLAY_FRAME_HASH_REMOTES 4
+
+struct netplay_frame_hash_remote
+{
+   uint64_t *chunks;
+   size_t   count;
+   size_t   capacity;
+   size_t   chunk_size;
+   uint32_t frame;
+   bool     used;
+};
+
+struct netplay_frame_hasher
+{
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+   slock_t   *lock;
+   scond_t   *cond;
+#endif
+   /* Copy of the core memory being hashed */
+   uint8_t  *data;
+   /* Its chunk hashes, in network byte order */
+   uint64_t *chunks;
+   /* The server's chunk hashes of its latest check frames (client only) */
+   struct netplay_frame_hash_remote remote[NETPLAY_FRAME_HASH_REMOTES];
+   size_t   data_size;
+   size_t   chunk_count;
+   size_t   chunk_capacity;
+   size_t   chunk_size;
+   /* The next entry of remote to replace */
+   size_t   remote_ptr;
+   size_t   remote_chunk_size;
+   uint32_t frame;
+   /* CRC-32 of the frame, if it was also checked that way */
+   uint32_t crc;
+   enum netplay_frame_hasher_state state;
+   bool     quit;
+};
+
+/**
+ * netplay_frame_hash_chunks
+ *
+ * Get the XXH3 hash of every chunk of core memory.
+ */
+static void netplay_frame_hash_chunks(const uint8_t *data, size_t len,
+      size_t chunk_size, uint64_t *chunks)
+{
+   size_t i;
+
+   for (i = 0; i < len; i += chunk_size)
+   {
+      size_t chunk_len = MIN(chunk_size, len - i);
+      *chunks++        = swap_if_little64(
+            (uint64_t)XXH3_64bits(data + i, chunk_len));
+   }
+}
+
+/**
+ * netplay_frame_hash_digest
+ *
+ * Fold a list of chunk hashes into a 32-bit value that stands in for
+ * the frame's CRC. Never 0, which means "no hash".
+ */
+static uint32_t netplay_frame_hash_digest(const uint64_t *chunks,
+      size_t count)
+{
+   uint32_t digest = (uint32_t)XXH3_64bits(chunks, count * sizeof(*chunks));
+   return digest ? digest : 1;
+}
+
+#ifdef HAVE_THREADS
+static void netplay_frame_hasher_thread(void *data)
+{
+   struct netplay_frame_hasher *hasher = (struct netplay_frame_hasher*)data;
+
+   slock_lock(hasher->lock);
+   for (;;)
+   {
+      while (hasher->state != NETPLAY_FRAME_HASHER_BUSY && !hasher->quit)
+         scond_wait(hasher->cond, hasher->lock);
+      if (hasher->quit)
+         break;
+      slock_unlock(hasher->lock);
+
+      netplay_frame_hash_chunks(hasher->data, hasher->data_size,
+            hasher->chunk_size, hasher->chunks);
+
+      slock_lock(hasher->lock);
+      hasher->state = NETPLAY_FRAME_HASHER_DONE;
+   }
+   slock_unlock(hasher->lock);
+}
+#endif
+
+static void netplay_frame_hasher_free(struct netplay_frame_hasher *hasher)
+{
+   size_t i;
+
+   if (!hasher)
+      return;
+
+#ifdef HAVE_THREADS
+   if (hasher->thread)
+   {
+      slock_lock(hasher->lock);
+      hasher->quit = true;
+      scond_signal(hasher->cond);
+      slock_unlock(hasher->lock);
+      sthread_join(hasher->thread);
+   }
+   if (hasher->lock)
+      slock_free(hasher->lock);
+   if (hasher->cond)
+      scond_free(hasher->cond);
+#endif
+
+   free(hasher->data);
+   free(hasher->chunks);
+   for (i = 0; i < NETPLAY_FRAME_HASH_REMOTES; i++)
+      free(hasher->remote[i].chunks);
+   free(hasher);
+}
+
+static struct netplay_frame_hasher *netplay_frame_hasher_new(void)
+{
+   struct netplay_frame_hasher *hasher = (struct netplay_frame_hasher*)
+      calloc(1, sizeof(*hasher));
+
+   if (!hasher)
+      return NULL;
+
+#ifdef HAVE_THREADS
+   if (     !(hasher->lock   = slock_new())
+         || !(hasher->cond   = scond_new())
+         || !(hasher->thread = sthread_create(
+               netplay_frame_hasher_thread, hasher)))
+   {
+      netplay_frame_hasher_free(hasher);
+      return NULL;
+   }
+#endif
+
+   return hasher;
+}
+
+/**
+ * netplay_frame_hasher_get_state
+ *
+ * Get the state of the hasher, as seen from the main thread.
+ */
+static enum netplay_frame_hasher_state netplay_frame_hasher_get_state(
+      struct netplay_frame_hasher *hasher)
+{
+   enum netplay_frame_hasher_state state;
+#ifdef HAVE_THREADS
+   slock_lock(hasher->lock);
+#endif
+   state = hasher->state;
+#ifdef HAVE_THREADS
+   slock_unlock(hasher->lock);
+#endif
+   return state;
+}
+
+/**
+ * netplay_frame_hash_submit
+ * @netplay              : pointer to netplay object
+ * @delta                : the check frame
+ * @crc                  : the frame's CRC-32, if it was also computed
+ *
+ * Start hashing the core memory of a check frame. The memory is copied,
+ * so the frame may be rewritten meanwhile. netplay_frame_hash_poll
+ * handles the result. A check frame is skipped if the previous one is
+ * still being hashed.
+ */
+static void netplay_frame_hash_submit(netplay_t *netplay,
+      struct delta_frame *delta, uint32_t crc)
+{
+   size_t count, chunk_size;
+   struct netplay_frame_hasher *hasher;
+
+   if (!netplay->coremem_size)
+      return;
+   if (!netplay->hasher && !(netplay->hasher = netplay_frame_hasher_new()))
+      return;
+
+   hasher = netplay->hasher;
+   if (netplay_frame_hasher_get_state(hasher) != NETPLAY_FRAME_HASHER_IDLE)
+   {
+      RARCH_WARN("[Netplay] Skipping hash of frame %u, still hashing frame %u.\n",
+            delta->frame, hasher->frame);
+      return;
+   }
+
+   /* Clients hash with the server's chunk size */
+   chunk_size = (!netplay->is_server && hasher->remote_chunk_size)
+      ? hasher->remote_chunk_size : NETPLAY_HASH_CHUNK_SIZE;
+   count      = (netplay->coremem_size + chunk_size - 1) / chunk_size;
+
+   if (hasher->data_size != netplay->coremem_size)
+   {
+      uint8_t *data = (uint8_t*)realloc(hasher->data, netplay->coremem_size);
+      if (!data)
+         return;
+      hasher->data      = data;
+      hasher->data_size = netplay->coremem_size;
+   }
+
+   if (hasher->chunk_capacity < count)
+   {
+      uint64_t *chunks = (uint64_t*)realloc(hasher->chunks,
+            count * sizeof(*chunks));
+      if (!chunks)
+         return;
+      hasher->chunks         = chunks;
+      hasher->chunk_capacity = count;
+   }
+
+   memcpy(hasher->data, netplay_get_savestate_coremem(netplay,
+            (const uint8_t*)delta->state), netplay->coremem_size);
+   hasher->frame       = delta->frame;
+   hasher->crc         = crc;
+   hasher->chunk_size  = chunk_size;
+   hasher->chunk_count = count;
+
+#ifdef HAVE_THREADS
+   slock_lock(hasher->lock);
+   hasher->state = NETPLAY_FRAME_HASHER_BUSY;
+   scond_signal(hasher->cond);
+   slock_unlock(hasher->lock);
+#else
+   netplay_frame_hash_chunks(hasher->data, hasher->data_size,
+         hasher->chunk_size, hasher->chunks);
+   hasher->state = NETPLAY_FRAME_HASHER_DONE;
+#endif
+}
+
+/**
+ * netplay_apply_savestate_delta
+ * @netplay              : pointer to netplay object
+ * @base                 : the base state the delta was made against
+ * @crc                  : CRC of the resulting core memory
+ * @head_size            : size of the savestate before the core memory
+ * @tail_size            : size of the savestate after the core memory
+ * @block_size           : size of each block of core memory
+ * @len                  : size of the decompressed delta in delta_buffer
+ * @state                : the savestate to write
+ *
+ * Rebuild a savestate from a decompressed delta, which is made of
+ * the savestate head and tail, a bitmap of changed blocks and then
+ * the changed blocks themselves. The result is checked against the
+ * CRC before the savestate is touched.
+ *
+ * Returns true if the savestate was rebuilt, false otherwise.
+ */
+static bool netplay_apply_savestate_delta(netplay_t *netplay,
+      const struct netplay_delta_base *base, uint32_t crc,
+      size_t head_size, size_t tail_size, size_t block_size,
+      size_t len, uint8_t *state)
+{
+   size_t i, j;
+   const uint8_t *src;
+   uint32_t local_crc   = 0;
+   const uint8_t *body  = netplay->delta_buffer;
+   const uint8_t *end   = body + len;
+   size_t coremem_size  = base->size;
+   size_t blocks        = (coremem_size + block_size - 1) / block_size;
+   const uint8_t *bitmap = body + head_size + tail_size;
+   const uint8_t *data  = bitmap + (blocks + 7) / 8;
+
+   if (data > end)
+      return false;
+
+   for (i = 0, j = 0, src = data; i < coremem_size; i += block_size, j++)
+   {
+      size_t block_len = MIN(block_size, coremem_size - i);
+
+      if (bitmap[j >> 3] & (1 << (j & 7)))
+      {
+         if ((size_t)(end - src) < block_len)
+            return false;
+         local_crc = encoding_crc32(local_crc, src, block_len);
+         src      += block_len;
+      }
+      else
+         local_crc = encoding_crc32(local_crc, base->coremem + i, block_len);
+   }
+
+   if (src != end || local_crc != crc)
+      return false;
+
+   memcpy(state, body, head_size);
+   state += head_size;
+
+   for (i = 0, j = 0, src = data; i < coremem_size; i += block_size, j++)
+   {
+      size_t block_len = MIN(block_size, coremem_size - i);
+
+      if (bitmap[j >> 3] & (1 << (j & 7)))
+      {
+         memcpy(state + i, src, block_len);
+         src += block_len;
+      }
+      else
+         memcpy(state + i, base->coremem + i, block_len);
+   }
+
+   memcpy(state + coremem_size, body + head_size, tail_size);
+   return true;
+}
+
 /*
  * Free an input state list
  */
@@ -2695,7 +3214,8 @@ static bool netplay_cmd_crc(netplay_t *netplay, struct delta_frame *delta)
    for (i = 0; i < netplay->connections_size; i++)
    {
       if (     (netplay->connections[i].flags & NETPLAY_CONN_FLAG_ACTIVE)
-            && (netplay->connections[i].mode >= NETPLAY_CONNECTION_CONNECTED))
+            && (netplay->connections[i].mode >= NETPLAY_CONNECTION_CONNECTED)
+            && (netplay->connections[i].frame_hash == NETPLAY_FRAME_HASH_CRC32))
          success = netplay_send_raw_cmd(netplay, &netplay->connections[i],
             NETPLAY_CMD_CRC, payload, sizeof(payload)) && success;
    }
@@ -2709,6 +3229,8 @@ static bool netplay_cmd_crc(netplay_t *netplay, struct delta_frame *delta)
  */
 static bool netplay_cmd_request_savestate(netplay_t *netplay)
 {
+   struct netplay_connection *connection = NULL;
+
    if (     (netplay->connections_size == 0)
        || (!(netplay->connections[0].flags & NETPLAY_CONN_FLAG_ACTIVE))
        ||   (netplay->connections[0].mode  < NETPLAY_CONNECTION_CONNECTED)
@@ -2717,10 +3239,155 @@ static bool netplay_cmd_request_savestate(netplay_t *netplay)
    if (netplay->savestate_request_outstanding)
       return true;
    netplay->savestate_request_outstanding = true;
-   return netplay_send_raw_cmd(netplay, &netplay->connections[0],
+   connection = &netplay->connections[0];
+
+   /* Name our newest checked state, so that the server
+    * can send us only what changed since. */
+   REQUIRE_PROTOCOL_VERSION(connection, 8)
+   {
+      const struct netplay_delta_base *base = &netplay->delta_bases[
+         (netplay->delta_base_ptr + NETPLAY_DELTA_BASES - 1)
+         % NETPLAY_DELTA_BASES];
+
+      if (base->valid && base->size == netplay->coremem_size)
+      {
+         uint32_t payload[2];
+
+         payload[0] = htonl(base->frame);
+         payload[1] = htonl(base->hash ? base->hash : base->crc);
+
+         return netplay_send_raw_cmd(netplay, connection,
+            NETPLAY_CMD_REQUEST_SAVESTATE, payload, sizeof(payload));
+      }
+   }
+
+   return netplay_send_raw_cmd(netplay, connection,
       NETPLAY_CMD_REQUEST_SAVESTATE, NULL, 0);
 }
 
+/**
+ * netplay_frame_hash_poll
+ *
+ * Handle a frame hashed by the helper thread: the server sends it to
+ * every peer using XXH3, a client checks it against the server's.
+ */
+static void netplay_frame_hash_poll(netplay_t *netplay)
+{
+   size_t i;
+   uint32_t digest;
+   bool adopt;
+   struct netplay_frame_hash_remote *remote = NULL;
+   struct netplay_frame_hasher *hasher      = netplay->hasher;
+
+   if (     !hasher
+         || netplay_frame_hasher_get_state(hasher)
+            != NETPLAY_FRAME_HASHER_DONE)
+      return;
+
+   digest = netplay_frame_hash_digest(hasher->chunks, hasher->chunk_count);
+   /* The copy that was hashed becomes the delta base as is,
+    * unless the state size changed meanwhile */
+   adopt  = hasher->data_size == netplay->coremem_size;
+
+   if (!netplay->is_server)
+   {
+      for (i = 0; i < NETPLAY_FRAME_HASH_REMOTES; i++)
+      {
+         if (     hasher->remote[i].used
+               && hasher->remote[i].frame == hasher->frame)
+         {
+            remote       = &hasher->remote[i];
+            remote->used = false;
+            break;
+         }
+      }
+   }
+
+   if (netplay->is_server)
+   {
+      uint32_t header[4];
+
+      header[0] = htonl(NETPLAY_CMD_FRAME_HASH);
+      header[1] = htonl((uint32_t)(2*sizeof(uint32_t)
+            + hasher->chunk_count * sizeof(uint64_t)));
+      header[2] = htonl(hasher->frame);
+      header[3] = htonl((uint32_t)hasher->chunk_size);
+
+      for (i = 0; i < netplay->connections_size; i++)
+      {
+         struct netplay_connection *connection = &netplay->connections[i];
+
+         if (     !(connection->flags & NETPLAY_CONN_FLAG_ACTIVE)
+               ||  (connection->mode < NETPLAY_CONNECTION_CONNECTED)
+               ||  (connection->frame_hash != NETPLAY_FRAME_HASH_XXH3))
+            continue;
+
+         /* A failed send surfaces on the connection's next flush */
+         if (netplay_send(&connection->send_packet_buffer,
+                 connection->fd, header, sizeof(header)))
+            netplay_send(&connection->send_packet_buffer,
+                 connection->fd, hasher->chunks,
+                 hasher->chunk_count * sizeof(uint64_t));
+      }
+
+      if (adopt)
+         netplay_delta_base_adopt(netplay, hasher->frame, &hasher->data,
+               hasher->crc, digest);
+   }
+   else if (remote
+         && remote->count      == hasher->chunk_count
+         && remote->chunk_size == hasher->chunk_size)
+   {
+      for (i = 0; i < hasher->chunk_count; i++)
+         if (hasher->chunks[i] != remote->chunks[i])
+            break;
+
+      if (i == hasher->chunk_count)
+      {
+         netplay->crc_validity_checked = true;
+         if (adopt)
+            netplay_delta_base_adopt(netplay, hasher->frame, &hasher->data,
+                  0, digest);
+      }
+      /* If the very first check frame is wrong,
+         they probably just don't work. */
+      else if (!netplay->crc_validity_checked)
+         netplay->crcs_valid = false;
+      else
+      {
+         uint32_t payload[3];
+         size_t offset = i * hasher->chunk_size;
+         size_t len    = MIN(hasher->chunk_size, hasher->data_size - offset);
+
+         RARCH_WARN("[Netplay] Desync at frame %u, core memory first differs at 0x%X-0x%X.\n",
+               hasher->frame, (unsigned)offset, (unsigned)(offset + len - 1));
+
+         payload[0] = htonl(hasher->frame);
+         payload[1] = htonl((uint32_t)offset);
+         payload[2] = htonl((uint32_t)len);
+         netplay_send_raw_cmd(netplay, &netplay->connections[0],
+               NETPLAY_CMD_FRAME_HASH_MISMATCH, payload, sizeof(payload));
+
+         if (netplay->check_frames)
+            netplay_cmd_request_savestate(netplay);
+         else
+            RARCH_WARN("[Netplay] Netplay CRCs mismatch!\n");
+      }
+   }
+
+   /* The buffer handed back is reused if it has the right size */
+   if (!hasher->data)
+      hasher->data_size = 0;
+
+#ifdef HAVE_THREADS
+   slock_lock(hasher->lock);
+#endif
+   hasher->state = NETPLAY_FRAME_HASHER_IDLE;
+#ifdef HAVE_THREADS
+   slock_unlock(hasher->lock);
+#endif
+}
+
 /**
  * netplay_cmd_stall
  *
@@ -3217,15 +3884,51 @@ static void netplay_handle_frame_hash(netplay_t *netplay,
    {
       if (netplay->check_frames && (delta->frame % netplay->check_frames) == 0)
       {
-         delta->crc = netplay->state_size ?
-            netplay_delta_frame_crc(netplay, delta) : 0;
-         netplay_cmd_crc(netplay, delta);
+         size_t i;
+         bool use_crc  = false;
+         bool use_xxh3 = false;
+
+         for (i = 0; i < netplay->connections_size; i++)
+         {
+            struct netplay_connection *connection = &netplay->connections[i];
+            if (     !(connection->flags & NETPLAY_CONN_FLAG_ACTIVE)
+                  ||  (connection->mode < NETPLAY_CONNECTION_CONNECTED))
+               continue;
+            if (connection->frame_hash == NETPLAY_FRAME_HASH_XXH3)
+               use_xxh3 = true;
+            else
+               use_crc  = true;
+         }
+
+         delta->crc = 0;
+         if (use_crc || !use_xxh3)
+         {
+            delta->crc = netplay->state_size ?
+               netplay_delta_frame_crc(netplay, delta) : 0;
+            netplay_cmd_crc(netplay, delta);
+         }
+
+         /* The delta base is kept once the XXH3 hash is known */
+         if (use_xxh3)
+            netplay_frame_hash_submit(netplay, delta, delta->crc);
+         else if (netplay->state_size)
+            netplay_delta_base_store(netplay, delta->frame,
+                  netplay_get_savestate_coremem(netplay,
+                     (const uint8_t*)delta->state), delta->crc, 0);
       }
    }
    else
    {
       if (netplay->crcs_valid && delta->crc)
       {
+         /* The server sent chunk hashes, which are checked
+          * on the helper thread. */
+         if (netplay->connections[0].frame_hash == NETPLAY_FRAME_HASH_XXH3)
+         {
+            netplay_frame_hash_submit(netplay, delta, 0);
+            return;
+         }
+
          /* We have a remote CRC, so check it. */
          uint32_t local_crc = netplay->state_size ?
             netplay_delta_frame_crc(netplay, delta) : 0;
@@ -3246,7 +3949,12 @@ static void netplay_handle_frame_hash(netplay_t *netplay,
                RARCH_WARN("[Netplay] Netplay CRCs mismatch!\n");
          }
          else
+         {
             netplay->crc_validity_checked = true;
+            netplay_delta_base_store(netplay, delta->frame,
+                  netplay_get_savestate_coremem(netplay,
+                     (const uint8_t*)delta->state), local_crc, 0);
+         }
       }
    }
 }
@@ -5987,6 +6695,11 @@ static bool netplay_get_cmd(netplay_t *netplay,
                /* Problem! */
                if (buffer[1] != local_crc)
                   netplay_cmd_request_savestate(netplay);
+               else
+                  netplay_delta_base_store(netplay, buffer[0],
+                        netplay_get_savestate_coremem(netplay,
+                           (const uint8_t*)netplay->buffer[tmp_ptr].state),
+                        local_crc, 0);
             }
             /* We'll have to check it when we catch up */
             else
@@ -5995,22 +6708,171 @@ static bool netplay_get_cmd(netplay_t *netplay,
             break;
          }
 
+      case NETPLAY_CMD_FRAME_HASH:
+         {
+            uint32_t buffer[2];
+            size_t count;
+            struct netplay_frame_hasher *hasher;
+            struct netplay_frame_hash_remote *remote;
+            size_t tmp_ptr = netplay->run_ptr;
+            bool found     = false;
+            NETPLAY_ASSERT_MODUS(NETPLAY_MODUS_INPUT_FRAME_SYNC);
+
+            if (netplay->is_server)
+            {
+               RARCH_ERR("[Netplay] NETPLAY_CMD_FRAME_HASH from a client.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            if (     cmd_size < sizeof(buffer)
+                  || ((cmd_size - sizeof(buffer)) % sizeof(uint64_t))
+                  || cmd_size > netplay->zbuffer_size)
+            {
+               RARCH_ERR("[Netplay] NETPLAY_CMD_FRAME_HASH received unexpected payload size.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+            count = (cmd_size - sizeof(buffer)) / sizeof(uint64_t);
+
+            if (!netplay->hasher && !(netplay->hasher = netplay_frame_hasher_new()))
+               return false;
+            hasher = netplay->hasher;
+
+            /* Keep the hashes of a few check frames, as we may not
+             * reach this one before the next arrives */
+            remote             = &hasher->remote[hasher->remote_ptr];
+            hasher->remote_ptr = (hasher->remote_ptr + 1)
+               % NETPLAY_FRAME_HASH_REMOTES;
+            remote->used       = false;
+
+            if (remote->capacity < count)
+            {
+               uint64_t *chunks = (uint64_t*)realloc(remote->chunks,
+                     count * sizeof(*chunks));
+               if (!chunks)
+                  return false;
+               remote->chunks   = chunks;
+               remote->capacity = count;
+            }
+
+            RECV(buffer, sizeof(buffer))
+               return false;
+            if (count)
+            {
+               RECV(remote->chunks, count * sizeof(uint64_t))
+                  return false;
+            }
+
+            buffer[0] = ntohl(buffer[0]);
+            buffer[1] = ntohl(buffer[1]);
+
+            if (!buffer[1])
+            {
+               RARCH_ERR("[Netplay] NETPLAY_CMD_FRAME_HASH received a zero chunk size.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            remote->frame             = buffer[0];
+            remote->count             = count;
+            remote->chunk_size        = buffer[1];
+            remote->used              = true;
+            hasher->remote_chunk_size = buffer[1];
+
+            do
+            {
+               if (     netplay->buffer[tmp_ptr].used
+                     && netplay->buffer[tmp_ptr].frame == buffer[0])
+               {
+                  found = true;
+                  break;
+               }
+
+               tmp_ptr = PREV_PTR(tmp_ptr);
+            } while (tmp_ptr != netplay->run_ptr);
+
+            if (!found || !netplay->crcs_valid)
+               break;
+
+            if (buffer[0] <= netplay->other_frame_count)
+               netplay_frame_hash_submit(netplay, &netplay->buffer[tmp_ptr], 0);
+            /* Mark it to be hashed when we catch up */
+            else
+               netplay->buffer[tmp_ptr].crc = netplay_frame_hash_digest(
+                     remote->chunks, count);
+
+            break;
+         }
+
+      case NETPLAY_CMD_FRAME_HASH_MISMATCH:
+         {
+            uint32_t payload[3];
+            NETPLAY_ASSERT_MODUS(NETPLAY_MODUS_INPUT_FRAME_SYNC);
+
+            if (!netplay->is_server)
+            {
+               RARCH_ERR("[Netplay] NETPLAY_CMD_FRAME_HASH_MISMATCH from the server.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            if (cmd_size != sizeof(payload))
+            {
+               RARCH_ERR("[Netplay] NETPLAY_CMD_FRAME_HASH_MISMATCH received unexpected payload size.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            RECV(payload, sizeof(payload))
+               return false;
+
+            payload[0] = ntohl(payload[0]);
+            payload[1] = ntohl(payload[1]);
+            payload[2] = ntohl(payload[2]);
+
+            RARCH_WARN("[Netplay] %s desynced at frame %u, core memory first differs at 0x%X-0x%X.\n",
+                  connection->nick, payload[0], payload[1],
+                  payload[1] + (payload[2] ? payload[2] - 1 : 0));
+            break;
+         }
+
       case NETPLAY_CMD_REQUEST_SAVESTATE:
          NETPLAY_ASSERT_MODUS(NETPLAY_MODUS_INPUT_FRAME_SYNC);
+         /* Protocol 8 clients may name a base state to send a delta against */
+         if (cmd_size == 2*sizeof(uint32_t))
+         {
+            uint32_t payload[2];
+
+            RECV(payload, sizeof(payload))
+               return false;
+
+            connection->delta_base_frame = ntohl(payload[0]);
+            connection->delta_base_crc   = ntohl(payload[1]);
+            connection->flags           |= NETPLAY_CONN_FLAG_DELTA_BASE;
+         }
+         else if (cmd_size)
+         {
+            RARCH_ERR("[Netplay] NETPLAY_CMD_REQUEST_SAVESTATE received unexpected payload size.\n");
+            return netplay_cmd_nak(netplay, connection);
+         }
+         else
+            connection->flags &= ~NETPLAY_CONN_FLAG_DELTA_BASE;
          /* Delay until next frame so we don't send the savestate after the
           * input */
          netplay->force_send_savestate = true;
          break;
 
       case NETPLAY_CMD_LOAD_SAVESTATE:
+      case NETPLAY_CMD_LOAD_SAVESTATE_DELTA:
          {
             uint32_t i;
             uint32_t frame;
             uint32_t state_size, state_size_raw;
+            /* Base frame, base CRC, CRC, head size,
+             * core memory size, tail size and block size */
+            uint32_t delta_info[7];
             size_t   load_ptr;
+            size_t   header_size;
             uint32_t load_frame_count;
             uint32_t rd, wn;
             struct compression_transcoder *ctrans = NULL;
+            bool is_delta = (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA);
             NETPLAY_ASSERT_MODUS(NETPLAY_MODUS_INPUT_FRAME_SYNC);
 
             if (netplay->is_server)
@@ -6019,7 +6881,10 @@ static bool netplay_get_cmd(netplay_t *netplay,
                return netplay_cmd_nak(netplay, connection);
             }
 
-            if (cmd_size < sizeof(frame) + sizeof(state_size))
+            header_size = sizeof(frame) + (is_delta
+                  ? sizeof(delta_info) : sizeof(state_size));
+
+            if (cmd_size < header_size)
             {
                RARCH_ERR("[Netplay] Received invalid payload size for NETPLAY_CMD_LOAD_SAVESTATE.\n");
                return netplay_cmd_nak(netplay, connection);
@@ -6078,74 +6943,152 @@ static bool netplay_get_cmd(netplay_t *netplay,
                /* Hopefully it will be ready after another round of input. */
                goto shrt;
 
-            RECV(&state_size, sizeof(state_size))
-               return false;
-            state_size     = ntohl(state_size);
-            state_size_raw = cmd_size - (sizeof(frame) + sizeof(state_size));
-
-            if (state_size_raw > netplay->zbuffer_size)
+            if (is_delta)
             {
-               RARCH_ERR("[Netplay] Netplay state load with an unexpected save state size.\n");
-               return netplay_cmd_nak(netplay, connection);
-            }
+               size_t bitmap_size, delta_size;
+               bool applied                          = false;
+               const struct netplay_delta_base *base = NULL;
 
-            RECV(netplay->zbuffer, state_size_raw)
-               return false;
+               RECV(delta_info, sizeof(delta_info))
+                  return false;
+               for (i = 0; i < ARRAY_SIZE(delta_info); i++)
+                  delta_info[i] = ntohl(delta_info[i]);
+               state_size_raw = cmd_size - header_size;
 
-            switch (connection->compression_supported)
-            {
-               case NETPLAY_COMPRESSION_ZLIB:
-                  ctrans = &netplay->compress_zlib;
-                  break;
-               default:
-                  ctrans = &netplay->compress_nil;
-                  break;
-            }
+               if (state_size_raw > netplay->zbuffer_size || !delta_info[6])
+               {
+                  RARCH_ERR("[Netplay] Netplay state load with an unexpected save state size.\n");
+                  return netplay_cmd_nak(netplay, connection);
+               }
 
-            if (state_size > netplay->state_size)
-            {
-               /* other client state size is larger than ours, grow ours */
-               netplay->state_size = state_size;
-               for (i = 0; i < netplay->buffer_size; i++)
+               RECV(netplay->zbuffer, state_size_raw)
+                  return false;
+
+               bitmap_size = ((size_t)delta_info[4] + delta_info[6] - 1)
+                  / delta_info[6];
+               bitmap_size = (bitmap_size + 7) / 8;
+               delta_size  = (size_t)delta_info[3] + delta_info[5]
+                  + bitmap_size + delta_info[4];
+
+               /* We can only rebuild the state on top of
+                * the same base, with the same layout */
+               if (     delta_info[3] <= netplay->state_size
+                     && delta_info[5] <= netplay->state_size
+                     && (size_t)delta_info[3] + delta_info[4] + delta_info[5]
+                        <= netplay->state_size
+                     && (base = netplay_delta_base_find(netplay,
+                           delta_info[0], delta_info[1]))
+                     && base->size == delta_info[4]
+                     && netplay_delta_buffer_reserve(netplay, delta_size))
                {
-                  netplay->buffer[i].state = realloc(netplay->buffer[i].state, netplay->state_size);
-                  if (!netplay->buffer[i].state)
-                     return false;
+                  enum trans_stream_error error;
+
+                  ctrans = (connection->compression_supported
+                        == NETPLAY_COMPRESSION_ZLIB)
+                     ? &netplay->compress_zlib : &netplay->compress_nil;
+
+                  ctrans->decompression_backend->set_in(
+                     ctrans->decompression_stream,
+                     netplay->zbuffer, state_size_raw);
+                  ctrans->decompression_backend->set_out(
+                     ctrans->decompression_stream,
+                     netplay->delta_buffer, (uint32_t)delta_size);
+                  if (     !ctrans->decompression_backend->trans(
+                              ctrans->decompression_stream,
+                              true, &rd, &wn, &error)
+                        || (error != TRANS_STREAM_ERROR_NONE))
+                  {
+                     RARCH_ERR("[Netplay] Netplay state load with a corrupt delta.\n");
+                     return netplay_cmd_nak(netplay, connection);
+                  }
+
+                  applied = netplay_apply_savestate_delta(netplay, base,
+                        delta_info[2], delta_info[3], delta_info[5],
+                        delta_info[6], wn,
+                        (uint8_t*)netplay->buffer[load_ptr].state);
                }
-            }
 
-            ctrans->decompression_backend->set_in(
-               ctrans->decompression_stream,
-               netplay->zbuffer, state_size_raw);
-            ctrans->decompression_backend->set_out(
-               ctrans->decompression_stream,
-               (uint8_t*)netplay->buffer[load_ptr].state, state_size);
-            ctrans->decompression_backend->trans(
-               ctrans->decompression_stream,
-               true, &rd, &wn, NULL);
-
-            if (memcmp(netplay->buffer[load_ptr].state, "NETPLAY", 7) != 0)
+               if (!applied)
+               {
+                  /* Our bases are no good, ask for the whole state */
+                  RARCH_WARN("[Netplay] Could not apply savestate delta, requesting full savestate.\n");
+                  netplay_delta_bases_free(netplay);
+                  netplay->savestate_request_outstanding = false;
+                  netplay_cmd_request_savestate(netplay);
+                  break;
+               }
+            }
+            else
             {
-               if (state_size != netplay->coremem_size)
+               RECV(&state_size, sizeof(state_size))
+                  return false;
+               state_size     = ntohl(state_size);
+               state_size_raw = cmd_size - header_size;
+
+               if (state_size_raw > netplay->zbuffer_size)
                {
                   RARCH_ERR("[Netplay] Netplay state load with an unexpected save state size.\n");
                   return netplay_cmd_nak(netplay, connection);
                }
 
-#ifdef HAVE_CHEEVOS
-               /* did not receive a protocol 7 packet. server isn't sending achievement data. disable hardcore */
-               if (     !netplay->is_server
-                     &&  rcheevos_hardcore_active()
-                     && !netplay_is_spectating())
+               RECV(netplay->zbuffer, state_size_raw)
+                  return false;
+
+               switch (connection->compression_supported)
                {
-                  const char* msg = msg_hash_to_str(MSG_CHEEVOS_HARDCORE_MODE_REQUIRES_NEWER_HOST);
-                  runloop_msg_queue_push(msg, strlen(msg), 0, 180, true, NULL,
-                     MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
-                  RARCH_WARN("[Netplay] Server did not send achievement information.\n", msg);
+                  case NETPLAY_COMPRESSION_ZLIB:
+                     ctrans = &netplay->compress_zlib;
+                     break;
+                  default:
+                     ctrans = &netplay->compress_nil;
+                     break;
+               }
 
-                  rcheevos_pause_hardcore();
+               if (state_size > netplay->state_size)
+               {
+                  /* other client state size is larger than ours, grow ours */
+                  netplay->state_size = state_size;
+                  for (i = 0; i < netplay->buffer_size; i++)
+                  {
+                     netplay->buffer[i].state = realloc(netplay->buffer[i].state, netplay->state_size);
+                     if (!netplay->buffer[i].state)
+                        return false;
+                  }
                }
+
+               ctrans->decompression_backend->set_in(
+                  ctrans->decompression_stream,
+                  netplay->zbuffer, state_size_raw);
+               ctrans->decompression_backend->set_out(
+                  ctrans->decompression_stream,
+                  (uint8_t*)netplay->buffer[load_ptr].state, state_size);
+               ctrans->decompression_backend->trans(
+                  ctrans->decompression_stream,
+                  true, &rd, &wn, NULL);
+
+               if (memcmp(netplay->buffer[load_ptr].state, "NETPLAY", 7) != 0)
+               {
+                  if (state_size != netplay->coremem_size)
+                  {
+                     RARCH_ERR("[Netplay] Netplay state load with an unexpected save state size.\n");
+                     return netplay_cmd_nak(netplay, connection);
+                  }
+
+#ifdef HAVE_CHEEVOS
+                  /* did not receive a protocol 7 packet. server isn't sending achievement data. disable hardcore */
+                  if (     !netplay->is_server
+                        &&  rcheevos_hardcore_active()
+                        && !netplay_is_spectating())
+                  {
+                     const char* msg = msg_hash_to_str(MSG_CHEEVOS_HARDCORE_MODE_REQUIRES_NEWER_HOST);
+                     runloop_msg_queue_push(msg, strlen(msg), 0, 180, true, NULL,
+                        MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+                     RARCH_WARN("[Netplay] Server did not send achievement information.\n", msg);
+
+                     rcheevos_pause_hardcore();
+                  }
 #endif
+               }
             }
 
             /* Force a rewind to the relevant frame. */
@@ -7278,6 +8221,9 @@ static void netplay_free(netplay_t *netplay)
    }
 
    free(netplay->zbuffer);
+   free(netplay->delta_buffer);
+   netplay_delta_bases_free(netplay);
+   netplay_frame_hasher_free(netplay->hasher);
 
    if (netplay->compress_nil.compression_stream)
       netplay->compress_nil.compression_backend->stream_free(
@@ -7431,6 +8377,142 @@ failure:
    return NULL;
 }
 
+/**
+ * netplay_send_savestate_deltas
+ * @netplay              : pointer to netplay object
+ * @serial_info          : the savestate being loaded
+ *
+ * Send a loaded savestate to those peers that named a base state we still
+ * hold, as only the blocks of core memory that changed since. Those peers
+ * are then skipped when sending the full savestate.
+ */
+static void netplay_send_savestate_deltas(netplay_t *netplay,
+   retro_ctx_serialize_info_t *serial_info)
+{
+   size_t i;
+   size_t head_size, tail_size, bitmap_size, blocks;
+   uint32_t crc;
+   const uint8_t *state   = (const uint8_t*)serial_info->data_const;
+   const uint8_t *coremem = NULL;
+   size_t coremem_size    = netplay->coremem_size;
+   NETPLAY_ASSERT_MODUS(NETPLAY_MODUS_INPUT_FRAME_SYNC);
+
+   if (!netplay->is_server || !coremem_size)
+      return;
+
+   coremem   = netplay_get_savestate_coremem(netplay, state);
+   head_size = coremem - state;
+   if (head_size + coremem_size > serial_info->size)
+      return;
+   tail_size   = serial_info->size - head_size - coremem_size;
+   blocks      = (coremem_size + NETPLAY_DELTA_BLOCK_SIZE - 1)
+      / NETPLAY_DELTA_BLOCK_SIZE;
+   bitmap_size = (blocks + 7) / 8;
+   crc         = 0;
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      size_t j, len, changed;
+      uint8_t *bitmap;
+      uint32_t header[10];
+      uint32_t rd, wn;
+      enum trans_stream_error error;
+      struct compression_transcoder *z        = NULL;
+      struct netplay_delta_base *base         = NULL;
+      struct netplay_connection *connection   = &netplay->connections[i];
+
+      if (!(connection->flags & NETPLAY_CONN_FLAG_DELTA_BASE))
+         continue;
+      connection->flags &= ~NETPLAY_CONN_FLAG_DELTA_BASE;
+
+      if (  (!(connection->flags & NETPLAY_CONN_FLAG_ACTIVE))
+         ||  (connection->mode < NETPLAY_CONNECTION_CONNECTED))
+         continue;
+
+      /* No common base, the full savestate will be sent instead */
+      if (!(base = netplay_delta_base_find(netplay,
+            connection->delta_base_frame, connection->delta_base_crc)))
+         continue;
+
+      if (!netplay_delta_base_hash(base))
+         continue;
+
+      z = (connection->compression_supported == NETPLAY_COMPRESSION_ZLIB)
+         ? &netplay->compress_zlib : &netplay->compress_nil;
+      if (!z->compression_backend)
+         continue;
+
+      if (!netplay_delta_buffer_reserve(netplay,
+            serial_info->size + bitmap_size))
+         return;
+
+      if (!crc)
+         crc = encoding_crc32(0L, coremem, coremem_size);
+
+      /* Head and tail of the savestate, then the changed blocks */
+      memcpy(netplay->delta_buffer, state, head_size);
+      memcpy(netplay->delta_buffer + head_size, coremem + coremem_size,
+         tail_size);
+      bitmap  = netplay->delta_buffer + head_size + tail_size;
+      memset(bitmap, 0, bitmap_size);
+      len     = head_size + tail_size + bitmap_size;
+      changed = 0;
+
+      for (j = 0; j < blocks; j++)
+      {
+         size_t offset    = j * NETPLAY_DELTA_BLOCK_SIZE;
+         size_t block_len = MIN(NETPLAY_DELTA_BLOCK_SIZE,
+            coremem_size - offset);
+
+         if (encoding_crc32(0L, coremem + offset, block_len)
+               == base->hashes[j])
+            continue;
+
+         bitmap[j >> 3] |= 1 << (j & 7);
+         memcpy(netplay->delta_buffer + len, coremem + offset, block_len);
+         len            += block_len;
+         changed++;
+      }
+
+      z->compression_backend->set_in(z->compression_stream,
+         netplay->delta_buffer, (uint32_t)len);
+      z->compression_backend->set_out(z->compression_stream,
+         netplay->zbuffer, (uint32_t)netplay->zbuffer_size);
+      if (     !z->compression_backend->trans(z->compression_stream, true,
+                  &rd, &wn, &error)
+            || (error != TRANS_STREAM_ERROR_NONE))
+      {
+         netplay_hangup(netplay, connection);
+         continue;
+      }
+
+      header[0] = htonl(NETPLAY_CMD_LOAD_SAVESTATE_DELTA);
+      header[1] = htonl(wn + 8*sizeof(uint32_t));
+      header[2] = htonl(netplay->run_frame_count);
+      header[3] = htonl(base->frame);
+      header[4] = htonl(connection->delta_base_crc);
+      header[5] = htonl(crc);
+      header[6] = htonl((uint32_t)head_size);
+      header[7] = htonl((uint32_t)coremem_size);
+      header[8] = htonl((uint32_t)tail_size);
+      header[9] = htonl(NETPLAY_DELTA_BLOCK_SIZE);
+
+      if (  !netplay_send(&connection->send_packet_buffer,
+              connection->fd, header, sizeof(header))
+         || !netplay_send(&connection->send_packet_buffer,
+              connection->fd, netplay->zbuffer, wn))
+      {
+         netplay_hangup(netplay, connection);
+         continue;
+      }
+
+      connection->flags |= NETPLAY_CONN_FLAG_DELTA_SENT;
+
+      RARCH_LOG("[Netplay] Sent savestate delta to %s: %u of %u blocks.\n",
+         connection->nick, (unsigned)changed, (unsigned)blocks);
+   }
+}
+
 /**
  * netplay_send_savestate
  * @netplay              : pointer to netplay object
@@ -7486,7 +8568,8 @@ static void netplay_send_savestate(netplay_t *netplay,
       {
          if ( (!(connection->flags & NETPLAY_CONN_FLAG_ACTIVE))
             ||  (connection->mode < NETPLAY_CONNECTION_CONNECTED)
-            ||  (connection->compression_supported != cx))
+            ||  (connection->compression_supported != cx)
+            ||  (connection->flags & NETPLAY_CONN_FLAG_DELTA_SENT))
             continue;
 
          if (  !netplay_send(&connection->send_packet_buffer,
@@ -7828,13 +8911,22 @@ void netplay_load_savestate(netplay_t *netplay,
    /* Don't send it if we're expected to be desynced. */
    if (!netplay->desync)
    {
-      /* Send this to every peer. */
+      size_t i;
+
+      /* Peers that still share a base state with us
+       * only need what changed since. */
+      netplay_send_savestate_deltas(netplay, serial_info);
+
+      /* Send this to every other peer. */
       if (netplay->compress_nil.compression_backend)
          netplay_send_savestate(netplay, serial_info, 0,
             &netplay->compress_nil, false);
       if (netplay->compress_zlib.compression_backend)
          netplay_send_savestate(netplay, serial_info, NETPLAY_COMPRESSION_ZLIB,
             &netplay->compress_zlib, false);
+
+      for (i = 0; i < netplay->connections_size; i++)
+         netplay->connections[i].flags &= ~NETPLAY_CONN_FLAG_DELTA_SENT;
    }
 }
 
@@ -8970,6 +10062,7 @@ static void netplay_post_frame(netplay_t *netplay)
    {
       netplay_update_unread_ptr(netplay);
       netplay_sync_input_post_frame(netplay, false);
+      netplay_frame_hash_poll(netplay);
    }
 
    for (i = 0; i < netplay->connections_size; i++)
@@ -9396,6 +10489,9 @@ bool netplay_reinit_serialization(void)
       netplay->zbuffer = NULL;
    }
 
+   /* Base states of the old size are of no use anymore */
+   netplay_delta_bases_free(netplay);
+
    return netplay_init_serialization(netplay);
 }
 
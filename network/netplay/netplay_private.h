@@ -50,6 +50,12 @@
 #define RETRY_MS                   500
 #define MAX_INPUT_DEVICES          16
 
+/* Connection header magics */
+#define NETPLAY_MAGIC 0x52414E50 /* RANP */
+#define FULL_MAGIC    0x46554C4C /* FULL */
+#define POKE_MAGIC    0x504F4B45 /* POKE */
+#define BANNED_MAGIC  0x44454E59 /* DENY */
+
 /* We allow only 32 clients to fit into a 32-bit bitmap */
 #define MAX_CLIENTS 32
 
@@ -79,6 +85,19 @@
 #define NETPLAY_COMPRESSION_SUPPORTED 0
 #endif
 
+/* Frame hash algorithms supported. These are advertised in the same
+ * handshake field as compression, which older peers mask away. */
+#define NETPLAY_HASH_XXH3 (1<<16)
+#define NETPLAY_HASH_SUPPORTED NETPLAY_HASH_XXH3
+
+/* Size of the chunks of core memory hashed with XXH3 */
+#define NETPLAY_HASH_CHUNK_SIZE 16384
+
+/* Savestate deltas are made of blocks of core memory of this size,
+ * against one of the last few states whose CRC both sides agreed on */
+#define NETPLAY_DELTA_BLOCK_SIZE 1024
+#define NETPLAY_DELTA_BASES      2
+
 /* The keys supported by netplay */
 enum netplay_keys
 {
@@ -165,6 +184,18 @@ enum netplay_cmd
    /* Send a network packet from the raw packet core interface */
    NETPLAY_CMD_NETPACKET      = 0x0048,
 
+   /* Send a savestate as the blocks of core memory that changed
+    * since a base state both sides hold (protocol 8 and higher) */
+   NETPLAY_CMD_LOAD_SAVESTATE_DELTA = 0x0049,
+
+   /* Send the hash of each chunk of a frame's core memory,
+    * replacing NETPLAY_CMD_CRC when both sides support XXH3 */
+   NETPLAY_CMD_FRAME_HASH     = 0x004A,
+
+   /* Report the first chunk of core memory that did not match
+    * NETPLAY_CMD_FRAME_HASH, for the server to log */
+   NETPLAY_CMD_FRAME_HASH_MISMATCH = 0x004B,
+
    /* Misc. commands */
 
    /* Sends multiple config requests over,
@@ -268,6 +299,17 @@ enum rarch_netplay_stall_reason
    NETPLAY_STALL_SERVER_REQUESTED
 };
 
+/* How the state of check frames is hashed */
+enum netplay_frame_hash
+{
+   /* CRC-32 of the whole core memory, sent with NETPLAY_CMD_CRC */
+   NETPLAY_FRAME_HASH_CRC32 = 0,
+
+   /* XXH3 of each chunk of core memory, computed on a helper
+    * thread and sent with NETPLAY_CMD_FRAME_HASH */
+   NETPLAY_FRAME_HASH_XXH3
+};
+
 enum netplay_modus
 {
    /* Netplay operates by having all participants send input data every
@@ -364,7 +406,11 @@ enum netplay_connection_flags
    /* Is this connection allowed to play (server only)? */
    NETPLAY_CONN_FLAG_CAN_PLAY       = (1 << 2),
    /* Did we request a ping response? */
-   NETPLAY_CONN_FLAG_PING_REQUESTED = (1 << 3)
+   NETPLAY_CONN_FLAG_PING_REQUESTED = (1 << 3),
+   /* Did this peer name a base state for savestate deltas? */
+   NETPLAY_CONN_FLAG_DELTA_BASE     = (1 << 4),
+   /* Has this peer already been sent the current savestate as a delta? */
+   NETPLAY_CONN_FLAG_DELTA_SENT     = (1 << 5)
 };
 
 /* Each connection gets a connection struct */
@@ -405,6 +451,11 @@ struct netplay_connection
       too slow? */
    uint32_t stall_slow;
 
+   /* The base state this peer asked savestates to be sent against,
+    * identified by its frame and CRC */
+   uint32_t delta_base_frame;
+   uint32_t delta_base_crc;
+
    /* What latency is this connection running on?
     * Network latency has limited precision as we estimate it
     * once every pre-frame. */
@@ -419,12 +470,35 @@ struct netplay_connection
    /* Is this connection stalling? */
    enum rarch_netplay_stall_reason stall;
 
+   /* How check frames are hashed for this peer */
+   enum netplay_frame_hash frame_hash;
+
    uint8_t flags;
 
    /* Nickname of peer */
    char nick[NETPLAY_NICK_LEN];
 };
 
+/* A copy of the core memory of a frame whose CRC was
+ * checked by both sides, used as a base for savestate deltas */
+struct netplay_delta_base
+{
+   uint8_t *coremem;
+   /* CRC-32 of each block of coremem, computed once a client
+    * asks for a delta against this base (server only) */
+   uint32_t *hashes;
+   size_t size;
+   uint32_t frame;
+   /* The frame's CRC-32 and digest of its XXH3 chunk hashes,
+    * whichever were checked, else 0 */
+   uint32_t crc;
+   uint32_t hash;
+   bool hashed;
+   bool valid;
+};
+
+struct netplay_frame_hasher;
+
 /* Compression transcoder */
 struct compression_transcoder
 {
@@ -522,9 +596,20 @@ struct netplay
    /* A buffer into which to compress frames for transfer */
    uint8_t *zbuffer;
 
+   /* Base states for savestate deltas, and the buffer in
+    * which deltas are built and decompressed */
+   struct netplay_delta_base delta_bases[NETPLAY_DELTA_BASES];
+   uint8_t *delta_buffer;
+
+   /* Hashes check frames for peers using NETPLAY_FRAME_HASH_XXH3 */
+   struct netplay_frame_hasher *hasher;
+
    size_t connections_size;
    size_t buffer_size;
    size_t zbuffer_size;
+   size_t delta_buffer_size;
+   /* The next entry of delta_bases to replace */
+   size_t delta_base_ptr;
    /* The size of our packet buffers */
    size_t packet_buffer_size;
    /* Size of savestates (coremem_size + cheevos_size + headers) */
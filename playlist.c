@@ -25,11 +25,24 @@
 #include <compat/posix_string.h>
 #include <string/stdstring.h>
 #include <streams/interface_stream.h>
+#include <streams/file_stream.h>
+#include <encodings/crc32.h>
 #include <file/file_path.h>
 #include <file/archive_file.h>
 #include <lists/string_list.h>
 #include <formats/rjson.h>
 #include <array/rbuf.h>
+#include <memmap.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#if defined(HAVE_MMAN) && !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#define HAVE_PLAYLIST_CACHE
+#endif
 
 #include "playlist.h"
 #include "verbosity.h"
@@ -47,6 +60,22 @@
 #define WINDOWS_PATH_DELIMITER '\\'
 #define POSIX_PATH_DELIMITER '/'
 
+#define PLAYLIST_JOURNAL_MAGIC        0x4A4C5052 /* 'RPLJ' */
+#define PLAYLIST_JOURNAL_VERSION      1
+#define PLAYLIST_JOURNAL_HEADER_SIZE  8
+/* Record header: length and CRC32 of the payload */
+#define PLAYLIST_JOURNAL_RECORD_SIZE  8
+/* Payload header: sequence number, op and entry index */
+#define PLAYLIST_JOURNAL_PAYLOAD_SIZE 13
+#define PLAYLIST_JOURNAL_NULL         0xFFFFFFFF
+/* Once the journal grows past this size, it is folded
+ * back into the playlist file */
+#define PLAYLIST_JOURNAL_COMPACT_SIZE (64 * 1024)
+
+#define PLAYLIST_CACHE_MAGIC          0x43504C52 /* 'RLPC' */
+#define PLAYLIST_CACHE_VERSION        1
+#define PLAYLIST_CACHE_NULL           0xFFFFFFFF
+
 /* Holds all configuration parameters required
  * to repeat a manual content scan for a
  * previously manual-scan-generated playlist */
@@ -61,12 +90,160 @@ typedef struct
    bool overwrite_playlist;
 } playlist_manual_scan_record_t;
 
+/* Open addressing (linear probing) table slot.
+ * A hash of 0 marks an empty slot; playlist_path_hash()
+ * never returns it */
+typedef struct
+{
+   size_t pos;
+   uint32_t hash;
+} playlist_path_slot_t;
+
+/* Hash index of entry positions, keyed on the real path
+ * hash and (for archives) the parent archive hash.
+ * Positions are stored relative to 'shift', so pushing an
+ * entry to the top of the playlist doesn't renumber the
+ * rest. Deleting, sorting or changing paths marks it stale;
+ * it is rebuilt on the next lookup. */
+typedef struct
+{
+   playlist_path_slot_t *real_slots;
+   playlist_path_slot_t *archive_slots;
+   size_t cap;   /* Slots per table, power of two */
+   size_t count;
+   size_t shift;
+   bool valid;
+} playlist_path_index_t;
+
+/* Changes recorded in the playlist journal. Every
+ * record carries a sequence number; the playlist file
+ * stores the last one it includes, so that only newer
+ * records are replayed on load */
+enum playlist_journal_op
+{
+   PLAYLIST_JOURNAL_OP_PUSH = 0, /* Insert entry at the top */
+   PLAYLIST_JOURNAL_OP_MOVE,     /* Move entry to the top */
+   PLAYLIST_JOURNAL_OP_SET,      /* Replace entry values */
+   PLAYLIST_JOURNAL_OP_DELETE
+};
+
+#ifdef HAVE_THREADS
+/* Playlist file snapshot, written out by a
+ * background thread */
+typedef struct
+{
+   char *data;
+   slock_t *lock;
+   size_t len;
+   bool compress;
+   bool done;
+   bool success;
+   char path[PATH_MAX_LENGTH];
+} playlist_journal_compact_t;
+#endif
+
+typedef struct
+{
+   uint8_t *pending; /* RBUF: records not yet written */
+   uint8_t *tail;    /* RBUF: records written during compaction */
+#ifdef HAVE_THREADS
+   sthread_t *compact_thread;
+   playlist_journal_compact_t *compact;
+#endif
+   uint64_t seq;     /* Sequence number of last record */
+   size_t size;      /* Size of journal file */
+   bool trim;        /* Keep only 'tail' after compaction */
+} playlist_journal_t;
+
+#ifdef HAVE_PLAYLIST_CACHE
+/* Binary playlist cache, stored next to the playlist
+ * file. Layout: header, entry records, subsystem ROM
+ * string offsets, string pool. Strings are stored as
+ * offsets into the pool. Values are native endian,
+ * the cache is only ever read on the machine that
+ * wrote it */
+typedef struct
+{
+   uint32_t magic;
+   uint32_t version;
+   uint64_t file_size;  /* Size and modification time */
+   int64_t file_mtime;  /* of the cached playlist file */
+   uint64_t journal_seq;
+   uint32_t entry_count;
+   uint32_t rom_count;
+   uint32_t pool_size;
+   uint32_t flags;      /* OLD_FMT and COMPRESSED only */
+   uint32_t default_core_path;
+   uint32_t default_core_name;
+   uint32_t base_content_directory;
+   uint32_t scan_content_dir;
+   uint32_t scan_file_exts;
+   uint32_t scan_dat_file_path;
+   uint32_t scan_flags;
+   uint32_t label_display_mode;
+   uint32_t right_thumbnail_mode;
+   uint32_t left_thumbnail_mode;
+   uint32_t thumbnail_match_mode;
+   uint32_t sort_mode;
+} playlist_cache_header_t;
+
+typedef struct
+{
+   uint32_t path;
+   uint32_t label;
+   uint32_t core_path;
+   uint32_t core_name;
+   uint32_t crc32;
+   uint32_t db_name;
+   uint32_t subsystem_ident;
+   uint32_t subsystem_name;
+   uint32_t roms_start;
+   uint32_t roms_count;
+   uint32_t entry_slot;
+   uint32_t runtime_hours;
+   uint32_t runtime_minutes;
+   uint32_t runtime_seconds;
+   uint32_t last_played_year;
+   uint32_t last_played_month;
+   uint32_t last_played_day;
+   uint32_t last_played_hour;
+   uint32_t last_played_minute;
+   uint32_t last_played_second;
+} playlist_cache_entry_t;
+
+enum playlist_cache_scan_flags
+{
+   PLAYLIST_CACHE_SCAN_RECURSIVE = (1 << 0),
+   PLAYLIST_CACHE_SCAN_ARCHIVES  = (1 << 1),
+   PLAYLIST_CACHE_SCAN_FILTER    = (1 << 2),
+   PLAYLIST_CACHE_SCAN_OVERWRITE = (1 << 3)
+};
+#endif
+
+/* Mapped cache file backing the entry strings of
+ * a freshly loaded playlist. Entry strings are copied
+ * out before the first change to any entry; the
+ * mapping itself is kept until the playlist is freed,
+ * since callers may still hold pointers into it */
+typedef struct
+{
+   void *data;
+   const char *pool;
+   size_t size;
+   size_t pool_size;
+   bool attached;  /* Entries point into the pool */
+} playlist_cache_t;
+
 enum content_playlist_flags
 {
    CNT_PLAYLIST_FLG_MOD        = (1 << 0),
    CNT_PLAYLIST_FLG_OLD_FMT    = (1 << 1),
    CNT_PLAYLIST_FLG_COMPRESSED = (1 << 2),
-   CNT_PLAYLIST_FLG_CACHED_EXT = (1 << 3)
+   CNT_PLAYLIST_FLG_CACHED_EXT = (1 << 3),
+   /* Entries were reordered or cleared without being
+    * journaled, or there is no playlist file to journal
+    * against yet - the next write must be a full one */
+   CNT_PLAYLIST_FLG_JOURNAL_STALE = (1 << 4)
 };
 
 struct content_playlist
@@ -78,6 +255,9 @@ struct content_playlist
    struct playlist_entry *entries;
 
    playlist_manual_scan_record_t scan_record; /* ptr alignment */
+   playlist_path_index_t path_index;          /* ptr alignment */
+   playlist_journal_t journal;                /* ptr alignment */
+   playlist_cache_t cache;                    /* ptr alignment */
    playlist_config_t config;                  /* size_t alignment */
 
    enum playlist_label_display_mode label_display_mode;
@@ -107,6 +287,7 @@ typedef struct
    enum playlist_thumbnail_match_mode *current_meta_thumbnail_match_mode_val;
    enum playlist_sort_mode *current_meta_sort_mode_val;
    bool *current_meta_bool_val;
+   uint64_t *current_meta_seq_val;
    playlist_t *playlist;
 
    unsigned array_depth;
@@ -181,6 +362,8 @@ bool playlist_config_copy(const playlist_config_t *src,
    dst->capacity            = src->capacity;
    dst->old_format          = src->old_format;
    dst->compress            = src->compress;
+   dst->journal             = src->journal;
+   dst->cache               = src->cache;
    dst->fuzzy_archive_match = src->fuzzy_archive_match;
    dst->autofix_paths       = src->autofix_paths;
 
@@ -489,6 +672,247 @@ static bool playlist_path_matches_entry(playlist_path_id_t *path_id,
    return false;
 }
 
+static bool playlist_path_id_is_indexed(const playlist_path_id_t *path_id)
+{
+   return path_id && !string_is_empty(path_id->real_path);
+}
+
+static void playlist_path_index_free(playlist_path_index_t *index)
+{
+   if (index->real_slots)
+      free(index->real_slots);
+   if (index->archive_slots)
+      free(index->archive_slots);
+   index->real_slots    = NULL;
+   index->archive_slots = NULL;
+   index->cap           = 0;
+   index->count         = 0;
+   index->shift         = 0;
+   index->valid         = false;
+}
+
+static void playlist_path_index_insert(playlist_path_slot_t *slots,
+      size_t mask, uint32_t hash, size_t pos)
+{
+   size_t i = hash & mask;
+   while (slots[i].hash)
+      i = (i + 1) & mask;
+   slots[i].hash = hash;
+   slots[i].pos  = pos;
+}
+
+/* Rewrites the position of the slot holding 'old_pos' */
+static void playlist_path_index_relabel(playlist_path_slot_t *slots,
+      size_t mask, uint32_t hash, size_t old_pos, size_t new_pos)
+{
+   size_t i = hash & mask;
+   while (slots[i].hash)
+   {
+      if (slots[i].hash == hash && slots[i].pos == old_pos)
+      {
+         slots[i].pos = new_pos;
+         return;
+      }
+      i = (i + 1) & mask;
+   }
+}
+
+/**
+ * playlist_path_index_add:
+ * @playlist          : Playlist handle.
+ * @path_id           : Path ID of the entry.
+ * @idx               : Position of the entry.
+ *
+ * Adds an entry to the index, marking the index
+ * stale instead if it is getting too full.
+ **/
+static void playlist_path_index_add(playlist_t *playlist,
+      const playlist_path_id_t *path_id, size_t idx)
+{
+   playlist_path_index_t *index = &playlist->path_index;
+   size_t mask                  = index->cap - 1;
+
+   if (!index->valid || !playlist_path_id_is_indexed(path_id))
+      return;
+
+   if ((index->count + 1) * 2 > index->cap)
+   {
+      index->valid = false;
+      return;
+   }
+
+   playlist_path_index_insert(index->real_slots, mask,
+         path_id->real_path_hash, idx - index->shift);
+   if (!string_is_empty(path_id->archive_path))
+      playlist_path_index_insert(index->archive_slots, mask,
+            path_id->archive_path_hash, idx - index->shift);
+   index->count++;
+}
+
+/* Call right before inserting a new entry at the top */
+static void playlist_path_index_push_front(playlist_t *playlist,
+      const playlist_path_id_t *path_id)
+{
+   playlist->path_index.shift++;
+   playlist_path_index_add(playlist, path_id, 0);
+}
+
+/**
+ * playlist_path_index_move_to_front:
+ * @playlist          : Playlist handle.
+ * @idx               : Position of the entry to move.
+ *
+ * Updates the index for moving the entry at 'idx' to the
+ * top, shifting the ones before it down by one. Call
+ * before moving the entries.
+ **/
+static void playlist_path_index_move_to_front(playlist_t *playlist,
+      size_t idx)
+{
+   size_t i;
+   playlist_path_index_t *index = &playlist->path_index;
+   size_t mask                  = index->cap - 1;
+   /* Parks the moved entry out of the way while the
+    * others are relabelled */
+   size_t parked                = (size_t)-1 - index->shift;
+
+   if (!index->valid)
+      return;
+
+   for (i = idx + 1; i-- > 0;)
+   {
+      const playlist_path_id_t *path_id = playlist->entries[i].path_id;
+      size_t new_pos = (i == idx) ? parked : i + 1 - index->shift;
+
+      if (!playlist_path_id_is_indexed(path_id))
+         continue;
+
+      playlist_path_index_relabel(index->real_slots, mask,
+            path_id->real_path_hash, i - index->shift, new_pos);
+      if (!string_is_empty(path_id->archive_path))
+         playlist_path_index_relabel(index->archive_slots, mask,
+               path_id->archive_path_hash, i - index->shift, new_pos);
+   }
+
+   {
+      const playlist_path_id_t *path_id = playlist->entries[idx].path_id;
+      if (!playlist_path_id_is_indexed(path_id))
+         return;
+      playlist_path_index_relabel(index->real_slots, mask,
+            path_id->real_path_hash, parked, 0 - index->shift);
+      if (!string_is_empty(path_id->archive_path))
+         playlist_path_index_relabel(index->archive_slots, mask,
+               path_id->archive_path_hash, parked, 0 - index->shift);
+   }
+}
+
+static bool playlist_path_index_rebuild(playlist_t *playlist)
+{
+   size_t i;
+   playlist_path_index_t *index = &playlist->path_index;
+   size_t _len                  = RBUF_LEN(playlist->entries);
+   size_t cap                   = 64;
+
+   /* Leave room for the playlist to double in size */
+   while (cap < _len * 4)
+      cap <<= 1;
+
+   playlist_path_index_free(index);
+
+   if (   !(index->real_slots    = (playlist_path_slot_t*)
+            calloc(cap, sizeof(playlist_path_slot_t)))
+       || !(index->archive_slots = (playlist_path_slot_t*)
+            calloc(cap, sizeof(playlist_path_slot_t))))
+   {
+      playlist_path_index_free(index);
+      return false;
+   }
+
+   index->cap   = cap;
+   index->valid = true;
+
+   for (i = 0; i < _len; i++)
+   {
+      struct playlist_entry *entry = &playlist->entries[i];
+      if (!entry->path_id && !string_is_empty(entry->path))
+         entry->path_id = playlist_path_id_init(entry->path);
+      playlist_path_index_add(playlist, entry->path_id, i);
+   }
+
+   return true;
+}
+
+/**
+ * playlist_find_path:
+ * @playlist          : Playlist handle.
+ * @path_id           : Path ID to search for.
+ * @from              : First position to consider.
+ *
+ * Finds the first entry at or after 'from' matching
+ * 'path_id' (or with an empty path, if 'path_id' is empty).
+ *
+ * Returns: position of the entry, or the playlist size
+ * if there is none.
+ **/
+static size_t playlist_find_path(playlist_t *playlist,
+      playlist_path_id_t *path_id, size_t from)
+{
+   size_t i, mask;
+   playlist_path_index_t *index = &playlist->path_index;
+   size_t _len                  = RBUF_LEN(playlist->entries);
+   size_t best                  = _len;
+
+   if (!playlist_path_id_is_indexed(path_id))
+   {
+      for (i = from; i < _len; i++)
+         if (string_is_empty(playlist->entries[i].path))
+            return i;
+      return _len;
+   }
+
+   if (!index->valid && !playlist_path_index_rebuild(playlist))
+   {
+      for (i = from; i < _len; i++)
+         if (playlist_path_matches_entry(path_id,
+               &playlist->entries[i], &playlist->config))
+            return i;
+      return _len;
+   }
+
+   mask = index->cap - 1;
+
+   for (i = path_id->real_path_hash & mask; index->real_slots[i].hash;
+         i = (i + 1) & mask)
+   {
+      size_t pos = index->real_slots[i].pos + index->shift;
+      if (   (index->real_slots[i].hash == path_id->real_path_hash)
+          && (pos >= from)
+          && (pos <  best)
+          && playlist_path_matches_entry(path_id,
+               &playlist->entries[pos], &playlist->config))
+         best = pos;
+   }
+
+   /* Archive files and files inside them may match each
+    * other (see playlist_path_matches_entry()) */
+   if (string_is_empty(path_id->archive_path))
+      return best;
+
+   for (i = path_id->archive_path_hash & mask; index->archive_slots[i].hash;
+         i = (i + 1) & mask)
+   {
+      size_t pos = index->archive_slots[i].pos + index->shift;
+      if (   (index->archive_slots[i].hash == path_id->archive_path_hash)
+          && (pos >= from)
+          && (pos <  best)
+          && playlist_path_matches_entry(path_id,
+               &playlist->entries[pos], &playlist->config))
+         best = pos;
+   }
+
+   return best;
+}
+
 /**
  * playlist_core_path_equal:
  * @real_core_path  : 'Real' search path, generated by path_resolve_realpath()
@@ -629,6 +1053,209 @@ static void playlist_free_entry(struct playlist_entry *entry)
    entry->last_played_second = 0;
 }
 
+static char *playlist_cache_release_str(const playlist_t *playlist,
+      char *str, bool copy)
+{
+   if (     (str >= playlist->cache.pool)
+         && (str <  playlist->cache.pool + playlist->cache.pool_size))
+      return copy ? strdup(str) : NULL;
+   return str;
+}
+
+/**
+ * playlist_cache_release:
+ * @playlist            : Playlist handle.
+ * @copy                : Copy entry strings out of the cache.
+ *
+ * Detaches playlist entries from the binary cache.
+ * Must be called before entries are changed or freed.
+ * If @copy is false, cached strings are dropped instead
+ * (only valid when freeing the playlist).
+ **/
+static void playlist_cache_release(playlist_t *playlist, bool copy)
+{
+   size_t i, _len;
+
+   if (!playlist->cache.attached)
+      return;
+
+   for (i = 0, _len = RBUF_LEN(playlist->entries); i < _len; i++)
+   {
+      struct playlist_entry *entry = &playlist->entries[i];
+      entry->path            = playlist_cache_release_str(playlist, entry->path,            copy);
+      entry->label           = playlist_cache_release_str(playlist, entry->label,           copy);
+      entry->core_path       = playlist_cache_release_str(playlist, entry->core_path,       copy);
+      entry->core_name       = playlist_cache_release_str(playlist, entry->core_name,       copy);
+      entry->crc32           = playlist_cache_release_str(playlist, entry->crc32,           copy);
+      entry->db_name         = playlist_cache_release_str(playlist, entry->db_name,         copy);
+      entry->subsystem_ident = playlist_cache_release_str(playlist, entry->subsystem_ident, copy);
+      entry->subsystem_name  = playlist_cache_release_str(playlist, entry->subsystem_name,  copy);
+   }
+
+   playlist->cache.attached = false;
+}
+
+static void playlist_cache_get_path(const playlist_t *playlist,
+      char *s, size_t len)
+{
+   size_t _len = strlcpy(s, playlist->config.path, len);
+   strlcpy(s + _len, FILE_PATH_LPL_CACHE_EXTENSION, len - _len);
+}
+
+/* Called whenever the playlist file itself is rewritten;
+ * file modification times only have a resolution of one
+ * second, so a stale cache cannot always be detected */
+static void playlist_cache_delete(const playlist_t *playlist)
+{
+   char cache_path[PATH_MAX_LENGTH];
+   playlist_cache_get_path(playlist, cache_path, sizeof(cache_path));
+   if (path_is_valid(cache_path))
+      filestream_delete(cache_path);
+}
+
+static void playlist_journal_get_path(const playlist_t *playlist,
+      char *s, size_t len)
+{
+   size_t _len = strlcpy(s, playlist->config.path, len);
+   strlcpy(s + _len, FILE_PATH_LPL_JOURNAL_EXTENSION, len - _len);
+}
+
+static void playlist_journal_set_u32(uint8_t *data, uint32_t val)
+{
+   data[0] = (uint8_t)(val);
+   data[1] = (uint8_t)(val >> 8);
+   data[2] = (uint8_t)(val >> 16);
+   data[3] = (uint8_t)(val >> 24);
+}
+
+static uint32_t playlist_journal_get_u32(const uint8_t *data)
+{
+   return  (uint32_t)data[0]
+         | ((uint32_t)data[1] << 8)
+         | ((uint32_t)data[2] << 16)
+         | ((uint32_t)data[3] << 24);
+}
+
+static bool playlist_journal_put(uint8_t **buf,
+      const void *data, size_t len)
+{
+   size_t _len = RBUF_LEN(*buf);
+   if (!RBUF_TRYFIT(*buf, _len + len))
+      return false;
+   RBUF_RESIZE(*buf, _len + len);
+   memcpy(*buf + _len, data, len);
+   return true;
+}
+
+static bool playlist_journal_put_u32(uint8_t **buf, uint32_t val)
+{
+   uint8_t data[4];
+   playlist_journal_set_u32(data, val);
+   return playlist_journal_put(buf, data, sizeof(data));
+}
+
+static bool playlist_journal_put_str(uint8_t **buf, const char *str)
+{
+   uint32_t _len;
+   if (!str)
+      return playlist_journal_put_u32(buf, PLAYLIST_JOURNAL_NULL);
+   _len = (uint32_t)strlen(str);
+   return playlist_journal_put_u32(buf, _len)
+       && playlist_journal_put(buf, str, _len);
+}
+
+/* Serialises the entry values that are saved in
+ * the playlist file */
+static bool playlist_journal_put_entry(uint8_t **buf,
+      const struct playlist_entry *entry)
+{
+   size_t i;
+
+   if (     !playlist_journal_put_str(buf, entry->path)
+         || !playlist_journal_put_str(buf, entry->label)
+         || !playlist_journal_put_str(buf, entry->core_path)
+         || !playlist_journal_put_str(buf, entry->core_name)
+         || !playlist_journal_put_str(buf, entry->crc32)
+         || !playlist_journal_put_str(buf, entry->db_name)
+         || !playlist_journal_put_str(buf, entry->subsystem_ident)
+         || !playlist_journal_put_str(buf, entry->subsystem_name)
+         || !playlist_journal_put_u32(buf, entry->entry_slot)
+         || !playlist_journal_put_u32(buf, entry->subsystem_roms
+               ? (uint32_t)entry->subsystem_roms->size
+               : PLAYLIST_JOURNAL_NULL))
+      return false;
+
+   if (entry->subsystem_roms)
+   {
+      for (i = 0; i < entry->subsystem_roms->size; i++)
+         if (!playlist_journal_put_str(buf,
+                  entry->subsystem_roms->elems[i].data))
+            return false;
+   }
+
+   return true;
+}
+
+/**
+ * playlist_journal_record:
+ * @playlist            : Playlist handle.
+ * @op                  : Journal operation.
+ * @idx                 : Index of affected playlist entry.
+ *
+ * Queues a journal record for a change that has just
+ * been made to the playlist. If the change cannot be
+ * journaled, flags the playlist for a full write instead.
+ **/
+static void playlist_journal_record(playlist_t *playlist,
+      enum playlist_journal_op op, size_t idx)
+{
+   uint8_t head[PLAYLIST_JOURNAL_RECORD_SIZE
+         + PLAYLIST_JOURNAL_PAYLOAD_SIZE];
+   size_t i, start, _len;
+   uint64_t seq = playlist->journal.seq + 1;
+
+   /* Nothing to gain if a full write is due anyway */
+   if (     !playlist->config.journal
+         ||  playlist->config.old_format
+         ||  (playlist->flags & (CNT_PLAYLIST_FLG_MOD
+                               | CNT_PLAYLIST_FLG_JOURNAL_STALE)))
+      goto full;
+
+   /* Length and CRC are filled in once the
+    * payload is complete */
+   memset(head, 0, PLAYLIST_JOURNAL_RECORD_SIZE);
+   for (i = 0; i < 8; i++)
+      head[PLAYLIST_JOURNAL_RECORD_SIZE + i] = (uint8_t)(seq >> (i * 8));
+   head[PLAYLIST_JOURNAL_RECORD_SIZE + 8] = (uint8_t)op;
+   playlist_journal_set_u32(head + PLAYLIST_JOURNAL_RECORD_SIZE + 9,
+         (uint32_t)idx);
+
+   start = RBUF_LEN(playlist->journal.pending);
+   if (     !playlist_journal_put(&playlist->journal.pending,
+               head, sizeof(head))
+         || (   (op == PLAYLIST_JOURNAL_OP_PUSH || op == PLAYLIST_JOURNAL_OP_SET)
+             && !playlist_journal_put_entry(&playlist->journal.pending,
+                  &playlist->entries[idx])))
+   {
+      RBUF_RESIZE(playlist->journal.pending, start);
+      goto full;
+   }
+
+   _len = RBUF_LEN(playlist->journal.pending)
+      - start - PLAYLIST_JOURNAL_RECORD_SIZE;
+   playlist_journal_set_u32(playlist->journal.pending + start,
+         (uint32_t)_len);
+   playlist_journal_set_u32(playlist->journal.pending + start + 4,
+         encoding_crc32(0, playlist->journal.pending + start
+            + PLAYLIST_JOURNAL_RECORD_SIZE, _len));
+
+   playlist->journal.seq = seq;
+   return;
+
+full:
+   playlist->flags |= CNT_PLAYLIST_FLG_MOD;
+}
+
 /**
  * playlist_delete_index:
  * @playlist            : Playlist handle.
@@ -649,6 +1276,8 @@ void playlist_delete_index(playlist_t *playlist,
    if (idx >= _len)
       return;
 
+   playlist_cache_release(playlist, true);
+
    /* Free unwanted entry */
    entry_to_delete = (struct playlist_entry *)(playlist->entries + idx);
    if (entry_to_delete)
@@ -660,7 +1289,8 @@ void playlist_delete_index(playlist_t *playlist,
 
    RBUF_RESIZE(playlist->entries, _len - 1);
 
-   playlist->flags |= CNT_PLAYLIST_FLG_MOD;
+   playlist->path_index.valid = false;
+   playlist_journal_record(playlist, PLAYLIST_JOURNAL_OP_DELETE, idx);
 }
 
 /**
@@ -707,7 +1337,7 @@ void playlist_get_index_by_path(playlist_t *playlist,
       const struct playlist_entry **entry)
 {
    playlist_path_id_t *path_id = NULL;
-   size_t i, len;
+   size_t i;
 
    if (!playlist || !entry || string_is_empty(search_path))
       return;
@@ -715,15 +1345,10 @@ void playlist_get_index_by_path(playlist_t *playlist,
    if (!(path_id = playlist_path_id_init(search_path)))
       return;
 
-   for (i = 0, len = RBUF_LEN(playlist->entries); i < len; i++)
-   {
-      if (!playlist_path_matches_entry(path_id,
-            &playlist->entries[i], &playlist->config))
-         continue;
-
+   if (     playlist_path_id_is_indexed(path_id)
+         && (i = playlist_find_path(playlist, path_id, 0))
+            < RBUF_LEN(playlist->entries))
       *entry = &playlist->entries[i];
-      break;
-   }
 
    playlist_path_id_free(path_id);
 }
@@ -731,8 +1356,8 @@ void playlist_get_index_by_path(playlist_t *playlist,
 bool playlist_entry_exists(playlist_t *playlist,
       const char *path)
 {
+   bool ret;
    playlist_path_id_t *path_id = NULL;
-   size_t i, len;
 
    if (!playlist || string_is_empty(path))
       return false;
@@ -740,28 +1365,24 @@ bool playlist_entry_exists(playlist_t *playlist,
    if (!(path_id = playlist_path_id_init(path)))
       return false;
 
-   for (i = 0, len = RBUF_LEN(playlist->entries); i < len; i++)
-   {
-      if (playlist_path_matches_entry(path_id,
-            &playlist->entries[i], &playlist->config))
-      {
-         playlist_path_id_free(path_id);
-         return true;
-      }
-   }
+   ret = playlist_path_id_is_indexed(path_id)
+      && playlist_find_path(playlist, path_id, 0)
+         < RBUF_LEN(playlist->entries);
 
    playlist_path_id_free(path_id);
-   return false;
+   return ret;
 }
 
 void playlist_update(playlist_t *playlist, size_t idx,
       const struct playlist_entry *update_entry)
 {
    struct playlist_entry *entry = NULL;
+   bool updated                 = false;
 
    if (!playlist || idx >= RBUF_LEN(playlist->entries))
       return;
 
+   playlist_cache_release(playlist, true);
    entry            = &playlist->entries[idx];
 
    if (update_entry->path && (update_entry->path != entry->path))
@@ -775,8 +1396,9 @@ void playlist_update(playlist_t *playlist, size_t idx,
          playlist_path_id_free(entry->path_id);
          entry->path_id  = NULL;
       }
+      playlist->path_index.valid = false;
 
-      playlist->flags |= CNT_PLAYLIST_FLG_MOD;
+      updated            = true;
    }
 
    if (update_entry->label && (update_entry->label != entry->label))
@@ -784,7 +1406,7 @@ void playlist_update(playlist_t *playlist, size_t idx,
       if (entry->label)
          free(entry->label);
       entry->label       = strdup(update_entry->label);
-      playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
+      updated            = true;
    }
 
    if (update_entry->core_path && (update_entry->core_path != entry->core_path))
@@ -792,7 +1414,7 @@ void playlist_update(playlist_t *playlist, size_t idx,
       if (entry->core_path)
          free(entry->core_path);
       entry->core_path   = strdup(update_entry->core_path);
-      playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
+      updated            = true;
    }
 
    if (update_entry->core_name && (update_entry->core_name != entry->core_name))
@@ -800,7 +1422,7 @@ void playlist_update(playlist_t *playlist, size_t idx,
       if (entry->core_name)
          free(entry->core_name);
       entry->core_name   = strdup(update_entry->core_name);
-      playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
+      updated            = true;
    }
 
    if (update_entry->db_name && (update_entry->db_name != entry->db_name))
@@ -808,7 +1430,7 @@ void playlist_update(playlist_t *playlist, size_t idx,
       if (entry->db_name)
          free(entry->db_name);
       entry->db_name     = strdup(update_entry->db_name);
-      playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
+      updated            = true;
    }
 
    if (update_entry->crc32 && (update_entry->crc32 != entry->crc32))
@@ -816,8 +1438,11 @@ void playlist_update(playlist_t *playlist, size_t idx,
       if (entry->crc32)
          free(entry->crc32);
       entry->crc32       = strdup(update_entry->crc32);
-      playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
+      updated            = true;
    }
+
+   if (updated)
+      playlist_journal_record(playlist, PLAYLIST_JOURNAL_OP_SET, idx);
 }
 
 void playlist_update_runtime(playlist_t *playlist, size_t idx,
@@ -829,6 +1454,7 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
    if (!playlist || idx >= RBUF_LEN(playlist->entries))
       return;
 
+   playlist_cache_release(playlist, true);
    entry            = &playlist->entries[idx];
 
    if (update_entry->path && (update_entry->path != entry->path))
@@ -842,6 +1468,7 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
          playlist_path_id_free(entry->path_id);
          entry->path_id  = NULL;
       }
+      playlist->path_index.valid = false;
 
       if (register_update)
          playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
@@ -956,6 +1583,8 @@ bool playlist_push_runtime(playlist_t *playlist,
    if (!playlist || !entry)
       goto error;
 
+   playlist_cache_release(playlist, true);
+
    if (string_is_empty(entry->core_path))
    {
       RARCH_ERR("Cannot push NULL or empty core path into the playlist.\n");
@@ -980,17 +1609,10 @@ bool playlist_push_runtime(playlist_t *playlist,
    }
 
    len = RBUF_LEN(playlist->entries);
-   for (i = 0; i < len; i++)
+   for (i = playlist_find_path(playlist, path_id, 0); i < len;
+         i = playlist_find_path(playlist, path_id, i + 1))
    {
       struct playlist_entry tmp;
-      bool equal_path  = (string_is_empty(path_id->real_path)
-            && string_is_empty(playlist->entries[i].path));
-
-      equal_path       = equal_path || playlist_path_matches_entry(
-            path_id, &playlist->entries[i], &playlist->config);
-
-      if (!equal_path)
-         continue;
 
       /* Core name can have changed while still being the same core.
        * Differentiate based on the core path only. */
@@ -1003,6 +1625,7 @@ bool playlist_push_runtime(playlist_t *playlist,
          goto error;
 
       /* Seen it before, bump to top. */
+      playlist_path_index_move_to_front(playlist, i);
       tmp = playlist->entries[i];
       memmove(playlist->entries + 1, playlist->entries,
             i * sizeof(struct playlist_entry));
@@ -1018,6 +1641,7 @@ bool playlist_push_runtime(playlist_t *playlist,
    {
       struct playlist_entry *last_entry = &playlist->entries[len - 1];
       playlist_free_entry(last_entry);
+      playlist->path_index.valid        = false;
       len--;
    }
    else
@@ -1030,6 +1654,7 @@ bool playlist_push_runtime(playlist_t *playlist,
 
    if (playlist->entries)
    {
+      playlist_path_index_push_front(playlist, path_id);
       memmove(playlist->entries + 1, playlist->entries,
             len * sizeof(struct playlist_entry));
 
@@ -1315,6 +1940,8 @@ bool playlist_push(playlist_t *playlist,
    if (!playlist || !entry)
       goto error;
 
+   playlist_cache_release(playlist, true);
+
    if (string_is_empty(entry->core_path))
    {
       RARCH_ERR("Cannot push NULL or empty core path into the playlist.\n");
@@ -1354,17 +1981,10 @@ bool playlist_push(playlist_t *playlist,
    }
 
    _len = RBUF_LEN(playlist->entries);
-   for (i = 0; i < _len; i++)
+   for (i = playlist_find_path(playlist, path_id, 0); i < _len;
+         i = playlist_find_path(playlist, path_id, i + 1))
    {
       struct playlist_entry tmp;
-      bool equal_path  = (string_is_empty(path_id->real_path)
-                       && string_is_empty(playlist->entries[i].path));
-
-      equal_path       = equal_path || playlist_path_matches_entry(
-            path_id, &playlist->entries[i], &playlist->config);
-
-      if (!equal_path)
-         continue;
 
       /* Core name can have changed while still being the same core.
        * Differentiate based on the core path only. */
@@ -1464,17 +2084,24 @@ bool playlist_push(playlist_t *playlist,
       if (i == 0)
       {
          if (entry_updated)
+         {
+            playlist_journal_record(playlist, PLAYLIST_JOURNAL_OP_SET, 0);
             goto success;
+         }
 
          goto error;
       }
 
       /* Seen it before, bump to top. */
+      playlist_path_index_move_to_front(playlist, i);
       tmp = playlist->entries[i];
       memmove(playlist->entries + 1, playlist->entries,
             i * sizeof(struct playlist_entry));
       playlist->entries[0] = tmp;
 
+      playlist_journal_record(playlist, PLAYLIST_JOURNAL_OP_MOVE, i);
+      if (entry_updated)
+         playlist_journal_record(playlist, PLAYLIST_JOURNAL_OP_SET, 0);
       goto success;
    }
 
@@ -1485,6 +2112,7 @@ bool playlist_push(playlist_t *playlist,
    {
       struct playlist_entry *last_entry = &playlist->entries[_len - 1];
       playlist_free_entry(last_entry);
+      playlist->path_index.valid        = false;
       _len--;
    }
    else
@@ -1497,6 +2125,7 @@ bool playlist_push(playlist_t *playlist,
 
    if (playlist->entries)
    {
+      playlist_path_index_push_front(playlist, path_id);
       memmove(playlist->entries + 1, playlist->entries,
             _len * sizeof(struct playlist_entry));
 
@@ -1554,12 +2183,13 @@ bool playlist_push(playlist_t *playlist,
          for (i = 0; i < entry->subsystem_roms->size; i++)
             string_list_append(playlist->entries[0].subsystem_roms, entry->subsystem_roms->elems[i].data, attributes);
       }
+
+      playlist_journal_record(playlist, PLAYLIST_JOURNAL_OP_PUSH, 0);
    }
 
 success:
    if (path_id)
       playlist_path_id_free(path_id);
-   playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
    return true;
 
 error:
@@ -1725,397 +2355,740 @@ end:
    free(file);
 }
 
-void playlist_write_file(playlist_t *playlist)
+static void playlist_write_json(playlist_t *playlist,
+      rjsonwriter_t *writer)
 {
    size_t i, _len;
-   intfstream_t *file = NULL;
-   bool compressed    = false;
 
-   /* Playlist will be written if any of the
-    * following are true:
-    * > 'modified' flag is set
-    * > Current playlist format (old/new) does not
-    *   match requested
-    * > Current playlist compression status does
-    *   not match requested */
-   bool pl_compressed   = ((playlist->flags & CNT_PLAYLIST_FLG_COMPRESSED) > 0);
-   bool pl_old_fmt      = ((playlist->flags & CNT_PLAYLIST_FLG_OLD_FMT)    > 0);
+   rjsonwriter_raw(writer, "{", 1);
+   rjsonwriter_raw(writer, "\n", 1);
 
-   if (   !playlist
-       || !((playlist->flags & CNT_PLAYLIST_FLG_MOD)
-#if defined(HAVE_ZLIB)
-       || (pl_compressed != playlist->config.compress)
-#endif
-       || (pl_old_fmt    != playlist->config.old_format)))
-      return;
+   rjsonwriter_add_spaces(writer, 2);
+   rjsonwriter_add_string(writer, "version");
+   rjsonwriter_raw(writer, ":", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_add_string(writer, "1.5");
+   rjsonwriter_raw(writer, ",", 1);
+   rjsonwriter_raw(writer, "\n", 1);
 
-#if defined(HAVE_ZLIB)
-   if (playlist->config.compress)
-      file = intfstream_open_rzip_file(playlist->config.path,
-            RETRO_VFS_FILE_ACCESS_WRITE);
-   else
-#endif
-      file = intfstream_open_file(playlist->config.path,
-            RETRO_VFS_FILE_ACCESS_WRITE,
-            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   rjsonwriter_add_spaces(writer, 2);
+   rjsonwriter_add_string(writer, "default_core_path");
+   rjsonwriter_raw(writer, ":", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_add_string(writer, playlist->default_core_path);
+   rjsonwriter_raw(writer, ",", 1);
+   rjsonwriter_raw(writer, "\n", 1);
 
-   if (!file)
+   rjsonwriter_add_spaces(writer, 2);
+   rjsonwriter_add_string(writer, "default_core_name");
+   rjsonwriter_raw(writer, ":", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_add_string(writer, playlist->default_core_name);
+   rjsonwriter_raw(writer, ",", 1);
+   rjsonwriter_raw(writer, "\n", 1);
+
+   if (!string_is_empty(playlist->base_content_directory))
    {
-      RARCH_ERR("Failed to write to playlist file: \"%s\".\n", playlist->config.path);
-      return;
+      rjsonwriter_add_spaces(writer, 2);
+      rjsonwriter_add_string(writer, "base_content_directory");
+      rjsonwriter_raw(writer, ":", 1);
+      rjsonwriter_raw(writer, " ", 1);
+      rjsonwriter_add_string(writer, playlist->base_content_directory);
+      rjsonwriter_raw(writer, ",", 1);
+      rjsonwriter_raw(writer, "\n", 1);
    }
 
-   /* Get current file compression state */
-   compressed = intfstream_is_compressed(file);
+   rjsonwriter_add_spaces(writer, 2);
+   rjsonwriter_add_string(writer, "label_display_mode");
+   rjsonwriter_raw(writer, ":", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_rawf(writer, "%d", (int)playlist->label_display_mode);
+   rjsonwriter_raw(writer, ",", 1);
+   rjsonwriter_raw(writer, "\n", 1);
 
-#ifdef RARCH_INTERNAL
-   if (playlist->config.old_format)
-   {
-      for (i = 0, _len = RBUF_LEN(playlist->entries); i < _len; i++)
-         intfstream_printf(file, "%s\n%s\n%s\n%s\n%s\n%s\n",
-               playlist->entries[i].path      ? playlist->entries[i].path      : "",
-               playlist->entries[i].label     ? playlist->entries[i].label     : "",
-               playlist->entries[i].core_path ? playlist->entries[i].core_path : "",
-               playlist->entries[i].core_name ? playlist->entries[i].core_name : "",
-               playlist->entries[i].crc32     ? playlist->entries[i].crc32     : "",
-               playlist->entries[i].db_name   ? playlist->entries[i].db_name   : ""
-               );
+   rjsonwriter_add_spaces(writer, 2);
+   rjsonwriter_add_string(writer, "right_thumbnail_mode");
+   rjsonwriter_raw(writer, ":", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_rawf(writer, "%d", (int)playlist->right_thumbnail_mode);
+   rjsonwriter_raw(writer, ",", 1);
+   rjsonwriter_raw(writer, "\n", 1);
 
-      /* Add metadata lines
-       * > We add these at the end of the file to prevent
-       *   breakage if the playlist is loaded with an older
-       *   version of RetroArch */
-      intfstream_printf(
-            file,
-            "default_core_path = \"%s\"\n"
-            "default_core_name = \"%s\"\n"
-            "label_display_mode = \"%d\"\n"
-            "thumbnail_mode = \"%d|%d\"\n"
-            "sort_mode = \"%d\"\n",
-            playlist->default_core_path ? playlist->default_core_path : "",
-            playlist->default_core_name ? playlist->default_core_name : "",
-            playlist->label_display_mode,
-            playlist->right_thumbnail_mode, playlist->left_thumbnail_mode,
-            playlist->sort_mode);
+   rjsonwriter_add_spaces(writer, 2);
+   rjsonwriter_add_string(writer, "left_thumbnail_mode");
+   rjsonwriter_raw(writer, ":", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_rawf(writer, "%d", (int)playlist->left_thumbnail_mode);
+   rjsonwriter_raw(writer, ",", 1);
+   rjsonwriter_raw(writer, "\n", 1);
 
-      playlist->flags  |=  (CNT_PLAYLIST_FLG_OLD_FMT);
-   }
-   else
-#endif
-   {
-      rjsonwriter_t* writer = rjsonwriter_open_stream(file);
-      if (!writer)
-      {
-         RARCH_ERR("Failed to create JSON writer\n");
-         goto end;
-      }
-      /*  When compressing playlists, human readability
-       *   is not a factor - can skip all indentation
-       *   and new line characters */
-      if (compressed)
-         rjsonwriter_set_options(writer, RJSONWRITER_OPTION_SKIP_WHITESPACE);
+   rjsonwriter_add_spaces(writer, 2);
+   rjsonwriter_add_string(writer, "thumbnail_match_mode");
+   rjsonwriter_raw(writer, ":", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_rawf(writer, "%d", (int)playlist->thumbnail_match_mode);
+   rjsonwriter_raw(writer, ",", 1);
+   rjsonwriter_raw(writer, "\n", 1);
 
-      rjsonwriter_raw(writer, "{", 1);
-      rjsonwriter_raw(writer, "\n", 1);
+   rjsonwriter_add_spaces(writer, 2);
+   rjsonwriter_add_string(writer, "sort_mode");
+   rjsonwriter_raw(writer, ":", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_rawf(writer, "%d", (int)playlist->sort_mode);
+   rjsonwriter_raw(writer, ",", 1);
+   rjsonwriter_raw(writer, "\n", 1);
 
+   /* Last journal record included in this file. 0 is
+    * left for files written without a journal */
+   if (playlist->config.journal)
+   {
+      if (!playlist->journal.seq)
+         playlist->journal.seq = 1;
       rjsonwriter_add_spaces(writer, 2);
-      rjsonwriter_add_string(writer, "version");
+      rjsonwriter_add_string(writer, "journal_seq");
       rjsonwriter_raw(writer, ":", 1);
       rjsonwriter_raw(writer, " ", 1);
-      rjsonwriter_add_string(writer, "1.5");
+      rjsonwriter_rawf(writer, STRING_REP_UINT64, playlist->journal.seq);
       rjsonwriter_raw(writer, ",", 1);
       rjsonwriter_raw(writer, "\n", 1);
+   }
 
+   if (!string_is_empty(playlist->scan_record.content_dir))
+   {
       rjsonwriter_add_spaces(writer, 2);
-      rjsonwriter_add_string(writer, "default_core_path");
+      rjsonwriter_add_string(writer, "scan_content_dir");
       rjsonwriter_raw(writer, ":", 1);
       rjsonwriter_raw(writer, " ", 1);
-      rjsonwriter_add_string(writer, playlist->default_core_path);
+      rjsonwriter_add_string(writer, playlist->scan_record.content_dir);
       rjsonwriter_raw(writer, ",", 1);
       rjsonwriter_raw(writer, "\n", 1);
 
       rjsonwriter_add_spaces(writer, 2);
-      rjsonwriter_add_string(writer, "default_core_name");
+      rjsonwriter_add_string(writer, "scan_file_exts");
       rjsonwriter_raw(writer, ":", 1);
       rjsonwriter_raw(writer, " ", 1);
-      rjsonwriter_add_string(writer, playlist->default_core_name);
+      rjsonwriter_add_string(writer, playlist->scan_record.file_exts);
       rjsonwriter_raw(writer, ",", 1);
       rjsonwriter_raw(writer, "\n", 1);
 
-      if (!string_is_empty(playlist->base_content_directory))
-      {
-         rjsonwriter_add_spaces(writer, 2);
-         rjsonwriter_add_string(writer, "base_content_directory");
-         rjsonwriter_raw(writer, ":", 1);
-         rjsonwriter_raw(writer, " ", 1);
-         rjsonwriter_add_string(writer, playlist->base_content_directory);
-         rjsonwriter_raw(writer, ",", 1);
-         rjsonwriter_raw(writer, "\n", 1);
-      }
-
       rjsonwriter_add_spaces(writer, 2);
-      rjsonwriter_add_string(writer, "label_display_mode");
+      rjsonwriter_add_string(writer, "scan_dat_file_path");
       rjsonwriter_raw(writer, ":", 1);
       rjsonwriter_raw(writer, " ", 1);
-      rjsonwriter_rawf(writer, "%d", (int)playlist->label_display_mode);
+      rjsonwriter_add_string(writer, playlist->scan_record.dat_file_path);
       rjsonwriter_raw(writer, ",", 1);
       rjsonwriter_raw(writer, "\n", 1);
 
       rjsonwriter_add_spaces(writer, 2);
-      rjsonwriter_add_string(writer, "right_thumbnail_mode");
+      rjsonwriter_add_string(writer, "scan_search_recursively");
       rjsonwriter_raw(writer, ":", 1);
       rjsonwriter_raw(writer, " ", 1);
-      rjsonwriter_rawf(writer, "%d", (int)playlist->right_thumbnail_mode);
+      {
+         bool value = playlist->scan_record.search_recursively;
+         rjsonwriter_raw(writer, (value ? "true" : "false"), (value ? 4 : 5));
+      }
       rjsonwriter_raw(writer, ",", 1);
       rjsonwriter_raw(writer, "\n", 1);
 
       rjsonwriter_add_spaces(writer, 2);
-      rjsonwriter_add_string(writer, "left_thumbnail_mode");
+      rjsonwriter_add_string(writer, "scan_search_archives");
       rjsonwriter_raw(writer, ":", 1);
       rjsonwriter_raw(writer, " ", 1);
-      rjsonwriter_rawf(writer, "%d", (int)playlist->left_thumbnail_mode);
+      {
+         bool value = playlist->scan_record.search_archives;
+         rjsonwriter_raw(writer, (value ? "true" : "false"), (value ? 4 : 5));
+      }
       rjsonwriter_raw(writer, ",", 1);
       rjsonwriter_raw(writer, "\n", 1);
 
       rjsonwriter_add_spaces(writer, 2);
-      rjsonwriter_add_string(writer, "thumbnail_match_mode");
+      rjsonwriter_add_string(writer, "scan_filter_dat_content");
       rjsonwriter_raw(writer, ":", 1);
       rjsonwriter_raw(writer, " ", 1);
-      rjsonwriter_rawf(writer, "%d", (int)playlist->thumbnail_match_mode);
+      {
+         bool value = playlist->scan_record.filter_dat_content;
+         rjsonwriter_raw(writer, (value ? "true" : "false"), (value ? 4 : 5));
+      }
       rjsonwriter_raw(writer, ",", 1);
       rjsonwriter_raw(writer, "\n", 1);
 
       rjsonwriter_add_spaces(writer, 2);
-      rjsonwriter_add_string(writer, "sort_mode");
+      rjsonwriter_add_string(writer, "scan_overwrite_playlist");
       rjsonwriter_raw(writer, ":", 1);
       rjsonwriter_raw(writer, " ", 1);
-      rjsonwriter_rawf(writer, "%d", (int)playlist->sort_mode);
+      {
+         bool value = playlist->scan_record.overwrite_playlist;
+         rjsonwriter_raw(writer, (value ? "true" : "false"), (value ? 4 : 5));
+      }
       rjsonwriter_raw(writer, ",", 1);
       rjsonwriter_raw(writer, "\n", 1);
+   }
 
-      if (!string_is_empty(playlist->scan_record.content_dir))
-      {
-         rjsonwriter_add_spaces(writer, 2);
-         rjsonwriter_add_string(writer, "scan_content_dir");
-         rjsonwriter_raw(writer, ":", 1);
-         rjsonwriter_raw(writer, " ", 1);
-         rjsonwriter_add_string(writer, playlist->scan_record.content_dir);
-         rjsonwriter_raw(writer, ",", 1);
-         rjsonwriter_raw(writer, "\n", 1);
-
-         rjsonwriter_add_spaces(writer, 2);
-         rjsonwriter_add_string(writer, "scan_file_exts");
-         rjsonwriter_raw(writer, ":", 1);
-         rjsonwriter_raw(writer, " ", 1);
-         rjsonwriter_add_string(writer, playlist->scan_record.file_exts);
-         rjsonwriter_raw(writer, ",", 1);
-         rjsonwriter_raw(writer, "\n", 1);
-
-         rjsonwriter_add_spaces(writer, 2);
-         rjsonwriter_add_string(writer, "scan_dat_file_path");
-         rjsonwriter_raw(writer, ":", 1);
-         rjsonwriter_raw(writer, " ", 1);
-         rjsonwriter_add_string(writer, playlist->scan_record.dat_file_path);
-         rjsonwriter_raw(writer, ",", 1);
-         rjsonwriter_raw(writer, "\n", 1);
+   rjsonwriter_add_spaces(writer, 2);
+   rjsonwriter_add_string(writer, "items");
+   rjsonwriter_raw(writer, ":", 1);
+   rjsonwriter_raw(writer, " ", 1);
+   rjsonwriter_raw(writer, "[", 1);
+   rjsonwriter_raw(writer, "\n", 1);
 
-         rjsonwriter_add_spaces(writer, 2);
-         rjsonwriter_add_string(writer, "scan_search_recursively");
-         rjsonwriter_raw(writer, ":", 1);
-         rjsonwriter_raw(writer, " ", 1);
-         {
-            bool value = playlist->scan_record.search_recursively;
-            rjsonwriter_raw(writer, (value ? "true" : "false"), (value ? 4 : 5));
-         }
-         rjsonwriter_raw(writer, ",", 1);
-         rjsonwriter_raw(writer, "\n", 1);
+   for (i = 0, _len = RBUF_LEN(playlist->entries); i < _len; i++)
+   {
+      rjsonwriter_add_spaces(writer, 4);
+      rjsonwriter_raw(writer, "{", 1);
 
-         rjsonwriter_add_spaces(writer, 2);
-         rjsonwriter_add_string(writer, "scan_search_archives");
-         rjsonwriter_raw(writer, ":", 1);
-         rjsonwriter_raw(writer, " ", 1);
-         {
-            bool value = playlist->scan_record.search_archives;
-            rjsonwriter_raw(writer, (value ? "true" : "false"), (value ? 4 : 5));
-         }
-         rjsonwriter_raw(writer, ",", 1);
-         rjsonwriter_raw(writer, "\n", 1);
+      rjsonwriter_raw(writer, "\n", 1);
+      rjsonwriter_add_spaces(writer, 6);
+      rjsonwriter_add_string(writer, "path");
+      rjsonwriter_raw(writer, ":", 1);
+      rjsonwriter_raw(writer, " ", 1);
+      rjsonwriter_add_string(writer, playlist->entries[i].path);
+      rjsonwriter_raw(writer, ",", 1);
 
-         rjsonwriter_add_spaces(writer, 2);
-         rjsonwriter_add_string(writer, "scan_filter_dat_content");
-         rjsonwriter_raw(writer, ":", 1);
-         rjsonwriter_raw(writer, " ", 1);
-         {
-            bool value = playlist->scan_record.filter_dat_content;
-            rjsonwriter_raw(writer, (value ? "true" : "false"), (value ? 4 : 5));
-         }
-         rjsonwriter_raw(writer, ",", 1);
+      if (playlist->entries[i].entry_slot)
+      {
          rjsonwriter_raw(writer, "\n", 1);
-
-         rjsonwriter_add_spaces(writer, 2);
-         rjsonwriter_add_string(writer, "scan_overwrite_playlist");
+         rjsonwriter_add_spaces(writer, 6);
+         rjsonwriter_add_string(writer, "entry_slot");
          rjsonwriter_raw(writer, ":", 1);
          rjsonwriter_raw(writer, " ", 1);
-         {
-            bool value = playlist->scan_record.overwrite_playlist;
-            rjsonwriter_raw(writer, (value ? "true" : "false"), (value ? 4 : 5));
-         }
+         rjsonwriter_rawf(writer, "%d", (int)playlist->entries[i].entry_slot);
          rjsonwriter_raw(writer, ",", 1);
-         rjsonwriter_raw(writer, "\n", 1);
       }
 
-      rjsonwriter_add_spaces(writer, 2);
-      rjsonwriter_add_string(writer, "items");
+      rjsonwriter_raw(writer, "\n", 1);
+      rjsonwriter_add_spaces(writer, 6);
+      rjsonwriter_add_string(writer, "label");
       rjsonwriter_raw(writer, ":", 1);
       rjsonwriter_raw(writer, " ", 1);
-      rjsonwriter_raw(writer, "[", 1);
+      rjsonwriter_add_string(writer, playlist->entries[i].label);
+      rjsonwriter_raw(writer, ",", 1);
+
       rjsonwriter_raw(writer, "\n", 1);
+      rjsonwriter_add_spaces(writer, 6);
+      rjsonwriter_add_string(writer, "core_path");
+      rjsonwriter_raw(writer, ":", 1);
+      rjsonwriter_raw(writer, " ", 1);
+      rjsonwriter_add_string(writer, playlist->entries[i].core_path);
+      rjsonwriter_raw(writer, ",", 1);
 
-      for (i = 0, _len = RBUF_LEN(playlist->entries); i < _len; i++)
-      {
-         rjsonwriter_add_spaces(writer, 4);
-         rjsonwriter_raw(writer, "{", 1);
+      rjsonwriter_raw(writer, "\n", 1);
+      rjsonwriter_add_spaces(writer, 6);
+      rjsonwriter_add_string(writer, "core_name");
+      rjsonwriter_raw(writer, ":", 1);
+      rjsonwriter_raw(writer, " ", 1);
+      rjsonwriter_add_string(writer, playlist->entries[i].core_name);
+      rjsonwriter_raw(writer, ",", 1);
 
-         rjsonwriter_raw(writer, "\n", 1);
-         rjsonwriter_add_spaces(writer, 6);
-         rjsonwriter_add_string(writer, "path");
-         rjsonwriter_raw(writer, ":", 1);
-         rjsonwriter_raw(writer, " ", 1);
-         rjsonwriter_add_string(writer, playlist->entries[i].path);
-         rjsonwriter_raw(writer, ",", 1);
+      rjsonwriter_raw(writer, "\n", 1);
+      rjsonwriter_add_spaces(writer, 6);
+      rjsonwriter_add_string(writer, "crc32");
+      rjsonwriter_raw(writer, ":", 1);
+      rjsonwriter_raw(writer, " ", 1);
+      rjsonwriter_add_string(writer, playlist->entries[i].crc32);
+      rjsonwriter_raw(writer, ",", 1);
 
-         if (playlist->entries[i].entry_slot)
-         {
-            rjsonwriter_raw(writer, "\n", 1);
-            rjsonwriter_add_spaces(writer, 6);
-            rjsonwriter_add_string(writer, "entry_slot");
-            rjsonwriter_raw(writer, ":", 1);
-            rjsonwriter_raw(writer, " ", 1);
-            rjsonwriter_rawf(writer, "%d", (int)playlist->entries[i].entry_slot);
-            rjsonwriter_raw(writer, ",", 1);
-         }
+      rjsonwriter_raw(writer, "\n", 1);
+      rjsonwriter_add_spaces(writer, 6);
+      rjsonwriter_add_string(writer, "db_name");
+      rjsonwriter_raw(writer, ":", 1);
+      rjsonwriter_raw(writer, " ", 1);
+      rjsonwriter_add_string(writer, playlist->entries[i].db_name);
 
+      if (!string_is_empty(playlist->entries[i].subsystem_ident))
+      {
+         rjsonwriter_raw(writer, ",", 1);
          rjsonwriter_raw(writer, "\n", 1);
          rjsonwriter_add_spaces(writer, 6);
-         rjsonwriter_add_string(writer, "label");
+         rjsonwriter_add_string(writer, "subsystem_ident");
          rjsonwriter_raw(writer, ":", 1);
          rjsonwriter_raw(writer, " ", 1);
-         rjsonwriter_add_string(writer, playlist->entries[i].label);
-         rjsonwriter_raw(writer, ",", 1);
+         rjsonwriter_add_string(writer, playlist->entries[i].subsystem_ident);
+      }
 
+      if (!string_is_empty(playlist->entries[i].subsystem_name))
+      {
+         rjsonwriter_raw(writer, ",", 1);
          rjsonwriter_raw(writer, "\n", 1);
          rjsonwriter_add_spaces(writer, 6);
-         rjsonwriter_add_string(writer, "core_path");
+         rjsonwriter_add_string(writer, "subsystem_name");
          rjsonwriter_raw(writer, ":", 1);
          rjsonwriter_raw(writer, " ", 1);
-         rjsonwriter_add_string(writer, playlist->entries[i].core_path);
-         rjsonwriter_raw(writer, ",", 1);
+         rjsonwriter_add_string(writer, playlist->entries[i].subsystem_name);
+      }
 
+      if (  playlist->entries[i].subsystem_roms &&
+            playlist->entries[i].subsystem_roms->size > 0)
+      {
+         unsigned j;
+
+         rjsonwriter_raw(writer, ",", 1);
          rjsonwriter_raw(writer, "\n", 1);
          rjsonwriter_add_spaces(writer, 6);
-         rjsonwriter_add_string(writer, "core_name");
+         rjsonwriter_add_string(writer, "subsystem_roms");
          rjsonwriter_raw(writer, ":", 1);
          rjsonwriter_raw(writer, " ", 1);
-         rjsonwriter_add_string(writer, playlist->entries[i].core_name);
-         rjsonwriter_raw(writer, ",", 1);
+         rjsonwriter_raw(writer, "[", 1);
+         rjsonwriter_raw(writer, "\n", 1);
+
+         for (j = 0; j < playlist->entries[i].subsystem_roms->size; j++)
+         {
+            const struct string_list *roms = playlist->entries[i].subsystem_roms;
+            rjsonwriter_add_spaces(writer, 8);
+            rjsonwriter_add_string(writer,
+                  !string_is_empty(roms->elems[j].data)
+                  ? roms->elems[j].data
+                  : "");
+
+            if (j < playlist->entries[i].subsystem_roms->size - 1)
+            {
+               rjsonwriter_raw(writer, ",", 1);
+               rjsonwriter_raw(writer, "\n", 1);
+            }
+         }
 
          rjsonwriter_raw(writer, "\n", 1);
          rjsonwriter_add_spaces(writer, 6);
-         rjsonwriter_add_string(writer, "crc32");
-         rjsonwriter_raw(writer, ":", 1);
-         rjsonwriter_raw(writer, " ", 1);
-         rjsonwriter_add_string(writer, playlist->entries[i].crc32);
+         rjsonwriter_raw(writer, "]", 1);
+      }
+
+      rjsonwriter_raw(writer, "\n", 1);
+
+      rjsonwriter_add_spaces(writer, 4);
+      rjsonwriter_raw(writer, "}", 1);
+
+      if (i < _len - 1)
          rjsonwriter_raw(writer, ",", 1);
 
-         rjsonwriter_raw(writer, "\n", 1);
-         rjsonwriter_add_spaces(writer, 6);
-         rjsonwriter_add_string(writer, "db_name");
-         rjsonwriter_raw(writer, ":", 1);
-         rjsonwriter_raw(writer, " ", 1);
-         rjsonwriter_add_string(writer, playlist->entries[i].db_name);
+      rjsonwriter_raw(writer, "\n", 1);
+   }
 
-         if (!string_is_empty(playlist->entries[i].subsystem_ident))
-         {
-            rjsonwriter_raw(writer, ",", 1);
-            rjsonwriter_raw(writer, "\n", 1);
-            rjsonwriter_add_spaces(writer, 6);
-            rjsonwriter_add_string(writer, "subsystem_ident");
-            rjsonwriter_raw(writer, ":", 1);
-            rjsonwriter_raw(writer, " ", 1);
-            rjsonwriter_add_string(writer, playlist->entries[i].subsystem_ident);
-         }
+   rjsonwriter_add_spaces(writer, 2);
+   rjsonwriter_raw(writer, "]", 1);
+   rjsonwriter_raw(writer, "\n", 1);
+   rjsonwriter_raw(writer, "}", 1);
+   rjsonwriter_raw(writer, "\n", 1);
+}
 
-         if (!string_is_empty(playlist->entries[i].subsystem_name))
-         {
-            rjsonwriter_raw(writer, ",", 1);
-            rjsonwriter_raw(writer, "\n", 1);
-            rjsonwriter_add_spaces(writer, 6);
-            rjsonwriter_add_string(writer, "subsystem_name");
-            rjsonwriter_raw(writer, ":", 1);
-            rjsonwriter_raw(writer, " ", 1);
-            rjsonwriter_add_string(writer, playlist->entries[i].subsystem_name);
-         }
+static bool playlist_replace_file(const char *src,
+      const char *dst)
+{
+   if (!filestream_rename(src, dst))
+      return true;
+   /* Some platforms refuse to rename over an existing file */
+   filestream_delete(dst);
+   if (!filestream_rename(src, dst))
+      return true;
+   filestream_delete(src);
+   return false;
+}
 
-         if (  playlist->entries[i].subsystem_roms &&
-               playlist->entries[i].subsystem_roms->size > 0)
-         {
-            unsigned j;
-
-            rjsonwriter_raw(writer, ",", 1);
-            rjsonwriter_raw(writer, "\n", 1);
-            rjsonwriter_add_spaces(writer, 6);
-            rjsonwriter_add_string(writer, "subsystem_roms");
-            rjsonwriter_raw(writer, ":", 1);
-            rjsonwriter_raw(writer, " ", 1);
-            rjsonwriter_raw(writer, "[", 1);
-            rjsonwriter_raw(writer, "\n", 1);
-
-            for (j = 0; j < playlist->entries[i].subsystem_roms->size; j++)
-            {
-               const struct string_list *roms = playlist->entries[i].subsystem_roms;
-               rjsonwriter_add_spaces(writer, 8);
-               rjsonwriter_add_string(writer,
-                     !string_is_empty(roms->elems[j].data)
-                     ? roms->elems[j].data
-                     : "");
-
-               if (j < playlist->entries[i].subsystem_roms->size - 1)
-               {
-                  rjsonwriter_raw(writer, ",", 1);
-                  rjsonwriter_raw(writer, "\n", 1);
-               }
-            }
+static bool playlist_journal_write_file(const char *path,
+      const uint8_t *data, size_t len)
+{
+   uint8_t header[PLAYLIST_JOURNAL_HEADER_SIZE];
+   RFILE *file = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_WRITE,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   bool success;
 
-            rjsonwriter_raw(writer, "\n", 1);
-            rjsonwriter_add_spaces(writer, 6);
-            rjsonwriter_raw(writer, "]", 1);
-         }
+   if (!file)
+      return false;
 
-         rjsonwriter_raw(writer, "\n", 1);
+   playlist_journal_set_u32(header,     PLAYLIST_JOURNAL_MAGIC);
+   playlist_journal_set_u32(header + 4, PLAYLIST_JOURNAL_VERSION);
+
+   success = filestream_write(file, header, sizeof(header))
+         == sizeof(header);
+   if (success && len)
+      success = filestream_write(file, data, len) == (int64_t)len;
 
-         rjsonwriter_add_spaces(writer, 4);
-         rjsonwriter_raw(writer, "}", 1);
+   return filestream_close(file) == 0 && success;
+}
+
+/**
+ * playlist_journal_append:
+ * @playlist            : Playlist handle.
+ *
+ * Appends all queued records to the playlist journal,
+ * creating it if required.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool playlist_journal_append(playlist_t *playlist)
+{
+   char journal_path[PATH_MAX_LENGTH];
+   RFILE *file = NULL;
+   size_t _len = RBUF_LEN(playlist->journal.pending);
+   bool success;
+
+   playlist_journal_get_path(playlist, journal_path, sizeof(journal_path));
+
+   if (playlist->journal.size < PLAYLIST_JOURNAL_HEADER_SIZE)
+   {
+      if (!playlist_journal_write_file(journal_path,
+               playlist->journal.pending, _len))
+         return false;
+      playlist->journal.size = PLAYLIST_JOURNAL_HEADER_SIZE;
+   }
+   else
+   {
+      if (!(file = filestream_open(journal_path,
+            RETRO_VFS_FILE_ACCESS_WRITE
+            | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+         return false;
+
+      /* Write at the last known good position rather
+       * than at the end, so that a torn write is
+       * overwritten instead of followed */
+      success = filestream_seek(file, (int64_t)playlist->journal.size,
+            RETRO_VFS_SEEK_POSITION_START) >= 0
+         && filestream_write(file, playlist->journal.pending, _len)
+            == (int64_t)_len;
+      if (filestream_close(file) != 0 || !success)
+         return false;
+   }
+
+#ifdef HAVE_THREADS
+   /* These records are not part of the snapshot
+    * being written by a running compaction */
+   if (     playlist->journal.compact
+         && playlist->journal.trim
+         && !playlist_journal_put(&playlist->journal.tail,
+               playlist->journal.pending, _len))
+      playlist->journal.trim = false;
+#endif
+
+   playlist->journal.size += _len;
+   RBUF_CLEAR(playlist->journal.pending);
+
+   RARCH_LOG("[Playlist]: Appended to playlist journal: \"%s\".\n", journal_path);
+   return true;
+}
+
+#ifdef HAVE_THREADS
+static void playlist_journal_compact_thread(void *data)
+{
+   char tmp_path[PATH_MAX_LENGTH];
+   playlist_journal_compact_t *compact = (playlist_journal_compact_t*)data;
+   intfstream_t *file                  = NULL;
+   bool success                        = false;
+   size_t _len                         = strlcpy(tmp_path, compact->path,
+         sizeof(tmp_path));
+
+   strlcpy(tmp_path + _len, ".tmp", sizeof(tmp_path) - _len);
+
+#if defined(HAVE_ZLIB)
+   if (compact->compress)
+      file = intfstream_open_rzip_file(tmp_path,
+            RETRO_VFS_FILE_ACCESS_WRITE);
+   else
+#endif
+      file = intfstream_open_file(tmp_path,
+            RETRO_VFS_FILE_ACCESS_WRITE,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (file)
+   {
+      success = intfstream_write(file, compact->data, compact->len)
+            == (int64_t)compact->len;
+      success = intfstream_close(file) == 0 && success;
+      free(file);
+
+      if (success)
+         success = playlist_replace_file(tmp_path, compact->path);
+      else
+         filestream_delete(tmp_path);
+   }
+
+   slock_lock(compact->lock);
+   compact->success = success;
+   compact->done    = true;
+   slock_unlock(compact->lock);
+}
+
+static void playlist_journal_compact_free(playlist_journal_compact_t *compact)
+{
+   if (compact->lock)
+      slock_free(compact->lock);
+   if (compact->data)
+      free(compact->data);
+   free(compact);
+}
+
+/**
+ * playlist_journal_compact:
+ * @playlist            : Playlist handle.
+ *
+ * Starts folding the journal back into the playlist
+ * file. The playlist is serialised immediately; writing
+ * it to disk happens on a background thread.
+ *
+ * Returns: true if compaction is in progress, otherwise false.
+ **/
+static bool playlist_journal_compact(playlist_t *playlist)
+{
+   int _len;
+   char *data;
+   rjsonwriter_t *writer;
+   playlist_journal_compact_t *compact = NULL;
+
+   if (playlist->journal.compact)
+      return true;
+
+   if (!(writer = rjsonwriter_open_memory()))
+      return false;
+
+   if (playlist->config.compress)
+      rjsonwriter_set_options(writer, RJSONWRITER_OPTION_SKIP_WHITESPACE);
+
+   playlist_write_json(playlist, writer);
+
+   if (     (data    = rjsonwriter_get_memory_buffer(writer, &_len))
+         && (compact = (playlist_journal_compact_t*)
+               calloc(1, sizeof(*compact)))
+         && (compact->data = (char*)malloc(_len))
+         && (compact->lock = slock_new()))
+   {
+      memcpy(compact->data, data, _len);
+      compact->len      = (size_t)_len;
+      compact->compress = playlist->config.compress;
+      strlcpy(compact->path, playlist->config.path, sizeof(compact->path));
+      playlist->journal.compact_thread = sthread_create(
+            playlist_journal_compact_thread, compact);
+   }
+
+   rjsonwriter_free(writer);
+
+   if (!playlist->journal.compact_thread)
+   {
+      if (compact)
+         playlist_journal_compact_free(compact);
+      return false;
+   }
+
+   playlist->journal.compact = compact;
+   playlist->journal.trim    = true;
+   RBUF_CLEAR(playlist->journal.tail);
+   return true;
+}
+
+/**
+ * playlist_journal_compact_finish:
+ * @playlist            : Playlist handle.
+ * @wait                : Block until compaction is complete.
+ *
+ * Once a running compaction has replaced the playlist
+ * file, trims the journal down to the records written
+ * since it was started.
+ **/
+static void playlist_journal_compact_finish(playlist_t *playlist,
+      bool wait)
+{
+   char journal_path[PATH_MAX_LENGTH];
+   char tmp_path[PATH_MAX_LENGTH];
+   size_t _len;
+   playlist_journal_compact_t *compact = playlist->journal.compact;
+
+   if (!compact)
+      return;
+
+   if (!wait)
+   {
+      bool done;
+      slock_lock(compact->lock);
+      done = compact->done;
+      slock_unlock(compact->lock);
+      if (!done)
+         return;
+   }
+
+   sthread_join(playlist->journal.compact_thread);
+   playlist->journal.compact_thread = NULL;
+   playlist->journal.compact        = NULL;
+
+   if (!compact->success)
+      RARCH_ERR("[Playlist]: Failed to compact playlist journal: \"%s\".\n",
+            compact->path);
+   else
+      playlist_cache_delete(playlist);
+
+   if (compact->success && playlist->journal.trim)
+   {
+      /* Records up to the snapshot are now redundant */
+      playlist_journal_get_path(playlist, journal_path, sizeof(journal_path));
+      _len = strlcpy(tmp_path, journal_path, sizeof(tmp_path));
+      strlcpy(tmp_path + _len, ".tmp", sizeof(tmp_path) - _len);
+
+      _len = RBUF_LEN(playlist->journal.tail);
+      if (     playlist_journal_write_file(tmp_path,
+                  playlist->journal.tail, _len)
+            && playlist_replace_file(tmp_path, journal_path))
+      {
+         playlist->journal.size = PLAYLIST_JOURNAL_HEADER_SIZE + _len;
+         RARCH_LOG("[Playlist]: Compacted playlist journal: \"%s\".\n",
+               journal_path);
+      }
+   }
+
+   RBUF_CLEAR(playlist->journal.tail);
+   playlist_journal_compact_free(compact);
+}
+#endif
+
+void playlist_write_file(playlist_t *playlist)
+{
+   size_t i, _len;
+   char journal_path[PATH_MAX_LENGTH];
+   intfstream_t *file = NULL;
+   bool compressed    = false;
+   bool success       = true;
+
+   /* Playlist will be written if any of the
+    * following are true:
+    * > 'modified' flag is set
+    * > Journal records are pending
+    * > Current playlist format (old/new) does not
+    *   match requested
+    * > Current playlist compression status does
+    *   not match requested */
+   bool pl_compressed   = ((playlist->flags & CNT_PLAYLIST_FLG_COMPRESSED) > 0);
+   bool pl_old_fmt      = ((playlist->flags & CNT_PLAYLIST_FLG_OLD_FMT)    > 0);
+
+#ifdef HAVE_THREADS
+   if (playlist)
+      playlist_journal_compact_finish(playlist, false);
+#endif
+
+   if (   !playlist
+       || !((playlist->flags & CNT_PLAYLIST_FLG_MOD)
+       || (RBUF_LEN(playlist->journal.pending) > 0)
+#if defined(HAVE_ZLIB)
+       || (pl_compressed != playlist->config.compress)
+#endif
+       || (pl_old_fmt    != playlist->config.old_format)))
+      return;
+
+   /* If only journaled changes are pending, append
+    * them instead of rewriting the whole file */
+   if (      !(playlist->flags & CNT_PLAYLIST_FLG_MOD)
+#if defined(HAVE_ZLIB)
+         && (pl_compressed == playlist->config.compress)
+#endif
+         && (pl_old_fmt    == playlist->config.old_format)
+         && playlist_journal_append(playlist))
+   {
+      if (playlist->journal.size < PLAYLIST_JOURNAL_COMPACT_SIZE)
+         return;
+#ifdef HAVE_THREADS
+      if (playlist_journal_compact(playlist))
+         return;
+#endif
+      /* Journal has grown too large - fold it
+       * back in with a full write */
+   }
+
+#ifdef HAVE_THREADS
+   /* A running compaction must not replace
+    * the file written here */
+   playlist_journal_compact_finish(playlist, true);
+#endif
+
+#if defined(HAVE_ZLIB)
+   if (playlist->config.compress)
+      file = intfstream_open_rzip_file(playlist->config.path,
+            RETRO_VFS_FILE_ACCESS_WRITE);
+   else
+#endif
+      file = intfstream_open_file(playlist->config.path,
+            RETRO_VFS_FILE_ACCESS_WRITE,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+   {
+      RARCH_ERR("Failed to write to playlist file: \"%s\".\n", playlist->config.path);
+      return;
+   }
+
+   /* Get current file compression state */
+   compressed = intfstream_is_compressed(file);
+
+#ifdef RARCH_INTERNAL
+   if (playlist->config.old_format)
+   {
+      for (i = 0, _len = RBUF_LEN(playlist->entries); i < _len; i++)
+         intfstream_printf(file, "%s\n%s\n%s\n%s\n%s\n%s\n",
+               playlist->entries[i].path      ? playlist->entries[i].path      : "",
+               playlist->entries[i].label     ? playlist->entries[i].label     : "",
+               playlist->entries[i].core_path ? playlist->entries[i].core_path : "",
+               playlist->entries[i].core_name ? playlist->entries[i].core_name : "",
+               playlist->entries[i].crc32     ? playlist->entries[i].crc32     : "",
+               playlist->entries[i].db_name   ? playlist->entries[i].db_name   : ""
+               );
 
-         if (i < _len - 1)
-            rjsonwriter_raw(writer, ",", 1);
+      /* Add metadata lines
+       * > We add these at the end of the file to prevent
+       *   breakage if the playlist is loaded with an older
+       *   version of RetroArch */
+      intfstream_printf(
+            file,
+            "default_core_path = \"%s\"\n"
+            "default_core_name = \"%s\"\n"
+            "label_display_mode = \"%d\"\n"
+            "thumbnail_mode = \"%d|%d\"\n"
+            "sort_mode = \"%d\"\n",
+            playlist->default_core_path ? playlist->default_core_path : "",
+            playlist->default_core_name ? playlist->default_core_name : "",
+            playlist->label_display_mode,
+            playlist->right_thumbnail_mode, playlist->left_thumbnail_mode,
+            playlist->sort_mode);
 
-         rjsonwriter_raw(writer, "\n", 1);
+      playlist->flags  |=  (CNT_PLAYLIST_FLG_OLD_FMT);
+   }
+   else
+#endif
+   {
+      rjsonwriter_t* writer = rjsonwriter_open_stream(file);
+      if (!writer)
+      {
+         RARCH_ERR("Failed to create JSON writer\n");
+         goto end;
       }
+      /*  When compressing playlists, human readability
+       *   is not a factor - can skip all indentation
+       *   and new line characters */
+      if (compressed)
+         rjsonwriter_set_options(writer, RJSONWRITER_OPTION_SKIP_WHITESPACE);
 
-      rjsonwriter_add_spaces(writer, 2);
-      rjsonwriter_raw(writer, "]", 1);
-      rjsonwriter_raw(writer, "\n", 1);
-      rjsonwriter_raw(writer, "}", 1);
-      rjsonwriter_raw(writer, "\n", 1);
+      playlist_write_json(playlist, writer);
 
       if (!rjsonwriter_free(writer))
       {
          RARCH_ERR("Failed to write to playlist file: \"%s\".\n", playlist->config.path);
+         success        = false;
       }
 
       playlist->flags  &= ~(CNT_PLAYLIST_FLG_OLD_FMT);
    }
 
+   /* Playlist file now includes all journaled changes */
+   if (success)
+   {
+      playlist_journal_get_path(playlist, journal_path, sizeof(journal_path));
+      if (path_is_valid(journal_path))
+         filestream_delete(journal_path);
+      playlist_cache_delete(playlist);
+      playlist->journal.size = 0;
+      RBUF_CLEAR(playlist->journal.pending);
+      playlist->flags  &= ~CNT_PLAYLIST_FLG_JOURNAL_STALE;
+   }
+   else
+   {
+      /* Journal no longer matches the playlist file */
+      RBUF_CLEAR(playlist->journal.pending);
+      playlist->flags  |=  CNT_PLAYLIST_FLG_JOURNAL_STALE;
+   }
+
    playlist->flags     &= ~CNT_PLAYLIST_FLG_MOD;
 
    if (compressed)
@@ -2166,6 +3139,8 @@ void playlist_free(playlist_t *playlist)
       free(playlist->scan_record.dat_file_path);
    playlist->scan_record.dat_file_path = NULL;
 
+   playlist_cache_release(playlist, false);
+
    if (playlist->entries)
    {
       for (i = 0, _len = RBUF_LEN(playlist->entries); i < _len; i++)
@@ -2179,6 +3154,19 @@ void playlist_free(playlist_t *playlist)
       RBUF_FREE(playlist->entries);
    }
 
+#ifdef HAVE_PLAYLIST_CACHE
+   if (playlist->cache.data)
+      munmap(playlist->cache.data, playlist->cache.size);
+#endif
+
+   playlist_path_index_free(&playlist->path_index);
+
+#ifdef HAVE_THREADS
+   playlist_journal_compact_finish(playlist, true);
+#endif
+   RBUF_FREE(playlist->journal.pending);
+   RBUF_FREE(playlist->journal.tail);
+
    free(playlist);
 }
 
@@ -2194,6 +3182,8 @@ void playlist_clear(playlist_t *playlist)
    if (!playlist)
       return;
 
+   playlist_cache_release(playlist, false);
+
    for (i = 0, _len = RBUF_LEN(playlist->entries); i < _len; i++)
    {
       struct playlist_entry *entry = &playlist->entries[i];
@@ -2202,6 +3192,8 @@ void playlist_clear(playlist_t *playlist)
          playlist_free_entry(entry);
    }
    RBUF_CLEAR(playlist->entries);
+   playlist->path_index.valid = false;
+   playlist->flags           |= CNT_PLAYLIST_FLG_JOURNAL_STALE;
 }
 
 /**
@@ -2250,11 +3242,11 @@ static bool JSONEndArrayHandler(void *context)
    if (     (pCtx->flags & JSON_CTX_FLG_IN_ITEMS)
          && (pCtx->array_depth  == 0)
          && (pCtx->object_depth <= 1))
-      pCtx->flags &= (JSON_CTX_FLG_IN_ITEMS);
+      pCtx->flags &= ~(JSON_CTX_FLG_IN_ITEMS);
    else if ((pCtx->flags & JSON_CTX_FLG_IN_SUBSYSTEM_CONTENT)
          && (pCtx->array_depth  <= 1)
          && (pCtx->object_depth <= 2))
-      pCtx->flags &= (JSON_CTX_FLG_IN_SUBSYSTEM_CONTENT);
+      pCtx->flags &= ~(JSON_CTX_FLG_IN_SUBSYSTEM_CONTENT);
 
    return true;
 }
@@ -2408,6 +3400,8 @@ static bool JSONNumberHandler(void *context, const char *pValue, size_t len)
                *pCtx->current_meta_thumbnail_match_mode_val = (enum playlist_thumbnail_match_mode)strtoul(pValue, NULL, 10);
             else if (pCtx->current_meta_sort_mode_val)
                *pCtx->current_meta_sort_mode_val            = (enum playlist_sort_mode)strtoul(pValue, NULL, 10);
+            else if (pCtx->current_meta_seq_val)
+               *pCtx->current_meta_seq_val                  = (uint64_t)strtoull(pValue, NULL, 10);
          }
       }
    }
@@ -2417,6 +3411,7 @@ static bool JSONNumberHandler(void *context, const char *pValue, size_t len)
    pCtx->current_meta_thumbnail_mode_val       = NULL;
    pCtx->current_meta_thumbnail_match_mode_val = NULL;
    pCtx->current_meta_sort_mode_val            = NULL;
+   pCtx->current_meta_seq_val                  = NULL;
 
    return true;
 }
@@ -2522,6 +3517,7 @@ static bool JSONObjectMemberHandler(void *context, const char *pValue, size_t le
       pCtx->current_meta_thumbnail_match_mode_val = NULL;
       pCtx->current_meta_sort_mode_val            = NULL;
       pCtx->current_meta_bool_val                 = NULL;
+      pCtx->current_meta_seq_val                  = NULL;
       pCtx->flags                                &= ~(JSON_CTX_FLG_IN_ITEMS);
 
       switch (pValue[0])
@@ -2540,6 +3536,10 @@ static bool JSONObjectMemberHandler(void *context, const char *pValue, size_t le
             if (string_is_equal(pValue, "items"))
                pCtx->flags |= JSON_CTX_FLG_IN_ITEMS;
             break;
+         case 'j':
+            if (string_is_equal(pValue, "journal_seq"))
+               pCtx->current_meta_seq_val = &pCtx->playlist->journal.seq;
+            break;
          case 'l':
             if (string_is_equal(pValue,      "label_display_mode"))
                pCtx->current_meta_label_display_mode_val = &pCtx->playlist->label_display_mode;
@@ -2592,20 +3592,374 @@ static size_t playlist_get_old_format_metadata_value(
    return strlcpy(s, start, len);
 }
 
+#ifdef HAVE_PLAYLIST_CACHE
+static uint32_t playlist_cache_put_str(char **pool, const char *str,
+      bool *ok)
+{
+   size_t _len;
+   size_t pos = RBUF_LEN(*pool);
+
+   if (!str)
+      return PLAYLIST_CACHE_NULL;
+
+   _len = strlen(str) + 1;
+   if (!RBUF_TRYFIT(*pool, pos + _len))
+   {
+      *ok = false;
+      return PLAYLIST_CACHE_NULL;
+   }
+   RBUF_RESIZE(*pool, pos + _len);
+   memcpy(*pool + pos, str, _len);
+   return (uint32_t)pos;
+}
+
+/**
+ * playlist_cache_write:
+ * @playlist            : Playlist handle.
+ * @st                  : Status of the playlist file that was read.
+ *
+ * Writes the binary cache of a freshly parsed playlist.
+ **/
+static void playlist_cache_write(playlist_t *playlist,
+      const struct stat *st)
+{
+   size_t i, _len;
+   char cache_path[PATH_MAX_LENGTH];
+   char tmp_path[PATH_MAX_LENGTH];
+   playlist_cache_header_t header;
+   RFILE *file                      = NULL;
+   playlist_cache_entry_t *entries  = NULL;
+   uint32_t *roms                   = NULL;
+   char *pool                       = NULL;
+   bool success                     = false;
+   bool ok                          = true;
+   size_t count                     = RBUF_LEN(playlist->entries);
+
+   memset(&header, 0, sizeof(header));
+   header.magic                  = PLAYLIST_CACHE_MAGIC;
+   header.version                = PLAYLIST_CACHE_VERSION;
+   header.file_size              = (uint64_t)st->st_size;
+   header.file_mtime             = (int64_t)st->st_mtime;
+   header.journal_seq            = playlist->journal.seq;
+   header.entry_count            = (uint32_t)count;
+   header.flags                  = playlist->flags
+         & (CNT_PLAYLIST_FLG_OLD_FMT | CNT_PLAYLIST_FLG_COMPRESSED);
+   header.default_core_path      = playlist_cache_put_str(&pool, playlist->default_core_path, &ok);
+   header.default_core_name      = playlist_cache_put_str(&pool, playlist->default_core_name, &ok);
+   header.base_content_directory = playlist_cache_put_str(&pool, playlist->base_content_directory, &ok);
+   header.scan_content_dir       = playlist_cache_put_str(&pool, playlist->scan_record.content_dir, &ok);
+   header.scan_file_exts         = playlist_cache_put_str(&pool, playlist->scan_record.file_exts, &ok);
+   header.scan_dat_file_path     = playlist_cache_put_str(&pool, playlist->scan_record.dat_file_path, &ok);
+   header.label_display_mode     = (uint32_t)playlist->label_display_mode;
+   header.right_thumbnail_mode   = (uint32_t)playlist->right_thumbnail_mode;
+   header.left_thumbnail_mode    = (uint32_t)playlist->left_thumbnail_mode;
+   header.thumbnail_match_mode   = (uint32_t)playlist->thumbnail_match_mode;
+   header.sort_mode              = (uint32_t)playlist->sort_mode;
+   if (playlist->scan_record.search_recursively)
+      header.scan_flags         |= PLAYLIST_CACHE_SCAN_RECURSIVE;
+   if (playlist->scan_record.search_archives)
+      header.scan_flags         |= PLAYLIST_CACHE_SCAN_ARCHIVES;
+   if (playlist->scan_record.filter_dat_content)
+      header.scan_flags         |= PLAYLIST_CACHE_SCAN_FILTER;
+   if (playlist->scan_record.overwrite_playlist)
+      header.scan_flags         |= PLAYLIST_CACHE_SCAN_OVERWRITE;
+
+   if (count && !(entries = (playlist_cache_entry_t*)
+            calloc(count, sizeof(*entries))))
+      goto end;
+
+   for (i = 0; i < count; i++)
+   {
+      const struct playlist_entry *entry = &playlist->entries[i];
+      playlist_cache_entry_t *rec        = &entries[i];
+
+      rec->path               = playlist_cache_put_str(&pool, entry->path, &ok);
+      rec->label              = playlist_cache_put_str(&pool, entry->label, &ok);
+      rec->core_path          = playlist_cache_put_str(&pool, entry->core_path, &ok);
+      rec->core_name          = playlist_cache_put_str(&pool, entry->core_name, &ok);
+      rec->crc32              = playlist_cache_put_str(&pool, entry->crc32, &ok);
+      rec->db_name            = playlist_cache_put_str(&pool, entry->db_name, &ok);
+      rec->subsystem_ident    = playlist_cache_put_str(&pool, entry->subsystem_ident, &ok);
+      rec->subsystem_name     = playlist_cache_put_str(&pool, entry->subsystem_name, &ok);
+      rec->entry_slot         = entry->entry_slot;
+      rec->runtime_hours      = entry->runtime_hours;
+      rec->runtime_minutes    = entry->runtime_minutes;
+      rec->runtime_seconds    = entry->runtime_seconds;
+      rec->last_played_year   = entry->last_played_year;
+      rec->last_played_month  = entry->last_played_month;
+      rec->last_played_day    = entry->last_played_day;
+      rec->last_played_hour   = entry->last_played_hour;
+      rec->last_played_minute = entry->last_played_minute;
+      rec->last_played_second = entry->last_played_second;
+      rec->roms_start         = (uint32_t)RBUF_LEN(roms);
+      rec->roms_count         = PLAYLIST_CACHE_NULL;
+
+      if (entry->subsystem_roms)
+      {
+         size_t j;
+         rec->roms_count      = (uint32_t)entry->subsystem_roms->size;
+         if (!RBUF_TRYFIT(roms, RBUF_LEN(roms) + rec->roms_count))
+            goto end;
+         for (j = 0; j < entry->subsystem_roms->size; j++)
+            RBUF_PUSH(roms, playlist_cache_put_str(&pool,
+                     entry->subsystem_roms->elems[j].data, &ok));
+      }
+   }
+
+   if (!ok)
+      goto end;
+
+   header.rom_count = (uint32_t)RBUF_LEN(roms);
+   header.pool_size = (uint32_t)RBUF_LEN(pool);
+
+   playlist_cache_get_path(playlist, cache_path, sizeof(cache_path));
+   _len = strlcpy(tmp_path, cache_path, sizeof(tmp_path));
+   strlcpy(tmp_path + _len, ".tmp", sizeof(tmp_path) - _len);
+
+   if (!(file = filestream_open(tmp_path,
+         RETRO_VFS_FILE_ACCESS_WRITE,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      goto end;
+
+   success = filestream_write(file, &header, sizeof(header))
+         == sizeof(header);
+   if (success && count)
+      success = filestream_write(file, entries, count * sizeof(*entries))
+         == (int64_t)(count * sizeof(*entries));
+   if (success && header.rom_count)
+      success = filestream_write(file, roms, header.rom_count * sizeof(*roms))
+         == (int64_t)(header.rom_count * sizeof(*roms));
+   if (success && header.pool_size)
+      success = filestream_write(file, pool, header.pool_size)
+         == (int64_t)header.pool_size;
+   success = filestream_close(file) == 0 && success;
+
+   if (success)
+      success = playlist_replace_file(tmp_path, cache_path);
+   else
+      filestream_delete(tmp_path);
+
+end:
+   if (!success)
+      RARCH_WARN("[Playlist]: Failed to write playlist cache for: \"%s\".\n",
+            playlist->config.path);
+   free(entries);
+   RBUF_FREE(roms);
+   RBUF_FREE(pool);
+}
+
+static bool playlist_cache_str_valid(const playlist_cache_header_t *header,
+      uint32_t offset)
+{
+   return offset == PLAYLIST_CACHE_NULL || offset < header->pool_size;
+}
+
+static char *playlist_cache_get_str(const char *pool, uint32_t offset)
+{
+   return (offset == PLAYLIST_CACHE_NULL) ? NULL : (char*)(pool + offset);
+}
+
+static char *playlist_cache_dup_str(const char *pool, uint32_t offset)
+{
+   return (offset == PLAYLIST_CACHE_NULL) ? NULL : strdup(pool + offset);
+}
+
+/**
+ * playlist_cache_load:
+ * @playlist            : Playlist handle.
+ * @st                  : Status of the playlist file.
+ *
+ * Maps the binary cache of the playlist, if it matches
+ * the current playlist file. Entry strings are used in
+ * place, so the only per-entry allocations are for
+ * subsystem ROM lists.
+ *
+ * Returns: true if the playlist was loaded from the
+ * cache, otherwise false.
+ **/
+static bool playlist_cache_load(playlist_t *playlist,
+      const struct stat *st)
+{
+   size_t i, size;
+   char cache_path[PATH_MAX_LENGTH];
+   struct stat cache_st;
+   const playlist_cache_header_t *header = NULL;
+   const playlist_cache_entry_t *entries = NULL;
+   const uint32_t *roms                  = NULL;
+   const char *pool                      = NULL;
+   void *data                            = MAP_FAILED;
+   int fd;
+
+   playlist_cache_get_path(playlist, cache_path, sizeof(cache_path));
+
+   if ((fd = open(cache_path, O_RDONLY)) < 0)
+      return false;
+
+   if (     fstat(fd, &cache_st) == 0
+         && cache_st.st_size >= (off_t)sizeof(*header))
+   {
+      size = (size_t)cache_st.st_size;
+      /* Writable private mapping, so that any in-place
+       * change to an entry string stays local */
+      data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+   }
+   close(fd);
+
+   if (data == MAP_FAILED)
+      return false;
+
+   header  = (const playlist_cache_header_t*)data;
+   entries = (const playlist_cache_entry_t*)(header + 1);
+
+   if (     (header->magic       != PLAYLIST_CACHE_MAGIC)
+         || (header->version     != PLAYLIST_CACHE_VERSION)
+         || (header->file_size   != (uint64_t)st->st_size)
+         || (header->file_mtime  != (int64_t)st->st_mtime)
+         || (header->entry_count  > playlist->config.capacity)
+         || (size != sizeof(*header)
+               + (size_t)header->entry_count * sizeof(*entries)
+               + (size_t)header->rom_count   * sizeof(*roms)
+               + header->pool_size)
+         || (header->pool_size && ((const char*)data)[size - 1] != '\0'))
+      goto error;
+
+   roms = (const uint32_t*)(entries + header->entry_count);
+   pool = (const char*)(roms + header->rom_count);
+
+   if (     !playlist_cache_str_valid(header, header->default_core_path)
+         || !playlist_cache_str_valid(header, header->default_core_name)
+         || !playlist_cache_str_valid(header, header->base_content_directory)
+         || !playlist_cache_str_valid(header, header->scan_content_dir)
+         || !playlist_cache_str_valid(header, header->scan_file_exts)
+         || !playlist_cache_str_valid(header, header->scan_dat_file_path))
+      goto error;
+
+   for (i = 0; i < header->rom_count; i++)
+      if (!playlist_cache_str_valid(header, roms[i]))
+         goto error;
+
+   for (i = 0; i < header->entry_count; i++)
+   {
+      const playlist_cache_entry_t *rec = &entries[i];
+      if (     !playlist_cache_str_valid(header, rec->path)
+            || !playlist_cache_str_valid(header, rec->label)
+            || !playlist_cache_str_valid(header, rec->core_path)
+            || !playlist_cache_str_valid(header, rec->core_name)
+            || !playlist_cache_str_valid(header, rec->crc32)
+            || !playlist_cache_str_valid(header, rec->db_name)
+            || !playlist_cache_str_valid(header, rec->subsystem_ident)
+            || !playlist_cache_str_valid(header, rec->subsystem_name)
+            || (   (rec->roms_count != PLAYLIST_CACHE_NULL)
+                && (   (rec->roms_start > header->rom_count)
+                    || (rec->roms_count > header->rom_count - rec->roms_start))))
+         goto error;
+   }
+
+   if (header->entry_count && !RBUF_TRYFIT(playlist->entries,
+            header->entry_count))
+      goto error;
+   RBUF_RESIZE(playlist->entries, header->entry_count);
+
+   for (i = 0; i < header->entry_count; i++)
+   {
+      const playlist_cache_entry_t *rec = &entries[i];
+      struct playlist_entry *entry      = &playlist->entries[i];
+
+      memset(entry, 0, sizeof(*entry));
+      entry->path               = playlist_cache_get_str(pool, rec->path);
+      entry->label              = playlist_cache_get_str(pool, rec->label);
+      entry->core_path          = playlist_cache_get_str(pool, rec->core_path);
+      entry->core_name          = playlist_cache_get_str(pool, rec->core_name);
+      entry->crc32              = playlist_cache_get_str(pool, rec->crc32);
+      entry->db_name            = playlist_cache_get_str(pool, rec->db_name);
+      entry->subsystem_ident    = playlist_cache_get_str(pool, rec->subsystem_ident);
+      entry->subsystem_name     = playlist_cache_get_str(pool, rec->subsystem_name);
+      entry->entry_slot         = rec->entry_slot;
+      entry->runtime_hours      = rec->runtime_hours;
+      entry->runtime_minutes    = rec->runtime_minutes;
+      entry->runtime_seconds    = rec->runtime_seconds;
+      entry->last_played_year   = rec->last_played_year;
+      entry->last_played_month  = rec->last_played_month;
+      entry->last_played_day    = rec->last_played_day;
+      entry->last_played_hour   = rec->last_played_hour;
+      entry->last_played_minute = rec->last_played_minute;
+      entry->last_played_second = rec->last_played_second;
+
+      if (rec->roms_count != PLAYLIST_CACHE_NULL)
+      {
+         uint32_t j;
+         union string_list_elem_attr attributes = {0};
+
+         if (!(entry->subsystem_roms = string_list_new()))
+            continue;
+
+         for (j = 0; j < rec->roms_count; j++)
+         {
+            const char *rom = playlist_cache_get_str(pool,
+                  roms[rec->roms_start + j]);
+            string_list_append(entry->subsystem_roms,
+                  rom ? rom : "", attributes);
+         }
+      }
+   }
+
+   playlist->default_core_path              = playlist_cache_dup_str(pool, header->default_core_path);
+   playlist->default_core_name              = playlist_cache_dup_str(pool, header->default_core_name);
+   playlist->base_content_directory         = playlist_cache_dup_str(pool, header->base_content_directory);
+   playlist->scan_record.content_dir        = playlist_cache_dup_str(pool, header->scan_content_dir);
+   playlist->scan_record.file_exts          = playlist_cache_dup_str(pool, header->scan_file_exts);
+   playlist->scan_record.dat_file_path      = playlist_cache_dup_str(pool, header->scan_dat_file_path);
+   playlist->scan_record.search_recursively = (header->scan_flags & PLAYLIST_CACHE_SCAN_RECURSIVE) != 0;
+   playlist->scan_record.search_archives    = (header->scan_flags & PLAYLIST_CACHE_SCAN_ARCHIVES)  != 0;
+   playlist->scan_record.filter_dat_content = (header->scan_flags & PLAYLIST_CACHE_SCAN_FILTER)    != 0;
+   playlist->scan_record.overwrite_playlist = (header->scan_flags & PLAYLIST_CACHE_SCAN_OVERWRITE) != 0;
+   playlist->label_display_mode             = (enum playlist_label_display_mode)header->label_display_mode;
+   playlist->right_thumbnail_mode           = (enum playlist_thumbnail_mode)header->right_thumbnail_mode;
+   playlist->left_thumbnail_mode            = (enum playlist_thumbnail_mode)header->left_thumbnail_mode;
+   playlist->thumbnail_match_mode           = (enum playlist_thumbnail_match_mode)header->thumbnail_match_mode;
+   playlist->sort_mode                      = (enum playlist_sort_mode)header->sort_mode;
+   playlist->journal.seq                    = header->journal_seq;
+   playlist->flags                         |= header->flags
+         & (CNT_PLAYLIST_FLG_OLD_FMT | CNT_PLAYLIST_FLG_COMPRESSED);
+
+   playlist->cache.data      = data;
+   playlist->cache.size      = size;
+   playlist->cache.pool      = pool;
+   playlist->cache.pool_size = header->pool_size;
+   playlist->cache.attached  = true;
+   return true;
+
+error:
+   munmap(data, size);
+   return false;
+}
+#endif
+
 static bool playlist_read_file(playlist_t *playlist)
 {
    unsigned i;
    int test_char;
    bool res             = true;
+   intfstream_t *file   = NULL;
+#ifdef HAVE_PLAYLIST_CACHE
+   struct stat st;
+   bool cacheable       = false;
+   bool use_cache       =    playlist->config.cache
+                          && (stat(playlist->config.path, &st) == 0);
+
+   if (use_cache && playlist_cache_load(playlist, &st))
+      return true;
+#endif
+
 #if defined(HAVE_ZLIB)
       /* Always use RZIP interface when reading playlists
        * > this will automatically handle uncompressed
        *   data */
-   intfstream_t *file   = intfstream_open_rzip_file(
+   file                 = intfstream_open_rzip_file(
          playlist->config.path,
          RETRO_VFS_FILE_ACCESS_READ);
 #else
-   intfstream_t *file   = intfstream_open_file(
+   file                 = intfstream_open_file(
          playlist->config.path,
          RETRO_VFS_FILE_ACCESS_READ,
          RETRO_VFS_FILE_ACCESS_HINT_NONE);
@@ -2685,6 +4039,10 @@ static bool playlist_read_file(playlist_t *playlist)
                   (*rjson_get_error(parser) ? rjson_get_error(parser) : "format error"));
          }
       }
+#ifdef HAVE_PLAYLIST_CACHE
+      else
+         cacheable = true;
+#endif
       rjson_free(parser);
    }
    else
@@ -2875,11 +4233,22 @@ static bool playlist_read_file(playlist_t *playlist)
             break;
          }
       }
+#ifdef HAVE_PLAYLIST_CACHE
+      cacheable = true;
+#endif
    }
 
 end:
    intfstream_close(file);
    free(file);
+#ifdef HAVE_PLAYLIST_CACHE
+   /* Excess entries flag the playlist as modified,
+    * in which case it no longer matches the file */
+   if (     use_cache
+         && cacheable
+         && !(playlist->flags & CNT_PLAYLIST_FLG_MOD))
+      playlist_cache_write(playlist, &st);
+#endif
    return res;
 }
 
@@ -2920,6 +4289,250 @@ bool playlist_init_cached(const playlist_config_t *config)
    return true;
 }
 
+static bool playlist_journal_read_u32(const uint8_t **data,
+      const uint8_t *end, uint32_t *val)
+{
+   if (end - *data < 4)
+      return false;
+   *val   = playlist_journal_get_u32(*data);
+   *data += 4;
+   return true;
+}
+
+static bool playlist_journal_read_str(const uint8_t **data,
+      const uint8_t *end, char **str)
+{
+   uint32_t _len;
+
+   if (!playlist_journal_read_u32(data, end, &_len))
+      return false;
+   if (_len == PLAYLIST_JOURNAL_NULL)
+      return true;
+   if ((size_t)(end - *data) < _len || !(*str = (char*)malloc(_len + 1)))
+      return false;
+
+   memcpy(*str, *data, _len);
+   (*str)[_len] = '\0';
+   *data       += _len;
+   return true;
+}
+
+static bool playlist_journal_read_entry(const uint8_t **data,
+      const uint8_t *end, struct playlist_entry *entry)
+{
+   uint32_t i, slot, count;
+
+   if (     !playlist_journal_read_str(data, end, &entry->path)
+         || !playlist_journal_read_str(data, end, &entry->label)
+         || !playlist_journal_read_str(data, end, &entry->core_path)
+         || !playlist_journal_read_str(data, end, &entry->core_name)
+         || !playlist_journal_read_str(data, end, &entry->crc32)
+         || !playlist_journal_read_str(data, end, &entry->db_name)
+         || !playlist_journal_read_str(data, end, &entry->subsystem_ident)
+         || !playlist_journal_read_str(data, end, &entry->subsystem_name)
+         || !playlist_journal_read_u32(data, end, &slot)
+         || !playlist_journal_read_u32(data, end, &count))
+      return false;
+
+   entry->entry_slot = slot;
+
+   if (count == PLAYLIST_JOURNAL_NULL)
+      return true;
+
+   if (!(entry->subsystem_roms = string_list_new()))
+      return false;
+
+   for (i = 0; i < count; i++)
+   {
+      union string_list_elem_attr attributes = {0};
+      char *rom                              = NULL;
+      bool ret                               =
+            playlist_journal_read_str(data, end, &rom)
+         && string_list_append(entry->subsystem_roms,
+               rom ? rom : "", attributes);
+
+      if (rom)
+         free(rom);
+      if (!ret)
+         return false;
+   }
+
+   return true;
+}
+
+/* Applies a single journal record payload.
+ * Returns false if the record is invalid */
+static bool playlist_journal_apply(playlist_t *playlist,
+      const uint8_t *data, const uint8_t *end)
+{
+   struct playlist_entry entry;
+   size_t _len = RBUF_LEN(playlist->entries);
+   uint8_t op  = data[8];
+   size_t idx  = playlist_journal_get_u32(data + 9);
+
+   data       += PLAYLIST_JOURNAL_PAYLOAD_SIZE;
+   memset(&entry, 0, sizeof(entry));
+   playlist_cache_release(playlist, true);
+
+   switch (op)
+   {
+      case PLAYLIST_JOURNAL_OP_PUSH:
+         if (     !playlist_journal_read_entry(&data, end, &entry)
+               || (playlist->config.capacity == 0))
+            goto error;
+
+         if (_len == playlist->config.capacity)
+            playlist_free_entry(&playlist->entries[--_len]);
+         else
+         {
+            if (!RBUF_TRYFIT(playlist->entries, _len + 1))
+               goto error;
+            RBUF_RESIZE(playlist->entries, _len + 1);
+         }
+
+         memmove(playlist->entries + 1, playlist->entries,
+               _len * sizeof(struct playlist_entry));
+         playlist->entries[0] = entry;
+         break;
+      case PLAYLIST_JOURNAL_OP_MOVE:
+         if (idx >= _len)
+            return false;
+
+         entry = playlist->entries[idx];
+         memmove(playlist->entries + 1, playlist->entries,
+               idx * sizeof(struct playlist_entry));
+         playlist->entries[0] = entry;
+         break;
+      case PLAYLIST_JOURNAL_OP_SET:
+         if (     (idx >= _len)
+               || !playlist_journal_read_entry(&data, end, &entry))
+            goto error;
+
+         playlist_free_entry(&playlist->entries[idx]);
+         playlist->entries[idx] = entry;
+         break;
+      case PLAYLIST_JOURNAL_OP_DELETE:
+         if (idx >= _len)
+            return false;
+
+         playlist_free_entry(&playlist->entries[idx]);
+         memmove(playlist->entries + idx, playlist->entries + idx + 1,
+               (_len - 1 - idx) * sizeof(struct playlist_entry));
+         RBUF_RESIZE(playlist->entries, _len - 1);
+         break;
+      default:
+         return false;
+   }
+
+   return true;
+
+error:
+   playlist_free_entry(&entry);
+   return false;
+}
+
+/**
+ * playlist_journal_replay:
+ * @playlist            : Playlist handle.
+ *
+ * Applies all journal records that are newer than
+ * the playlist file. If the journal is damaged, the
+ * playlist is flagged for a full write, which starts
+ * a new journal. A journal next to a playlist file
+ * written without one is stale and gets deleted.
+ **/
+static void playlist_journal_replay(playlist_t *playlist)
+{
+   char journal_path[PATH_MAX_LENGTH];
+   const uint8_t *data, *end;
+   void *buf       = NULL;
+   int64_t _len    = 0;
+   unsigned count  = 0;
+
+   playlist_journal_get_path(playlist, journal_path, sizeof(journal_path));
+
+   if (!path_is_valid(journal_path))
+      return;
+
+   /* Journal of a playlist that has since been deleted */
+   if (!path_is_valid(playlist->config.path))
+   {
+      filestream_delete(journal_path);
+      return;
+   }
+
+   /* The playlist file was rewritten without a journal
+    * (older version, journal disabled...), so it already
+    * supersedes whatever the journal holds */
+   if (!playlist->journal.seq)
+   {
+      RARCH_WARN("[Playlist]: Discarding stale playlist journal: \"%s\".\n",
+            journal_path);
+      filestream_delete(journal_path);
+      return;
+   }
+
+   if (!filestream_read_file(journal_path, &buf, &_len))
+      return;
+
+   data = (const uint8_t*)buf;
+   end  = data + _len;
+
+   if (     (_len < PLAYLIST_JOURNAL_HEADER_SIZE)
+         || (playlist_journal_get_u32(data)     != PLAYLIST_JOURNAL_MAGIC)
+         || (playlist_journal_get_u32(data + 4) != PLAYLIST_JOURNAL_VERSION))
+      goto error;
+
+   for (data += PLAYLIST_JOURNAL_HEADER_SIZE; data < end;
+         data += PLAYLIST_JOURNAL_RECORD_SIZE + playlist_journal_get_u32(data))
+   {
+      int i;
+      uint64_t seq        = 0;
+      const uint8_t *rec  = data + PLAYLIST_JOURNAL_RECORD_SIZE;
+      uint32_t rec_len;
+
+      if (end - data < PLAYLIST_JOURNAL_RECORD_SIZE)
+         goto error;
+
+      rec_len = playlist_journal_get_u32(data);
+      if (     (rec_len < PLAYLIST_JOURNAL_PAYLOAD_SIZE)
+            || ((size_t)(end - rec) < rec_len)
+            || (encoding_crc32(0, rec, rec_len)
+               != playlist_journal_get_u32(data + 4)))
+         goto error;
+
+      for (i = 7; i >= 0; i--)
+         seq = (seq << 8) | rec[i];
+
+      /* Already included in the playlist file */
+      if (seq <= playlist->journal.seq)
+         continue;
+
+      if (!playlist_journal_apply(playlist, rec, rec + rec_len))
+         goto error;
+
+      playlist->journal.seq = seq;
+      count++;
+   }
+
+   playlist->journal.size = (size_t)_len;
+   goto end;
+
+error:
+   RARCH_WARN("[Playlist]: Discarding damaged playlist journal: \"%s\".\n",
+         journal_path);
+   playlist->flags |= CNT_PLAYLIST_FLG_MOD;
+
+end:
+   if (count)
+   {
+      playlist->path_index.valid = false;
+      RARCH_LOG("[Playlist]: Replayed %u change(s) from playlist journal: \"%s\".\n",
+            count, journal_path);
+   }
+   free(buf);
+}
+
 /**
  * playlist_init:
  * @config            : Playlist configuration object.
@@ -2940,6 +4553,26 @@ playlist_t *playlist_init(const playlist_config_t *config)
    playlist->default_core_path              = NULL;
    playlist->base_content_directory         = NULL;
    playlist->entries                        = NULL;
+   playlist->path_index.real_slots          = NULL;
+   playlist->path_index.archive_slots       = NULL;
+   playlist->path_index.cap                 = 0;
+   playlist->path_index.count               = 0;
+   playlist->path_index.shift               = 0;
+   playlist->path_index.valid               = false;
+   playlist->journal.pending                = NULL;
+   playlist->journal.tail                   = NULL;
+#ifdef HAVE_THREADS
+   playlist->journal.compact_thread         = NULL;
+   playlist->journal.compact                = NULL;
+#endif
+   playlist->journal.seq                    = 0;
+   playlist->journal.size                   = 0;
+   playlist->journal.trim                   = false;
+   playlist->cache.data                     = NULL;
+   playlist->cache.pool                     = NULL;
+   playlist->cache.size                     = 0;
+   playlist->cache.pool_size                = 0;
+   playlist->cache.attached                 = false;
    playlist->label_display_mode             = LABEL_DISPLAY_MODE_DEFAULT;
    playlist->right_thumbnail_mode           = PLAYLIST_THUMBNAIL_MODE_DEFAULT;
    playlist->left_thumbnail_mode            = PLAYLIST_THUMBNAIL_MODE_DEFAULT;
@@ -2949,6 +4582,7 @@ playlist_t *playlist_init(const playlist_config_t *config)
    playlist->scan_record.search_recursively = false;
    playlist->scan_record.search_archives    = false;
    playlist->scan_record.filter_dat_content = false;
+   playlist->scan_record.overwrite_playlist = false;
    playlist->scan_record.content_dir        = NULL;
    playlist->scan_record.file_exts          = NULL;
    playlist->scan_record.dat_file_path      = NULL;
@@ -2961,6 +4595,14 @@ playlist_t *playlist_init(const playlist_config_t *config)
    if (!playlist_read_file(playlist))
       goto error;
 
+   /* Apply changes made since it was last written */
+   playlist_journal_replay(playlist);
+
+   /* Journals are only replayed on top of an existing
+    * playlist file, so the first write has to create it */
+   if (!path_is_valid(playlist->config.path))
+      playlist->flags |= CNT_PLAYLIST_FLG_JOURNAL_STALE;
+
    /* Try auto-fixing paths if enabled, and playlist
     * base content directory is different */
    if (    config->autofix_paths
@@ -2972,6 +4614,8 @@ playlist_t *playlist_init(const playlist_config_t *config)
          size_t i, j, _len;
          char tmp_entry_path[PATH_MAX_LENGTH];
 
+         playlist_cache_release(playlist, true);
+
          for (i = 0, _len = RBUF_LEN(playlist->entries); i < _len; i++)
          {
             struct playlist_entry* entry = &playlist->entries[i];
@@ -3163,6 +4807,8 @@ void playlist_qsort(playlist_t *playlist)
    qsort(playlist->entries, RBUF_LEN(playlist->entries),
          sizeof(struct playlist_entry),
          (int (*)(const void *, const void *))playlist_qsort_func);
+   playlist->path_index.valid = false;
+   playlist->flags           |= CNT_PLAYLIST_FLG_JOURNAL_STALE;
 }
 
 void command_playlist_push_write(
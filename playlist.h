@@ -152,6 +152,8 @@ typedef struct
    size_t capacity;
    bool old_format;
    bool compress;
+   bool journal;
+   bool cache;
    bool fuzzy_archive_match;
    bool autofix_paths;
    char path[PATH_MAX_LENGTH];
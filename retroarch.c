@@ -176,6 +176,7 @@
 #include "autosave.h"
 #include "config.features.h"
 #include "content.h"
+#include "content_fingerprint.h"
 #include "core_info.h"
 #include "dynamic.h"
 #include "defaults.h"
@@ -1513,9 +1514,7 @@ void driver_set_nonblock_state(void)
    }
 
    if (audio_driver_active && audio_st->context_audio_data)
-      audio_st->current_audio->set_nonblock_state(
-            audio_st->context_audio_data,
-            audio_sync ? enable : true);
+      audio_driver_set_nonblock_state(audio_sync ? enable : true);
 
    audio_st->chunk_size = enable
       ? audio_st->chunk_nonblock_size
@@ -1623,12 +1622,6 @@ void drivers_init(
       audio_driver_init_internal(
             settings,
             audio_st->callback.callback != NULL);
-      if (     audio_st->current_audio
-            && audio_st->current_audio->device_list_new
-            && audio_st->context_audio_data)
-         audio_st->devices_list = (struct string_list*)
-            audio_st->current_audio->device_list_new(
-                  audio_st->context_audio_data);
    }
 
 #ifdef HAVE_MICROPHONE
@@ -3727,6 +3720,10 @@ bool command_event(enum event_command cmd, void *data)
 #ifdef HAVE_REWIND
          {
             bool rewind_enable        = settings->bools.rewind_enable;
+            bool rewind_threaded      = settings->bools.rewind_threaded;
+            bool rewind_kf_compress   = settings->bools.rewind_keyframe_compress;
+            unsigned rewind_kf_interval = settings->uints.rewind_keyframe_interval;
+            unsigned rewind_kf_budget = settings->uints.rewind_keyframe_budget;
             size_t rewind_buf_size    = settings->sizes.rewind_buffer_size;
             bool core_type_is_dummy   = runloop_st->current_core_type == CORE_TYPE_DUMMY;
 
@@ -3750,7 +3747,9 @@ bool command_event(enum event_command cmd, void *data)
 #endif
                {
                   state_manager_event_init(&runloop_st->rewind_st,
-                        (unsigned)rewind_buf_size);
+                        (unsigned)rewind_buf_size, rewind_threaded,
+                        rewind_kf_interval, rewind_kf_budget,
+                        rewind_kf_compress);
                }
             }
          }
@@ -4047,6 +4046,8 @@ bool command_event(enum event_command cmd, void *data)
             playlist_config.capacity               = settings->uints.content_history_size;
             playlist_config.old_format             = settings->bools.playlist_use_old_format;
             playlist_config.compress               = settings->bools.playlist_compression;
+            playlist_config.journal                = settings->bools.playlist_journal;
+            playlist_config.cache                  = settings->bools.playlist_cache;
             playlist_config.fuzzy_archive_match    = settings->bools.playlist_fuzzy_archive_match;
             /* don't use relative paths for content, music, video, and image histories */
             playlist_config_set_base_content_directory(&playlist_config, NULL);
@@ -4454,6 +4455,8 @@ bool command_event(enum event_command cmd, void *data)
                   playlist_config.capacity            = COLLECTION_SIZE;
                   playlist_config.old_format          = settings->bools.playlist_use_old_format;
                   playlist_config.compress            = settings->bools.playlist_compression;
+                  playlist_config.journal             = settings->bools.playlist_journal;
+                  playlist_config.cache               = settings->bools.playlist_cache;
                   playlist_config.fuzzy_archive_match = settings->bools.playlist_fuzzy_archive_match;
                   playlist_config_set_base_content_directory(&playlist_config,
                         settings->bools.playlist_portable_paths
@@ -5785,6 +5788,7 @@ void main_exit(void *args)
    retroarch_ctl(RARCH_CTL_STATE_FREE,  NULL);
    global_free(p_rarch);
    task_queue_deinit();
+   content_fingerprint_deinit();
 
    ui_companion_driver_deinit();
    retroarch_config_deinit();
@@ -5795,6 +5799,7 @@ void main_exit(void *args)
    uico_state_get_ptr()->drv = NULL;
    frontend_driver_free();
 
+   retro_resampler_cache_deinit();
    rtime_deinit();
 
 #if defined(ANDROID)
@@ -5851,6 +5856,7 @@ int rarch_main(int argc, char *argv[], void *data)
 #endif
 
    rtime_init();
+   retro_resampler_cache_init();
 
 #if defined(ANDROID)
    play_feature_delivery_init();
@@ -7448,6 +7454,7 @@ static bool retroarch_parse_input_and_config(
 
                   drivers_init(settings, reinit_flags, (enum driver_lifetime_flags)0, false);
                   retroarch_init_task_queue();
+                  content_fingerprint_init();
 
 #ifdef HAVE_MENU
                   if (explicit_menu)
@@ -7464,6 +7471,7 @@ static bool retroarch_parse_input_and_config(
                   if (!explicit_menu)
                   {
                      task_queue_wait(NULL, NULL);
+                     content_fingerprint_deinit();
                      driver_uninit(DRIVERS_CMD_ALL, (enum driver_lifetime_flags)0);
                      exit(0);
                   }
@@ -7739,6 +7747,7 @@ bool retroarch_main_init(int argc, char *argv[])
 
    retroarch_validate_cpu_features();
    retroarch_init_task_queue();
+   content_fingerprint_init();
 
    {
       const char    *fullpath  = p_rarch->path_content;
@@ -8594,6 +8603,8 @@ void retroarch_favorites_init(void)
    playlist_config.capacity            = COLLECTION_SIZE;
    playlist_config.old_format          = settings ? settings->bools.playlist_use_old_format : false;
    playlist_config.compress            = settings ? settings->bools.playlist_compression : false;
+   playlist_config.journal             = settings ? settings->bools.playlist_journal : false;
+   playlist_config.cache               = settings ? settings->bools.playlist_cache : false;
    playlist_config.fuzzy_archive_match = settings ? settings->bools.playlist_fuzzy_archive_match : false;
    playlist_config_set_base_content_directory(&playlist_config, NULL);
 
@@ -6935,8 +6935,8 @@ int runloop_iterate(void)
       {
          size_t audio_buf_avail;
 
-         if ((audio_buf_avail = audio_st->current_audio->write_avail(
-               audio_st->context_audio_data)) > audio_st->buffer_size)
+         if ((audio_buf_avail = audio_driver_write_avail())
+               > audio_st->buffer_size)
             audio_buf_avail = audio_st->buffer_size;
 
          audio_buf_occupancy = (unsigned)(100 - (audio_buf_avail * 100) /
@@ -6958,6 +6958,12 @@ int runloop_iterate(void)
                audio_buf_active, audio_buf_occupancy, audio_buf_underrun);
    }
 
+#ifdef HAVE_BSV_MOVIE
+   /* Long replay seeks advance a batch of frames per
+    * iteration, also while paused */
+   bsv_movie_seek_step(input_st);
+#endif
+
    switch ((enum runloop_state_enum)runloop_check_state(
             input_st, audio_st, video_st,
             uico_st,
@@ -7119,8 +7125,7 @@ end:
             /* Nonblocking audio */
             if (    (audio_st->flags & AUDIO_FLAG_ACTIVE)
                  && (audio_st->context_audio_data))
-               audio_st->current_audio->set_nonblock_state(
-                     audio_st->context_audio_data, true);
+               audio_driver_set_nonblock_state(true);
             audio_st->chunk_size =
                audio_st->chunk_nonblock_size;
          }
@@ -7132,9 +7137,7 @@ end:
             /* Blocking audio */
             if (     (audio_st->flags & AUDIO_FLAG_ACTIVE)
                   && (audio_st->context_audio_data))
-               audio_st->current_audio->set_nonblock_state(
-                     audio_st->context_audio_data,
-                     audio_sync ? false : true);
+               audio_driver_set_nonblock_state(!audio_sync);
 
             audio_st->chunk_size = audio_st->chunk_block_size;
             runloop_st->fastforward_after_frames = 0;
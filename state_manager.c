@@ -26,6 +26,8 @@
 #include <retro_inline.h>
 #include <compat/strl.h>
 #include <compat/intrinsics.h>
+#include <features/features_cpu.h>
+#include <streams/trans_stream.h>
 
 #include "state_manager.h"
 #include "msg_hash.h"
@@ -65,6 +67,30 @@
 #include <emmintrin.h>
 #endif
 
+/* AVX2 is picked at runtime, so it must be usable
+ * without building the whole file for AVX2 */
+#if defined(CPU_X86) && (defined(__AVX2__) \
+      || (defined(_MSC_VER) && _MSC_VER >= 1800) \
+      || defined(__clang__) \
+      || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define HAVE_FIND_CHANGE_AVX2
+#include <immintrin.h>
+#if defined(__AVX2__) || defined(_MSC_VER)
+#define FIND_CHANGE_AVX2_TARGET
+#else
+#define FIND_CHANGE_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+#if (defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(HAVE_NEON)) && !defined(__ARM_BIG_ENDIAN)
+#define HAVE_FIND_CHANGE_NEON
+#include <arm_neon.h>
+#endif
+
+/* Scanning loads up to this many bytes at once;
+ * state blocks are padded accordingly */
+#define STATE_BLOCK_PADDING 32
+
 /* Format per frame (pseudocode): */
 #if 0
 size nextstart;
@@ -145,6 +171,85 @@ static size_t find_change(const uint16_t *a, const uint16_t *b)
 #endif
 }
 
+#ifdef HAVE_FIND_CHANGE_AVX2
+static FIND_CHANGE_AVX2_TARGET size_t find_change_avx2(
+      const uint16_t *a, const uint16_t *b)
+{
+   const __m256i *a256 = (const __m256i*)a;
+   const __m256i *b256 = (const __m256i*)b;
+
+   for (;;)
+   {
+      __m256i v0    = _mm256_loadu_si256(a256);
+      __m256i v1    = _mm256_loadu_si256(b256);
+      __m256i c     = _mm256_cmpeq_epi8(v0, v1);
+      uint32_t mask = (uint32_t)_mm256_movemask_epi8(c);
+
+      if (mask != 0xffffffff)
+      {
+         size_t ret = ((uint8_t*)a256 - (uint8_t*)a)
+            + compat_ctz(~mask);
+         return (ret >> 1);
+      }
+
+      a256++;
+      b256++;
+   }
+}
+#endif
+
+#ifdef HAVE_FIND_CHANGE_NEON
+/* Index of the first byte that differs,
+ * given a 64-bit lane of byte compare results */
+static INLINE unsigned find_change_neon_lane(uint64_t eq)
+{
+   uint64_t ne = ~eq;
+   if ((uint32_t)ne)
+      return compat_ctz((uint32_t)ne) >> 3;
+   return 4 + (compat_ctz((uint32_t)(ne >> 32)) >> 3);
+}
+
+static size_t find_change_neon(const uint16_t *a, const uint16_t *b)
+{
+   const uint8_t *a8 = (const uint8_t*)a;
+   const uint8_t *b8 = (const uint8_t*)b;
+
+   for (;;)
+   {
+      uint8x16_t c = vceqq_u8(vld1q_u8(a8), vld1q_u8(b8));
+      uint64_t lo  = vgetq_lane_u64(vreinterpretq_u64_u8(c), 0);
+      uint64_t hi  = vgetq_lane_u64(vreinterpretq_u64_u8(c), 1);
+
+      if (lo != UINT64_C(0xffffffffffffffff))
+         return ((a8 - (const uint8_t*)a)
+               + find_change_neon_lane(lo)) >> 1;
+      if (hi != UINT64_C(0xffffffffffffffff))
+         return ((a8 - (const uint8_t*)a) + 8
+               + find_change_neon_lane(hi)) >> 1;
+
+      a8 += 16;
+      b8 += 16;
+   }
+}
+#endif
+
+/* Picks the fastest find_change() the CPU supports */
+static state_manager_find_change_t find_change_get_impl(void)
+{
+#if defined(HAVE_FIND_CHANGE_AVX2) || defined(HAVE_FIND_CHANGE_NEON)
+   uint64_t cpu = cpu_features_get();
+#endif
+#ifdef HAVE_FIND_CHANGE_AVX2
+   if (cpu & RETRO_SIMD_AVX2)
+      return find_change_avx2;
+#endif
+#ifdef HAVE_FIND_CHANGE_NEON
+   if (cpu & (RETRO_SIMD_NEON | RETRO_SIMD_ASIMD))
+      return find_change_neon;
+#endif
+   return find_change;
+}
+
 static size_t find_same(const uint16_t *a, const uint16_t *b)
 {
    const uint16_t *a_org = a;
@@ -206,7 +311,8 @@ static size_t state_manager_raw_maxsize(size_t uncomp)
 static void *state_manager_raw_alloc(size_t len, uint16_t uniq)
 {
    size_t  _len  = (len + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
-   uint16_t *ret = (uint16_t*)calloc(_len + sizeof(uint16_t) * 4 + 16, 1);
+   uint16_t *ret = (uint16_t*)calloc(_len + sizeof(uint16_t) * 4
+         + STATE_BLOCK_PADDING, 1);
 
    if (!ret)
       return NULL;
@@ -220,8 +326,8 @@ static void *state_manager_raw_alloc(size_t len, uint16_t uniq)
     * There is also some padding at the end. This is so we don't
     * read outside the buffer end if we're reading in large blocks;
     *
-    * It doesn't make any difference to us, but sacrificing 16 bytes to get
-    * Valgrind happy is worth it. */
+    * It doesn't make any difference to us, but sacrificing a few bytes to
+    * get Valgrind happy is worth it. */
    ret[_len / sizeof(uint16_t) + 3] = uniq;
 
    return ret;
@@ -235,8 +341,9 @@ static void *state_manager_raw_alloc(size_t len, uint16_t uniq)
  * 'patch' must be size 'state_manager_raw_maxsize(len)' or more.
  * Returns the number of bytes actually written to 'patch'.
  */
-static size_t state_manager_raw_compress(const void *src,
-      const void *dst, size_t len, void *patch)
+static size_t state_manager_raw_compress(
+      state_manager_find_change_t find_change_impl,
+      const void *src, const void *dst, size_t len, void *patch)
 {
    const uint16_t  *old16 = (const uint16_t*)src;
    const uint16_t  *new16 = (const uint16_t*)dst;
@@ -247,7 +354,7 @@ static size_t state_manager_raw_compress(const void *src,
    while (num16s)
    {
       size_t i, changed;
-      size_t skip = find_change(old16, new16);
+      size_t skip = find_change_impl(old16, new16);
 
       if (skip >= num16s)
          break;
@@ -374,11 +481,221 @@ static INLINE size_t read_size_t(const void *ptr)
    return ret;
 }
 
+static void state_manager_keyframe_drop_front(state_manager_t *state)
+{
+   state->keyframe_bytes -= state->keyframes[0].size;
+   free(state->keyframes[0].data);
+   state->num_keyframes--;
+   memmove(state->keyframes, state->keyframes + 1,
+         state->num_keyframes * sizeof(*state->keyframes));
+}
+
+/* Forgets keyframes of frames newer than the current one;
+ * they'll be overwritten by the next push. */
+static void state_manager_keyframe_drop_newer(state_manager_t *state)
+{
+   while (   state->num_keyframes
+          && state->keyframes[state->num_keyframes - 1].serial > state->serial)
+   {
+      state_manager_keyframe_t *kf = &state->keyframes[--state->num_keyframes];
+      state->keyframe_bytes       -= kf->size;
+      free(kf->data);
+   }
+}
+
+static void state_manager_keyframe_push(state_manager_t *state,
+      const uint8_t *block)
+{
+   state_manager_keyframe_t *kf;
+   uint8_t *data = NULL;
+   size_t size   = state->blocksize;
+
+   if (state->keyframe_stream)
+   {
+      uint32_t rd, wn;
+      const struct trans_stream_backend *be =
+         trans_stream_get_lz4_compress_backend();
+      size_t bound  = size + size / 255 + 16;
+
+      if (!(data = (uint8_t*)malloc(bound)))
+         return;
+
+      be->set_in(state->keyframe_stream, block, (uint32_t)size);
+      be->set_out(state->keyframe_stream, data, (uint32_t)bound);
+      if (!be->trans(state->keyframe_stream, true, &rd, &wn, NULL))
+      {
+         free(data);
+         return;
+      }
+      size = wn;
+   }
+   else if ((data = (uint8_t*)malloc(size)))
+      memcpy(data, block, size);
+
+   if (!data)
+      return;
+
+   if (size > state->keyframe_budget)
+   {
+      free(data);
+      return;
+   }
+
+   while (state->keyframe_bytes + size > state->keyframe_budget)
+      state_manager_keyframe_drop_front(state);
+
+   if (state->num_keyframes == state->cap_keyframes)
+   {
+      size_t new_cap = state->cap_keyframes ? state->cap_keyframes * 2 : 16;
+      state_manager_keyframe_t *tmp = (state_manager_keyframe_t*)realloc(
+            state->keyframes, new_cap * sizeof(*tmp));
+      if (!tmp)
+      {
+         free(data);
+         return;
+      }
+      state->keyframes     = tmp;
+      state->cap_keyframes = new_cap;
+   }
+
+   kf                     = &state->keyframes[state->num_keyframes++];
+   kf->data               = data;
+   kf->size               = size;
+   kf->head               = state->head - state->data;
+   kf->serial             = state->serial;
+   state->keyframe_bytes += size;
+}
+
+/* Appends the patch turning 'newb' back into 'oldb' to the ring,
+ * dropping the oldest entries if there's no room for it.
+ * 'newb' is frame 'state->serial'. */
+static void state_manager_push_compress(state_manager_t *state,
+      const uint8_t *oldb, const uint8_t *newb)
+{
+   uint8_t *compressed;
+   size_t headpos, tailpos, remaining;
+
+recheckcapacity:;
+   headpos   = state->head - state->data;
+   tailpos   = state->tail - state->data;
+   remaining = (tailpos + state->capacity -
+         sizeof(size_t) - headpos - 1) % state->capacity + 1;
+
+   if (remaining <= state->maxcompsize)
+   {
+      state->tail = state->data + read_size_t(state->tail);
+      state->entries--;
+      state->oldest++;
+      goto recheckcapacity;
+   }
+
+   compressed        = state->head + sizeof(size_t);
+
+   compressed       += state_manager_raw_compress(state->find_change,
+         oldb, newb, state->blocksize, compressed);
+
+   if (compressed - state->data + state->maxcompsize > state->capacity)
+   {
+      compressed     = state->data;
+      if (state->tail == state->data + sizeof(size_t))
+      {
+         state->tail = state->data + read_size_t(state->tail);
+         state->oldest++;
+      }
+   }
+   write_size_t(compressed, state->head-state->data);
+   compressed       += sizeof(size_t);
+   write_size_t(state->head, compressed-state->data);
+   state->head       = compressed;
+
+   /* A keyframe is useless once its entry left the ring */
+   while (   state->num_keyframes
+          && state->keyframes[0].serial <= state->oldest)
+      state_manager_keyframe_drop_front(state);
+
+   if (     state->keyframe_interval
+         && (state->serial % state->keyframe_interval) == 0)
+      state_manager_keyframe_push(state, newb);
+}
+
+#ifdef HAVE_THREADS
+static void state_manager_thread(void *data)
+{
+   state_manager_t *state = (state_manager_t*)data;
+
+   slock_lock(state->lock);
+   for (;;)
+   {
+      while (!state->job_pending && !state->quit)
+         scond_wait(state->cond, state->lock);
+
+      if (state->quit)
+         break;
+
+      slock_unlock(state->lock);
+      state_manager_push_compress(state, state->job_old, state->job_new);
+      slock_lock(state->lock);
+
+      state->job_pending = false;
+      scond_signal(state->cond);
+   }
+   slock_unlock(state->lock);
+}
+
+/* Blocks until the helper thread is done with the ring
+ * and the blocks it was diffing. */
+static void state_manager_wait(state_manager_t *state)
+{
+   if (!state->thread)
+      return;
+
+   slock_lock(state->lock);
+   while (state->job_pending)
+      scond_wait(state->cond, state->lock);
+   slock_unlock(state->lock);
+}
+#endif
+
 static void state_manager_free(state_manager_t *state)
 {
    if (!state)
       return;
 
+#ifdef HAVE_THREADS
+   if (state->thread)
+   {
+      slock_lock(state->lock);
+      state->quit = true;
+      scond_signal(state->cond);
+      slock_unlock(state->lock);
+      sthread_join(state->thread);
+   }
+   if (state->lock)
+      slock_free(state->lock);
+   if (state->cond)
+      scond_free(state->cond);
+   if (state->spareblock)
+      free(state->spareblock);
+   state->thread     = NULL;
+   state->lock       = NULL;
+   state->cond       = NULL;
+   state->spareblock = NULL;
+#endif
+
+   if (state->keyframes)
+   {
+      size_t i;
+      for (i = 0; i < state->num_keyframes; i++)
+         free(state->keyframes[i].data);
+      free(state->keyframes);
+   }
+   if (state->keyframe_stream)
+      trans_stream_get_lz4_compress_backend()->stream_free(
+            state->keyframe_stream);
+   state->keyframes       = NULL;
+   state->keyframe_stream = NULL;
+   state->num_keyframes   = 0;
+
    if (state->data)
       free(state->data);
    if (state->thisblock)
@@ -396,9 +713,12 @@ static void state_manager_free(state_manager_t *state)
 }
 
 static state_manager_t *state_manager_new(
-      size_t state_size, size_t buffer_size)
+      size_t state_size, size_t buffer_size, bool threaded,
+      unsigned keyframe_interval, unsigned keyframe_budget_pct,
+      bool keyframe_compress)
 {
    size_t max_comp_size, block_size;
+   size_t keyframe_budget = 0;
    uint8_t *next_block    = NULL;
    uint8_t *this_block    = NULL;
    uint8_t *state_data    = NULL;
@@ -410,6 +730,12 @@ static state_manager_t *state_manager_new(
    block_size         = (state_size + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
    /* the compressed data is surrounded by pointers to the other side */
    max_comp_size      = state_manager_raw_maxsize(state_size) + sizeof(size_t) * 2;
+
+   /* Keyframes come on top of the ring, so enabling
+    * them doesn't reduce how far back deltas reach */
+   if (keyframe_interval)
+      keyframe_budget = buffer_size / 100 * keyframe_budget_pct;
+
    state_data         = (uint8_t*)malloc(buffer_size);
 
    if (!state_data)
@@ -427,10 +753,35 @@ static state_manager_t *state_manager_new(
    state->thisblock   = this_block;
    state->nextblock   = next_block;
    state->capacity    = buffer_size;
+   state->find_change = find_change_get_impl();
+
+   state->keyframe_interval = keyframe_interval;
+   state->keyframe_budget   = keyframe_budget;
+   if (keyframe_interval && keyframe_compress)
+      state->keyframe_stream = trans_stream_get_lz4_compress_backend()
+         ->stream_new();
 
    state->head        = state->data + sizeof(size_t);
    state->tail        = state->data + sizeof(size_t);
 
+#ifdef HAVE_THREADS
+   /* Not worth a thread on a single core */
+   if (threaded && cpu_features_get_core_amount() > 1)
+   {
+      /* Every pair of blocks that ever gets diffed
+       * needs distinct sentinels, hence uniq 2 */
+      state->spareblock = (uint8_t*)state_manager_raw_alloc(state_size, 2);
+      state->lock       = slock_new();
+      state->cond       = scond_new();
+
+      if (state->spareblock && state->lock && state->cond)
+         state->thread  = sthread_create(state_manager_thread, state);
+
+      if (!state->thread)
+         RARCH_WARN("[Rewind] Failed to start delta thread, falling back to serial mode.\n");
+   }
+#endif
+
 #if STRICT_BUF_SIZE
    state->debugsize   = state_size;
    state->debugblock  = (uint8_t*)malloc(state_size);
@@ -447,14 +798,36 @@ error:
    return NULL;
 }
 
-static bool state_manager_pop(state_manager_t *state, const void **data)
+/* Undoes the newest patch in the ring, leaving
+ * the previous state in thisblock. */
+static bool state_manager_pop_patch(state_manager_t *state)
 {
    size_t start;
-   uint8_t *out                 = NULL;
    const uint8_t *compressed    = NULL;
 
+   if (state->head == state->tail)
+      return false;
+
+   start                        = read_size_t(state->head - sizeof(size_t));
+   state->head                  = state->data + start;
+   compressed                   = state->data + start + sizeof(size_t);
+
+   state_manager_raw_decompress(compressed, state->thisblock);
+
+   state->entries--;
+   state->serial--;
+   state_manager_keyframe_drop_newer(state);
+   return true;
+}
+
+static bool state_manager_pop(state_manager_t *state, const void **data)
+{
    *data                        = NULL;
 
+#ifdef HAVE_THREADS
+   state_manager_wait(state);
+#endif
+
    if (state->thisblock_valid)
    {
       state->thisblock_valid    = false;
@@ -464,17 +837,89 @@ static bool state_manager_pop(state_manager_t *state, const void **data)
    }
 
    *data                        = state->thisblock;
-   if (state->head == state->tail)
+   return state_manager_pop_patch(state);
+}
+
+/* Same as popping until the state 'frames_back' steps
+ * before the current one comes out, but starts from the
+ * closest keyframe when that's cheaper than undoing
+ * every patch on the way. */
+static bool state_manager_seek_frames(state_manager_t *state,
+      unsigned frames_back, const void **data)
+{
+   size_t i;
+   uint64_t target;
+
+#ifdef HAVE_THREADS
+   state_manager_wait(state);
+#endif
+
+   *data                        = state->thisblock;
+
+   if (!state->thisblock_valid && state->head == state->tail)
       return false;
 
-   start                        = read_size_t(state->head - sizeof(size_t));
-   state->head                  = state->data + start;
-   compressed                   = state->data + start + sizeof(size_t);
-   out                          = state->thisblock;
+   if (state->thisblock_valid)
+   {
+      state->thisblock_valid    = false;
+      state->entries--;
+   }
 
-   state_manager_raw_decompress(compressed, out);
+   if (frames_back > state->serial - state->oldest)
+      frames_back               = (unsigned)(state->serial - state->oldest);
+   target                       = state->serial - frames_back;
+
+   for (i = 0; i < state->num_keyframes; i++)
+   {
+      state_manager_keyframe_t *kf = &state->keyframes[i];
+      size_t skipped;
+
+      if (kf->serial < target)
+         continue;
+      if (kf->serial >= state->serial)
+         break;
+
+      /* Only worth it if the patches we'd skip
+       * add up to more than one whole state */
+      skipped = (state->head - state->data + state->capacity
+            - kf->head) % state->capacity;
+      if (skipped < state->blocksize)
+         break;
+
+      if (state->keyframe_stream)
+      {
+         uint32_t rd, wn;
+         const struct trans_stream_backend *be =
+            trans_stream_get_lz4_decompress_backend();
+         void *stream = be->stream_new();
+         bool ok      = false;
+
+         if (stream)
+         {
+            be->set_in(stream, kf->data, (uint32_t)kf->size);
+            be->set_out(stream, state->thisblock, (uint32_t)state->blocksize);
+            ok = be->trans(stream, true, &rd, &wn, NULL)
+               && wn == state->blocksize;
+            be->stream_free(stream);
+         }
+
+         if (!ok)
+            break;
+      }
+      else
+         memcpy(state->thisblock, kf->data, state->blocksize);
+
+      state->entries           -= (unsigned)(state->serial - kf->serial);
+      state->serial             = kf->serial;
+      state->head               = state->data + kf->head;
+      state_manager_keyframe_drop_newer(state);
+      break;
+   }
+
+   while (state->serial > target)
+      if (!state_manager_pop_patch(state))
+         break;
 
-   state->entries--;
    return true;
 }
 
@@ -508,50 +953,51 @@ static void state_manager_push_do(state_manager_t *state)
    memcpy(state->nextblock, state->debugblock, state->debugsize);
 #endif
 
+#ifdef HAVE_THREADS
+   state_manager_wait(state);
+#endif
+
    if (state->thisblock_valid)
    {
-      uint8_t *compressed;
-      const uint8_t *oldb, *newb;
-      size_t headpos, tailpos, remaining;
       if (state->capacity < sizeof(size_t) + state->maxcompsize)
       {
          RARCH_ERR("State capacity insufficient\n");
          return;
       }
 
-recheckcapacity:;
-      headpos   = state->head - state->data;
-      tailpos   = state->tail - state->data;
-      remaining = (tailpos + state->capacity -
-            sizeof(size_t) - headpos - 1) % state->capacity + 1;
+      state->serial++;
 
-      if (remaining <= state->maxcompsize)
+#ifdef HAVE_THREADS
+      if (state->thread)
       {
-         state->tail = state->data + read_size_t(state->tail);
-         state->entries--;
-         goto recheckcapacity;
-      }
-
-      oldb              = state->thisblock;
-      newb              = state->nextblock;
-      compressed        = state->head + sizeof(size_t);
-
-      compressed       += state_manager_raw_compress(oldb, newb,
-            state->blocksize, compressed);
+         /* Hand the diff to the helper thread; the next state
+          * gets serialized into the spare block meanwhile. */
+         state->job_old          = state->thisblock;
+         state->job_new          = state->nextblock;
+         state->thisblock        = state->nextblock;
+         state->nextblock        = state->spareblock;
+         state->spareblock       = (uint8_t*)state->job_old;
+         state->entries++;
 
-      if (compressed - state->data + state->maxcompsize > state->capacity)
-      {
-         compressed     = state->data;
-         if (state->tail == state->data + sizeof(size_t))
-            state->tail = state->data + read_size_t(state->tail);
+         slock_lock(state->lock);
+         state->job_pending      = true;
+         scond_signal(state->cond);
+         slock_unlock(state->lock);
+         return;
       }
-      write_size_t(compressed, state->head-state->data);
-      compressed       += sizeof(size_t);
-      write_size_t(state->head, compressed-state->data);
-      state->head       = compressed;
+#endif
+
+      state_manager_push_compress(state, state->thisblock, state->nextblock);
    }
    else
+   {
+      /* Nothing left to diff against, the ring starts over */
       state->thisblock_valid = true;
+      state->serial++;
+      state->oldest          = state->serial;
+      while (state->num_keyframes)
+         state_manager_keyframe_drop_front(state);
+   }
 
    swap                      = state->thisblock;
    state->thisblock          = state->nextblock;
@@ -580,7 +1026,9 @@ static void state_manager_capacity(state_manager_t *state,
 
 void state_manager_event_init(
       struct state_manager_rewind_state *rewind_st,
-      unsigned rewind_buffer_size)
+      unsigned rewind_buffer_size, bool threaded,
+      unsigned keyframe_interval, unsigned keyframe_budget,
+      bool keyframe_compress)
 {
    core_info_t *core_info = NULL;
    void *state            = NULL;
@@ -633,7 +1081,8 @@ void state_manager_event_init(
          (unsigned)(rewind_buffer_size / 1000000));
 
    rewind_st->state = state_manager_new(rewind_st->size,
-         rewind_buffer_size);
+         rewind_buffer_size, threaded,
+         keyframe_interval, keyframe_budget, keyframe_compress);
 
    if (!rewind_st->state)
       RARCH_WARN("%s.\n", msg_hash_to_str(MSG_REWIND_INIT_FAILED));
@@ -686,6 +1135,29 @@ void state_manager_event_deinit(
    }
 }
 
+bool state_manager_seek(struct state_manager_rewind_state *rewind_st,
+      unsigned frames_back)
+{
+   const void *buf = NULL;
+
+   if (!rewind_st || !rewind_st->state)
+      return false;
+
+   /* Movies are recorded frame by frame, and
+    * netplay can't follow a jump */
+   if (retroarch_ctl(RARCH_CTL_BSV_MOVIE_IS_INITED, NULL))
+      return false;
+#ifdef HAVE_NETWORKING
+   if (netplay_driver_ctl(RARCH_NETPLAY_CTL_IS_ENABLED, NULL))
+      return false;
+#endif
+
+   if (!state_manager_seek_frames(rewind_st->state, frames_back, &buf))
+      return false;
+
+   return content_deserialize_state(buf, rewind_st->size);
+}
+
 /**
  * check_rewind:
  * @pressed              : was rewind key pressed or held?
@@ -24,6 +24,10 @@
 #include <boolean.h>
 #include <retro_common_api.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #include "dynamic.h"
 
 RETRO_BEGIN_DECLS
@@ -36,6 +40,19 @@ enum state_manager_rewind_st_flags
    STATE_MGR_REWIND_ST_FLAG_HOTKEY_WAS_PRESSED    = (1 << 3)
 };
 
+typedef size_t (*state_manager_find_change_t)(
+      const uint16_t *a, const uint16_t *b);
+
+typedef struct state_manager_keyframe
+{
+   uint8_t *data;
+   /* Stored size, after compression if enabled. */
+   size_t size;
+   /* Ring head offset right after this frame's entry. */
+   size_t head;
+   uint64_t serial;
+} state_manager_keyframe_t;
+
 struct state_manager
 {
    uint8_t *data;
@@ -50,6 +67,37 @@ struct state_manager
    uint8_t *debugblock;
    size_t debugsize;
 #endif
+#ifdef HAVE_THREADS
+   /* Threaded mode only: the helper thread diffs
+    * job_old against job_new while the core runs,
+    * and the core serializes into a third block. */
+   uint8_t *spareblock;
+   const uint8_t *job_old;
+   const uint8_t *job_new;
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   bool job_pending;
+   bool quit;
+#endif
+
+   /* Fastest delta scanner for this CPU. */
+   state_manager_find_change_t find_change;
+
+   /* Full copies of every Nth state, oldest first,
+    * so that seeking doesn't walk the whole delta chain. */
+   state_manager_keyframe_t *keyframes;
+   void *keyframe_stream;
+   size_t num_keyframes;
+   size_t cap_keyframes;
+   size_t keyframe_bytes;
+   size_t keyframe_budget;
+   unsigned keyframe_interval;
+
+   /* Frame held in thisblock, and the oldest one
+    * the ring can still reproduce. */
+   uint64_t serial;
+   uint64_t oldest;
 
    size_t capacity;
    /* This one is rounded up from reset::blocksize. */
@@ -80,7 +128,24 @@ void state_manager_event_deinit(
       struct retro_core_t *current_core);
 
 void state_manager_event_init(struct state_manager_rewind_state *rewind_st,
-      unsigned rewind_buffer_size);
+      unsigned rewind_buffer_size, bool threaded,
+      unsigned keyframe_interval, unsigned keyframe_budget,
+      bool keyframe_compress);
+
+/**
+ * state_manager_seek:
+ * @frames_back          : how many rewind steps to go back
+ *
+ * Jumps back in the rewind buffer and loads the resulting
+ * state into the core. Starts from the nearest keyframe,
+ * so the cost is bounded by the keyframe interval rather
+ * than by @frames_back. Rewinding past the oldest state
+ * stops there.
+ *
+ * Returns: true if a state was loaded.
+ **/
+bool state_manager_seek(struct state_manager_rewind_state *rewind_st,
+      unsigned frames_back);
 
 /**
  * check_rewind:
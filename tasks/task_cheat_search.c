@@ -0,0 +1,81 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <queues/task_queue.h>
+
+#include "../cheat_manager.h"
+#include "../msg_hash.h"
+
+#include "tasks_internal.h"
+
+static void task_cheat_search_handler(retro_task_t *task)
+{
+   bool done;
+   cheat_search_t *search = (cheat_search_t*)task->state;
+
+   if (!search || (task_get_flags(task) & RETRO_TASK_FLG_CANCELLED))
+   {
+      task_set_flags(task, RETRO_TASK_FLG_FINISHED, true);
+      return;
+   }
+
+   done = cheat_manager_search_iterate(search);
+   task_set_progress(task, cheat_manager_search_progress(search));
+
+   if (done)
+      task_set_flags(task, RETRO_TASK_FLG_FINISHED, true);
+}
+
+/* Runs on the main thread, whether the search finished or
+ * was cancelled */
+static void task_cheat_search_cleanup(retro_task_t *task)
+{
+   cheat_search_t *search = (cheat_search_t*)task->state;
+
+   if (search)
+      cheat_manager_search_end(search);
+   task->state = NULL;
+}
+
+bool task_push_cheat_search(struct cheat_search *search)
+{
+   retro_task_t *task = task_init();
+
+   if (!task)
+      return false;
+
+   task->handler  = task_cheat_search_handler;
+   task->cleanup  = task_cheat_search_cleanup;
+   task->state    = search;
+   task->title    = strdup(msg_hash_to_str(MSG_CHEAT_SEARCH_RUNNING));
+   task->progress = 0;
+   task->flags   |= RETRO_TASK_FLG_ALTERNATIVE_LOOK;
+
+   if (!task_queue_push(task))
+   {
+      /* The caller still owns the search */
+      task->state = NULL;
+      if (task->title)
+         task_free_title(task);
+      free(task);
+      return false;
+   }
+
+   return true;
+}
@@ -58,9 +58,20 @@
 #include <lists/dir_list.h>
 #include <vfs/vfs_implementation.h>
 #include <array/rbuf.h>
+#include <memmap.h>
 
 #include <retro_miscellaneous.h>
 
+/* Platforms without a real mmap() only get
+ * memmap.h's malloc() stand-in */
+#if defined(HAVE_MMAN)
+#include <unistd.h>
+#define HAVE_CONTENT_MMAP
+#elif defined(_WIN32) && !defined(_XBOX) && !defined(__WINRT__) \
+   && (!defined(_MSC_VER) || _MSC_VER >= 1500)
+#define HAVE_CONTENT_MMAP
+#endif
+
 #ifdef HAVE_MENU
 #include "../menu/menu_driver.h"
 #endif
@@ -83,6 +94,7 @@
 #include "../command.h"
 #include "../core_info.h"
 #include "../content.h"
+#include "../content_fingerprint.h"
 #include "../core.h"
 #include "../configuration.h"
 #include "../defaults.h"
@@ -268,6 +280,21 @@ bool content_file_override_set(
    return true;
 }
 
+/* Frees a content data buffer, which is either
+ * a heap allocation or a memory mapped file */
+static void content_file_data_free(void *data, size_t data_size,
+      bool data_mapped)
+{
+#ifdef HAVE_CONTENT_MMAP
+   if (data_mapped)
+   {
+      munmap(data, data_size);
+      return;
+   }
+#endif
+   free(data);
+}
+
 /* Frees any content data that is not flagged
  * as 'persistent'. Should be called after
  * content_file_load() */
@@ -286,10 +313,12 @@ static void content_file_list_free_transient_data(
       if (file_info->data &&
           !file_info->persistent_data)
       {
-         free((void*)file_info->data);
+         content_file_data_free(file_info->data,
+               file_info->data_size, file_info->data_mapped);
 
-         file_info->data      = NULL;
-         file_info->data_size = 0;
+         file_info->data        = NULL;
+         file_info->data_size   = 0;
+         file_info->data_mapped = false;
       }
    }
 }
@@ -344,10 +373,12 @@ static void content_file_list_free_entry(
 
    if (file_info->data)
    {
-      free((void*)file_info->data);
+      content_file_data_free(file_info->data,
+            file_info->data_size, file_info->data_mapped);
       file_info->data = NULL;
    }
    file_info->data_size       = 0;
+   file_info->data_mapped     = false;
 
    file_info->file_in_archive = false;
    file_info->persistent_data = false;
@@ -474,6 +505,7 @@ static bool content_file_list_set_info(
       const char *path,
       void *data,
       size_t data_size,
+      bool data_mapped,
       bool persistent_data,
       size_t idx)
 {
@@ -521,6 +553,7 @@ static bool content_file_list_set_info(
 
    file_info->data            = data;
    file_info->data_size       = data_size;
+   file_info->data_mapped     = data_mapped;
    file_info->persistent_data = persistent_data;
 
    /* Assign paths
@@ -640,6 +673,178 @@ static bool content_file_list_set_info(
 /* Content file info functions END */
 /***********************************/
 
+#ifndef CRC32_BUFFER_SIZE
+#define CRC32_BUFFER_SIZE 1048576
+#endif
+
+#ifndef CRC32_MAX_MB
+#define CRC32_MAX_MB 64
+#endif
+
+/**
+ * Calculate a CRC32 from the first part of the given file.
+ * "first part" being the first (CRC32_BUFFER_SIZE * CRC32_MAX_MB)
+ * bytes.
+ *
+ * @return The calculated CRC32 hash, or 0 if there was an error.
+ */
+static uint32_t file_crc32(uint32_t crc, const char *path)
+{
+   unsigned i;
+   RFILE *file        = NULL;
+   unsigned char *buf = NULL;
+   if (!path)
+      return 0;
+
+   if (!(file = filestream_open(path, RETRO_VFS_FILE_ACCESS_READ, 0)))
+      return 0;
+
+   if (!(buf = (unsigned char*)malloc(CRC32_BUFFER_SIZE)))
+   {
+      filestream_close(file);
+      return 0;
+   }
+
+   for (i = 0; i < CRC32_MAX_MB; i++)
+   {
+      int64_t nread = filestream_read(file, buf, CRC32_BUFFER_SIZE);
+      if (nread < 0)
+      {
+         free(buf);
+         filestream_close(file);
+         return 0;
+      }
+
+      crc = encoding_crc32(crc, buf, (size_t)nread);
+      if (filestream_eof(file))
+         break;
+   }
+   free(buf);
+   filestream_close(file);
+   return crc;
+}
+
+/**
+ * content_file_crc:
+ * @path : path of the content file.
+ *
+ * Gets the CRC32 of the first CRC32_MAX_MB of a content
+ * file, from the fingerprint cache if possible.
+ *
+ * Thread-safe.
+ *
+ * Returns: the CRC32, or 0 if there was an error.
+ **/
+static uint32_t content_file_crc(const char *path)
+{
+   uint32_t crc;
+   content_fingerprint_t fp;
+   int64_t max_size = (int64_t)CRC32_BUFFER_SIZE * CRC32_MAX_MB;
+
+   /* file_crc32 only hashes the first CRC32_MAX_MB, so
+    * a whole file CRC32 (e.g. from a database scan) can
+    * only be used for files smaller than that */
+   if (     content_fingerprint_lookup(path, CONTENT_FINGERPRINT_FILE, &fp)
+         && (fp.flags & CONTENT_FINGERPRINT_FLAG_CRC)
+         && fp.size <= max_size)
+      return fp.crc;
+   if (     content_fingerprint_lookup(path, CONTENT_FINGERPRINT_HEAD, &fp)
+         && (fp.flags & CONTENT_FINGERPRINT_FLAG_CRC))
+      return fp.crc;
+
+   /* TODO/FIXME - file_crc32 has a 64MB max limit -
+    * get rid of this function and find a better
+    * way to calculate CRC based on the file */
+   if ((crc = file_crc32(0, path)))
+   {
+      fp.crc       = crc;
+      fp.flags     = CONTENT_FINGERPRINT_FLAG_CRC;
+      fp.serial[0] = '\0';
+      content_fingerprint_store(path, CONTENT_FINGERPRINT_HEAD, &fp);
+   }
+   return crc;
+}
+
+typedef struct content_crc_task_state
+{
+   char path[PATH_MAX_LENGTH];
+   uint32_t crc;
+} content_crc_task_state_t;
+
+static void task_content_crc_handler(retro_task_t *task)
+{
+   content_crc_task_state_t *state = (content_crc_task_state_t*)task->state;
+
+   state->crc = content_file_crc(state->path);
+   task_set_progress(task, 100);
+   task_set_flags(task, RETRO_TASK_FLG_FINISHED, true);
+}
+
+static void task_content_crc_cb(retro_task_t *task,
+      void *task_data, void *user_data, const char *error)
+{
+   content_state_t *p_content      = content_state_get_ptr();
+   content_crc_task_state_t *state = (content_crc_task_state_t*)task->state;
+
+   /* Only publish the result if nothing has asked for
+    * the CRC in the meantime and the content is unchanged */
+   if (     (p_content->flags & CONTENT_ST_FLAG_PENDING_ROM_CRC)
+         && string_is_equal(p_content->pending_rom_crc_path, state->path))
+   {
+      p_content->flags  &= ~CONTENT_ST_FLAG_PENDING_ROM_CRC;
+      p_content->rom_crc = state->crc;
+      RARCH_LOG("[Content]: CRC32: 0x%x.\n", (unsigned)state->crc);
+   }
+}
+
+static void task_content_crc_cleanup(retro_task_t *task)
+{
+   if (task->state)
+      free(task->state);
+   task->state = NULL;
+}
+
+/**
+ * task_push_content_crc:
+ * @path : path of the content file.
+ *
+ * Computes the deferred content CRC32 on a background
+ * task while the core starts running, so that it is
+ * usually ready by the time netplay, replays or the
+ * network command interface need it.
+ *
+ * Only done with a threaded task queue, otherwise the
+ * CRC stays deferred until it is actually needed.
+ **/
+static void task_push_content_crc(const char *path)
+{
+   retro_task_t *task;
+   content_crc_task_state_t *state;
+
+   if (!task_queue_is_threaded())
+      return;
+
+   if (!(task = task_init()))
+      return;
+   if (!(state = (content_crc_task_state_t*)calloc(1, sizeof(*state))))
+   {
+      free(task);
+      return;
+   }
+
+   strlcpy(state->path, path, sizeof(state->path));
+
+   task->state    = state;
+   task->handler  = task_content_crc_handler;
+   task->callback = task_content_crc_cb;
+   task->cleanup  = task_content_crc_cleanup;
+   task->priority = TASK_PRIORITY_LOW;
+   /* The fingerprint cache is locked */
+   task->flags   |= RETRO_TASK_FLG_MUTE | RETRO_TASK_FLG_CONCURRENT;
+
+   task_queue_push(task);
+}
+
 /********************************/
 /* Content file functions START */
 /********************************/
@@ -656,15 +861,141 @@ static bool content_file_list_set_info(
 #define CONTENT_FILE_ATTR_GET_REQUIRED(attr)      ((attr.i & 4) != 0)
 #define CONTENT_FILE_ATTR_GET_PERSISTENT(attr)    ((attr.i & 8) != 0)
 
+#ifdef HAVE_CONTENT_MMAP
+/* Smaller files are simply read, mapping them
+ * is not worth the page faults */
+#ifndef CONTENT_MMAP_MIN_SIZE
+#define CONTENT_MMAP_MIN_SIZE 1048576
+#endif
+
+static size_t content_file_page_size(void)
+{
+#ifdef _WIN32
+   SYSTEM_INFO info;
+   GetSystemInfo(&info);
+   return info.dwPageSize;
+#else
+   long page_size = sysconf(_SC_PAGESIZE);
+   return (page_size > 0) ? (size_t)page_size : 0;
+#endif
+}
+
+/**
+ * content_file_map:
+ * @content_path : path of the content file.
+ * @data         : set to the mapped content file.
+ * @data_size    : set to the size of the content file.
+ *
+ * Memory maps a content file, so that the core can start
+ * running while the content is still being paged in by
+ * the OS instead of after it has been read in full.
+ * The file is opened through the VFS, the mapping is
+ * private and writable, cores that modify their content
+ * buffer get copy-on-write pages.
+ *
+ * Pages are read from the file for as long as the core
+ * runs. Windows refuses to truncate a mapped file, but
+ * elsewhere truncating it while the core runs raises
+ * SIGBUS on the next access to a page past the new end,
+ * which terminates RetroArch like a read error would.
+ * 'content_memory_map' turns this off for setups where
+ * content may change under a running core.
+ *
+ * Returns: true if successful, false if the content file
+ * has to be read normally.
+ **/
+static bool content_file_map(const char *content_path,
+      uint8_t **data, int64_t *data_size)
+{
+   void *mapped;
+   int64_t size;
+   size_t page_size;
+   libretro_vfs_implementation_file *handle = NULL;
+   RFILE *file                              = NULL;
+
+   if (path_stat(content_path) & (RETRO_VFS_STAT_IS_DIRECTORY
+            | RETRO_VFS_STAT_IS_CHARACTER_SPECIAL))
+      return false;
+
+   if (!(file = filestream_open(content_path,
+               RETRO_VFS_FILE_ACCESS_READ,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      return false;
+
+   size      = filestream_get_size(file);
+   page_size = content_file_page_size();
+   handle    = filestream_get_vfs_handle(file);
+
+   /* filestream_read_file() NUL terminates the buffer,
+    * which the zero filled tail of the last page also
+    * does unless the file ends on a page boundary.
+    * Only plain files have a descriptor to map. */
+   if (     size < CONTENT_MMAP_MIN_SIZE
+         || (uint64_t)size > (uint64_t)((size_t)-1)
+         || !page_size
+         || (size % page_size) == 0
+         || !handle
+         || handle->scheme != VFS_SCHEME_NONE
+         || !handle->fp)
+   {
+      filestream_close(file);
+      return false;
+   }
+
+#ifdef _WIN32
+   mapped = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE,
+         MAP_PRIVATE, _fileno(handle->fp), 0);
+#else
+   mapped = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE,
+         MAP_PRIVATE, fileno(handle->fp), 0);
+#endif
+   /* The mapping keeps its own reference to the file */
+   filestream_close(file);
+
+   if (mapped == MAP_FAILED)
+      return false;
+
+#if defined(HAVE_MMAN) && defined(MADV_WILLNEED)
+   /* Start reading ahead straight away */
+   madvise(mapped, (size_t)size, MADV_WILLNEED);
+#endif
+
+   *data      = (uint8_t*)mapped;
+   *data_size = size;
+   return true;
+}
+#endif
+
+#ifdef HAVE_PATCH
+/* Returns true if patch_content() could find a
+ * patch for the current content */
+static bool content_file_has_patch(content_information_ctx_t *content_ctx)
+{
+   if (content_ctx->flags & CONTENT_INFO_FLAG_PATCH_IS_BLOCKED)
+      return false;
+   return
+            (!string_is_empty(content_ctx->name_ips)
+         && path_is_valid(content_ctx->name_ips))
+      ||    (!string_is_empty(content_ctx->name_bps)
+         && path_is_valid(content_ctx->name_bps))
+      ||    (!string_is_empty(content_ctx->name_ups)
+         && path_is_valid(content_ctx->name_ups))
+      ||    (!string_is_empty(content_ctx->name_xdelta)
+         && path_is_valid(content_ctx->name_xdelta));
+}
+#endif
+
 /**
  * content_file_load_into_memory:
  * @content_path : path of the content file.
  * @data         : buffer into which the content file will be read.
  * @data_size    : size of the resultant content buffer.
+ * @data_mapped  : set to true if @data is a memory mapped file.
  *
  * Reads the content file into memory. Also performs soft patching
  * (see patch_content function) if soft patching has not been
- * blocked by the user.
+ * blocked by the user. Large uncompressed and unpatched content
+ * is memory mapped instead if 'content_memory_map' is enabled.
  *
  * Returns: true if successful, false on error.
  **/
@@ -676,17 +1007,36 @@ static bool content_file_load_into_memory(
       size_t idx,
       enum rarch_content_type first_content_type,
       uint8_t **data,
-      size_t *data_size)
+      size_t *data_size,
+      bool *data_mapped)
 {
    uint8_t *content_data = NULL;
    int64_t content_size  = 0;
 
    *data                 = NULL;
    *data_size            = 0;
+   *data_mapped          = false;
 
    RARCH_LOG("[Content]: %s: \"%s\".\n",
          msg_hash_to_str(MSG_LOADING_CONTENT_FILE), content_path);
 
+#ifdef HAVE_CONTENT_MMAP
+   /* patch_content() replaces the buffer, so patched
+    * content always has to be read */
+   if (     !content_compressed
+         && config_get_ptr()->bools.content_memory_map
+#ifdef HAVE_PATCH
+         && !(   idx == 0
+              && first_content_type == RARCH_CONTENT_NONE
+              && content_file_has_patch(content_ctx))
+#endif
+         && content_file_map(content_path, &content_data, &content_size))
+   {
+      RARCH_LOG("[Content]: Content file is memory mapped.\n");
+      *data_mapped = true;
+   }
+   else
+#endif
    /* Read content from file into memory buffer */
 #ifdef HAVE_COMPRESSION
    if (content_compressed)
@@ -716,7 +1066,8 @@ static bool content_file_load_into_memory(
 
 #ifdef HAVE_PATCH
          /* Attempt to apply a patch. */
-         if (!(content_ctx->flags & CONTENT_INFO_FLAG_PATCH_IS_BLOCKED))
+         if (     !*data_mapped
+               && !(content_ctx->flags & CONTENT_INFO_FLAG_PATCH_IS_BLOCKED))
             has_patch = patch_content(
                   content_ctx->flags & CONTENT_INFO_FLAG_IS_IPS_PREF,
                   content_ctx->flags & CONTENT_INFO_FLAG_IS_BPS_PREF,
@@ -733,13 +1084,32 @@ static bool content_file_load_into_memory(
           * applied, must determine CRC value using the
           * actual data buffer, since the content path
           * cannot be used for this purpose...
+          * (Unpatched archive members are hashed whole,
+          * so a cached 'archive#member' CRC is reused.)
           * In all other cases, cache the content path
           * and defer CRC calculation until the value is
           * actually needed */
          if (content_compressed || has_patch)
          {
-            p_content->rom_crc = encoding_crc32(0, content_data,
-                  (size_t)content_size);
+            content_fingerprint_t fp;
+            if (     !has_patch
+                  && content_fingerprint_lookup(content_path,
+                        CONTENT_FINGERPRINT_FILE, &fp)
+                  && (fp.flags & CONTENT_FINGERPRINT_FLAG_CRC))
+               p_content->rom_crc = fp.crc;
+            else
+            {
+               p_content->rom_crc = encoding_crc32(0, content_data,
+                     (size_t)content_size);
+               if (!has_patch)
+               {
+                  fp.crc       = p_content->rom_crc;
+                  fp.flags     = CONTENT_FINGERPRINT_FLAG_CRC;
+                  fp.serial[0] = '\0';
+                  content_fingerprint_store(content_path,
+                        CONTENT_FINGERPRINT_FILE, &fp);
+               }
+            }
             RARCH_LOG("[Content]: CRC32: 0x%x.\n",
                   (unsigned)p_content->rom_crc);
          }
@@ -951,6 +1321,7 @@ static bool content_file_load(
       const char *content_path = NULL;
       uint8_t *content_data    = NULL;
       size_t content_size      = 0;
+      bool content_mapped      = false;
       const char *valid_exts   = special
             ? special->roms[i].valid_extensions
             : content_ctx->valid_extensions;
@@ -989,7 +1360,7 @@ static bool content_file_load(
             if (!content_file_load_into_memory(
                   content_ctx, p_content, content_path,
                   content_compressed, i, first_content_type,
-                  &content_data, &content_size))
+                  &content_data, &content_size, &content_mapped))
             {
                char msg[PATH_MAX_LENGTH];
                snprintf(msg, sizeof(msg), "%s \"%s\"\n",
@@ -1111,12 +1482,13 @@ static bool content_file_load(
       /* Add current entry to content file list */
       if (!content_file_list_set_info(
             p_content->content_list,
-            content_path, content_data, content_size,
+            content_path, content_data, content_size, content_mapped,
             CONTENT_FILE_ATTR_GET_PERSISTENT(content->elems[i].attr), i))
       {
          RARCH_LOG("[Content]: Failed to process content file: \"%s\".\n", content_path);
          if (content_data)
-            free((void*)content_data);
+            content_file_data_free(content_data, content_size,
+                  content_mapped);
          *error_enum = MSG_FAILED_TO_LOAD_CONTENT;
          return false;
       }
@@ -1139,6 +1511,10 @@ static bool content_file_load(
       return false;
    }
 
+   /* Hash the content while the core starts running */
+   if (p_content->flags & CONTENT_ST_FLAG_PENDING_ROM_CRC)
+      task_push_content_crc(p_content->pending_rom_crc_path);
+
 #ifdef HAVE_CHEEVOS
    if (!special)
    {
@@ -2906,68 +3282,16 @@ void content_unset_does_not_need_content(void)
    p_content->flags &= ~CONTENT_ST_FLAG_CORE_DOES_NOT_NEED_CONTENT;
 }
 
-#ifndef CRC32_BUFFER_SIZE
-#define CRC32_BUFFER_SIZE 1048576
-#endif
-
-#ifndef CRC32_MAX_MB
-#define CRC32_MAX_MB 64
-#endif
-
-/**
- * Calculate a CRC32 from the first part of the given file.
- * "first part" being the first (CRC32_BUFFER_SIZE * CRC32_MAX_MB)
- * bytes.
- *
- * @return The calculated CRC32 hash, or 0 if there was an error.
- */
-static uint32_t file_crc32(uint32_t crc, const char *path)
-{
-   unsigned i;
-   RFILE *file        = NULL;
-   unsigned char *buf = NULL;
-   if (!path)
-      return 0;
-
-   if (!(file = filestream_open(path, RETRO_VFS_FILE_ACCESS_READ, 0)))
-      return 0;
-
-   if (!(buf = (unsigned char*)malloc(CRC32_BUFFER_SIZE)))
-   {
-      filestream_close(file);
-      return 0;
-   }
-
-   for (i = 0; i < CRC32_MAX_MB; i++)
-   {
-      int64_t nread = filestream_read(file, buf, CRC32_BUFFER_SIZE);
-      if (nread < 0)
-      {
-         free(buf);
-         filestream_close(file);
-         return 0;
-      }
-
-      crc = encoding_crc32(crc, buf, (size_t)nread);
-      if (filestream_eof(file))
-         break;
-   }
-   free(buf);
-   filestream_close(file);
-   return crc;
-}
-
 uint32_t content_get_crc(void)
 {
    content_state_t *p_content = content_state_get_ptr();
    if (p_content->flags & CONTENT_ST_FLAG_PENDING_ROM_CRC)
    {
-      p_content->flags   &= ~CONTENT_ST_FLAG_PENDING_ROM_CRC;
-      /* TODO/FIXME - file_crc32 has a 64MB max limit -
-       * get rid of this function and find a better
-       * way to calculate CRC based on the file */
-      p_content->rom_crc  = file_crc32(0,
-            (const char*)p_content->pending_rom_crc_path);
+      /* The background task may still be running,
+       * its result is ignored once this is done */
+      p_content->flags    &= ~CONTENT_ST_FLAG_PENDING_ROM_CRC;
+      p_content->rom_crc   = content_file_crc(
+            p_content->pending_rom_crc_path);
       RARCH_LOG("[Content]: CRC32: 0x%x.\n",
             (unsigned)p_content->rom_crc);
    }
@@ -496,6 +496,7 @@ void *task_push_get_core_updater_list(
 
    /* Configure task */
    task->handler          = task_core_updater_get_list_handler;
+   task->priority         = TASK_PRIORITY_LOW;
    task->state            = list_handle;
    task->title            = strdup(msg_hash_to_str(MSG_FETCHING_CORE_LIST));
    task->progress         = 0;
@@ -1139,6 +1140,7 @@ void *task_push_core_updater_download(
          sizeof(task_title) - _len);
 
    task->handler          = task_core_updater_download_handler;
+   task->priority         = TASK_PRIORITY_LOW;
    task->state            = download_handle;
    task->title            = strdup(task_title);
    task->progress         = 0;
@@ -1668,6 +1670,7 @@ void task_push_update_installed_cores(
 
    /* Configure task */
    task->handler          = task_update_installed_cores_handler;
+   task->priority         = TASK_PRIORITY_LOW;
    task->state            = update_installed_handle;
    task->title            = strdup(msg_hash_to_str(MSG_FETCHING_CORE_LIST));
    task->progress         = 0;
@@ -1745,6 +1748,7 @@ bool task_push_update_single_core(
 
    /* Configure task */
    task->handler = task_update_single_core_handler;
+   task->priority = TASK_PRIORITY_LOW;
    task->cleanup = task_update_single_core_cleanup;
    task->state   = handle;
 
@@ -2054,6 +2058,7 @@ void *task_push_play_feature_delivery_core_install(
          sizeof(task_title) - _len);
 
    task->handler          = task_play_feature_delivery_core_install_handler;
+   task->priority         = TASK_PRIORITY_LOW;
    task->state            = pfd_install_handle;
    task->title            = strdup(task_title);
    task->progress         = 0;
@@ -2425,6 +2430,7 @@ void task_push_play_feature_delivery_switch_installed_cores(
 
    /* Configure task */
    task->handler          = task_play_feature_delivery_switch_cores_handler;
+   task->priority         = TASK_PRIORITY_LOW;
    task->state            = pfd_switch_cores_handle;
    task->title            = strdup(msg_hash_to_str(MSG_SCANNING_CORES));
    task->progress         = 0;
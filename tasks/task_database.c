@@ -29,6 +29,12 @@
 #include <streams/interface_stream.h>
 #include "tasks_internal.h"
 
+#if defined(HAVE_THREADS) && defined(RARCH_INTERNAL)
+#include <rthreads/rthreads.h>
+#include <features/features_cpu.h>
+#define HAVE_DATABASE_HASH_POOL
+#endif
+
 #include "../core_info.h"
 #include "../database_info.h"
 
@@ -37,6 +43,7 @@
 #include "../playlist.h"
 #ifdef RARCH_INTERNAL
 #include "../configuration.h"
+#include "../content_fingerprint.h"
 #include "../ui/ui_companion_driver.h"
 #include "../gfx/video_display_server.h"
 #endif
@@ -57,6 +64,64 @@ typedef struct database_state_handle
    char serial[4096];      /* TODO/FIXME - check size */
 } database_state_handle_t;
 
+enum database_fingerprint_flags
+{
+   DB_FINGERPRINT_FLAG_TYPE        = (1 << 0),
+   DB_FINGERPRINT_FLAG_CRC         = (1 << 1),
+   DB_FINGERPRINT_FLAG_ARCHIVE_CRC = (1 << 2),
+   DB_FINGERPRINT_FLAG_SERIAL      = (1 << 3)
+};
+
+/* What was read from a content file; the flags
+ * tell which of the fields were set */
+typedef struct database_fingerprint
+{
+   uint32_t crc;
+   uint32_t archive_crc;
+   int ret;
+   enum database_type type;
+   uint8_t flags;
+   char serial[4096];
+} database_fingerprint_t;
+
+#ifdef HAVE_DATABASE_HASH_POOL
+#define DATABASE_HASH_MAX_WORKERS 8
+/* How many files are queued per worker */
+#define DATABASE_HASH_JOBS_PER_WORKER 4
+
+enum database_hash_job_state
+{
+   DATABASE_HASH_JOB_FREE = 0,
+   DATABASE_HASH_JOB_READY,
+   DATABASE_HASH_JOB_BUSY,
+   DATABASE_HASH_JOB_DONE
+};
+
+typedef struct database_hash_job
+{
+   database_fingerprint_t fp;
+   char *path;
+   enum database_hash_job_state state;
+} database_hash_job_t;
+
+/* Workers that read and hash the files ahead of the
+ * scan, which does the database lookups and playlist
+ * writes in list order. The job for list index 'i'
+ * lives in jobs[i % num_jobs]. */
+typedef struct database_hash_pool
+{
+   database_hash_job_t *jobs;
+   sthread_t *workers[DATABASE_HASH_MAX_WORKERS];
+   slock_t *lock;
+   scond_t *cond;
+   size_t num_jobs;
+   size_t head;            /* List index of the oldest queued file */
+   size_t tail;            /* List index of the next file to queue */
+   unsigned num_workers;
+   bool quit;
+} database_hash_pool_t;
+#endif
+
 enum db_flags_enum
 {
    DB_HANDLE_FLAG_IS_DIRECTORY            = (1 << 0),
@@ -72,6 +137,9 @@ typedef struct db_handle
    char *fullpath;
    database_info_handle_t *handle;
    database_state_handle_t state;
+#ifdef HAVE_DATABASE_HASH_POOL
+   database_hash_pool_t *hash_pool;
+#endif
    playlist_config_t playlist_config; /* size_t alignment */
    unsigned status;
    uint8_t flags;
@@ -503,8 +571,179 @@ static bool task_database_chd_get_crc(const char *name, uint32_t *crc)
    return found_crc;
 }
 
+/* CRC32 of a whole file, taken from the fingerprint
+ * cache while the file is unchanged */
+static bool task_database_file_get_crc(const char *name, uint32_t *crc)
+{
+#ifdef RARCH_INTERNAL
+   content_fingerprint_t fp;
+
+   if (     content_fingerprint_lookup(name, CONTENT_FINGERPRINT_FILE, &fp)
+         && (fp.flags & CONTENT_FINGERPRINT_FLAG_CRC))
+   {
+      *crc = fp.crc;
+      return true;
+   }
+#endif
+
+   if (!intfstream_file_get_crc(name, 0, SIZE_MAX, crc))
+      return false;
+
+#ifdef RARCH_INTERNAL
+   fp.crc       = *crc;
+   fp.flags     = CONTENT_FINGERPRINT_FLAG_CRC;
+   fp.serial[0] = '\0';
+   content_fingerprint_store(name, CONTENT_FINGERPRINT_FILE, &fp);
+#endif
+   return true;
+}
+
+/* CRC32 of an archive member, taken from the fingerprint
+ * cache while the archive is unchanged */
+static uint32_t task_database_archive_get_crc(const char *name)
+{
+#ifdef RARCH_INTERNAL
+   content_fingerprint_t fp;
+
+   if (     content_fingerprint_lookup(name, CONTENT_FINGERPRINT_FILE, &fp)
+         && (fp.flags & CONTENT_FINGERPRINT_FLAG_CRC))
+      return fp.crc;
+
+   if ((fp.crc = file_archive_get_file_crc32(name)))
+   {
+      fp.flags     = CONTENT_FINGERPRINT_FLAG_CRC;
+      fp.serial[0] = '\0';
+      content_fingerprint_store(name, CONTENT_FINGERPRINT_FILE, &fp);
+   }
+   return fp.crc;
+#else
+   return file_archive_get_file_crc32(name);
+#endif
+}
+
+/**
+ * task_database_get_disc_fingerprint:
+ *
+ * Gets the serial of a disc image, falling back to the
+ * CRC32 of its data track for cue, gdi and chd images,
+ * and picks the lookup type accordingly. Results are
+ * kept in the fingerprint cache, so unchanged images
+ * are not read again.
+ **/
+static void task_database_get_disc_fingerprint(const char *name,
+      enum msg_file_type type, database_fingerprint_t *fp)
+{
+   bool has_serial = false;
+   bool no_serial  = false;
+#ifdef RARCH_INTERNAL
+   content_fingerprint_t cfp;
+
+   if (content_fingerprint_lookup(name, CONTENT_FINGERPRINT_DISC, &cfp))
+   {
+      if (cfp.flags & CONTENT_FINGERPRINT_FLAG_SERIAL)
+      {
+         strlcpy(fp->serial, cfp.serial, sizeof(fp->serial));
+         fp->type   = DATABASE_TYPE_SERIAL_LOOKUP;
+         fp->flags |= DB_FINGERPRINT_FLAG_TYPE
+                    | DB_FINGERPRINT_FLAG_SERIAL;
+         return;
+      }
+      if (cfp.flags & CONTENT_FINGERPRINT_FLAG_NO_SERIAL)
+      {
+         no_serial = true;
+         if (     type != FILE_TYPE_ISO
+               && (cfp.flags & CONTENT_FINGERPRINT_FLAG_CRC))
+         {
+            fp->serial[0] = '\0';
+            fp->crc       = cfp.crc;
+            fp->type      = DATABASE_TYPE_CRC_LOOKUP;
+            fp->flags    |= DB_FINGERPRINT_FLAG_TYPE
+                          | DB_FINGERPRINT_FLAG_SERIAL
+                          | DB_FINGERPRINT_FLAG_CRC;
+            return;
+         }
+      }
+   }
+#endif
+
+   fp->serial[0]  = '\0';
+   fp->flags     |= DB_FINGERPRINT_FLAG_TYPE
+                  | DB_FINGERPRINT_FLAG_SERIAL;
+
+   if (!no_serial)
+   {
+      switch (type)
+      {
+         case FILE_TYPE_CUE:
+            has_serial = task_database_cue_get_serial(name,
+                  fp->serial, sizeof(fp->serial)) != 0;
+            break;
+         case FILE_TYPE_GDI:
+            has_serial = task_database_gdi_get_serial(name,
+                  fp->serial, sizeof(fp->serial)) != 0;
+            break;
+         case FILE_TYPE_CHD:
+            has_serial = task_database_chd_get_serial(name,
+                  fp->serial, sizeof(fp->serial)) != 0;
+            break;
+         default:
+            has_serial = intfstream_file_get_serial(name, 0, SIZE_MAX,
+                  fp->serial, sizeof(fp->serial));
+            break;
+      }
+   }
+
+   /* WBFS, RVZ, WIA and ISO files are looked up
+    * by serial even if none was found */
+   if (has_serial || type == FILE_TYPE_ISO)
+      fp->type = DATABASE_TYPE_SERIAL_LOOKUP;
+   else
+   {
+      fp->type = DATABASE_TYPE_CRC_LOOKUP;
+      switch (type)
+      {
+         case FILE_TYPE_CUE:
+            fp->ret = task_database_cue_get_crc(name, &fp->crc);
+            break;
+         case FILE_TYPE_GDI:
+            fp->ret = task_database_gdi_get_crc(name, &fp->crc);
+            break;
+         case FILE_TYPE_CHD:
+            fp->ret = task_database_chd_get_crc(name, &fp->crc);
+            break;
+         default:
+            break;
+      }
+      if (fp->ret)
+         fp->flags |= DB_FINGERPRINT_FLAG_CRC;
+   }
+
+#ifdef RARCH_INTERNAL
+   cfp.crc       = fp->crc;
+   cfp.serial[0] = '\0';
+   if (has_serial)
+   {
+      cfp.flags  = CONTENT_FINGERPRINT_FLAG_SERIAL;
+      strlcpy(cfp.serial, fp->serial, sizeof(cfp.serial));
+      /* Too long to be cached */
+      if (strlen(fp->serial) >= sizeof(cfp.serial))
+         cfp.flags = 0;
+   }
+   else
+   {
+      cfp.flags  = CONTENT_FINGERPRINT_FLAG_NO_SERIAL;
+      if (fp->flags & DB_FINGERPRINT_FLAG_CRC)
+         cfp.flags |= CONTENT_FINGERPRINT_FLAG_CRC;
+   }
+   if (cfp.flags)
+      content_fingerprint_store(name, CONTENT_FINGERPRINT_DISC, &cfp);
+#endif
+}
+
+/* Drops the files referenced by a cue sheet from the
+ * part of the content list starting at 'start' */
 static void task_database_cue_prune(database_info_handle_t *db,
-      const char *name)
+      const char *name, size_t start)
 {
    size_t i;
    char path[PATH_MAX_LENGTH];
@@ -518,7 +757,7 @@ static void task_database_cue_prune(database_info_handle_t *db,
 
    while (cue_next_file(fd, name, path, sizeof(path)))
    {
-      for (i = db->list_ptr; i < db->list->size; ++i)
+      for (i = start; i < db->list->size; ++i)
       {
          if (db->list->elems[i].data
                && string_is_equal(path, db->list->elems[i].data))
@@ -536,7 +775,8 @@ static void task_database_cue_prune(database_info_handle_t *db,
    free(fd);
 }
 
-static void gdi_prune(database_info_handle_t *db, const char *name)
+static void gdi_prune(database_info_handle_t *db, const char *name,
+      size_t start)
 {
    size_t i;
    char path[PATH_MAX_LENGTH];
@@ -550,7 +790,7 @@ static void gdi_prune(database_info_handle_t *db, const char *name)
 
    while (gdi_next_file(fd, name, path, sizeof(path)))
    {
-      for (i = db->list_ptr; i < db->list->size; ++i)
+      for (i = start; i < db->list->size; ++i)
       {
          if (db->list->elems[i].data
                && string_is_equal(path, db->list->elems[i].data))
@@ -613,72 +853,346 @@ static enum msg_file_type extension_to_file_type(const char *ext)
    return FILE_TYPE_NONE;
 }
 
-static int task_database_iterate_playlist(
-      database_state_handle_t *db_state,
-      database_info_handle_t *db, const char *name)
+/* Drops the files referenced by the cue or gdi sheet
+ * at 'index' from the rest of the content list */
+static void task_database_prune(database_info_handle_t *db,
+      const char *name, size_t index)
 {
    switch (extension_to_file_type(path_get_extension(name)))
+   {
+      case FILE_TYPE_CUE:
+         task_database_cue_prune(db, name, index);
+         break;
+      case FILE_TYPE_GDI:
+         gdi_prune(db, name, index);
+         break;
+      default:
+         break;
+   }
+}
+
+/**
+ * task_database_get_fingerprint:
+ *
+ * Reads everything needed to look a content file up in
+ * the databases: the CRC32 of the file (or of the archive
+ * member), and the serial of disc images. This is the
+ * part of a scan that touches the file, and does not
+ * access any scan state, so it can run on any thread.
+ **/
+static void task_database_get_fingerprint(const char *name,
+      database_fingerprint_t *fp)
+{
+   enum msg_file_type type;
+
+   fp->crc         = 0;
+   fp->archive_crc = 0;
+   fp->ret         = 1;
+   fp->type        = DATABASE_TYPE_NONE;
+   fp->flags       = 0;
+   fp->serial[0]   = '\0';
+
+   /* Archive member, see task_database_iterate_crc_lookup() */
+   if (path_contains_compressed_file(name))
+   {
+      if ((fp->crc = task_database_archive_get_crc(name)))
+         fp->flags |= DB_FINGERPRINT_FLAG_CRC;
+      return;
+   }
+
+   switch ((type = extension_to_file_type(path_get_extension(name))))
    {
       case FILE_TYPE_COMPRESSED:
 #ifdef HAVE_COMPRESSION
-         db->type = DATABASE_TYPE_CRC_LOOKUP;
+         fp->type   = DATABASE_TYPE_CRC_LOOKUP;
+         fp->flags |= DB_FINGERPRINT_FLAG_TYPE;
          /* first check crc of archive itself */
-         return intfstream_file_get_crc(name,
-               0, SIZE_MAX, &db_state->archive_crc);
-#else
-         break;
+         if ((fp->ret = task_database_file_get_crc(name, &fp->archive_crc)))
+            fp->flags |= DB_FINGERPRINT_FLAG_ARCHIVE_CRC;
 #endif
-      case FILE_TYPE_CUE:
-         task_database_cue_prune(db, name);
-         db_state->serial[0] = '\0';
-         if (task_database_cue_get_serial(name, db_state->serial, sizeof(db_state->serial)))
-            db->type = DATABASE_TYPE_SERIAL_LOOKUP;
-         else
-         {
-            db->type = DATABASE_TYPE_CRC_LOOKUP;
-            return task_database_cue_get_crc(name, &db_state->crc);
-         }
          break;
+      case FILE_TYPE_CUE:
       case FILE_TYPE_GDI:
-         gdi_prune(db, name);
-         db_state->serial[0] = '\0';
-         if (task_database_gdi_get_serial(name, db_state->serial, sizeof(db_state->serial)))
-            db->type = DATABASE_TYPE_SERIAL_LOOKUP;
-         else
-         {
-            db->type = DATABASE_TYPE_CRC_LOOKUP;
-            return task_database_gdi_get_crc(name, &db_state->crc);
-         }
+      case FILE_TYPE_CHD:
+         task_database_get_disc_fingerprint(name, type, fp);
          break;
       /* Consider WBFS, RVZ and WIA files similar to ISO files. */
       case FILE_TYPE_WBFS:
       case FILE_TYPE_RVZ:
       case FILE_TYPE_WIA:
       case FILE_TYPE_ISO:
-         db_state->serial[0] = '\0';
-         intfstream_file_get_serial(name, 0, SIZE_MAX, db_state->serial, sizeof(db_state->serial));
-         db->type            =  DATABASE_TYPE_SERIAL_LOOKUP;
-         break;
-      case FILE_TYPE_CHD:
-         db_state->serial[0] = '\0';
-         if (task_database_chd_get_serial(name, db_state->serial, sizeof(db_state->serial)))
-            db->type         = DATABASE_TYPE_SERIAL_LOOKUP;
-         else
-         {
-            db->type         = DATABASE_TYPE_CRC_LOOKUP;
-            return task_database_chd_get_crc(name, &db_state->crc);
-         }
+         task_database_get_disc_fingerprint(name, FILE_TYPE_ISO, fp);
          break;
       case FILE_TYPE_LUTRO:
-         db->type            = DATABASE_TYPE_ITERATE_LUTRO;
+         fp->type   = DATABASE_TYPE_ITERATE_LUTRO;
+         fp->flags |= DB_FINGERPRINT_FLAG_TYPE;
          break;
       default:
-         db_state->serial[0] = '\0';
-         db->type            = DATABASE_TYPE_CRC_LOOKUP;
-         return intfstream_file_get_crc(name, 0, SIZE_MAX, &db_state->crc);
+         fp->type   = DATABASE_TYPE_CRC_LOOKUP;
+         fp->flags |= DB_FINGERPRINT_FLAG_TYPE
+                    | DB_FINGERPRINT_FLAG_SERIAL;
+         if ((fp->ret = task_database_file_get_crc(name, &fp->crc)))
+            fp->flags |= DB_FINGERPRINT_FLAG_CRC;
+         break;
    }
+}
 
-   return 1;
+#ifdef HAVE_DATABASE_HASH_POOL
+static void task_database_hash_worker(void *data)
+{
+   database_hash_pool_t *pool = (database_hash_pool_t*)data;
+
+   slock_lock(pool->lock);
+
+   while (!pool->quit)
+   {
+      size_t i;
+      database_hash_job_t *job = NULL;
+
+      /* Oldest file first, that is the one the
+       * consumer is going to wait for */
+      for (i = pool->head; i < pool->tail; i++)
+      {
+         database_hash_job_t *cur = &pool->jobs[i % pool->num_jobs];
+         if (cur->state == DATABASE_HASH_JOB_READY)
+         {
+            job = cur;
+            break;
+         }
+      }
+
+      if (!job)
+      {
+         scond_wait(pool->cond, pool->lock);
+         continue;
+      }
+
+      job->state = DATABASE_HASH_JOB_BUSY;
+      slock_unlock(pool->lock);
+
+      task_database_get_fingerprint(job->path, &job->fp);
+
+      slock_lock(pool->lock);
+      job->state = DATABASE_HASH_JOB_DONE;
+      scond_broadcast(pool->cond);
+   }
+
+   slock_unlock(pool->lock);
+}
+
+static void task_database_hash_pool_free(database_hash_pool_t *pool)
+{
+   size_t i;
+   unsigned j;
+
+   if (!pool)
+      return;
+
+   slock_lock(pool->lock);
+   pool->quit = true;
+   scond_broadcast(pool->cond);
+   slock_unlock(pool->lock);
+
+   for (j = 0; j < pool->num_workers; j++)
+      sthread_join(pool->workers[j]);
+   cpu_features_release_threads(pool->num_workers);
+
+   for (i = 0; i < pool->num_jobs; i++)
+      free(pool->jobs[i].path);
+
+   free(pool->jobs);
+   scond_free(pool->cond);
+   slock_free(pool->lock);
+   free(pool);
+}
+
+static database_hash_pool_t *task_database_hash_pool_new(size_t num_files)
+{
+   unsigned num_workers       = DATABASE_HASH_MAX_WORKERS;
+   database_hash_pool_t *pool = NULL;
+
+   if (num_workers > num_files)
+      num_workers = (unsigned)num_files;
+   /* The scan itself already runs on a task queue worker,
+    * the hashing workers come out of the process-wide
+    * budget that CHD read-ahead and rzip also draw from */
+   num_workers = cpu_features_reserve_threads(num_workers);
+   /* Not worth it, stay serial */
+   if (num_workers < 2)
+   {
+      cpu_features_release_threads(num_workers);
+      return NULL;
+   }
+
+   if (!(pool = (database_hash_pool_t*)calloc(1, sizeof(*pool))))
+   {
+      cpu_features_release_threads(num_workers);
+      return NULL;
+   }
+
+   pool->num_jobs = num_workers * DATABASE_HASH_JOBS_PER_WORKER;
+   pool->jobs     = (database_hash_job_t*)calloc(pool->num_jobs,
+         sizeof(*pool->jobs));
+   pool->lock     = slock_new();
+   pool->cond     = scond_new();
+
+   if (!pool->jobs || !pool->lock || !pool->cond)
+   {
+      cpu_features_release_threads(num_workers);
+      task_database_hash_pool_free(pool);
+      return NULL;
+   }
+
+   for (; pool->num_workers < num_workers; pool->num_workers++)
+   {
+      if (!(pool->workers[pool->num_workers] = sthread_create(
+            task_database_hash_worker, pool)))
+         break;
+   }
+
+   /* Give back what couldn't be started */
+   cpu_features_release_threads(num_workers - pool->num_workers);
+
+   if (!pool->num_workers)
+   {
+      task_database_hash_pool_free(pool);
+      return NULL;
+   }
+
+   RARCH_LOG("[Scanner]: Reading content on %u threads.\n",
+         pool->num_workers);
+   return pool;
+}
+
+/* Queues files from the content list until the queue is
+ * full. This is the only place that pushes work, so the
+ * queue never runs more than 'num_jobs' files ahead of
+ * the consumer. */
+static void task_database_hash_pool_fill(database_hash_pool_t *pool,
+      database_info_handle_t *db)
+{
+   /* Workers only look at jobs in [head, tail), so
+    * the slot at 'tail' can be set up without the lock */
+   while (     pool->tail < db->list->size
+            && pool->tail - pool->head < pool->num_jobs)
+   {
+      database_hash_job_t *job = &pool->jobs[pool->tail % pool->num_jobs];
+      const char *path         = db->list->elems[pool->tail].data;
+
+      job->state               = DATABASE_HASH_JOB_FREE;
+
+      if (!string_is_empty(path))
+      {
+         /* Prune what the sheet references before those
+          * files get queued themselves */
+         task_database_prune(db, path, pool->tail);
+         if ((job->path = strdup(path)))
+            job->state         = DATABASE_HASH_JOB_READY;
+      }
+
+      slock_lock(pool->lock);
+      pool->tail++;
+      scond_broadcast(pool->cond);
+      slock_unlock(pool->lock);
+   }
+}
+
+/**
+ * task_database_hash_pool_take:
+ *
+ * Gets the fingerprint of the file at the current position
+ * of the content list from the workers, waiting for it if
+ * needed, and drops the results of any files the scan has
+ * moved past.
+ *
+ * Returns: true if a fingerprint for 'name' was available.
+ **/
+static bool task_database_hash_pool_take(database_hash_pool_t *pool,
+      database_info_handle_t *db, const char *name,
+      database_fingerprint_t *fp)
+{
+   bool taken   = false;
+   size_t index = db->list_ptr;
+
+   slock_lock(pool->lock);
+   while (pool->head < pool->tail && pool->head < index)
+   {
+      database_hash_job_t *job = &pool->jobs[pool->head % pool->num_jobs];
+      while (job->state == DATABASE_HASH_JOB_BUSY)
+         scond_wait(pool->cond, pool->lock);
+      free(job->path);
+      job->path  = NULL;
+      job->state = DATABASE_HASH_JOB_FREE;
+      pool->head++;
+   }
+   if (pool->tail < index)
+   {
+      pool->head = index;
+      pool->tail = index;
+   }
+   slock_unlock(pool->lock);
+
+   task_database_hash_pool_fill(pool, db);
+
+   slock_lock(pool->lock);
+   if (pool->head == index && pool->head < pool->tail)
+   {
+      database_hash_job_t *job = &pool->jobs[pool->head % pool->num_jobs];
+      if (job->state != DATABASE_HASH_JOB_FREE)
+      {
+         while (job->state != DATABASE_HASH_JOB_DONE)
+            scond_wait(pool->cond, pool->lock);
+         if (string_is_equal(job->path, name))
+         {
+            fp->crc         = job->fp.crc;
+            fp->archive_crc = job->fp.archive_crc;
+            fp->ret         = job->fp.ret;
+            fp->type        = job->fp.type;
+            fp->flags       = job->fp.flags;
+            strlcpy(fp->serial, job->fp.serial, sizeof(fp->serial));
+            taken           = true;
+         }
+      }
+      free(job->path);
+      job->path  = NULL;
+      job->state = DATABASE_HASH_JOB_FREE;
+      pool->head++;
+   }
+   slock_unlock(pool->lock);
+
+   /* Keep the workers busy while the databases are searched */
+   task_database_hash_pool_fill(pool, db);
+
+   return taken;
+}
+#endif
+
+static int task_database_iterate_playlist(
+      db_handle_t *_db,
+      database_state_handle_t *db_state,
+      database_info_handle_t *db, const char *name)
+{
+   database_fingerprint_t fp;
+
+#ifdef HAVE_DATABASE_HASH_POOL
+   if (     !_db->hash_pool
+         || !task_database_hash_pool_take(_db->hash_pool, db, name, &fp))
+#endif
+   {
+      task_database_prune(db, name, db->list_ptr);
+      task_database_get_fingerprint(name, &fp);
+   }
+
+   if (fp.flags & DB_FINGERPRINT_FLAG_TYPE)
+      db->type              = fp.type;
+   if (fp.flags & DB_FINGERPRINT_FLAG_CRC)
+      db_state->crc         = fp.crc;
+   if (fp.flags & DB_FINGERPRINT_FLAG_ARCHIVE_CRC)
+      db_state->archive_crc = fp.archive_crc;
+   if (fp.flags & DB_FINGERPRINT_FLAG_SERIAL)
+      strlcpy(db_state->serial, fp.serial, sizeof(db_state->serial));
+
+   return fp.ret;
 }
 
 static int database_info_list_iterate_end_no_match(
@@ -741,7 +1255,7 @@ static int database_info_list_iterate_end_no_match(
 }
 
 static int database_info_list_iterate_new(database_state_handle_t *db_state,
-      const char *query)
+      uint32_t crc, uint32_t archive_crc, const char *serial)
 {
    const char *new_database = database_info_get_current_name(db_state);
 
@@ -755,7 +1269,8 @@ static int database_info_list_iterate_new(database_state_handle_t *db_state,
       database_info_list_free(db_state->info);
       free(db_state->info);
    }
-   db_state->info = database_info_list_new(new_database, query);
+   db_state->info = database_info_list_new_lookup(new_database,
+         crc, archive_crc, serial);
    return 0;
 }
 
@@ -943,7 +1458,14 @@ static int task_database_iterate_crc_lookup(
     * or the file is empty. */
    if (!db_state->crc)
    {
-      db_state->crc = file_archive_get_file_crc32(name);
+#ifdef HAVE_DATABASE_HASH_POOL
+      database_fingerprint_t fp;
+      if (     _db->hash_pool
+            && task_database_hash_pool_take(_db->hash_pool, db, name, &fp))
+         db_state->crc = fp.crc;
+      else
+#endif
+         db_state->crc = task_database_archive_get_crc(name);
 
       if (!db_state->crc)
          return database_info_list_iterate_next(db_state);
@@ -951,10 +1473,6 @@ static int task_database_iterate_crc_lookup(
 
    if (db_state->entry_index == 0)
    {
-      char query[50];
-
-      query[0] = '\0';
-
       if (!(_db->flags & DB_HANDLE_FLAG_SCAN_WITHOUT_CORE_MATCH))
       {
          /* don't scan files that can't be in this database.
@@ -974,11 +1492,8 @@ static int task_database_iterate_crc_lookup(
          }
       }
 
-      snprintf(query, sizeof(query),
-            "{crc:or(b\"%08lX\",b\"%08lX\")}",
-            (unsigned long)db_state->crc, (unsigned long)db_state->archive_crc);
-
-      database_info_list_iterate_new(db_state, query);
+      database_info_list_iterate_new(db_state,
+            db_state->crc, db_state->archive_crc, NULL);
    }
 
    if (db_state->info)
@@ -1104,25 +1619,7 @@ static int task_database_iterate_serial_lookup(
             path_contains_compressed_file);
 
    if (db_state->entry_index == 0)
-   {
-      size_t _len;
-      char query[50];
-      char *serial_buf = bin_to_hex_alloc(
-            (uint8_t*)db_state->serial,
-            strlen(db_state->serial) * sizeof(uint8_t));
-
-      if (!serial_buf)
-         return 1;
-
-      _len  = strlcpy(query, "{'serial': b'", sizeof(query));
-      _len += strlcpy(query + _len, serial_buf, sizeof(query) - _len);
-      query[  _len] = '\'';
-      query[++_len] = '}';
-      query[++_len] = '\0';
-      database_info_list_iterate_new(db_state, query);
-
-      free(serial_buf);
-   }
+      database_info_list_iterate_new(db_state, 0, 0, db_state->serial);
 
    if (db_state->info)
    {
@@ -1136,7 +1633,7 @@ static int task_database_iterate_serial_lookup(
             if (task_database_check_serial_and_crc(db_state))
             {
                if (db_state->crc == 0)
-                  intfstream_file_get_crc(name, 0, SIZE_MAX, &db_state->crc);
+                  task_database_file_get_crc(name, &db_state->crc);
                if (db_state->crc == db_info_entry->crc32)
                   return database_info_list_iterate_found_match(_db,
                         db_state, db, NULL);
@@ -1176,7 +1673,7 @@ static int task_database_iterate(
    switch (db->type)
    {
       case DATABASE_TYPE_ITERATE:
-         return task_database_iterate_playlist(db_state, db, name);
+         return task_database_iterate_playlist(_db, db_state, db, name);
       case DATABASE_TYPE_ITERATE_ARCHIVE:
 #ifdef HAVE_COMPRESSION
          return task_database_iterate_crc_lookup(
@@ -1313,6 +1810,10 @@ static void task_database_handler(retro_task_t *task)
                }
             }
          }
+#ifdef HAVE_DATABASE_HASH_POOL
+         if (dbinfo->list && !db->hash_pool)
+            db->hash_pool = task_database_hash_pool_new(dbinfo->list->size);
+#endif
          dbinfo->status = DATABASE_STATUS_ITERATE_START;
          break;
       case DATABASE_STATUS_ITERATE_START:
@@ -1381,6 +1882,9 @@ static void task_database_handler(retro_task_t *task)
    return;
 
 task_finished:
+#ifdef RARCH_INTERNAL
+   content_fingerprint_flush();
+#endif
    if (task)
       task_set_flags(task, RETRO_TASK_FLG_FINISHED, true);
 
@@ -1392,6 +1896,9 @@ task_finished:
 
    if (db)
    {
+#ifdef HAVE_DATABASE_HASH_POOL
+      task_database_hash_pool_free(db->hash_pool);
+#endif
       if (!string_is_empty(db->playlist_directory))
          free(db->playlist_directory);
       if (!string_is_empty(db->content_database_path))
@@ -1437,6 +1944,7 @@ bool task_push_dbscan(
       goto error;
 
    t->handler                              = task_database_handler;
+   t->priority                             = TASK_PRIORITY_LOW;
    t->state                                = db;
    t->callback                             = cb;
    t->title                                = strdup(msg_hash_to_str(
@@ -1449,12 +1957,16 @@ bool task_push_dbscan(
    db->playlist_config.capacity            = COLLECTION_SIZE;
    db->playlist_config.old_format          = settings->bools.playlist_use_old_format;
    db->playlist_config.compress            = settings->bools.playlist_compression;
+   db->playlist_config.journal             = settings->bools.playlist_journal;
+   db->playlist_config.cache               = settings->bools.playlist_cache;
    db->playlist_config.fuzzy_archive_match = settings->bools.playlist_fuzzy_archive_match;
    playlist_config_set_base_content_directory(&db->playlist_config, settings->bools.playlist_portable_paths ? settings->paths.directory_menu_content : NULL);
 #else
    db->playlist_config.capacity            = COLLECTION_SIZE;
    db->playlist_config.old_format          = false;
    db->playlist_config.compress            = false;
+   db->playlist_config.journal             = false;
+   db->playlist_config.cache               = false;
    db->playlist_config.fuzzy_archive_match = false;
    playlist_config_set_base_content_directory(&db->playlist_config, NULL);
 #endif
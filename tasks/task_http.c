@@ -295,6 +295,9 @@ static void *task_push_http_transfer_generic(
    t->cleanup              = task_http_transfer_cleanup;
    t->user_data            = user_data;
    t->progress             = -1;
+   /* Each transfer only touches its own connection,
+    * the shared DNS cache and pool in net_http are locked */
+   t->flags               |=  RETRO_TASK_FLG_CONCURRENT;
    if (mute)
       t->flags            |=  RETRO_TASK_FLG_MUTE;
    else
@@ -31,6 +31,7 @@ typedef struct menu_explore_init_handle
    explore_state_t *state;
    char *directory_playlist;
    char *directory_database;
+   bool playlist_cache;
 } menu_explore_init_handle_t;
 
 /*********************/
@@ -148,7 +149,8 @@ static void task_menu_explore_init_handler(retro_task_t *task)
              * initialisation on a background thread) */
             menu_explore->state = menu_explore_build_list(
                   menu_explore->directory_playlist,
-                  menu_explore->directory_database);
+                  menu_explore->directory_database,
+                  menu_explore->playlist_cache);
 
             task_set_progress(task, 100);
          }
@@ -164,7 +166,7 @@ static bool task_menu_explore_init_finder(retro_task_t *task, void *user_data)
 }
 
 bool task_push_menu_explore_init(const char *directory_playlist,
-      const char *directory_database)
+      const char *directory_database, bool playlist_cache)
 {
    task_finder_data_t find_data;
    retro_task_t *task                       = NULL;
@@ -193,6 +195,7 @@ bool task_push_menu_explore_init(const char *directory_playlist,
    menu_explore->state              = NULL;
    menu_explore->directory_playlist = strdup(directory_playlist);
    menu_explore->directory_database = strdup(directory_database);
+   menu_explore->playlist_cache     = playlist_cache;
 
    /* Configure task
     * > Note: This is silent task, with no title
@@ -24,6 +24,7 @@
 #include <compat/strl.h>
 #include <file/file_path.h>
 #include <streams/file_stream.h>
+#include <streams/trans_stream.h>
 #include <retro_endianness.h>
 
 #ifdef _WIN32
@@ -52,14 +53,295 @@
 #define IDENTIFIER_INDEX   4
 #define HEADER_LEN         6
 
-#define REPLAY_FORMAT_VERSION 1
+/* Version 2 added compressed/delta checkpoints */
+#define REPLAY_FORMAT_VERSION 2
 #define REPLAY_MAGIC       0x42535632
 
+/* Every Nth checkpoint is stored whole, so that playback
+ * started from a savestate resyncs before long */
+#define REPLAY_CHECKPOINT2_KEYFRAME 8
+/* Token, encoding, state size, base offset, packed size */
+#define REPLAY_CHECKPOINT2_HEADER   (1 + 1 + 8 + 8 + 8)
+
+#define BSV_MOVIE_RECORD_BUF_SIZE   (64 << 10)
+
+/* Footer written when a recording is finalized:
+ * index entries (frame, record offset, checkpoint offset,
+ * flags; all uint64), then a trailer holding the index
+ * offset, entry count, version and magic. */
+#define REPLAY_INDEX_ENTRY_SIZE     32
+#define REPLAY_INDEX_TRAILER_SIZE   24
+#define REPLAY_INDEX_VERSION        1
+#define REPLAY_INDEX_MAGIC          0x49565342
+#define REPLAY_INDEX_FLAG_FULL      1
+
 /* Forward declaration */
 bool content_load_state_in_progress(void* data);
 
 /* Private functions */
 
+static void bsv_movie_put64(uint8_t *s, uint64_t val)
+{
+   val = swap_if_big64(val);
+   memcpy(s, &val, sizeof(val));
+}
+
+static uint64_t bsv_movie_get64(const uint8_t *s)
+{
+   uint64_t val;
+   memcpy(&val, s, sizeof(val));
+   return swap_if_big64(val);
+}
+
+static void bsv_movie_put32(uint8_t *s, uint32_t val)
+{
+   val = swap_if_big32(val);
+   memcpy(s, &val, sizeof(val));
+}
+
+static uint32_t bsv_movie_get32(const uint8_t *s)
+{
+   uint32_t val;
+   memcpy(&val, s, sizeof(val));
+   return swap_if_big32(val);
+}
+
+static bool bsv_movie_index_push(bsv_movie_t *handle, uint64_t frame,
+      uint64_t record_pos, uint64_t checkpoint_pos, bool full)
+{
+   bsv_movie_index_entry_t *entry;
+
+   if (handle->index_count == handle->index_cap)
+   {
+      size_t new_cap = handle->index_cap ? handle->index_cap * 2 : 64;
+      bsv_movie_index_entry_t *tmp = (bsv_movie_index_entry_t*)realloc(
+            handle->index, new_cap * sizeof(*tmp));
+      if (!tmp)
+         return false;
+      handle->index     = tmp;
+      handle->index_cap = new_cap;
+   }
+
+   entry                 = &handle->index[handle->index_count++];
+   entry->frame          = frame;
+   entry->record_pos     = record_pos;
+   entry->checkpoint_pos = checkpoint_pos;
+   entry->full           = full;
+   return true;
+}
+
+/* Loads the footer index, if the replay has a valid one.
+ * Leaves the file position untouched. */
+static void bsv_movie_read_index(bsv_movie_t *handle)
+{
+   size_t i;
+   uint64_t index_pos, count;
+   uint8_t trailer[REPLAY_INDEX_TRAILER_SIZE];
+   uint8_t *entries = NULL;
+   int64_t pos      = intfstream_tell(handle->file);
+   int64_t size     = intfstream_get_size(handle->file);
+
+   if (size < (int64_t)(handle->min_file_pos + REPLAY_INDEX_TRAILER_SIZE))
+      return;
+
+   intfstream_seek(handle->file, size - REPLAY_INDEX_TRAILER_SIZE, SEEK_SET);
+   if (     intfstream_read(handle->file, trailer, sizeof(trailer))
+         != sizeof(trailer)
+         || bsv_movie_get32(trailer + 20) != REPLAY_INDEX_MAGIC
+         || bsv_movie_get32(trailer + 16) != REPLAY_INDEX_VERSION)
+      goto end;
+
+   index_pos = bsv_movie_get64(trailer);
+   count     = bsv_movie_get64(trailer + 8);
+   if (     index_pos < handle->min_file_pos
+         || count > (uint64_t)size / REPLAY_INDEX_ENTRY_SIZE
+         || index_pos + count * REPLAY_INDEX_ENTRY_SIZE
+            + REPLAY_INDEX_TRAILER_SIZE != (uint64_t)size)
+      goto end;
+
+   if (count)
+   {
+      if (!(entries = (uint8_t*)malloc(count * REPLAY_INDEX_ENTRY_SIZE)))
+         goto end;
+      intfstream_seek(handle->file, index_pos, SEEK_SET);
+      if (     intfstream_read(handle->file, entries,
+                  count * REPLAY_INDEX_ENTRY_SIZE)
+            != (int64_t)(count * REPLAY_INDEX_ENTRY_SIZE))
+         goto end;
+   }
+
+   handle->index_count = 0;
+   for (i = 0; i < count; i++)
+   {
+      const uint8_t *e = entries + i * REPLAY_INDEX_ENTRY_SIZE;
+      if (!bsv_movie_index_push(handle, bsv_movie_get64(e),
+               bsv_movie_get64(e + 8), bsv_movie_get64(e + 16),
+               (bsv_movie_get64(e + 24) & REPLAY_INDEX_FLAG_FULL) != 0))
+         goto end;
+   }
+
+   handle->end_pos     = index_pos;
+   handle->index_valid = true;
+
+end:
+   free(entries);
+   intfstream_seek(handle->file, pos, SEEK_SET);
+}
+
+/* Appends the footer index to a finished recording */
+static void bsv_movie_write_index(bsv_movie_t *handle)
+{
+   size_t i;
+   int64_t index_pos;
+   uint8_t trailer[REPLAY_INDEX_TRAILER_SIZE];
+
+   bsv_movie_sync(handle);
+   index_pos       = intfstream_tell(handle->file);
+   if (index_pos <= (int64_t)handle->min_file_pos)
+      return;
+   /* Drop anything left over past the last frame */
+   intfstream_truncate(handle->file, index_pos);
+
+   handle->end_pos = index_pos;
+   if (!bsv_movie_build_index(handle))
+      return;
+
+   for (i = 0; i < handle->index_count; i++)
+   {
+      uint8_t e[REPLAY_INDEX_ENTRY_SIZE];
+      bsv_movie_put64(e,      handle->index[i].frame);
+      bsv_movie_put64(e + 8,  handle->index[i].record_pos);
+      bsv_movie_put64(e + 16, handle->index[i].checkpoint_pos);
+      bsv_movie_put64(e + 24, handle->index[i].full
+            ? REPLAY_INDEX_FLAG_FULL : 0);
+      intfstream_write(handle->file, e, sizeof(e));
+   }
+
+   bsv_movie_put64(trailer,      index_pos);
+   bsv_movie_put64(trailer + 8,  handle->index_count);
+   bsv_movie_put32(trailer + 16, REPLAY_INDEX_VERSION);
+   bsv_movie_put32(trailer + 20, REPLAY_INDEX_MAGIC);
+   intfstream_write(handle->file, trailer, sizeof(trailer));
+}
+
+static bool bsv_movie_reserve(bsv_movie_t *handle, size_t len)
+{
+   uint8_t *buf;
+   size_t cap = handle->record_cap ? handle->record_cap
+      : BSV_MOVIE_RECORD_BUF_SIZE;
+
+   if (handle->record_len + len <= handle->record_cap)
+      return true;
+
+   while (cap < handle->record_len + len)
+      cap *= 2;
+
+   if (!(buf = (uint8_t*)realloc(handle->record_buf, cap)))
+      return false;
+
+   handle->record_buf = buf;
+   handle->record_cap = cap;
+   return true;
+}
+
+/* Makes sure the checkpoint buffers fit a state of 'len' bytes;
+ * a size change also means the next delta has no base. */
+static bool bsv_movie_checkpoint_alloc(bsv_movie_t *handle, size_t len)
+{
+   uint8_t *cur, *scratch;
+
+   if (len == handle->checkpoint_size)
+      return true;
+
+   handle->checkpoint_pos  = -1;
+   handle->checkpoint_size = 0;
+
+   if (!(cur = (uint8_t*)realloc(handle->checkpoint, len)))
+      return false;
+   handle->checkpoint = cur;
+   if (!(scratch = (uint8_t*)realloc(handle->checkpoint_scratch, len)))
+      return false;
+   handle->checkpoint_scratch = scratch;
+
+   handle->checkpoint_size = len;
+   return true;
+}
+
+static void bsv_movie_checkpoint_swap(bsv_movie_t *handle)
+{
+   uint8_t *swap              = handle->checkpoint;
+   handle->checkpoint         = handle->checkpoint_scratch;
+   handle->checkpoint_scratch = swap;
+}
+
+#ifdef HAVE_THREADS
+static void bsv_movie_writer_thread(void *data)
+{
+   bsv_movie_t *handle = (bsv_movie_t*)data;
+
+   slock_lock(handle->writer_lock);
+   for (;;)
+   {
+      while (!handle->writer_busy && !handle->writer_quit)
+         scond_wait(handle->writer_cond, handle->writer_lock);
+
+      if (!handle->writer_busy)
+         break;
+
+      slock_unlock(handle->writer_lock);
+      intfstream_write(handle->file, handle->flush_buf, handle->flush_len);
+      slock_lock(handle->writer_lock);
+
+      handle->flush_len   = 0;
+      handle->writer_busy = false;
+      scond_signal(handle->writer_cond);
+   }
+   slock_unlock(handle->writer_lock);
+}
+#endif
+
+static void bsv_movie_writer_init(bsv_movie_t *handle)
+{
+#ifdef HAVE_THREADS
+   handle->writer_lock = slock_new();
+   handle->writer_cond = scond_new();
+
+   if (handle->writer_lock && handle->writer_cond)
+      handle->writer   = sthread_create(bsv_movie_writer_thread, handle);
+
+   if (!handle->writer)
+      RARCH_WARN("[Replay] Failed to start writer thread, writing on the main thread.\n");
+#endif
+}
+
+static void bsv_movie_writer_deinit(bsv_movie_t *handle)
+{
+   if (handle->file)
+   {
+      bsv_movie_sync(handle);
+      if (!handle->playback && handle->min_file_pos)
+         bsv_movie_write_index(handle);
+   }
+
+#ifdef HAVE_THREADS
+   if (handle->writer)
+   {
+      slock_lock(handle->writer_lock);
+      handle->writer_quit = true;
+      scond_signal(handle->writer_cond);
+      slock_unlock(handle->writer_lock);
+      sthread_join(handle->writer);
+   }
+   if (handle->writer_lock)
+      slock_free(handle->writer_lock);
+   if (handle->writer_cond)
+      scond_free(handle->writer_cond);
+   handle->writer      = NULL;
+   handle->writer_lock = NULL;
+   handle->writer_cond = NULL;
+#endif
+}
+
 static bool bsv_movie_init_playback(
       bsv_movie_t *handle, const char *path)
 {
@@ -138,6 +420,7 @@ static bool bsv_movie_init_playback(
    }
 
    handle->min_file_pos = sizeof(header) + state_size;
+   bsv_movie_read_index(handle);
    if(vsn > 0)
       bsv_movie_read_next_events(handle);
 
@@ -185,6 +468,8 @@ static bool bsv_movie_init_record(
    handle->min_file_pos     = sizeof(header) + state_size;
    handle->state_size       = state_size;
 
+   bsv_movie_writer_init(handle);
+
    if (state_size)
    {
       retro_ctx_serialize_info_t serial_info;
@@ -207,8 +492,390 @@ static bool bsv_movie_init_record(
    return true;
 }
 
+/**
+ * bsv_movie_write:
+ *
+ * Appends recorded data. It reaches the file once
+ * bsv_movie_kick() or bsv_movie_sync() is called.
+ **/
+void bsv_movie_write(bsv_movie_t *handle, const void *data, size_t len)
+{
+   bsv_movie_tell(handle);
+
+   if (!bsv_movie_reserve(handle, len))
+   {
+      bsv_movie_sync(handle);
+      intfstream_write(handle->file, data, len);
+      return;
+   }
+
+   memcpy(handle->record_buf + handle->record_len, data, len);
+   handle->record_len += len;
+   handle->write_pos  += len;
+}
+
+/**
+ * bsv_movie_kick:
+ *
+ * Hands everything recorded so far to the writer thread,
+ * unless it is still busy with the previous batch, in which
+ * case recording keeps accumulating.
+ **/
+void bsv_movie_kick(bsv_movie_t *handle)
+{
+   if (!handle->record_len)
+      return;
+
+#ifdef HAVE_THREADS
+   if (handle->writer)
+   {
+      uint8_t *buf;
+      size_t cap;
+
+      slock_lock(handle->writer_lock);
+      if (handle->writer_busy)
+      {
+         slock_unlock(handle->writer_lock);
+         return;
+      }
+
+      buf                 = handle->flush_buf;
+      cap                 = handle->flush_cap;
+      handle->flush_buf   = handle->record_buf;
+      handle->flush_cap   = handle->record_cap;
+      handle->flush_len   = handle->record_len;
+      handle->record_buf  = buf;
+      handle->record_cap  = cap;
+      handle->record_len  = 0;
+      handle->writer_busy = true;
+      scond_signal(handle->writer_cond);
+      slock_unlock(handle->writer_lock);
+
+      handle->frames_since_flush = 0;
+      return;
+   }
+#endif
+
+   intfstream_write(handle->file, handle->record_buf, handle->record_len);
+   handle->record_len         = 0;
+   handle->frames_since_flush = 0;
+}
+
+/**
+ * bsv_movie_sync:
+ *
+ * Writes out everything recorded so far and waits for the
+ * writer thread. Must be called before the main thread reads,
+ * seeks or truncates a file that is being recorded.
+ **/
+void bsv_movie_sync(bsv_movie_t *handle)
+{
+#ifdef HAVE_THREADS
+   if (handle->writer)
+   {
+      slock_lock(handle->writer_lock);
+      while (handle->writer_busy)
+         scond_wait(handle->writer_cond, handle->writer_lock);
+      slock_unlock(handle->writer_lock);
+   }
+#endif
+
+   if (handle->record_len)
+      intfstream_write(handle->file, handle->record_buf, handle->record_len);
+   handle->record_len         = 0;
+   handle->frames_since_flush = 0;
+   /* The file may be moved around from here on */
+   handle->write_pos          = -1;
+}
+
+/**
+ * bsv_movie_tell:
+ *
+ * Returns the position in the file being recorded,
+ * counting data that hasn't been written yet.
+ **/
+int64_t bsv_movie_tell(bsv_movie_t *handle)
+{
+   /* Only ever unknown right after a sync,
+    * so the file is not being written to */
+   if (handle->write_pos < 0)
+      handle->write_pos = intfstream_tell(handle->file);
+   return handle->write_pos;
+}
+
+/**
+ * bsv_movie_write_checkpoint:
+ *
+ * Serializes the core and records it as a checkpoint frame,
+ * stored as an LZ4-compressed XOR delta against the previous
+ * checkpoint when there is one.
+ *
+ * Returns: false if nothing was recorded.
+ **/
+bool bsv_movie_write_checkpoint(bsv_movie_t *handle)
+{
+   size_t i, bound;
+   uint32_t rd, wn;
+   int64_t pos;
+   uint8_t *hdr;
+   bool delta;
+   retro_ctx_serialize_info_t serial_info;
+   const struct trans_stream_backend *be =
+      trans_stream_get_lz4_compress_backend();
+   size_t _len = core_serialize_size();
+
+   if (!_len || !bsv_movie_checkpoint_alloc(handle, _len))
+      return false;
+   if (     !handle->checkpoint_stream
+         && !(handle->checkpoint_stream = be->stream_new()))
+      return false;
+
+   serial_info.data = handle->checkpoint_scratch;
+   serial_info.size = _len;
+   if (!core_serialize(&serial_info))
+      return false;
+
+   bound = _len + _len / 255 + 16;
+   if (!bsv_movie_reserve(handle, REPLAY_CHECKPOINT2_HEADER + bound))
+      return false;
+
+   delta = (handle->checkpoint_pos >= 0)
+      && (handle->checkpoint_count % REPLAY_CHECKPOINT2_KEYFRAME) != 0;
+
+   /* Unchanged bytes turn into zeroes, which LZ4 makes short work of */
+   if (delta)
+      for (i = 0; i < _len; i++)
+         handle->checkpoint[i] ^= handle->checkpoint_scratch[i];
+
+   pos = bsv_movie_tell(handle);
+   hdr = handle->record_buf + handle->record_len;
+
+   be->set_in(handle->checkpoint_stream,
+         delta ? handle->checkpoint : handle->checkpoint_scratch,
+         (uint32_t)_len);
+   be->set_out(handle->checkpoint_stream,
+         hdr + REPLAY_CHECKPOINT2_HEADER, (uint32_t)bound);
+   if (!be->trans(handle->checkpoint_stream, true, &rd, &wn, NULL))
+   {
+      handle->checkpoint_pos = -1;
+      return false;
+   }
+
+   hdr[0] = REPLAY_TOKEN_CHECKPOINT2_FRAME;
+   hdr[1] = delta ? REPLAY_CHECKPOINT2_DELTA : REPLAY_CHECKPOINT2_FULL;
+   bsv_movie_put64(hdr + 2,  _len);
+   bsv_movie_put64(hdr + 10, delta ? (uint64_t)handle->checkpoint_pos : 0);
+   bsv_movie_put64(hdr + 18, wn);
+
+   handle->record_len    += REPLAY_CHECKPOINT2_HEADER + wn;
+   handle->write_pos     += REPLAY_CHECKPOINT2_HEADER + wn;
+
+   /* This state is the base for the next delta */
+   bsv_movie_checkpoint_swap(handle);
+   handle->checkpoint_pos = pos;
+   handle->checkpoint_count++;
+   return true;
+}
+
+/**
+ * bsv_movie_read_checkpoint:
+ *
+ * Reads a checkpoint frame written by bsv_movie_write_checkpoint(),
+ * right after its token, and loads it into the core. A delta whose
+ * base wasn't seen (playback started from a savestate, or rewound)
+ * is skipped; the next full checkpoint resyncs. With @load unset,
+ * only decodes it as the base for the next one.
+ *
+ * Returns: false if the replay is truncated or corrupt.
+ **/
+bool bsv_movie_read_checkpoint(bsv_movie_t *handle, bool load)
+{
+   uint32_t rd, wn;
+   uint64_t size, base, packed;
+   uint8_t hdr[REPLAY_CHECKPOINT2_HEADER - 1];
+   retro_ctx_serialize_info_t serial_info;
+   const struct trans_stream_backend *be =
+      trans_stream_get_lz4_decompress_backend();
+   int64_t pos       = intfstream_tell(handle->file) - 1;
+   int64_t file_size = intfstream_get_size(handle->file);
+   size_t max_size   = core_serialize_size();
+
+   if (intfstream_read(handle->file, hdr, sizeof(hdr)) != sizeof(hdr))
+      return false;
+
+   size   = bsv_movie_get64(hdr + 1);
+   base   = bsv_movie_get64(hdr + 9);
+   packed = bsv_movie_get64(hdr + 17);
+
+   /* Both sizes come from the file, so check them before
+    * allocating anything: the state can't be larger than
+    * the core's savestates, and the packed data has to fit
+    * in the LZ4 bound and in what is left of the file */
+   if (     size > max_size
+         || packed > size + size / 255 + 16
+         || (int64_t)packed > file_size - (pos + REPLAY_CHECKPOINT2_HEADER))
+   {
+      RARCH_ERR("[Replay] Invalid checkpoint size.\n");
+      return false;
+   }
+
+   if (packed > handle->checkpoint_packed_cap)
+   {
+      uint8_t *buf = (uint8_t*)realloc(handle->checkpoint_packed, packed);
+      if (!buf)
+         return false;
+      handle->checkpoint_packed     = buf;
+      handle->checkpoint_packed_cap = packed;
+   }
+
+   if (intfstream_read(handle->file, handle->checkpoint_packed, packed)
+         != (int64_t)packed)
+      return false;
+
+   if (!bsv_movie_checkpoint_alloc(handle, size))
+      return false;
+
+   if (     hdr[0] == REPLAY_CHECKPOINT2_DELTA
+         && (   handle->checkpoint_pos < 0
+             || (uint64_t)handle->checkpoint_pos != base))
+   {
+      RARCH_WARN("[Replay] Skipping checkpoint, its base wasn't loaded.\n");
+      return true;
+   }
+
+   if (     !handle->checkpoint_stream
+         && !(handle->checkpoint_stream = be->stream_new()))
+      return false;
+
+   be->set_in(handle->checkpoint_stream,
+         handle->checkpoint_packed, (uint32_t)packed);
+   be->set_out(handle->checkpoint_stream,
+         handle->checkpoint_scratch, (uint32_t)size);
+   if (     !be->trans(handle->checkpoint_stream, true, &rd, &wn, NULL)
+         || wn != size)
+   {
+      handle->checkpoint_pos = -1;
+      return false;
+   }
+
+   if (hdr[0] == REPLAY_CHECKPOINT2_DELTA)
+   {
+      size_t i;
+      for (i = 0; i < size; i++)
+         handle->checkpoint_scratch[i] ^= handle->checkpoint[i];
+   }
+
+   bsv_movie_checkpoint_swap(handle);
+   handle->checkpoint_pos = pos;
+
+   if (load)
+   {
+      serial_info.data_const = handle->checkpoint;
+      serial_info.size       = size;
+      core_unserialize(&serial_info);
+   }
+   return true;
+}
+
+/**
+ * bsv_movie_build_index:
+ *
+ * Scans the frame records for checkpoints, for replays
+ * without a footer index (or to write one). Skips over
+ * checkpoint data without decoding it, and leaves the
+ * file position untouched.
+ *
+ * Returns: false if the scan couldn't be done.
+ **/
+bool bsv_movie_build_index(bsv_movie_t *handle)
+{
+   uint64_t frame;
+   int64_t pos         = intfstream_tell(handle->file);
+
+   handle->index_count = 0;
+   handle->index_valid = false;
+
+   intfstream_seek(handle->file, handle->min_file_pos, SEEK_SET);
+
+   for (frame = 0; ; frame++)
+   {
+      uint8_t key_count, tok;
+      int64_t tok_pos;
+      int64_t record_pos = intfstream_tell(handle->file);
+
+      if (handle->end_pos && record_pos >= handle->end_pos)
+         break;
+      if (intfstream_read(handle->file, &key_count, 1) != 1)
+         break;
+      intfstream_seek(handle->file,
+            key_count * sizeof(bsv_key_data_t), SEEK_CUR);
+
+      if (handle->version > 0)
+      {
+         uint16_t input_count;
+         if (intfstream_read(handle->file, &input_count, 2) != 2)
+            break;
+         input_count = swap_if_big16(input_count);
+         intfstream_seek(handle->file,
+               input_count * sizeof(bsv_input_data_t), SEEK_CUR);
+      }
+
+      tok_pos = intfstream_tell(handle->file);
+      if (intfstream_read(handle->file, &tok, 1) != 1)
+         break;
+
+      if (tok == REPLAY_TOKEN_CHECKPOINT2_FRAME)
+      {
+         uint8_t hdr[REPLAY_CHECKPOINT2_HEADER - 1];
+         if (intfstream_read(handle->file, hdr, sizeof(hdr)) != sizeof(hdr))
+            break;
+         if (!bsv_movie_index_push(handle, frame, record_pos, tok_pos,
+                  hdr[0] == REPLAY_CHECKPOINT2_FULL))
+            goto error;
+         intfstream_seek(handle->file, bsv_movie_get64(hdr + 17), SEEK_CUR);
+      }
+      else if (tok == REPLAY_TOKEN_CHECKPOINT_FRAME)
+      {
+         uint8_t size[8];
+         if (intfstream_read(handle->file, size, sizeof(size)) != sizeof(size))
+            break;
+         if (!bsv_movie_index_push(handle, frame, record_pos, tok_pos, true))
+            goto error;
+         intfstream_seek(handle->file, bsv_movie_get64(size), SEEK_CUR);
+      }
+      else if (tok != REPLAY_TOKEN_REGULAR_FRAME)
+         break;
+   }
+
+   handle->index_valid = true;
+   intfstream_seek(handle->file, pos, SEEK_SET);
+   return true;
+
+error:
+   intfstream_seek(handle->file, pos, SEEK_SET);
+   return false;
+}
+
 void bsv_movie_free(bsv_movie_t *handle)
 {
+   bsv_movie_writer_deinit(handle);
+
+   if (handle->checkpoint_stream)
+   {
+      if (handle->playback)
+         trans_stream_get_lz4_decompress_backend()->stream_free(
+               handle->checkpoint_stream);
+      else
+         trans_stream_get_lz4_compress_backend()->stream_free(
+               handle->checkpoint_stream);
+   }
+   free(handle->checkpoint);
+   free(handle->checkpoint_scratch);
+   free(handle->checkpoint_packed);
+   free(handle->record_buf);
+   free(handle->flush_buf);
+   free(handle->index);
+
    intfstream_close(handle->file);
    free(handle->file);
 
@@ -225,6 +892,9 @@ static bsv_movie_t *bsv_movie_init_internal(const char *path, enum rarch_movie_t
    if (!handle)
       return NULL;
 
+   handle->write_pos      = -1;
+   handle->checkpoint_pos = -1;
+
    if (type == RARCH_MOVIE_PLAYBACK)
    {
       if (!bsv_movie_init_playback(handle, path))
@@ -618,6 +618,7 @@ bool task_push_pl_thumbnail_download(
 
    /* Configure task */
    task->handler                 = task_pl_thumbnail_download_handler;
+   task->priority                = TASK_PRIORITY_LOW;
    task->state                   = pl_thumb;
    task->title                   = strdup(system);
    task->progress                = 0;
@@ -967,12 +968,17 @@ bool task_push_pl_entry_thumbnail_download(
 
    /* Configure task */
    task->handler                 = task_pl_entry_thumbnail_download_handler;
+   /* The user is looking at this entry right now */
+   task->priority                = TASK_PRIORITY_HIGH;
    task->state                   = pl_thumb;
    task->title                   = strdup(system);
    task->progress                = 0;
    task->callback                = cb_task_pl_entry_thumbnail_refresh_menu;
    task->cleanup                 = task_pl_entry_thumbnail_free;
    task->flags                  |=  RETRO_TASK_FLG_ALTERNATIVE_LOOK;
+   /* The handler only works on its own copy of the
+    * thumbnail paths, the playlist is not touched */
+   task->flags                  |=  RETRO_TASK_FLG_CONCURRENT;
    if (mute)
       task->flags               |=  RETRO_TASK_FLG_MUTE;
    else
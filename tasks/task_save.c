@@ -102,7 +102,8 @@ enum save_task_state_flags
    SAVE_TASK_FLAG_MUTE                  = (1 << 4),
    SAVE_TASK_FLAG_THUMBNAIL_ENABLE      = (1 << 5),
    SAVE_TASK_FLAG_HAS_VALID_FB          = (1 << 6),
-   SAVE_TASK_FLAG_COMPRESS_FILES        = (1 << 7)
+   SAVE_TASK_FLAG_COMPRESS_FILES        = (1 << 7),
+   SAVE_TASK_FLAG_FAST_COMPRESSION      = (1 << 8)
 };
 
 typedef struct
@@ -115,7 +116,7 @@ typedef struct
    ssize_t written;
    ssize_t bytes_read;
    int state_slot;
-   uint8_t flags;
+   uint16_t flags;
    char path[PATH_MAX_LENGTH];
 } save_task_state_t;
 
@@ -133,6 +134,9 @@ static struct save_state_buf undo_load_buf;
  * This is useful for devices with slow I/O. */
 static struct ram_save_state_buf ram_buf;
 
+/* The buffers above are not locked, so all save
+ * and load tasks run serially (without RETRO_TASK_FLG_CONCURRENT) */
+
 static bool save_state_in_background       = false;
 
 typedef struct rastate_size_info
@@ -511,8 +515,10 @@ static void task_save_handler(retro_task_t *task)
    if (!state->file)
    {
       if (state->flags & SAVE_TASK_FLAG_COMPRESS_FILES)
-         state->file   = intfstream_open_rzip_file(
-               state->path, RETRO_VFS_FILE_ACCESS_WRITE);
+         state->file   = intfstream_open_rzip_file_codec(
+               state->path, RETRO_VFS_FILE_ACCESS_WRITE,
+               (state->flags & SAVE_TASK_FLAG_FAST_COMPRESSION)
+               ? RZIP_CODEC_LZ4 : RZIP_CODEC_ZLIB);
       else
          state->file   = intfstream_open_file(
                state->path, RETRO_VFS_FILE_ACCESS_WRITE,
@@ -632,6 +638,8 @@ static bool task_push_undo_save_state(const char *path, void *data, size_t len)
 #if defined(HAVE_ZLIB)
    if (settings->bools.savestate_file_compression)
       state->flags              |= SAVE_TASK_FLAG_COMPRESS_FILES;
+   if (settings->bools.savestate_fast_compression)
+      state->flags              |= SAVE_TASK_FLAG_FAST_COMPRESSION;
 #endif
    if (!settings->bools.notification_show_save_state)
       state->flags              |= SAVE_TASK_FLAG_MUTE;
@@ -639,6 +647,7 @@ static bool task_push_undo_save_state(const char *path, void *data, size_t len)
    task->type                    = TASK_TYPE_BLOCKING;
    task->state                   = state;
    task->handler                 = task_save_handler;
+   task->priority                = TASK_PRIORITY_HIGH;
    task->callback                = undo_save_state_cb;
    task->title                   = strdup(msg_hash_to_str(MSG_UNDOING_SAVE_STATE));
 
@@ -1186,6 +1195,9 @@ static void task_push_save_state(const char *path, void *data, size_t len, bool
 #if defined(HAVE_ZLIB)
    if (settings->bools.savestate_file_compression)
       state->flags              |= SAVE_TASK_FLAG_COMPRESS_FILES;
+   /* Automatic saves favour speed over size */
+   if (autosave && settings->bools.savestate_fast_compression)
+      state->flags              |= SAVE_TASK_FLAG_FAST_COMPRESSION;
 #endif
    if (!settings->bools.notification_show_save_state)
       state->flags              |= SAVE_TASK_FLAG_MUTE;
@@ -1193,6 +1205,7 @@ static void task_push_save_state(const char *path, void *data, size_t len, bool
    task->type                    = TASK_TYPE_BLOCKING;
    task->state                   = state;
    task->handler                 = task_save_handler;
+   task->priority                = TASK_PRIORITY_HIGH;
    task->callback                = save_state_cb;
    task->title                   = strdup(msg_hash_to_str(MSG_SAVING_STATE));
 
@@ -1303,6 +1316,7 @@ static void task_push_load_and_save_state(const char *path, void *data,
    task->state                   = state;
    task->type                    = TASK_TYPE_BLOCKING;
    task->handler                 = task_load_handler;
+   task->priority                = TASK_PRIORITY_HIGH;
    task->callback                = content_load_and_save_state_cb;
    task->title                   = strdup(msg_hash_to_str(MSG_LOADING_STATE));
 
@@ -1356,7 +1370,9 @@ bool content_auto_save_state(const char *path)
 
 #if defined(HAVE_ZLIB)
    if (settings->bools.savestate_file_compression)
-      file = intfstream_open_rzip_file(path, RETRO_VFS_FILE_ACCESS_WRITE);
+      file = intfstream_open_rzip_file_codec(path, RETRO_VFS_FILE_ACCESS_WRITE,
+            settings->bools.savestate_fast_compression
+            ? RZIP_CODEC_LZ4 : RZIP_CODEC_ZLIB);
    else
 #endif
       file = intfstream_open_file(path, RETRO_VFS_FILE_ACCESS_WRITE,
@@ -1589,6 +1605,7 @@ bool content_load_state(const char *path,
    task->type                   = TASK_TYPE_BLOCKING;
    task->state                  = state;
    task->handler                = task_load_handler;
+   task->priority               = TASK_PRIORITY_HIGH;
    task->callback               = content_load_state_cb;
    task->title                  = strdup(msg_hash_to_str(MSG_LOADING_STATE));
 
@@ -1808,8 +1825,10 @@ bool content_ram_state_to_file(const char *path)
       settings_t *settings = config_get_ptr();
       if (settings->bools.save_file_compression)
       {
-         if (rzipstream_write_file(
-               path, ram_buf.state_buf.data, ram_buf.state_buf.size))
+         if (rzipstream_write_file_codec(
+               path, ram_buf.state_buf.data, ram_buf.state_buf.size,
+               settings->bools.savestate_fast_compression
+               ? RZIP_CODEC_LZ4 : RZIP_CODEC_ZLIB))
             goto success;
       }
       else
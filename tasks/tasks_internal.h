@@ -196,6 +196,13 @@ bool task_push_manual_content_scan(
       const playlist_config_t *playlist_config,
       const char *playlist_directory);
 
+#ifdef HAVE_CHEATS
+struct cheat_search;
+
+/* Takes ownership of the search on success */
+bool task_push_cheat_search(struct cheat_search *search);
+#endif
+
 #ifdef HAVE_OVERLAY
 bool task_push_overlay_load_default(
       retro_task_callback_t cb,
@@ -269,7 +276,7 @@ void task_push_cdrom_dump(const char *drive);
 /* Menu explore tasks */
 #if defined(HAVE_MENU) && defined(HAVE_LIBRETRODB)
 bool task_push_menu_explore_init(const char *directory_playlist,
-      const char *directory_database);
+      const char *directory_database, bool playlist_cache);
 bool menu_explore_init_in_progress(void *data);
 void menu_explore_wait_for_init_task(void);
 #endif
@@ -0,0 +1,1545 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2021 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* ranetrelay joins a netplay host as a single spectator and forwards the
+ * session to any number of spectators of its own, so that the host only
+ * ever serves one extra connection. It does not run the core: input frames,
+ * CRCs and savestates are passed through as received. Every spectator has
+ * its own send queue, and one that falls too far behind is dropped instead
+ * of holding up the others. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <compat/getopt.h>
+#include <compat/strl.h>
+#include <string/stdstring.h>
+#include <net/net_compat.h>
+#include <net/net_socket.h>
+
+/* Only for #defines */
+#include "../../network/netplay/netplay_private.h"
+
+#define RELAY_DEFAULT_NICK       "RANetrelay"
+
+/* Spectators only ever send small commands */
+#define RELAY_MAX_CLIENT_PAYLOAD 4096
+
+/* Savestates are the largest thing the host sends */
+#define RELAY_MAX_HOST_PAYLOAD   (64 * 1024 * 1024)
+
+/* Seconds a spectator has to finish the handshake */
+#define RELAY_HANDSHAKE_TIMEOUT  30
+
+/* Size of a SYNC payload, without the SRAM */
+#define RELAY_SYNC_SIZE (2*sizeof(uint32_t) \
+      /* Controller devices */ \
+      + MAX_INPUT_DEVICES*sizeof(uint32_t) \
+      /* Share modes */ \
+      + MAX_INPUT_DEVICES*sizeof(uint8_t) \
+      /* Device-client mapping */ \
+      + MAX_INPUT_DEVICES*sizeof(uint32_t) \
+      /* Client nick */ \
+      + NETPLAY_NICK_LEN)
+
+/* Size of an INFO payload: content CRC, core name and core version */
+#define RELAY_INFO_SIZE (sizeof(uint32_t) + 2*NETPLAY_NICK_LEN)
+
+/* A complete command, header included. A message is shared by every queue
+ * it is in, and freed once the last of them has sent it. */
+struct relay_msg
+{
+   size_t   refs;
+   size_t   size;
+   uint32_t cmd;
+   uint8_t  data[1];
+};
+
+#define RELAY_MSG_PAYLOAD(msg) ((msg)->data + 2*sizeof(uint32_t))
+
+struct relay_queue
+{
+   struct relay_msg **msgs;
+   size_t capacity;
+   size_t head;
+   size_t count;
+   /* Bytes of the head message already sent */
+   size_t offset;
+   /* Bytes left to send */
+   size_t bytes;
+};
+
+enum relay_peer_mode
+{
+   RELAY_PEER_NONE = 0,
+   /* Waiting for the connection header */
+   RELAY_PEER_INIT,
+   RELAY_PEER_PRE_NICK,
+   RELAY_PEER_PRE_INFO,
+   /* Handshake done, waiting for a savestate to start from */
+   RELAY_PEER_WAIT_STATE,
+   RELAY_PEER_SPECTATING
+};
+
+struct relay_peer
+{
+   struct relay_queue queue;
+   /* Received data not yet handled */
+   uint8_t *recv_buf;
+   size_t   recv_len;
+   size_t   recv_cap;
+   time_t   connected;
+   int      fd;
+   enum relay_peer_mode mode;
+   char     nick[NETPLAY_NICK_LEN];
+};
+
+/* What a new spectator needs to know in its SYNC */
+struct relay_sync
+{
+   /* The host's latest settings commands */
+   struct relay_msg *settings[2];
+   uint32_t config_devices[MAX_INPUT_DEVICES];
+   uint32_t device_clients[MAX_INPUT_DEVICES];
+   uint8_t  share_modes[MAX_INPUT_DEVICES];
+   bool     paused;
+};
+
+struct relay
+{
+   struct relay_peer host;
+   struct relay_peer *clients;
+   size_t clients_size;
+   size_t clients_capacity;
+
+   /* The newest savestate and everything the host sent after it */
+   struct relay_msg *state;
+   struct relay_msg **backlog;
+   size_t backlog_size;
+   size_t backlog_capacity;
+
+   /* Session info as of the current frame, and as of the savestate */
+   struct relay_sync live;
+   struct relay_sync at_state;
+
+   uint8_t *sram;
+   size_t   sram_size;
+
+   size_t   max_clients;
+   size_t   queue_limit;
+   uint32_t backlog_frames;
+
+   uint32_t protocol;
+   uint32_t compression;
+   uint32_t platform_magic;
+   uint32_t impl_magic;
+   uint32_t client_num;
+   uint32_t frame;
+   uint32_t state_frame;
+
+   int      listen_fd;
+   bool     state_requested;
+
+   char     host_nick[NETPLAY_NICK_LEN];
+   uint8_t  host_info[RELAY_INFO_SIZE];
+};
+
+static void usage(void)
+{
+   fprintf(stderr,
+      "Use: ranetrelay [options]\n"
+      "Options:\n"
+      "    -H|--host <address>:      Netplay host. Defaults to localhost.\n"
+      "    -P|--port <port>:         Netplay port. Defaults to 55435.\n"
+      "    -l|--listen <port>:       Port to serve spectators on. Defaults to\n"
+      "                              55436.\n"
+      "    -n|--nick <nick>:         Nickname to join the host with.\n"
+      "    -m|--max-clients <n>:     Maximum number of spectators. Defaults to\n"
+      "                              128.\n"
+      "    -q|--queue <KiB>:         Data queued for a spectator before it is\n"
+      "                              dropped as too slow. Must be well above\n"
+      "                              the size of a savestate. Defaults to\n"
+      "                              32768.\n"
+      "    -b|--backlog <frames>:    Frames a new spectator may have to catch\n"
+      "                              up on before a fresh savestate is\n"
+      "                              requested from the host. Defaults to\n"
+      "                              1800.\n"
+      "\n");
+}
+
+static uint32_t relay_read32(const uint8_t *data)
+{
+   uint32_t val;
+   memcpy(&val, data, sizeof(val));
+   return ntohl(val);
+}
+
+/**
+ * relay_platform_magic
+ *
+ * Same as netplay_platform_magic.
+ */
+static uint32_t relay_platform_magic(void)
+{
+   return ((1 == htonl(1)) << 30)
+      | (sizeof(size_t) << 15)
+      | (sizeof(long));
+}
+
+static struct relay_msg *relay_msg_new(uint32_t cmd,
+      const void *payload, uint32_t payload_size)
+{
+   uint32_t header[2];
+   struct relay_msg *msg = (struct relay_msg*)malloc(
+         sizeof(*msg) + sizeof(header) + payload_size);
+
+   if (!msg)
+      return NULL;
+
+   header[0]  = htonl(cmd);
+   header[1]  = htonl(payload_size);
+   msg->refs  = 1;
+   msg->size  = sizeof(header) + payload_size;
+   msg->cmd   = cmd;
+   memcpy(msg->data, header, sizeof(header));
+   if (payload_size)
+      memcpy(RELAY_MSG_PAYLOAD(msg), payload, payload_size);
+
+   return msg;
+}
+
+static struct relay_msg *relay_msg_ref(struct relay_msg *msg)
+{
+   if (msg)
+      msg->refs++;
+   return msg;
+}
+
+static void relay_msg_unref(struct relay_msg *msg)
+{
+   if (msg && !--msg->refs)
+      free(msg);
+}
+
+static bool relay_queue_push(struct relay_queue *queue,
+      struct relay_msg *msg)
+{
+   if (queue->count == queue->capacity)
+   {
+      size_t i;
+      size_t capacity        = queue->capacity ? queue->capacity * 2 : 64;
+      struct relay_msg **msgs = (struct relay_msg**)malloc(
+            capacity * sizeof(*msgs));
+
+      if (!msgs)
+         return false;
+
+      /* Unwrap the ring while growing it */
+      for (i = 0; i < queue->count; i++)
+         msgs[i] = queue->msgs[(queue->head + i) % queue->capacity];
+
+      free(queue->msgs);
+      queue->msgs     = msgs;
+      queue->capacity = capacity;
+      queue->head     = 0;
+   }
+
+   queue->msgs[(queue->head + queue->count) % queue->capacity] =
+      relay_msg_ref(msg);
+   queue->count++;
+   queue->bytes += msg->size;
+
+   return true;
+}
+
+static void relay_queue_pop(struct relay_queue *queue)
+{
+   relay_msg_unref(queue->msgs[queue->head]);
+   queue->head   = (queue->head + 1) % queue->capacity;
+   queue->offset = 0;
+   queue->count--;
+}
+
+static void relay_queue_clear(struct relay_queue *queue)
+{
+   while (queue->count)
+      relay_queue_pop(queue);
+   free(queue->msgs);
+   memset(queue, 0, sizeof(*queue));
+}
+
+/**
+ * relay_queue_flush
+ *
+ * Send as much of the queue as the socket takes without blocking.
+ * Returns false on a socket error.
+ */
+static bool relay_queue_flush(int fd, struct relay_queue *queue)
+{
+   while (queue->count)
+   {
+      struct relay_msg *msg = queue->msgs[queue->head];
+      ssize_t sent          = socket_send_all_nonblocking(fd,
+            msg->data + queue->offset, msg->size - queue->offset, true);
+
+      if (sent < 0)
+         return false;
+
+      queue->offset += sent;
+      queue->bytes  -= sent;
+
+      if (queue->offset < msg->size)
+         break;
+
+      relay_queue_pop(queue);
+   }
+
+   return true;
+}
+
+static void relay_sync_copy(struct relay_sync *dst,
+      const struct relay_sync *src)
+{
+   size_t i;
+
+   for (i = 0; i < ARRAY_SIZE(dst->settings); i++)
+   {
+      relay_msg_unref(dst->settings[i]);
+      dst->settings[i] = relay_msg_ref(src->settings[i]);
+   }
+
+   memcpy(dst->config_devices, src->config_devices,
+         sizeof(dst->config_devices));
+   memcpy(dst->device_clients, src->device_clients,
+         sizeof(dst->device_clients));
+   memcpy(dst->share_modes, src->share_modes, sizeof(dst->share_modes));
+   dst->paused = src->paused;
+}
+
+static void relay_sync_free(struct relay_sync *sync)
+{
+   size_t i;
+
+   for (i = 0; i < ARRAY_SIZE(sync->settings); i++)
+   {
+      relay_msg_unref(sync->settings[i]);
+      sync->settings[i] = NULL;
+   }
+}
+
+static void relay_peer_close(struct relay_peer *peer)
+{
+   if (peer->fd >= 0)
+      socket_close(peer->fd);
+   relay_queue_clear(&peer->queue);
+   free(peer->recv_buf);
+   memset(peer, 0, sizeof(*peer));
+   peer->fd   = -1;
+   peer->mode = RELAY_PEER_NONE;
+}
+
+static void relay_client_drop(struct relay_peer *client, const char *reason)
+{
+   fprintf(stderr, "Dropped spectator \"%s\": %s.\n",
+         client->nick[0] ? client->nick : "(handshake)", reason);
+   relay_peer_close(client);
+}
+
+/**
+ * relay_send
+ *
+ * Queue a message for a spectator. Spectators that fall more than
+ * queue_limit bytes behind are dropped, so that a slow connection never
+ * holds up the host or the other spectators.
+ */
+static bool relay_send(struct relay *relay, struct relay_peer *client,
+      struct relay_msg *msg)
+{
+   if (!relay_queue_push(&client->queue, msg))
+   {
+      relay_client_drop(client, "out of memory");
+      return false;
+   }
+
+   if (client->queue.bytes > relay->queue_limit)
+   {
+      relay_client_drop(client, "too far behind");
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * relay_send_cmd
+ *
+ * Queue a new command for a peer.
+ */
+static bool relay_send_cmd(struct relay *relay, struct relay_peer *peer,
+      uint32_t cmd, const void *payload, uint32_t size)
+{
+   bool ret;
+   struct relay_msg *msg = relay_msg_new(cmd, payload, size);
+
+   if (!msg)
+   {
+      if (peer != &relay->host)
+         relay_client_drop(peer, "out of memory");
+      return false;
+   }
+
+   if (peer == &relay->host)
+      ret = relay_queue_push(&peer->queue, msg);
+   else
+      ret = relay_send(relay, peer, msg);
+
+   relay_msg_unref(msg);
+   return ret;
+}
+
+/**
+ * relay_request_state
+ *
+ * Ask the host for a savestate, unless we already did.
+ */
+static void relay_request_state(struct relay *relay)
+{
+   if (relay->state_requested)
+      return;
+
+   relay->state_requested = relay_send_cmd(relay, &relay->host,
+         NETPLAY_CMD_REQUEST_SAVESTATE, NULL, 0);
+}
+
+static void relay_backlog_clear(struct relay *relay)
+{
+   size_t i;
+
+   for (i = 0; i < relay->backlog_size; i++)
+      relay_msg_unref(relay->backlog[i]);
+   relay->backlog_size = 0;
+}
+
+/**
+ * relay_backlog_push
+ *
+ * Keep a message for spectators that join later. Once the backlog is
+ * more than backlog_frames long, a fresh savestate is requested; if it
+ * reaches twice that, the savestate and backlog are dropped, and new
+ * spectators wait for the next savestate instead.
+ */
+static bool relay_backlog_push(struct relay *relay, struct relay_msg *msg)
+{
+   /* Nothing to catch up from */
+   if (!relay->state)
+      return true;
+
+   if (relay->frame > relay->state_frame)
+   {
+      uint32_t behind = relay->frame - relay->state_frame;
+
+      if (behind > relay->backlog_frames)
+         relay_request_state(relay);
+
+      if (behind / 2 > relay->backlog_frames)
+      {
+         fprintf(stderr, "No savestate from the host for %u frames, "
+               "dropping the backlog.\n", behind);
+         relay_msg_unref(relay->state);
+         relay->state           = NULL;
+         relay->state_requested = false;
+         relay_backlog_clear(relay);
+         return true;
+      }
+   }
+
+   if (relay->backlog_size == relay->backlog_capacity)
+   {
+      size_t capacity         = relay->backlog_capacity
+         ? relay->backlog_capacity * 2 : 1024;
+      struct relay_msg **msgs = (struct relay_msg**)realloc(relay->backlog,
+            capacity * sizeof(*msgs));
+
+      if (!msgs)
+         return false;
+
+      relay->backlog          = msgs;
+      relay->backlog_capacity = capacity;
+   }
+
+   relay->backlog[relay->backlog_size++] = relay_msg_ref(msg);
+   return true;
+}
+
+/**
+ * relay_start_client
+ *
+ * Send a spectator the SYNC for our savestate, the savestate itself and
+ * everything that happened since, then let it follow the live session.
+ */
+static bool relay_start_client(struct relay *relay,
+      struct relay_peer *client)
+{
+   size_t i;
+   uint8_t *payload, *out;
+   uint32_t size = (uint32_t)(RELAY_SYNC_SIZE + relay->sram_size);
+   struct relay_msg *msg;
+
+   payload = (uint8_t*)calloc(1, size);
+   if (!payload)
+   {
+      relay_client_drop(client, "out of memory");
+      return false;
+   }
+
+   out = payload;
+#define PUT32(val) \
+   do { \
+      uint32_t tmp = htonl(val); \
+      memcpy(out, &tmp, sizeof(tmp)); \
+      out += sizeof(tmp); \
+   } while (0)
+
+   PUT32(relay->state_frame);
+   PUT32(relay->client_num |
+         (relay->at_state.paused ? NETPLAY_CMD_SYNC_BIT_PAUSED : 0));
+   for (i = 0; i < MAX_INPUT_DEVICES; i++)
+      PUT32(relay->at_state.config_devices[i]);
+   memcpy(out, relay->at_state.share_modes, MAX_INPUT_DEVICES);
+   out += MAX_INPUT_DEVICES;
+   for (i = 0; i < MAX_INPUT_DEVICES; i++)
+      PUT32(relay->at_state.device_clients[i]);
+   memcpy(out, client->nick, NETPLAY_NICK_LEN);
+   out += NETPLAY_NICK_LEN;
+   if (relay->sram_size)
+      memcpy(out, relay->sram, relay->sram_size);
+#undef PUT32
+
+   msg = relay_msg_new(NETPLAY_CMD_SYNC, payload, size);
+   free(payload);
+   if (!msg)
+   {
+      relay_client_drop(client, "out of memory");
+      return false;
+   }
+   if (!relay_send(relay, client, msg))
+   {
+      relay_msg_unref(msg);
+      return false;
+   }
+   relay_msg_unref(msg);
+
+   for (i = 0; i < ARRAY_SIZE(relay->at_state.settings); i++)
+      if (     relay->at_state.settings[i]
+            && !relay_send(relay, client, relay->at_state.settings[i]))
+         return false;
+
+   if (!relay_send(relay, client, relay->state))
+      return false;
+
+   for (i = 0; i < relay->backlog_size; i++)
+      if (!relay_send(relay, client, relay->backlog[i]))
+         return false;
+
+   client->mode = RELAY_PEER_SPECTATING;
+   fprintf(stderr, "Spectator \"%s\" joined at frame %u.\n",
+         client->nick, relay->state_frame);
+
+   return true;
+}
+
+/**
+ * relay_serve_client
+ *
+ * Start a spectator that finished its handshake, or have it wait for a
+ * fresh savestate if ours would leave it too much to catch up on.
+ */
+static bool relay_serve_client(struct relay *relay,
+      struct relay_peer *client)
+{
+   if (     relay->state
+         && (     relay->frame <= relay->state_frame
+               || relay->frame - relay->state_frame <= relay->backlog_frames))
+      return relay_start_client(relay, client);
+
+   client->mode = RELAY_PEER_WAIT_STATE;
+   relay_request_state(relay);
+   return true;
+}
+
+/**
+ * relay_broadcast
+ *
+ * Forward a message from the host to every spectator, and keep it for
+ * those that join later.
+ */
+static bool relay_broadcast(struct relay *relay, struct relay_msg *msg)
+{
+   size_t i;
+
+   for (i = 0; i < relay->clients_size; i++)
+   {
+      struct relay_peer *client = &relay->clients[i];
+      if (client->mode == RELAY_PEER_SPECTATING)
+         relay_send(relay, client, msg);
+   }
+
+   return relay_backlog_push(relay, msg);
+}
+
+/**
+ * relay_new_state
+ *
+ * The host sent a savestate: it replaces the backlog, and spectators
+ * waiting for one can start.
+ */
+static bool relay_new_state(struct relay *relay, struct relay_msg *msg)
+{
+   size_t i;
+
+   relay_msg_unref(relay->state);
+   relay_backlog_clear(relay);
+   relay->state           = relay_msg_ref(msg);
+   relay->state_frame     = relay_read32(RELAY_MSG_PAYLOAD(msg));
+   relay->state_requested = false;
+   relay_sync_copy(&relay->at_state, &relay->live);
+
+   for (i = 0; i < relay->clients_size; i++)
+   {
+      struct relay_peer *client = &relay->clients[i];
+
+      if (client->mode == RELAY_PEER_SPECTATING)
+         relay_send(relay, client, msg);
+      else if (client->mode == RELAY_PEER_WAIT_STATE)
+         relay_start_client(relay, client);
+   }
+
+   return true;
+}
+
+/**
+ * relay_apply_mode
+ *
+ * Track a player joining or leaving, as a client would.
+ */
+static bool relay_apply_mode(struct relay *relay,
+      const uint8_t *payload, uint32_t size)
+{
+   size_t i;
+   uint32_t mode, client_num, devices;
+
+   if (size != 3*sizeof(uint32_t) + MAX_INPUT_DEVICES + NETPLAY_NICK_LEN)
+      return false;
+
+   mode       = relay_read32(payload + sizeof(uint32_t));
+   devices    = relay_read32(payload + 2*sizeof(uint32_t));
+   client_num = mode & 0xFFFF;
+
+   if (client_num >= MAX_CLIENTS)
+      return false;
+
+   memcpy(relay->live.share_modes, payload + 3*sizeof(uint32_t),
+         MAX_INPUT_DEVICES);
+
+   for (i = 0; i < MAX_INPUT_DEVICES; i++)
+   {
+      if (!(mode & NETPLAY_CMD_MODE_BIT_PLAYING))
+         relay->live.device_clients[i] &= ~(1 << client_num);
+      else if (devices & (1 << i))
+         relay->live.device_clients[i] |=  (1 << client_num);
+   }
+
+   return true;
+}
+
+/**
+ * relay_host_command
+ *
+ * Handle a command from the host. Returns false if the session is over.
+ */
+static bool relay_host_command(struct relay *relay, uint32_t cmd,
+      const uint8_t *payload, uint32_t size)
+{
+   bool ret;
+   struct relay_msg *msg = NULL;
+
+   switch (cmd)
+   {
+      case NETPLAY_CMD_INPUT:
+      case NETPLAY_CMD_NOINPUT:
+         if (size >= sizeof(uint32_t))
+         {
+            uint32_t frame = relay_read32(payload);
+            if (frame > relay->frame)
+               relay->frame = frame;
+         }
+         break;
+
+      case NETPLAY_CMD_MODE:
+         /* Changes to our own mode are not for the spectators */
+         if (     size >= 2*sizeof(uint32_t)
+               && (relay_read32(payload + sizeof(uint32_t))
+                  & NETPLAY_CMD_MODE_BIT_YOU))
+            return true;
+         if (!relay_apply_mode(relay, payload, size))
+         {
+            fprintf(stderr, "Invalid NETPLAY_CMD_MODE from the host.\n");
+            return false;
+         }
+         break;
+
+      case NETPLAY_CMD_LOAD_SAVESTATE:
+         if (size < 2*sizeof(uint32_t))
+         {
+            fprintf(stderr, "Invalid NETPLAY_CMD_LOAD_SAVESTATE from the host.\n");
+            return false;
+         }
+         if (!(msg = relay_msg_new(cmd, payload, size)))
+            return false;
+         ret = relay_new_state(relay, msg);
+         relay_msg_unref(msg);
+         return ret;
+
+      case NETPLAY_CMD_PAUSE:
+         relay->live.paused = true;
+         break;
+
+      case NETPLAY_CMD_RESUME:
+         relay->live.paused = false;
+         break;
+
+      case NETPLAY_CMD_SETTING_ALLOW_PAUSING:
+      case NETPLAY_CMD_SETTING_INPUT_LATENCY_FRAMES:
+         {
+            size_t idx = (cmd == NETPLAY_CMD_SETTING_ALLOW_PAUSING) ? 0 : 1;
+            if (!(msg = relay_msg_new(cmd, payload, size)))
+               return false;
+            relay_msg_unref(relay->live.settings[idx]);
+            relay->live.settings[idx] = relay_msg_ref(msg);
+         }
+         break;
+
+      case NETPLAY_CMD_CRC:
+      case NETPLAY_CMD_RESET:
+      case NETPLAY_CMD_PLAYER_CHAT:
+         break;
+
+      case NETPLAY_CMD_PING_REQUEST:
+         return relay_send_cmd(relay, &relay->host,
+               NETPLAY_CMD_PING_RESPONSE, NULL, 0);
+
+      case NETPLAY_CMD_NAK:
+      case NETPLAY_CMD_DISCONNECT:
+         fprintf(stderr, "The host ended the session.\n");
+         return false;
+
+      default:
+         /* Nothing the spectators need: stalls, our own pings,
+          * netpacket data and so on */
+         return true;
+   }
+
+   if (!msg && !(msg = relay_msg_new(cmd, payload, size)))
+      return false;
+
+   ret = relay_broadcast(relay, msg);
+   relay_msg_unref(msg);
+   return ret;
+}
+
+/**
+ * relay_client_header
+ *
+ * Answer a spectator's connection header with the host's details, since
+ * it will be following the host's session.
+ */
+static bool relay_client_header(struct relay *relay,
+      struct relay_peer *client, const uint8_t *data)
+{
+   uint32_t header[6];
+   uint32_t lo_protocol, hi_protocol;
+   uint32_t magic = relay_read32(data);
+   struct nick_buf
+   {
+      uint32_t cmd[2];
+      char nick[NETPLAY_NICK_LEN];
+   } nick_buf;
+
+   header[0] = htonl(NETPLAY_MAGIC);
+   header[1] = htonl(relay->platform_magic);
+   header[2] = htonl(relay->compression);
+   header[3] = 0;
+   header[4] = htonl(relay->protocol);
+   header[5] = htonl(relay->impl_magic);
+
+   if (magic == POKE_MAGIC)
+   {
+      socket_send_all_nonblocking(client->fd, header, sizeof(header), true);
+      relay_peer_close(client);
+      return false;
+   }
+   if (magic != NETPLAY_MAGIC)
+   {
+      relay_client_drop(client, "not a netplay client");
+      return false;
+   }
+
+   /* Clients send their lowest protocol, and their highest one in the
+    * salt field; older clients only support the one they send. */
+   lo_protocol = relay_read32(data + 4*sizeof(uint32_t));
+   hi_protocol = relay_read32(data + 3*sizeof(uint32_t));
+   if (!hi_protocol)
+      hi_protocol = lo_protocol;
+
+   if (relay->protocol < lo_protocol || relay->protocol > hi_protocol)
+   {
+      /* A zero protocol tells the client it is out of date */
+      header[4] = 0;
+      socket_send_all_nonblocking(client->fd, header, sizeof(header), true);
+      relay_client_drop(client, "unsupported protocol version");
+      return false;
+   }
+
+   /* Savestates are forwarded as the host compressed them */
+   if ((relay_read32(data + 2*sizeof(uint32_t)) & relay->compression)
+         != relay->compression)
+   {
+      relay_client_drop(client, "compression not supported");
+      return false;
+   }
+
+   memset(&nick_buf, 0, sizeof(nick_buf));
+   nick_buf.cmd[0] = htonl(NETPLAY_CMD_NICK);
+   nick_buf.cmd[1] = htonl(sizeof(nick_buf.nick));
+   memcpy(nick_buf.nick, relay->host_nick, sizeof(nick_buf.nick));
+
+   if (     socket_send_all_nonblocking(client->fd, header,
+               sizeof(header), true) != sizeof(header)
+         || socket_send_all_nonblocking(client->fd, &nick_buf,
+               sizeof(nick_buf), true) != sizeof(nick_buf))
+   {
+      relay_client_drop(client, "send failed");
+      return false;
+   }
+
+   client->mode = RELAY_PEER_PRE_NICK;
+   return true;
+}
+
+/**
+ * relay_client_command
+ *
+ * Handle a command from a spectator. Returns false if it was dropped.
+ */
+static bool relay_client_command(struct relay *relay,
+      struct relay_peer *client, uint32_t cmd,
+      const uint8_t *payload, uint32_t size)
+{
+   switch (client->mode)
+   {
+      case RELAY_PEER_PRE_NICK:
+         if (cmd != NETPLAY_CMD_NICK || size != NETPLAY_NICK_LEN)
+         {
+            relay_client_drop(client, "expected a nickname");
+            return false;
+         }
+         memcpy(client->nick, payload, NETPLAY_NICK_LEN);
+         client->nick[NETPLAY_NICK_LEN - 1] = '\0';
+
+         if (!relay_send_cmd(relay, client, NETPLAY_CMD_INFO,
+               relay->host_info, sizeof(relay->host_info)))
+            return false;
+         client->mode = RELAY_PEER_PRE_INFO;
+         return true;
+
+      case RELAY_PEER_PRE_INFO:
+         {
+            char core_name[NETPLAY_NICK_LEN];
+
+            if (cmd != NETPLAY_CMD_INFO || size != RELAY_INFO_SIZE)
+            {
+               relay_client_drop(client, "expected core info");
+               return false;
+            }
+
+            memcpy(core_name, payload + sizeof(uint32_t), sizeof(core_name));
+            core_name[sizeof(core_name) - 1] = '\0';
+            if (!string_is_equal_case_insensitive(core_name,
+                  (const char*)relay->host_info + sizeof(uint32_t)))
+            {
+               relay_client_drop(client, "different core");
+               return false;
+            }
+
+            return relay_serve_client(relay, client);
+         }
+
+      default:
+         break;
+   }
+
+   switch (cmd)
+   {
+      case NETPLAY_CMD_PING_REQUEST:
+         return relay_send_cmd(relay, client,
+               NETPLAY_CMD_PING_RESPONSE, NULL, 0);
+
+      case NETPLAY_CMD_REQUEST_SAVESTATE:
+         /* A desynced spectator; the host's answer goes to everyone */
+         if (client->mode == RELAY_PEER_SPECTATING)
+            relay_request_state(relay);
+         return true;
+
+      case NETPLAY_CMD_PLAY:
+         {
+            uint32_t reason = htonl(
+                  NETPLAY_CMD_MODE_REFUSED_REASON_UNPRIVILEGED);
+            return relay_send_cmd(relay, client,
+                  NETPLAY_CMD_MODE_REFUSED, &reason, sizeof(reason));
+         }
+
+      case NETPLAY_CMD_NAK:
+      case NETPLAY_CMD_DISCONNECT:
+         relay_client_drop(client, "disconnected");
+         return false;
+
+      default:
+         return true;
+   }
+}
+
+/**
+ * relay_peer_read
+ *
+ * Read whatever a peer has sent and handle every complete command.
+ * Returns false if the peer is gone.
+ */
+static bool relay_peer_read(struct relay *relay, struct relay_peer *peer)
+{
+   bool is_host       = (peer == &relay->host);
+   size_t max_payload = is_host
+      ? RELAY_MAX_HOST_PAYLOAD : RELAY_MAX_CLIENT_PAYLOAD;
+
+   for (;;)
+   {
+      ssize_t recvd;
+      size_t pos   = 0;
+      size_t want  = 16384;
+      bool error   = false;
+
+      /* Make room for the command being received */
+      if (peer->recv_len >= 2*sizeof(uint32_t)
+            && peer->mode != RELAY_PEER_INIT)
+      {
+         size_t size = relay_read32(peer->recv_buf + sizeof(uint32_t));
+         if (size > max_payload)
+         {
+            if (is_host)
+               fprintf(stderr, "Command from the host is too large.\n");
+            else
+               relay_client_drop(peer, "command too large");
+            return false;
+         }
+         if (size + 2*sizeof(uint32_t) > want)
+            want = size + 2*sizeof(uint32_t);
+      }
+
+      if (peer->recv_cap < peer->recv_len + want)
+      {
+         uint8_t *buf = (uint8_t*)realloc(peer->recv_buf,
+               peer->recv_len + want);
+         if (!buf)
+            return false;
+         peer->recv_buf = buf;
+         peer->recv_cap = peer->recv_len + want;
+      }
+
+      recvd = socket_receive_all_nonblocking(peer->fd, &error,
+            peer->recv_buf + peer->recv_len,
+            peer->recv_cap - peer->recv_len);
+      if (recvd < 0)
+      {
+         if (is_host)
+            fprintf(stderr, "Lost the connection to the host.\n");
+         else
+            relay_client_drop(peer, "connection closed");
+         return false;
+      }
+      if (!recvd)
+         return true;
+      peer->recv_len += recvd;
+
+      for (;;)
+      {
+         uint32_t cmd, size;
+         const uint8_t *data = peer->recv_buf + pos;
+         size_t avail        = peer->recv_len - pos;
+
+         if (peer->mode == RELAY_PEER_INIT)
+         {
+            if (avail < 6*sizeof(uint32_t))
+               break;
+            if (!relay_client_header(relay, peer, data))
+               return false;
+            pos += 6*sizeof(uint32_t);
+            continue;
+         }
+
+         if (avail < 2*sizeof(uint32_t))
+            break;
+         cmd  = relay_read32(data);
+         size = relay_read32(data + sizeof(uint32_t));
+         if (size > max_payload || avail - 2*sizeof(uint32_t) < size)
+            break;
+         pos += 2*sizeof(uint32_t) + size;
+
+         if (is_host)
+         {
+            if (!relay_host_command(relay, cmd,
+                  data + 2*sizeof(uint32_t), size))
+               return false;
+         }
+         else if (!relay_client_command(relay, peer, cmd,
+                  data + 2*sizeof(uint32_t), size))
+            return false;
+      }
+
+      memmove(peer->recv_buf, peer->recv_buf + pos, peer->recv_len - pos);
+      peer->recv_len -= pos;
+   }
+}
+
+/**
+ * relay_accept
+ *
+ * Take every pending connection on the listening socket.
+ */
+static void relay_accept(struct relay *relay)
+{
+   for (;;)
+   {
+      struct relay_peer *client = NULL;
+      int fd                    = accept(relay->listen_fd, NULL, NULL);
+      size_t i, active          = 0;
+
+      if (fd < 0)
+         return;
+
+      for (i = 0; i < relay->clients_size; i++)
+      {
+         if (relay->clients[i].mode == RELAY_PEER_NONE)
+         {
+            if (!client)
+               client = &relay->clients[i];
+         }
+         else
+            active++;
+      }
+
+      if (active >= relay->max_clients)
+      {
+         /* Only the magic matters; the version is for old clients */
+         uint32_t header[6];
+         memset(header, 0, sizeof(header));
+         header[0] = htonl(FULL_MAGIC);
+         header[4] = htonl(HIGH_NETPLAY_PROTOCOL_VERSION);
+         socket_send_all_nonblocking(fd, header, sizeof(header), true);
+         socket_close(fd);
+         continue;
+      }
+
+      if (!client)
+      {
+         if (relay->clients_size == relay->clients_capacity)
+         {
+            size_t capacity = relay->clients_capacity
+               ? relay->clients_capacity * 2 : 16;
+            struct relay_peer *clients = (struct relay_peer*)realloc(
+                  relay->clients, capacity * sizeof(*clients));
+
+            if (!clients)
+            {
+               socket_close(fd);
+               continue;
+            }
+            relay->clients          = clients;
+            relay->clients_capacity = capacity;
+         }
+         client = &relay->clients[relay->clients_size++];
+      }
+
+      if (!socket_nonblock(fd))
+      {
+         socket_close(fd);
+         memset(client, 0, sizeof(*client));
+         client->fd = -1;
+         continue;
+      }
+
+      memset(client, 0, sizeof(*client));
+      client->fd        = fd;
+      client->mode      = RELAY_PEER_INIT;
+      client->connected = time(NULL);
+   }
+}
+
+/* Blocking helpers for the handshake with the host, which happens before
+ * there is anyone to relay to. */
+
+static bool relay_host_send(struct relay *relay,
+      uint32_t cmd, const void *payload, uint32_t size)
+{
+   uint32_t header[2];
+
+   header[0] = htonl(cmd);
+   header[1] = htonl(size);
+
+   return socket_send_all_blocking(relay->host.fd,
+         header, sizeof(header), true)
+      && (!size || socket_send_all_blocking(relay->host.fd,
+         payload, size, true));
+}
+
+static uint8_t *relay_host_recv(struct relay *relay,
+      uint32_t *cmd, uint32_t *size)
+{
+   uint32_t header[2];
+   uint8_t *payload;
+
+   if (!socket_receive_all_blocking(relay->host.fd, header, sizeof(header)))
+      return NULL;
+
+   *cmd  = ntohl(header[0]);
+   *size = ntohl(header[1]);
+   if (*size > RELAY_MAX_HOST_PAYLOAD)
+      return NULL;
+
+   /* Never return NULL for an empty payload */
+   if (!(payload = (uint8_t*)malloc(*size + 1)))
+      return NULL;
+
+   if (*size && !socket_receive_all_blocking(relay->host.fd, payload, *size))
+   {
+      free(payload);
+      return NULL;
+   }
+
+   return payload;
+}
+
+/**
+ * relay_host_connect
+ *
+ * Join the host as a spectator, the way a client would.
+ */
+static bool relay_host_connect(struct relay *relay,
+      const char *host, int port, const char *nick)
+{
+   size_t i;
+   uint32_t header[6];
+   uint32_t cmd, size;
+   uint8_t *payload;
+   const uint8_t *in;
+   char nick_payload[NETPLAY_NICK_LEN];
+   struct addrinfo *addr = NULL;
+   int fd                = socket_init((void**)&addr, port, host,
+         SOCKET_TYPE_STREAM, 0);
+
+   if (fd < 0)
+   {
+      perror("socket");
+      return false;
+   }
+   if (socket_connect(fd, addr) < 0)
+   {
+      perror("connect");
+      socket_close(fd);
+      freeaddrinfo_retro(addr);
+      return false;
+   }
+   freeaddrinfo_retro(addr);
+   relay->host.fd = fd;
+
+   /* Like any client, we send our lowest protocol, and our highest one in
+    * the salt field. Savestates are passed through compressed, so ask for
+    * zlib whether or not we could decompress it ourselves. We don't ask
+    * for XXH3 frame hashes, so that the host sends plain CRCs which every
+    * spectator understands. */
+   header[0] = htonl(NETPLAY_MAGIC);
+   header[1] = htonl(relay_platform_magic());
+   header[2] = htonl(NETPLAY_COMPRESSION_ZLIB);
+   header[3] = htonl(HIGH_NETPLAY_PROTOCOL_VERSION);
+   header[4] = htonl(LOW_NETPLAY_PROTOCOL_VERSION);
+   header[5] = 0;
+
+   if (  !socket_send_all_blocking(fd, header, sizeof(header), true)
+       || !socket_receive_all_blocking(fd, header, sizeof(header)))
+   {
+      fprintf(stderr, "Failed to exchange connection headers.\n");
+      return false;
+   }
+
+   switch (ntohl(header[0]))
+   {
+      case NETPLAY_MAGIC:
+         break;
+      case FULL_MAGIC:
+         fprintf(stderr, "The host is full.\n");
+         return false;
+      case BANNED_MAGIC:
+         fprintf(stderr, "Banned from the host.\n");
+         return false;
+      default:
+         fprintf(stderr, "The host is not a netplay server.\n");
+         return false;
+   }
+
+   relay->platform_magic = ntohl(header[1]);
+   relay->compression    = ntohl(header[2]) & NETPLAY_COMPRESSION_ZLIB;
+   relay->protocol       = ntohl(header[4]);
+   relay->impl_magic     = ntohl(header[5]);
+
+   if (     relay->protocol < LOW_NETPLAY_PROTOCOL_VERSION
+         || relay->protocol > HIGH_NETPLAY_PROTOCOL_VERSION)
+   {
+      fprintf(stderr, "The host's netplay protocol is not supported.\n");
+      return false;
+   }
+
+   if (header[3])
+   {
+      fprintf(stderr, "Password required but unsupported.\n");
+      return false;
+   }
+
+   memset(nick_payload, 0, sizeof(nick_payload));
+   strlcpy(nick_payload, nick, sizeof(nick_payload));
+   if (!relay_host_send(relay, NETPLAY_CMD_NICK,
+            nick_payload, sizeof(nick_payload)))
+      return false;
+
+   /* The host's nick, shown to our spectators as theirs */
+   if (!(payload = relay_host_recv(relay, &cmd, &size)))
+      return false;
+   if (cmd != NETPLAY_CMD_NICK || size != NETPLAY_NICK_LEN)
+   {
+      fprintf(stderr, "Failed to receive the host's nickname.\n");
+      free(payload);
+      return false;
+   }
+   memcpy(relay->host_nick, payload, NETPLAY_NICK_LEN);
+   relay->host_nick[NETPLAY_NICK_LEN - 1] = '\0';
+   free(payload);
+
+   /* The host's INFO; we run the same core, so echo it back */
+   if (!(payload = relay_host_recv(relay, &cmd, &size)))
+      return false;
+   if (cmd != NETPLAY_CMD_INFO || size != RELAY_INFO_SIZE)
+   {
+      fprintf(stderr, "The host has no content loaded.\n");
+      free(payload);
+      return false;
+   }
+   memcpy(relay->host_info, payload, RELAY_INFO_SIZE);
+   free(payload);
+   if (!relay_host_send(relay, NETPLAY_CMD_INFO,
+            relay->host_info, sizeof(relay->host_info)))
+      return false;
+
+   /* And finally the SYNC, which new spectators get a copy of */
+   if (!(payload = relay_host_recv(relay, &cmd, &size)))
+      return false;
+   if (cmd != NETPLAY_CMD_SYNC || size < RELAY_SYNC_SIZE)
+   {
+      fprintf(stderr, "Failed to receive netplay sync.\n");
+      free(payload);
+      return false;
+   }
+
+   in                 = payload;
+   relay->frame       = relay_read32(in);
+   in                += sizeof(uint32_t);
+   relay->client_num  = relay_read32(in);
+   in                += sizeof(uint32_t);
+   relay->live.paused = !!(relay->client_num & NETPLAY_CMD_SYNC_BIT_PAUSED);
+   relay->client_num &= ~NETPLAY_CMD_SYNC_BIT_PAUSED;
+   for (i = 0; i < MAX_INPUT_DEVICES; i++, in += sizeof(uint32_t))
+      relay->live.config_devices[i] = relay_read32(in);
+   memcpy(relay->live.share_modes, in, MAX_INPUT_DEVICES);
+   in += MAX_INPUT_DEVICES;
+   for (i = 0; i < MAX_INPUT_DEVICES; i++, in += sizeof(uint32_t))
+      relay->live.device_clients[i] = relay_read32(in);
+   in += NETPLAY_NICK_LEN;
+
+   relay->sram_size = size - RELAY_SYNC_SIZE;
+   if (relay->sram_size)
+   {
+      if (!(relay->sram = (uint8_t*)malloc(relay->sram_size)))
+      {
+         free(payload);
+         return false;
+      }
+      memcpy(relay->sram, in, relay->sram_size);
+   }
+   free(payload);
+
+   if (!socket_nonblock(fd))
+      return false;
+
+   relay->host.mode = RELAY_PEER_SPECTATING;
+   fprintf(stderr, "Relaying \"%s\" (protocol %u) from frame %u.\n",
+         relay->host_nick, relay->protocol, relay->frame);
+
+   /* The host sends every new connection a savestate */
+   relay->state_requested = true;
+   return true;
+}
+
+static int relay_listen(int port)
+{
+   struct addrinfo *addr = NULL;
+   int fd                = socket_init((void**)&addr, port, NULL,
+         SOCKET_TYPE_STREAM, 0);
+
+   if (fd < 0)
+      return -1;
+
+   if (     !socket_bind(fd, addr)
+         || listen(fd, 64) < 0
+         || !socket_nonblock(fd))
+   {
+      socket_close(fd);
+      fd = -1;
+   }
+
+   freeaddrinfo_retro(addr);
+   return fd;
+}
+
+static void relay_free(struct relay *relay)
+{
+   size_t i;
+
+   for (i = 0; i < relay->clients_size; i++)
+      if (relay->clients[i].mode != RELAY_PEER_NONE)
+         relay_peer_close(&relay->clients[i]);
+   free(relay->clients);
+
+   relay_peer_close(&relay->host);
+   if (relay->listen_fd >= 0)
+      socket_close(relay->listen_fd);
+
+   relay_backlog_clear(relay);
+   free(relay->backlog);
+   relay_msg_unref(relay->state);
+   relay_sync_free(&relay->live);
+   relay_sync_free(&relay->at_state);
+   free(relay->sram);
+}
+
+/**
+ * relay_run
+ *
+ * The relay's event loop: one poll over the host, the listening socket
+ * and every spectator. Runs until the host goes away.
+ */
+static void relay_run(struct relay *relay)
+{
+   struct pollfd *fds = NULL;
+   size_t fds_capacity = 0;
+
+   for (;;)
+   {
+      size_t i, nfds = 2;
+      time_t now;
+      int ret;
+
+      if (fds_capacity < relay->clients_size + 2)
+      {
+         struct pollfd *tmp = (struct pollfd*)realloc(fds,
+               (relay->clients_size + 2) * sizeof(*fds));
+         if (!tmp)
+            break;
+         fds          = tmp;
+         fds_capacity = relay->clients_size + 2;
+      }
+
+      fds[0].fd      = relay->host.fd;
+      fds[0].events  = POLLIN | (relay->host.queue.count ? POLLOUT : 0);
+      fds[0].revents = 0;
+      fds[1].fd      = relay->listen_fd;
+      fds[1].events  = POLLIN;
+      fds[1].revents = 0;
+      for (i = 0; i < relay->clients_size; i++)
+      {
+         struct relay_peer *client = &relay->clients[i];
+         fds[nfds].fd      = client->fd;
+         fds[nfds].events  = POLLIN | (client->queue.count ? POLLOUT : 0);
+         fds[nfds].revents = 0;
+         nfds++;
+      }
+
+      ret = socket_poll(fds, (unsigned)nfds, 1000);
+      if (ret < 0)
+         continue;
+
+      if (fds[0].revents & (POLLIN | POLLHUP | POLLERR))
+         if (!relay_peer_read(relay, &relay->host))
+            break;
+      if (!relay_queue_flush(relay->host.fd, &relay->host.queue))
+      {
+         fprintf(stderr, "Lost the connection to the host.\n");
+         break;
+      }
+
+      /* Spectators are read from before anyone new joins, so that the
+       * pollfds still line up with them */
+      now = time(NULL);
+      for (i = 0; i < relay->clients_size; i++)
+      {
+         struct relay_peer *client = &relay->clients[i];
+
+         if (client->mode == RELAY_PEER_NONE)
+            continue;
+
+         if (     (fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR))
+               && !relay_peer_read(relay, client))
+            continue;
+
+         if (     client->mode < RELAY_PEER_WAIT_STATE
+               && now - client->connected > RELAY_HANDSHAKE_TIMEOUT)
+         {
+            relay_client_drop(client, "handshake timed out");
+            continue;
+         }
+      }
+
+      /* Flush everyone, including those that just got host data */
+      for (i = 0; i < relay->clients_size; i++)
+      {
+         struct relay_peer *client = &relay->clients[i];
+
+         if (     client->mode != RELAY_PEER_NONE
+               && client->queue.count
+               && !relay_queue_flush(client->fd, &client->queue))
+            relay_client_drop(client, "send failed");
+      }
+
+      if (!relay_queue_flush(relay->host.fd, &relay->host.queue))
+      {
+         fprintf(stderr, "Lost the connection to the host.\n");
+         break;
+      }
+
+      if (fds[1].revents & POLLIN)
+         relay_accept(relay);
+
+      /* Drop trailing free slots */
+      while (     relay->clients_size
+            && relay->clients[relay->clients_size - 1].mode
+               == RELAY_PEER_NONE)
+         relay->clients_size--;
+   }
+
+   free(fds);
+}
+
+int main(int argc, char **argv)
+{
+   struct relay relay;
+   const char *host = "localhost";
+   const char *nick = RELAY_DEFAULT_NICK;
+   int port         = RARCH_DEFAULT_PORT;
+   int listen_port  = RARCH_DEFAULT_PORT + 1;
+
+   const struct option opt[] = {
+      {"host",        1, NULL, 'H'},
+      {"port",        1, NULL, 'P'},
+      {"listen",      1, NULL, 'l'},
+      {"nick",        1, NULL, 'n'},
+      {"max-clients", 1, NULL, 'm'},
+      {"queue",       1, NULL, 'q'},
+      {"backlog",     1, NULL, 'b'},
+      {NULL,          0, NULL, 0}
+   };
+
+   memset(&relay, 0, sizeof(relay));
+   relay.host.fd        = -1;
+   relay.listen_fd      = -1;
+   relay.max_clients    = 128;
+   relay.queue_limit    = 32768 * 1024;
+   relay.backlog_frames = 1800;
+
+   for (;;)
+   {
+      int c = getopt_long(argc, argv, "H:P:l:n:m:q:b:", opt, NULL);
+      if (c == -1)
+         break;
+
+      switch (c)
+      {
+         case 'H':
+            host = optarg;
+            break;
+
+         case 'P':
+            port = atoi(optarg);
+            break;
+
+         case 'l':
+            listen_port = atoi(optarg);
+            break;
+
+         case 'n':
+            nick = optarg;
+            break;
+
+         case 'm':
+            relay.max_clients = (size_t)atoi(optarg);
+            break;
+
+         case 'q':
+            relay.queue_limit = (size_t)atoi(optarg) * 1024;
+            break;
+
+         case 'b':
+            relay.backlog_frames = (uint32_t)atoi(optarg);
+            break;
+
+         default:
+            usage();
+            return 1;
+      }
+   }
+
+   if ((relay.listen_fd = relay_listen(listen_port)) < 0)
+   {
+      fprintf(stderr, "Failed to listen on port %d.\n", listen_port);
+      return 1;
+   }
+
+   if (!relay_host_connect(&relay, host, port, nick))
+   {
+      relay_free(&relay);
+      return 1;
+   }
+
+   relay_run(&relay);
+   relay_free(&relay);
+
+   return 0;
+}
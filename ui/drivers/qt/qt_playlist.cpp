@@ -410,6 +410,8 @@ void MainWindow::addFilesToPlaylist(QStringList files)
    playlist_config.capacity            = COLLECTION_SIZE;
    playlist_config.old_format          = settings->bools.playlist_use_old_format;
    playlist_config.compress            = settings->bools.playlist_compression;
+   playlist_config.journal             = settings->bools.playlist_journal;
+   playlist_config.cache               = settings->bools.playlist_cache;
    playlist_config.fuzzy_archive_match = settings->bools.playlist_fuzzy_archive_match;
    playlist_config_set_base_content_directory(&playlist_config, settings->bools.playlist_portable_paths ? settings->paths.directory_menu_content : NULL);
 
@@ -728,6 +730,8 @@ bool MainWindow::updateCurrentPlaylistEntry(
    playlist_config.capacity            = COLLECTION_SIZE;
    playlist_config.old_format          = settings->bools.playlist_use_old_format;
    playlist_config.compress            = settings->bools.playlist_compression;
+   playlist_config.journal             = settings->bools.playlist_journal;
+   playlist_config.cache               = settings->bools.playlist_cache;
    playlist_config.fuzzy_archive_match = settings->bools.playlist_fuzzy_archive_match;
    playlist_config_set_base_content_directory(&playlist_config,
 		    settings->bools.playlist_portable_paths
@@ -862,6 +866,8 @@ void MainWindow::onPlaylistWidgetContextMenuRequested(const QPoint&)
    playlist_config.capacity            = COLLECTION_SIZE;
    playlist_config.old_format          = settings->bools.playlist_use_old_format;
    playlist_config.compress            = settings->bools.playlist_compression;
+   playlist_config.journal             = settings->bools.playlist_journal;
+   playlist_config.cache               = settings->bools.playlist_cache;
    playlist_config.fuzzy_archive_match = settings->bools.playlist_fuzzy_archive_match;
    playlist_config_set_base_content_directory(&playlist_config,
 		   settings->bools.playlist_portable_paths
@@ -1414,6 +1420,8 @@ void MainWindow::deleteCurrentPlaylistItem()
    playlist_config.capacity            = COLLECTION_SIZE;
    playlist_config.old_format          = settings->bools.playlist_use_old_format;
    playlist_config.compress            = settings->bools.playlist_compression;
+   playlist_config.journal             = settings->bools.playlist_journal;
+   playlist_config.cache               = settings->bools.playlist_cache;
    playlist_config.fuzzy_archive_match = settings->bools.playlist_fuzzy_archive_match;
    playlist_config_set_base_content_directory(&playlist_config,
 		   settings->bools.playlist_portable_paths
@@ -1465,6 +1473,8 @@ QString MainWindow::getPlaylistDefaultCore(QString plName)
    playlist_config.capacity            = COLLECTION_SIZE;
    playlist_config.old_format          = settings->bools.playlist_use_old_format;
    playlist_config.compress            = settings->bools.playlist_compression;
+   playlist_config.journal             = settings->bools.playlist_journal;
+   playlist_config.cache               = settings->bools.playlist_cache;
    playlist_config.fuzzy_archive_match = settings->bools.playlist_fuzzy_archive_match;
    playlist_config_set_base_content_directory(&playlist_config,
 		   settings->bools.playlist_portable_paths
@@ -1537,6 +1547,8 @@ void PlaylistModel::getPlaylistItems(QString path)
    playlist_config.capacity            = COLLECTION_SIZE;
    playlist_config.old_format          = settings->bools.playlist_use_old_format;
    playlist_config.compress            = settings->bools.playlist_compression;
+   playlist_config.journal             = settings->bools.playlist_journal;
+   playlist_config.cache               = settings->bools.playlist_cache;
    playlist_config.fuzzy_archive_match = settings->bools.playlist_fuzzy_archive_match;
    playlist_config_set_base_content_directory(&playlist_config,
 		   settings->bools.playlist_portable_paths